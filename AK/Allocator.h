@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
+
+namespace AK {
+
+// Containers that take an Allocator parameter get their memory through an object with this interface:
+//
+//   void* allocate(size_t size, size_t alignment);  // Returns nullptr on failure.
+//   void deallocate(void* ptr, size_t size);        // Called with the size that was allocated.
+//   size_t good_size(size_t size) const;            // The size an allocation would actually use.
+//
+// The allocator is stored inside the container, and travels along with its contents when the
+// container is copied, moved or swapped. Stateless allocators like this one take up no space.
+struct DefaultAllocator {
+    static void* allocate(size_t size, [[maybe_unused]] size_t alignment) { return kmalloc(size); }
+    static void deallocate(void* ptr, size_t size) { kfree_sized(ptr, size); }
+    static size_t good_size(size_t size) { return kmalloc_good_size(size); }
+};
+
+}
+
+#if USING_AK_GLOBALLY
+using AK::DefaultAllocator;
+#endif
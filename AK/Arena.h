@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Checked.h>
+#include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
+
+namespace AK {
+
+// A monotonic allocator: memory is handed out by bumping a pointer through chunks that are only
+// freed all at once, when the arena is cleared or destroyed. This is meant for lots of short-lived
+// data that dies together, like the nodes and containers built up while parsing something.
+//
+// Freed memory is not reused, except when it was the most recent allocation, which is given back
+// so the next allocation can take its place. A container that grows copies into a new buffer
+// before freeing the old one, so the buffers it outgrew stay allocated until the arena is cleared.
+class Arena {
+    AK_MAKE_NONCOPYABLE(Arena);
+    AK_MAKE_NONMOVABLE(Arena);
+
+public:
+    static constexpr size_t default_initial_chunk_size = 4 * KiB;
+    static constexpr size_t max_chunk_size = 1 * MiB;
+
+    explicit Arena(size_t initial_chunk_size = default_initial_chunk_size)
+        : m_next_chunk_size(max(initial_chunk_size, sizeof(ChunkHeader) + 1))
+    {
+    }
+
+    ~Arena()
+    {
+        clear();
+    }
+
+    void* allocate(size_t size, size_t alignment)
+    {
+        VERIFY(alignment && is_power_of_two(alignment));
+        auto aligned = align_up_to(m_top, alignment);
+        if (m_current_chunk && aligned <= m_end && size <= m_end - aligned) [[likely]] {
+            m_top = aligned + size;
+            m_bytes_allocated += size;
+            return reinterpret_cast<void*>(aligned);
+        }
+        return allocate_from_new_chunk(size, alignment);
+    }
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        auto* memory = allocate(sizeof(T), alignof(T));
+        if (!memory)
+            return nullptr;
+        return new (memory) T(forward<Args>(args)...);
+    }
+
+    void deallocate(void* ptr, size_t size)
+    {
+        m_bytes_allocated -= size;
+        if (reinterpret_cast<FlatPtr>(ptr) + size == m_top)
+            m_top = reinterpret_cast<FlatPtr>(ptr);
+    }
+
+    // Frees every chunk at once. Nothing allocated from the arena may be used afterwards, and no
+    // destructors are run.
+    void clear()
+    {
+        auto* chunk = m_chunks;
+        while (chunk) {
+            auto* next = chunk->next;
+            kfree_sized(chunk, chunk->size);
+            chunk = next;
+        }
+        m_chunks = nullptr;
+        m_current_chunk = nullptr;
+        m_top = 0;
+        m_end = 0;
+        m_bytes_allocated = 0;
+        m_bytes_reserved = 0;
+    }
+
+    // The bytes currently handed out, and the bytes taken from the system to do so.
+    size_t bytes_allocated() const { return m_bytes_allocated; }
+    size_t bytes_reserved() const { return m_bytes_reserved; }
+
+private:
+    struct ChunkHeader {
+        ChunkHeader* next;
+        size_t size;
+    };
+
+    void* allocate_from_new_chunk(size_t size, size_t alignment)
+    {
+        Checked<size_t> needed = size;
+        needed += alignment - 1;
+        needed += sizeof(ChunkHeader);
+        if (needed.has_overflow())
+            return nullptr;
+
+        // Allocations that would take up a large part of a chunk get one of their own, so that
+        // they don't waste the rest of the current chunk.
+        bool is_large = needed.value() > m_next_chunk_size / 4;
+        auto chunk_size = is_large ? needed.value() : m_next_chunk_size;
+
+        auto* chunk = static_cast<ChunkHeader*>(kmalloc(chunk_size));
+        if (!chunk)
+            return nullptr;
+        chunk->next = m_chunks;
+        chunk->size = chunk_size;
+        m_chunks = chunk;
+        m_bytes_reserved += chunk_size;
+
+        auto start = reinterpret_cast<FlatPtr>(chunk) + sizeof(ChunkHeader);
+        auto aligned = align_up_to(start, alignment);
+        m_bytes_allocated += size;
+        if (is_large)
+            return reinterpret_cast<void*>(aligned);
+
+        m_current_chunk = chunk;
+        m_top = aligned + size;
+        m_end = reinterpret_cast<FlatPtr>(chunk) + chunk_size;
+        m_next_chunk_size = min(m_next_chunk_size * 2, max(max_chunk_size, m_next_chunk_size));
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    ChunkHeader* m_chunks { nullptr };
+    ChunkHeader* m_current_chunk { nullptr };
+    FlatPtr m_top { 0 };
+    FlatPtr m_end { 0 };
+    size_t m_next_chunk_size { default_initial_chunk_size };
+    size_t m_bytes_allocated { 0 };
+    size_t m_bytes_reserved { 0 };
+};
+
+// Lets containers allocate from an Arena, e.g. ArenaVector<T> or ArenaHashMap<K, V>.
+// The arena must outlive every container using it.
+// NOTE: There is deliberately no default constructor, so a container that would end up
+//       without an arena (e.g. `ArenaVector<T> vector;`) fails to compile instead of crashing later.
+class ArenaAllocator {
+public:
+    ArenaAllocator() = delete;
+    ArenaAllocator(Arena& arena)
+        : m_arena(&arena)
+    {
+    }
+
+    Arena* arena() const { return m_arena; }
+
+    void* allocate(size_t size, size_t alignment)
+    {
+        VERIFY(m_arena);
+        return m_arena->allocate(size, alignment);
+    }
+    void deallocate(void* ptr, size_t size)
+    {
+        VERIFY(m_arena);
+        m_arena->deallocate(ptr, size);
+    }
+    static size_t good_size(size_t size) { return size; }
+
+private:
+    Arena* m_arena { nullptr };
+};
+
+}
+
+#if USING_AK_GLOBALLY
+using AK::Arena;
+using AK::ArenaAllocator;
+#endif
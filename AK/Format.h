@@ -414,10 +414,10 @@ struct Formatter<Span<T>> : Formatter<ReadonlySpan<T>> {
     }
 };
 
-template<typename T, size_t inline_capacity>
+template<typename T, size_t inline_capacity, typename Allocator>
 requires(HasFormatter<T>)
-struct Formatter<Vector<T, inline_capacity>> : Formatter<ReadonlySpan<T>> {
-    ErrorOr<void> format(FormatBuilder& builder, Vector<T, inline_capacity> const& value)
+struct Formatter<Vector<T, inline_capacity, Allocator>> : Formatter<ReadonlySpan<T>> {
+    ErrorOr<void> format(FormatBuilder& builder, Vector<T, inline_capacity, Allocator> const& value)
     {
         return Formatter<ReadonlySpan<T>>::format(builder, value.span());
     }
@@ -82,18 +82,33 @@ class CircularQueue;
 template<typename T>
 struct Traits;
 
-template<typename T, typename TraitsForT = Traits<T>, bool IsOrdered = false>
+struct DefaultAllocator;
+class ArenaAllocator;
+
+template<typename T, typename TraitsForT = Traits<T>, bool IsOrdered = false, typename Allocator = DefaultAllocator>
 class HashTable;
 
 template<typename T, typename TraitsForT = Traits<T>>
 using OrderedHashTable = HashTable<T, TraitsForT, true>;
 
-template<typename K, typename V, typename KeyTraits = Traits<K>, typename ValueTraits = Traits<V>, bool IsOrdered = false>
+template<typename T, typename TraitsForT = Traits<T>, bool IsOrdered = false>
+using ArenaHashTable = HashTable<T, TraitsForT, IsOrdered, ArenaAllocator>;
+
+template<typename T, typename TraitsForT = Traits<T>, bool IsOrdered = false, typename Allocator = DefaultAllocator>
+class SwissHashTable;
+
+template<typename K, typename V, typename KeyTraits = Traits<K>, typename ValueTraits = Traits<V>, bool IsOrdered = false, template<typename, typename, bool, typename> typename TableType = HashTable, typename Allocator = DefaultAllocator>
 class HashMap;
 
 template<typename K, typename V, typename KeyTraits = Traits<K>, typename ValueTraits = Traits<V>>
 using OrderedHashMap = HashMap<K, V, KeyTraits, ValueTraits, true>;
 
+template<typename K, typename V, typename KeyTraits = Traits<K>, typename ValueTraits = Traits<V>>
+using SwissHashMap = HashMap<K, V, KeyTraits, ValueTraits, false, SwissHashTable>;
+
+template<typename K, typename V, typename KeyTraits = Traits<K>, typename ValueTraits = Traits<V>, bool IsOrdered = false>
+using ArenaHashMap = HashMap<K, V, KeyTraits, ValueTraits, IsOrdered, HashTable, ArenaAllocator>;
+
 template<typename T>
 class Badge;
 
@@ -138,9 +153,12 @@ class OwnPtr;
 template<typename T>
 class WeakPtr;
 
-template<typename T, size_t inline_capacity = 0>
+template<typename T, size_t inline_capacity = 0, typename Allocator = DefaultAllocator>
 requires(!IsRvalueReference<T>) class Vector;
 
+template<typename T, size_t inline_capacity = 0>
+using ArenaVector = Vector<T, inline_capacity, ArenaAllocator>;
+
 template<typename T, typename ErrorType = Error>
 class [[nodiscard]] ErrorOr;
 
@@ -14,7 +14,7 @@
 
 namespace AK {
 
-template<typename K, typename V, typename KeyTraits, typename ValueTraits, bool IsOrdered>
+template<typename K, typename V, typename KeyTraits, typename ValueTraits, bool IsOrdered, template<typename, typename, bool, typename> typename TableType, typename Allocator>
 class HashMap {
 private:
     struct Entry {
@@ -33,6 +33,11 @@ public:
 
     HashMap() = default;
 
+    explicit HashMap(Allocator allocator)
+        : m_table(move(allocator))
+    {
+    }
+
     HashMap(std::initializer_list<Entry> list)
     {
         MUST(try_ensure_capacity(list.size()));
@@ -85,7 +90,7 @@ public:
         });
     }
 
-    using HashTableType = HashTable<Entry, EntryTraits, IsOrdered>;
+    using HashTableType = TableType<Entry, EntryTraits, IsOrdered, Allocator>;
     using IteratorType = typename HashTableType::Iterator;
     using ConstIteratorType = typename HashTableType::ConstIterator;
 
@@ -296,6 +301,7 @@ private:
 }
 
 #if USING_AK_GLOBALLY
+using AK::ArenaHashMap;
 using AK::HashMap;
 using AK::OrderedHashMap;
 #endif
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <AK/Allocator.h>
 #include <AK/Concepts.h>
 #include <AK/Error.h>
 #include <AK/StdLibExtras.h>
@@ -92,7 +93,7 @@ private:
     BucketType* m_bucket { nullptr };
 };
 
-template<typename T, typename TraitsForT, bool IsOrdered>
+template<typename T, typename TraitsForT, bool IsOrdered, typename Allocator>
 class HashTable {
     static constexpr size_t grow_capacity_at_least = 8;
     static constexpr size_t grow_at_load_factor_percent = 80;
@@ -129,6 +130,15 @@ class HashTable {
 public:
     HashTable() = default;
     explicit HashTable(size_t capacity) { rehash(capacity); }
+    explicit HashTable(Allocator allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+    HashTable(size_t capacity, Allocator allocator)
+        : m_allocator(move(allocator))
+    {
+        rehash(capacity);
+    }
 
     ~HashTable()
     {
@@ -142,10 +152,11 @@ public:
             }
         }
 
-        kfree_sized(m_buckets, size_in_bytes(m_capacity));
+        m_allocator.deallocate(m_buckets, size_in_bytes(m_capacity));
     }
 
     HashTable(HashTable const& other)
+        : m_allocator(other.m_allocator)
     {
         rehash(other.capacity());
         for (auto& it : other)
@@ -164,6 +175,7 @@ public:
         , m_collection_data(other.m_collection_data)
         , m_size(other.m_size)
         , m_capacity(other.m_capacity)
+        , m_allocator(other.m_allocator)
     {
         other.m_size = 0;
         other.m_capacity = 0;
@@ -184,6 +196,7 @@ public:
         swap(a.m_buckets, b.m_buckets);
         swap(a.m_size, b.m_size);
         swap(a.m_capacity, b.m_capacity);
+        swap(a.m_allocator, b.m_allocator);
 
         if constexpr (IsOrdered)
             swap(a.m_collection_data, b.m_collection_data);
@@ -277,7 +290,7 @@ public:
 
     void clear()
     {
-        *this = HashTable();
+        *this = HashTable(m_allocator);
     }
 
     void clear_with_capacity()
@@ -442,16 +455,17 @@ private:
     ErrorOr<void> try_rehash(size_t new_capacity)
     {
         new_capacity = max(new_capacity, m_capacity + grow_capacity_at_least);
-        new_capacity = kmalloc_good_size(size_in_bytes(new_capacity)) / sizeof(BucketType);
+        new_capacity = m_allocator.good_size(size_in_bytes(new_capacity)) / sizeof(BucketType);
         VERIFY(new_capacity >= size());
 
         auto* old_buckets = m_buckets;
         auto old_buckets_size = size_in_bytes(m_capacity);
         Iterator old_iter = begin();
 
-        auto* new_buckets = kcalloc(1, size_in_bytes(new_capacity));
+        auto* new_buckets = m_allocator.allocate(size_in_bytes(new_capacity), alignof(BucketType));
         if (!new_buckets)
             return Error::from_errno(ENOMEM);
+        __builtin_memset(new_buckets, 0, size_in_bytes(new_capacity));
 
         m_buckets = static_cast<BucketType*>(new_buckets);
         m_capacity = new_capacity;
@@ -468,7 +482,7 @@ private:
             it->~T();
         }
 
-        kfree_sized(old_buckets, old_buckets_size);
+        m_allocator.deallocate(old_buckets, old_buckets_size);
         return {};
     }
     void rehash(size_t new_capacity)
@@ -710,10 +724,12 @@ private:
     [[no_unique_address]] CollectionDataType m_collection_data;
     size_t m_size { 0 };
     size_t m_capacity { 0 };
+    [[no_unique_address]] Allocator m_allocator;
 };
 }
 
 #if USING_AK_GLOBALLY
+using AK::ArenaHashTable;
 using AK::HashSetResult;
 using AK::HashTable;
 using AK::OrderedHashTable;
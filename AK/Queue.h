@@ -56,6 +56,22 @@ public:
         return value;
     }
 
+    // Takes the most recently enqueued value, which lets the queue double as a stack.
+    T dequeue_end()
+    {
+        VERIFY(!is_empty());
+        auto* segment = m_segments.last();
+        auto value = segment->data.take_last();
+        --m_size;
+        if (m_size == 0) {
+            m_index_into_first = 0;
+            segment->data.clear_with_capacity();
+        } else if (segment->data.is_empty()) {
+            delete m_segments.take_last();
+        }
+        return value;
+    }
+
     T const& head() const
     {
         VERIFY(!is_empty());
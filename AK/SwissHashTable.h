@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Allocator.h>
+#include <AK/BuiltinWrappers.h>
+#include <AK/Concepts.h>
+#include <AK/Error.h>
+#include <AK/HashTable.h>
+#include <AK/Optional.h>
+#include <AK/Platform.h>
+#include <AK/SIMD.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Traits.h>
+#include <AK/Types.h>
+
+namespace AK {
+
+namespace Detail {
+
+// Every slot of a SwissHashTable has a control byte, kept in a separate array so that a whole
+// group of them can be checked at once:
+// - Empty: never used since the last rehash, a lookup can stop at the first group containing one
+// - Deleted: a tombstone left behind by a removal
+// - Full (high bit set): the low 7 bits are bits of the hash that weren't used to pick a group,
+//   so most mismatching slots are skipped without ever touching the slot itself
+struct SwissControl {
+    static constexpr u8 Empty = 0x00;
+    static constexpr u8 Deleted = 0x01;
+    static constexpr u8 FullBit = 0x80;
+};
+
+class SwissGroup {
+public:
+    static constexpr size_t width = 16;
+
+    ALWAYS_INLINE static SwissGroup load(u8 const* control)
+    {
+        SwissGroup group;
+        __builtin_memcpy(&group.m_bytes, control, width);
+        return group;
+    }
+
+    // Each of these returns a mask with bit N set if the Nth control byte in the group matches.
+    ALWAYS_INLINE u32 match(u8 control) const { return high_bits(reinterpret_cast<SIMD::u8x16>(m_bytes == control)); }
+    ALWAYS_INLINE u32 match_empty() const { return match(SwissControl::Empty); }
+    ALWAYS_INLINE u32 match_empty_or_deleted() const { return high_bits(~m_bytes); }
+
+private:
+    ALWAYS_INLINE static u32 high_bits(SIMD::u8x16 bytes)
+    {
+#if ARCH(X86_64)
+        return static_cast<u16>(__builtin_ia32_pmovmskb128(reinterpret_cast<SIMD::c8x16>(bytes)));
+#else
+        u32 mask = 0;
+        for (size_t i = 0; i < width; ++i)
+            mask |= static_cast<u32>(bytes[i] >> 7) << i;
+        return mask;
+#endif
+    }
+
+    SIMD::u8x16 m_bytes;
+};
+
+}
+
+template<typename SwissHashTableType, typename T>
+class SwissHashTableIterator {
+    friend SwissHashTableType;
+
+public:
+    bool operator==(SwissHashTableIterator const& other) const { return m_index == other.m_index; }
+    bool operator!=(SwissHashTableIterator const& other) const { return m_index != other.m_index; }
+    T& operator*() { return m_slots[m_index]; }
+    T* operator->() { return &m_slots[m_index]; }
+    void operator++()
+    {
+        ++m_index;
+        skip_to_full();
+    }
+
+private:
+    SwissHashTableIterator(u8 const* control, T* slots, size_t index, size_t capacity)
+        : m_control(control)
+        , m_slots(slots)
+        , m_index(index)
+        , m_capacity(capacity)
+    {
+    }
+
+    void skip_to_full()
+    {
+        while (m_index < m_capacity && !(m_control[m_index] & Detail::SwissControl::FullBit))
+            ++m_index;
+    }
+
+    u8 const* m_control { nullptr };
+    T* m_slots { nullptr };
+    size_t m_index { 0 };
+    size_t m_capacity { 0 };
+};
+
+// A hash table with the same interface as HashTable, laid out like Abseil's "Swiss tables".
+//
+// Slots are grouped by 16, and a lookup compares the control bytes of a whole group against the
+// hash in one go, only looking at the slots whose control byte matches. Unlike HashTable's Robin
+// Hood probing, insertions never move existing entries and removals leave a tombstone instead of
+// shifting entries back, so lookups touch far less memory at the cost of occasional rehashes to
+// clean up tombstones.
+//
+// This does not keep insertion order; use OrderedHashTable for that. For a HashMap backed by this,
+// see SwissHashMap.
+template<typename T, typename TraitsForT, bool IsOrdered, typename Allocator>
+class SwissHashTable {
+    static_assert(!IsOrdered, "SwissHashTable does not keep insertion order");
+
+    using Control = Detail::SwissControl;
+    using Group = Detail::SwissGroup;
+
+    static constexpr size_t group_width = Group::width;
+
+public:
+    SwissHashTable() = default;
+    explicit SwissHashTable(size_t capacity) { ensure_capacity(capacity); }
+    explicit SwissHashTable(Allocator allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+    SwissHashTable(size_t capacity, Allocator allocator)
+        : m_allocator(move(allocator))
+    {
+        ensure_capacity(capacity);
+    }
+
+    ~SwissHashTable()
+    {
+        if (!m_slots)
+            return;
+
+        destroy_all_slots();
+        m_allocator.deallocate(m_slots, size_in_bytes(m_capacity));
+    }
+
+    SwissHashTable(SwissHashTable const& other)
+        : m_allocator(other.m_allocator)
+    {
+        ensure_capacity(other.size());
+        for (auto& it : other)
+            set(it);
+    }
+
+    SwissHashTable& operator=(SwissHashTable const& other)
+    {
+        SwissHashTable temporary(other);
+        swap(*this, temporary);
+        return *this;
+    }
+
+    SwissHashTable(SwissHashTable&& other) noexcept
+        : m_slots(exchange(other.m_slots, nullptr))
+        , m_control(exchange(other.m_control, nullptr))
+        , m_size(exchange(other.m_size, 0))
+        , m_capacity(exchange(other.m_capacity, 0))
+        , m_growth_left(exchange(other.m_growth_left, 0))
+        , m_allocator(other.m_allocator)
+    {
+    }
+
+    SwissHashTable& operator=(SwissHashTable&& other) noexcept
+    {
+        SwissHashTable temporary { move(other) };
+        swap(*this, temporary);
+        return *this;
+    }
+
+    friend void swap(SwissHashTable& a, SwissHashTable& b) noexcept
+    {
+        swap(a.m_slots, b.m_slots);
+        swap(a.m_control, b.m_control);
+        swap(a.m_size, b.m_size);
+        swap(a.m_capacity, b.m_capacity);
+        swap(a.m_growth_left, b.m_growth_left);
+        swap(a.m_allocator, b.m_allocator);
+    }
+
+    [[nodiscard]] bool is_empty() const { return m_size == 0; }
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    template<typename U, size_t N>
+    ErrorOr<void> try_set_from(U (&from_array)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+            TRY(try_set(from_array[i]));
+        return {};
+    }
+    template<typename U, size_t N>
+    void set_from(U (&from_array)[N])
+    {
+        MUST(try_set_from(from_array));
+    }
+
+    ErrorOr<void> try_ensure_capacity(size_t capacity)
+    {
+        if (capacity <= m_size + m_growth_left)
+            return {};
+        return try_rehash(capacity_for(max(capacity, m_size)));
+    }
+    void ensure_capacity(size_t capacity)
+    {
+        MUST(try_ensure_capacity(capacity));
+    }
+
+    [[nodiscard]] bool contains(T const& value) const
+    {
+        return find(value) != end();
+    }
+
+    template<Concepts::HashCompatible<T> K>
+    requires(IsSame<TraitsForT, Traits<T>>) [[nodiscard]] bool contains(K const& value) const
+    {
+        return find(value) != end();
+    }
+
+    using Iterator = SwissHashTableIterator<SwissHashTable, T>;
+
+    [[nodiscard]] Iterator begin()
+    {
+        Iterator iterator(m_control, m_slots, 0, m_capacity);
+        iterator.skip_to_full();
+        return iterator;
+    }
+
+    [[nodiscard]] Iterator end()
+    {
+        return Iterator(m_control, m_slots, m_capacity, m_capacity);
+    }
+
+    using ConstIterator = SwissHashTableIterator<const SwissHashTable, const T>;
+
+    [[nodiscard]] ConstIterator begin() const
+    {
+        ConstIterator iterator(m_control, m_slots, 0, m_capacity);
+        iterator.skip_to_full();
+        return iterator;
+    }
+
+    [[nodiscard]] ConstIterator end() const
+    {
+        return ConstIterator(m_control, m_slots, m_capacity, m_capacity);
+    }
+
+    void clear()
+    {
+        *this = SwissHashTable(m_allocator);
+    }
+
+    void clear_with_capacity()
+    {
+        if (m_capacity == 0)
+            return;
+        destroy_all_slots();
+        __builtin_memset(m_control, Control::Empty, m_capacity);
+        m_size = 0;
+        m_growth_left = max_load(m_capacity);
+    }
+
+    template<typename U = T>
+    ErrorOr<HashSetResult> try_set(U&& value, HashSetExistingEntryBehavior existing_entry_behavior = HashSetExistingEntryBehavior::Replace)
+    {
+        auto hash = TraitsForT::hash(value);
+        auto existing_index = lookup_with_hash(hash, [&](auto& other) { return TraitsForT::equals(other, static_cast<T const&>(value)); });
+        if (existing_index != m_capacity) {
+            if (existing_entry_behavior == HashSetExistingEntryBehavior::Replace) {
+                m_slots[existing_index] = forward<U>(value);
+                return HashSetResult::ReplacedExistingEntry;
+            }
+            return HashSetResult::KeptExistingEntry;
+        }
+
+        if (m_capacity == 0)
+            TRY(try_rehash(group_width));
+
+        // Reusing a tombstone is always fine, but taking an empty slot may only happen while we
+        // stay below the maximum load factor, otherwise lookups could run out of empty slots to stop at.
+        auto index = find_insertion_slot(hash);
+        if (m_growth_left == 0 && m_control[index] == Control::Empty) {
+            TRY(try_rehash(capacity_after_growth()));
+            index = find_insertion_slot(hash);
+        }
+
+        if (m_control[index] == Control::Empty)
+            --m_growth_left;
+        new (&m_slots[index]) T(forward<U>(value));
+        m_control[index] = control_byte(hash);
+        ++m_size;
+        return HashSetResult::InsertedNewEntry;
+    }
+    template<typename U = T>
+    HashSetResult set(U&& value, HashSetExistingEntryBehavior existing_entry_behaviour = HashSetExistingEntryBehavior::Replace)
+    {
+        return MUST(try_set(forward<U>(value), existing_entry_behaviour));
+    }
+
+    template<typename TUnaryPredicate>
+    [[nodiscard]] Iterator find(unsigned hash, TUnaryPredicate predicate)
+    {
+        return Iterator(m_control, m_slots, lookup_with_hash(hash, move(predicate)), m_capacity);
+    }
+
+    [[nodiscard]] Iterator find(T const& value)
+    {
+        return find(TraitsForT::hash(value), [&](auto& other) { return TraitsForT::equals(value, other); });
+    }
+
+    template<typename TUnaryPredicate>
+    [[nodiscard]] ConstIterator find(unsigned hash, TUnaryPredicate predicate) const
+    {
+        return ConstIterator(m_control, m_slots, lookup_with_hash(hash, move(predicate)), m_capacity);
+    }
+
+    [[nodiscard]] ConstIterator find(T const& value) const
+    {
+        return find(TraitsForT::hash(value), [&](auto& other) { return TraitsForT::equals(value, other); });
+    }
+
+    template<Concepts::HashCompatible<T> K>
+    requires(IsSame<TraitsForT, Traits<T>>) [[nodiscard]] Iterator find(K const& value)
+    {
+        return find(Traits<K>::hash(value), [&](auto& other) { return Traits<T>::equals(other, value); });
+    }
+
+    template<Concepts::HashCompatible<T> K, typename TUnaryPredicate>
+    requires(IsSame<TraitsForT, Traits<T>>) [[nodiscard]] Iterator find(K const& value, TUnaryPredicate predicate)
+    {
+        return find(Traits<K>::hash(value), move(predicate));
+    }
+
+    template<Concepts::HashCompatible<T> K>
+    requires(IsSame<TraitsForT, Traits<T>>) [[nodiscard]] ConstIterator find(K const& value) const
+    {
+        return find(Traits<K>::hash(value), [&](auto& other) { return Traits<T>::equals(other, value); });
+    }
+
+    template<Concepts::HashCompatible<T> K, typename TUnaryPredicate>
+    requires(IsSame<TraitsForT, Traits<T>>) [[nodiscard]] ConstIterator find(K const& value, TUnaryPredicate predicate) const
+    {
+        return find(Traits<K>::hash(value), move(predicate));
+    }
+
+    bool remove(T const& value)
+    {
+        auto it = find(value);
+        if (it != end()) {
+            remove(it);
+            return true;
+        }
+        return false;
+    }
+
+    template<Concepts::HashCompatible<T> K>
+    requires(IsSame<TraitsForT, Traits<T>>) bool remove(K const& value)
+    {
+        auto it = find(value);
+        if (it != end()) {
+            remove(it);
+            return true;
+        }
+        return false;
+    }
+
+    // This invalidates the iterator
+    void remove(Iterator& iterator)
+    {
+        VERIFY(iterator.m_index < m_capacity);
+        delete_slot(iterator.m_index);
+        iterator.m_index = m_capacity;
+    }
+
+    template<typename TUnaryPredicate>
+    bool remove_all_matching(TUnaryPredicate const& predicate)
+    {
+        bool has_removed_anything = false;
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (!(m_control[i] & Control::FullBit) || !predicate(m_slots[i]))
+                continue;
+
+            delete_slot(i);
+            has_removed_anything = true;
+        }
+        return has_removed_anything;
+    }
+
+private:
+    // Up to 7/8 of all slots may be in use (or deleted), which leaves at least two empty slots in
+    // an average group for lookups of missing values to stop at.
+    static constexpr size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+    static constexpr size_t size_in_bytes(size_t capacity) { return (sizeof(T) + 1) * capacity; }
+
+    static constexpr size_t capacity_for(size_t size)
+    {
+        size_t capacity = group_width;
+        while (max_load(capacity) < size)
+            capacity *= 2;
+        return capacity;
+    }
+
+    // When the table ran full mostly because of tombstones, cleaning them up makes enough room.
+    // Below 25/32 of the capacity, that still frees at least 3/32 of it before the next rehash.
+    size_t capacity_after_growth() const
+    {
+        if (m_size * 32 <= m_capacity * 25)
+            return m_capacity;
+        return m_capacity * 2;
+    }
+
+    // Traits hashes are often weak in their lower bits (e.g. for pointers), so spread them over a
+    // 64-bit word first. The upper half picks the first group to probe, and bits that don't feed
+    // into that go into the control byte.
+    static constexpr u64 mix(unsigned hash) { return static_cast<u64>(hash) * 0x9e3779b97f4a7c15ull; }
+    static constexpr u8 control_byte(unsigned hash) { return Control::FullBit | ((mix(hash) >> 25) & 0x7f); }
+    size_t first_group_offset(unsigned hash) const { return (mix(hash) >> 32) * group_width & (m_capacity - 1); }
+
+    // Visits the groups at offsets 0, 1, 3, 6, 10... from the first group. As the number of groups
+    // is a power of two, this eventually visits every one of them.
+    template<typename Callback>
+    ALWAYS_INLINE size_t probe(unsigned hash, Callback callback) const
+    {
+        auto offset = first_group_offset(hash);
+        for (size_t step = group_width;; step += group_width) {
+            if (auto result = callback(offset, Group::load(&m_control[offset])); result.has_value())
+                return result.value();
+            offset = (offset + step) & (m_capacity - 1);
+        }
+    }
+
+    template<typename TUnaryPredicate>
+    [[nodiscard]] size_t lookup_with_hash(unsigned hash, TUnaryPredicate predicate) const
+    {
+        if (is_empty())
+            return m_capacity;
+
+        auto control = control_byte(hash);
+        return probe(hash, [&](size_t offset, Group group) -> Optional<size_t> {
+            for (auto matches = group.match(control); matches; matches &= matches - 1) {
+                auto index = offset + count_trailing_zeroes(matches);
+                if (predicate(m_slots[index]))
+                    return index;
+            }
+            if (group.match_empty())
+                return m_capacity;
+            return {};
+        });
+    }
+
+    size_t find_insertion_slot(unsigned hash) const
+    {
+        return probe(hash, [&](size_t offset, Group group) -> Optional<size_t> {
+            if (auto free_slots = group.match_empty_or_deleted())
+                return offset + count_trailing_zeroes(free_slots);
+            return {};
+        });
+    }
+
+    void delete_slot(size_t index)
+    {
+        VERIFY(m_control[index] & Control::FullBit);
+
+        m_slots[index].~T();
+        --m_size;
+
+        // If this group still has an empty slot, no lookup has ever had to probe past it, so the
+        // slot can become empty again instead of leaving a tombstone.
+        auto group_offset = index & ~(group_width - 1);
+        if (Group::load(&m_control[group_offset]).match_empty()) {
+            m_control[index] = Control::Empty;
+            ++m_growth_left;
+        } else {
+            m_control[index] = Control::Deleted;
+        }
+    }
+
+    void destroy_all_slots()
+    {
+        if constexpr (!IsTriviallyDestructible<T>) {
+            for (size_t i = 0; i < m_capacity; ++i) {
+                if (m_control[i] & Control::FullBit)
+                    m_slots[i].~T();
+            }
+        }
+    }
+
+    ErrorOr<void> try_rehash(size_t new_capacity)
+    {
+        VERIFY(is_power_of_two(new_capacity) && new_capacity >= group_width);
+        VERIFY(max_load(new_capacity) >= m_size);
+
+        auto* old_slots = m_slots;
+        auto* old_control = m_control;
+        auto old_capacity = m_capacity;
+
+        auto* storage = static_cast<u8*>(m_allocator.allocate(size_in_bytes(new_capacity), alignof(T)));
+        if (!storage)
+            return Error::from_errno(ENOMEM);
+
+        m_slots = reinterpret_cast<T*>(storage);
+        m_control = storage + sizeof(T) * new_capacity;
+        __builtin_memset(m_control, Control::Empty, new_capacity);
+        m_capacity = new_capacity;
+        m_growth_left = max_load(new_capacity) - m_size;
+
+        if (!old_slots)
+            return {};
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (!(old_control[i] & Control::FullBit))
+                continue;
+            auto hash = TraitsForT::hash(old_slots[i]);
+            auto index = find_insertion_slot(hash);
+            new (&m_slots[index]) T(move(old_slots[i]));
+            m_control[index] = control_byte(hash);
+            old_slots[i].~T();
+        }
+
+        m_allocator.deallocate(old_slots, size_in_bytes(old_capacity));
+        return {};
+    }
+
+    T* m_slots { nullptr };
+    u8* m_control { nullptr };
+    size_t m_size { 0 };
+    size_t m_capacity { 0 };
+    size_t m_growth_left { 0 };
+    [[no_unique_address]] Allocator m_allocator;
+};
+
+}
+
+#if USING_AK_GLOBALLY
+using AK::SwissHashMap;
+using AK::SwissHashTable;
+#endif
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <AK/Allocator.h>
 #include <AK/Assertions.h>
 #include <AK/Error.h>
 #include <AK/Find.h>
@@ -41,7 +42,7 @@ struct CanBePlacedInsideVectorHelper<StorageType, false> {
 };
 }
 
-template<typename T, size_t inline_capacity>
+template<typename T, size_t inline_capacity, typename Allocator>
 requires(!IsRvalueReference<T>) class Vector {
 private:
     static constexpr bool contains_reference = IsLvalueReference<T>;
@@ -58,6 +59,11 @@ public:
     {
     }
 
+    explicit Vector(Allocator allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+
     Vector(std::initializer_list<T> list)
     requires(!IsLvalueReference<T>)
     {
@@ -70,6 +76,7 @@ public:
         : m_size(other.m_size)
         , m_capacity(other.m_capacity)
         , m_outline_buffer(other.m_outline_buffer)
+        , m_allocator(other.m_allocator)
     {
         if constexpr (inline_capacity > 0) {
             if (!m_outline_buffer) {
@@ -83,6 +90,7 @@ public:
     }
 
     Vector(Vector const& other)
+        : m_allocator(other.m_allocator)
     {
         ensure_capacity(other.size());
         TypedTransfer<StorageType>::copy(data(), other.data(), other.size());
@@ -97,8 +105,17 @@ public:
         m_size = other.size();
     }
 
-    template<size_t other_inline_capacity>
-    Vector(Vector<T, other_inline_capacity> const& other)
+    template<size_t other_inline_capacity, typename OtherAllocator>
+    Vector(Vector<T, other_inline_capacity, OtherAllocator> const& other)
+    {
+        ensure_capacity(other.size());
+        TypedTransfer<StorageType>::copy(data(), other.data(), other.size());
+        m_size = other.size();
+    }
+
+    template<size_t other_inline_capacity, typename OtherAllocator>
+    Vector(Vector<T, other_inline_capacity, OtherAllocator> const& other, Allocator allocator)
+        : m_allocator(move(allocator))
     {
         ensure_capacity(other.size());
         TypedTransfer<StorageType>::copy(data(), other.data(), other.size());
@@ -331,6 +348,7 @@ public:
             m_size = other.m_size;
             m_capacity = other.m_capacity;
             m_outline_buffer = other.m_outline_buffer;
+            m_allocator = other.m_allocator;
             if constexpr (inline_capacity > 0) {
                 if (!m_outline_buffer) {
                     for (size_t i = 0; i < m_size; ++i) {
@@ -350,6 +368,7 @@ public:
     {
         if (this != &other) {
             clear();
+            m_allocator = other.m_allocator;
             ensure_capacity(other.size());
             TypedTransfer<StorageType>::copy(data(), other.data(), other.size());
             m_size = other.size();
@@ -357,8 +376,8 @@ public:
         return *this;
     }
 
-    template<size_t other_inline_capacity>
-    Vector& operator=(Vector<T, other_inline_capacity> const& other)
+    template<size_t other_inline_capacity, typename OtherAllocator>
+    Vector& operator=(Vector<T, other_inline_capacity, OtherAllocator> const& other)
     {
         clear();
         ensure_capacity(other.size());
@@ -371,7 +390,7 @@ public:
     {
         clear_with_capacity();
         if (m_outline_buffer) {
-            kfree_sized(m_outline_buffer, m_capacity * sizeof(StorageType));
+            m_allocator.deallocate(m_outline_buffer, m_capacity * sizeof(StorageType));
             m_outline_buffer = nullptr;
         }
         reset_capacity();
@@ -645,8 +664,10 @@ public:
     {
         if (m_capacity >= needed_capacity)
             return {};
-        size_t new_capacity = kmalloc_good_size(needed_capacity * sizeof(StorageType)) / sizeof(StorageType);
-        auto* new_buffer = static_cast<StorageType*>(kmalloc_array(new_capacity, sizeof(StorageType)));
+        if (Checked<size_t>::multiplication_would_overflow(needed_capacity, sizeof(StorageType)))
+            return Error::from_errno(ENOMEM);
+        size_t new_capacity = m_allocator.good_size(needed_capacity * sizeof(StorageType)) / sizeof(StorageType);
+        auto* new_buffer = static_cast<StorageType*>(m_allocator.allocate(new_capacity * sizeof(StorageType), alignof(StorageType)));
         if (new_buffer == nullptr)
             return Error::from_errno(ENOMEM);
 
@@ -659,7 +680,7 @@ public:
             }
         }
         if (m_outline_buffer)
-            kfree_sized(m_outline_buffer, m_capacity * sizeof(StorageType));
+            m_allocator.deallocate(m_outline_buffer, m_capacity * sizeof(StorageType));
         m_outline_buffer = new_buffer;
         m_capacity = new_capacity;
         return {};
@@ -732,7 +753,7 @@ public:
     {
         if (size() == capacity())
             return;
-        Vector new_vector;
+        Vector new_vector(m_allocator);
         new_vector.ensure_capacity(size());
         for (auto& element : *this) {
             new_vector.unchecked_append(move(element));
@@ -852,6 +873,7 @@ private:
 
     alignas(storage_alignment()) unsigned char m_inline_buffer_storage[storage_size()];
     StorageType* m_outline_buffer { nullptr };
+    [[no_unique_address]] Allocator m_allocator;
 };
 
 template<class... Args>
@@ -860,5 +882,6 @@ Vector(Args... args) -> Vector<CommonType<Args...>>;
 }
 
 #if USING_AK_GLOBALLY
+using AK::ArenaVector;
 using AK::Vector;
 #endif
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define TCP_NODELAY 10
+#define TCP_MAXSEG 11
+#define TCP_CONGESTION 12
+
+#define TCP_CA_NAME_MAX 16
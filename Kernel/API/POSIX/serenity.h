@@ -14,6 +14,7 @@ extern "C" {
 
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
+#define PURGE_ALL_CLEAN_BLOCK_CACHE 0x4
 
 enum {
     PERF_EVENT_SAMPLE = 1,
@@ -33,6 +34,8 @@ enum {
     PERF_EVENT_SYSCALL = 16384,
     PERF_EVENT_SIGNPOST = 32768,
     PERF_EVENT_READ = 65536,
+    PERF_EVENT_LOCK_WAIT = 131072,
+    PERF_EVENT_LOCK_HOLD = 262144,
 };
 
 #define PERF_EVENT_MASK_ALL (~0ull)
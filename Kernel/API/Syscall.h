@@ -18,6 +18,7 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -70,6 +71,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)              \
     S(dup2, NeedsBigProcessLock::No)                        \
     S(emuctl, NeedsBigProcessLock::No)                      \
+    S(epoll_create, NeedsBigProcessLock::No)                \
+    S(epoll_ctl, NeedsBigProcessLock::No)                   \
+    S(epoll_wait, NeedsBigProcessLock::No)                  \
     S(execve, NeedsBigProcessLock::Yes)                     \
     S(exit, NeedsBigProcessLock::Yes)                       \
     S(exit_thread, NeedsBigProcessLock::Yes)                \
@@ -156,6 +160,7 @@ enum class NeedsBigProcessLock {
     S(scheduler_get_parameters, NeedsBigProcessLock::No)    \
     S(scheduler_set_parameters, NeedsBigProcessLock::No)    \
     S(sendfd, NeedsBigProcessLock::No)                      \
+    S(sendfile, NeedsBigProcessLock::No)                    \
     S(sendmsg, NeedsBigProcessLock::Yes)                    \
     S(set_mmap_name, NeedsBigProcessLock::Yes)              \
     S(set_thread_name, NeedsBigProcessLock::No)             \
@@ -264,6 +269,14 @@ struct SC_poll_params {
     u32 const* sigmask;
 };
 
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    u32 const* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -45,10 +45,9 @@ void PageFault::handle(RegisterState& regs)
 
     if (!faulted_in_kernel) {
         VirtualAddress userspace_sp = VirtualAddress { regs.userspace_sp() };
-        bool has_valid_stack_pointer = current_thread->process().address_space().with([&](auto& space) {
-            return MM.validate_user_stack(*space, userspace_sp);
-        });
-        if (!has_valid_stack_pointer) {
+        // NOTE: We don't take the address space lock here, so that concurrent page faults in the same
+        //       process don't have to wait for each other (or for an mmap() to finish).
+        if (!MM.validate_user_stack_of_current_address_space(userspace_sp)) {
             dbgln("Invalid stack pointer: {}", userspace_sp);
             return handle_crash(regs, "Bad stack on page fault", SIGSEGV);
         }
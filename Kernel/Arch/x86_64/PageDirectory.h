@@ -199,6 +199,8 @@ private:
     RefPtr<PhysicalPage> m_pml4t;
     RefPtr<PhysicalPage> m_directory_table;
     RefPtr<PhysicalPage> m_directory_pages[512];
+    // Page tables that are still populated behind a large page, keyed by the large page's address.
+    HashMap<FlatPtr, PhysicalPtr> m_page_tables_behind_large_pages;
     RecursiveSpinlock<LockRank::None> m_lock {};
 };
 
@@ -29,6 +29,7 @@
 #include <Kernel/Devices/SelfTTYDevice.h>
 #include <Kernel/Devices/SerialDevice.h>
 #include <Kernel/Devices/ZeroDevice.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/FileSystem/SysFS/Registry.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Firmware/Directory.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
@@ -54,6 +55,7 @@
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/Tasks/PageZeroingTask.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/WorkQueue.h>
@@ -323,7 +325,9 @@ void init_stage2(void*)
     ConsoleManagement::the().initialize();
 
     SyncTask::spawn();
+    BlockBasedFileSystem::spawn_write_back_task();
     FinalizerTask::spawn();
+    PageZeroingTask::spawn();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
 
@@ -23,6 +23,7 @@ extern WorkQueue* g_io_work;
 class AsyncDeviceRequest : public AtomicRefCounted<AsyncDeviceRequest> {
     AK_MAKE_NONCOPYABLE(AsyncDeviceRequest);
     AK_MAKE_NONMOVABLE(AsyncDeviceRequest);
+    friend class Device;
 
 public:
     enum [[nodiscard]] RequestResult {
@@ -122,6 +123,14 @@ protected:
 
     RequestResult get_request_result() const;
 
+    // Used when a request is merged into another one that is about to be started, and thus
+    // is carried out (and completed) along with it, without ever being started on its own.
+    void mark_started_as_part_of_another_request()
+    {
+        VERIFY(m_result == Pending);
+        m_result = Started;
+    }
+
 private:
     void sub_request_finished(AsyncDeviceRequest&);
     void request_finished();
@@ -142,6 +151,7 @@ private:
 
     AsyncDeviceRequest* m_parent_request { nullptr };
     RequestResult m_result { Pending };
+    bool m_is_in_flight { false };
     IntrusiveListNode<AsyncDeviceRequest, LockRefPtr<AsyncDeviceRequest>> m_list_node;
 
     using AsyncDeviceSubRequestList = IntrusiveList<&AsyncDeviceRequest::m_list_node>;
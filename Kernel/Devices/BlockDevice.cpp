@@ -17,9 +17,57 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
     , m_block_count(block_count)
     , m_buffer(buffer)
     , m_buffer_size(buffer_size)
+    , m_merged_block_count(block_count)
 {
 }
 
+bool AsyncBlockDeviceRequest::try_merge(AsyncBlockDeviceRequest& other)
+{
+    VERIFY(&other != this);
+    VERIFY(other.m_request_type == m_request_type);
+    VERIFY(other.m_block_index == merged_end_block_index());
+    VERIFY(other.m_merged_requests.is_empty());
+    if (m_merged_requests.try_append(other).is_error())
+        return false;
+    other.mark_started_as_part_of_another_request();
+    m_merged_block_count += other.m_block_count;
+    return true;
+}
+
+ErrorOr<void> AsyncBlockDeviceRequest::read_from_merged_buffers(u8* data)
+{
+    TRY(read_from_buffer(m_buffer, data, m_block_count * block_size()));
+    data += m_block_count * block_size();
+    for (auto& request : m_merged_requests) {
+        TRY(request->read_from_buffer(request->m_buffer, data, request->m_block_count * block_size()));
+        data += request->m_block_count * block_size();
+    }
+    return {};
+}
+
+void AsyncBlockDeviceRequest::complete_merged(RequestResult result, u8 const* read_data)
+{
+    auto complete_one = [&](AsyncBlockDeviceRequest& request) {
+        auto size = request.m_block_count * block_size();
+        if (result == Success && read_data) {
+            if (request.write_to_buffer(request.m_buffer, read_data, size).is_error()) {
+                request.complete(MemoryFault);
+                read_data += size;
+                return;
+            }
+            read_data += size;
+        }
+        request.complete(result);
+    };
+
+    // NOTE: Completing a request may drop the last reference to it, so we hold on to the merged ones until we're done.
+    auto merged_requests = move(m_merged_requests);
+    NonnullLockRefPtr<AsyncBlockDeviceRequest> protector(*this);
+    complete_one(*this);
+    for (auto& request : merged_requests)
+        complete_one(*request);
+}
+
 void AsyncBlockDeviceRequest::start()
 {
     m_block_device.start_request(*this);
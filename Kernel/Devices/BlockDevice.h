@@ -70,6 +70,17 @@ public:
     UserOrKernelBuffer const& buffer() const { return m_buffer; }
     size_t buffer_size() const { return m_buffer_size; }
 
+    // The I/O scheduler may merge a queued request for the blocks directly following this one into it.
+    // Drivers that support this transfer the merged requests' blocks along with this one's,
+    // and have to use the *_merged_* functions below to handle their buffers and completion.
+    bool try_merge(AsyncBlockDeviceRequest&);
+    u32 merged_block_count() const { return m_merged_block_count; }
+    u64 merged_end_block_index() const { return m_block_index + m_merged_block_count; }
+    size_t merged_buffer_size() const { return m_merged_block_count * block_size(); }
+
+    ErrorOr<void> read_from_merged_buffers(u8* data);
+    void complete_merged(RequestResult, u8 const* read_data = nullptr);
+
     virtual void start() override;
     virtual StringView name() const override
     {
@@ -90,6 +101,8 @@ private:
     const u32 m_block_count;
     UserOrKernelBuffer m_buffer;
     const size_t m_buffer_size;
+    u32 m_merged_block_count { 0 };
+    Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>> m_merged_requests;
 };
 
 }
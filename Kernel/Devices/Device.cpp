@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Find.h>
 #include <AK/Singleton.h>
 #include <Kernel/Devices/Device.h>
 #include <Kernel/Devices/DeviceManagement.h>
@@ -69,17 +70,46 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> Device::open(int options)
     return File::open(options);
 }
 
-void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
+void Device::start_queued_requests()
 {
-    SpinlockLocker lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
+    for (;;) {
+        SpinlockLocker lock(m_requests_lock);
+        if (m_requests_in_flight >= max_requests_in_flight())
+            return;
+
+        AsyncDeviceRequest* next_request = nullptr;
+        for (auto& request : m_requests) {
+            if (request->m_result == AsyncDeviceRequest::Pending) {
+                next_request = request.ptr();
+                break;
+            }
+        }
+        if (!next_request)
+            return;
+
+        ++m_requests_in_flight;
+        next_request->m_is_in_flight = true;
+        will_start_request(*next_request);
         next_request->do_start(move(lock));
     }
+}
+
+void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
+{
+    {
+        SpinlockLocker lock(m_requests_lock);
+        VERIFY(!m_requests.is_empty());
+        auto it = AK::find_if(m_requests.begin(), m_requests.end(), [&](auto& request) { return request.ptr() == &completed_request; });
+        VERIFY(it != m_requests.end());
+        m_requests.remove(it);
+        // NOTE: Requests that were merged into another one never took up a slot of their own.
+        if (completed_request.m_is_in_flight) {
+            VERIFY(m_requests_in_flight > 0);
+            --m_requests_in_flight;
+        }
+    }
 
+    start_queued_requests();
     evaluate_block_conditions();
 }
 
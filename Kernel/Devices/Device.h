@@ -58,16 +58,35 @@ public:
     ErrorOr<NonnullLockRefPtr<AsyncRequestType>> try_make_request(Args&&... args)
     {
         auto request = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) AsyncRequestType(*this, forward<Args>(args)...)));
-        SpinlockLocker lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
-        TRY(m_requests.try_append(request));
-        if (was_empty)
-            request->do_start(move(lock));
+        {
+            SpinlockLocker lock(m_requests_lock);
+            TRY(m_requests.try_append(request));
+        }
+        start_queued_requests();
         return request;
     }
 
 protected:
     Device(MajorNumber major, MinorNumber minor);
+
+    // Devices that can process several requests at once (e.g. with hardware command queues) may raise this.
+    virtual size_t max_requests_in_flight() const { return 1; }
+
+    // Called with the requests lock held right before a queued request is started.
+    // Subclasses can use this to merge other queued requests into it, see for_each_queued_request().
+    virtual void will_start_request(AsyncDeviceRequest&) { }
+
+    template<typename Callback>
+    void for_each_queued_request(Callback callback)
+    {
+        VERIFY(m_requests_lock.is_locked());
+        for (auto& request : m_requests) {
+            if (request->m_result != AsyncDeviceRequest::Pending)
+                continue;
+            if (callback(*request) == IterationDecision::Break)
+                return;
+        }
+    }
     void set_uid(UserID uid) { m_uid = uid; }
     void set_gid(GroupID gid) { m_gid = gid; }
 
@@ -83,6 +102,8 @@ protected:
     virtual void before_will_be_destroyed_remove_from_device_identifier_directory() = 0;
 
 private:
+    void start_queued_requests();
+
     MajorNumber const m_major { 0 };
     MinorNumber const m_minor { 0 };
     UserID m_uid { 0 };
@@ -92,6 +113,7 @@ private:
 
     Spinlock<LockRank::None> m_requests_lock {};
     DoublyLinkedList<LockRefPtr<AsyncDeviceRequest>> m_requests;
+    size_t m_requests_in_flight { 0 };
 
 protected:
     // FIXME: This pointer will be eventually removed after all nodes in /sys/dev/block/ and
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/Types.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Locking/Mutex.h>
@@ -35,8 +36,12 @@ public:
         return peek(buffer, size);
     }
 
+    // Lets the consumer look at the readable data in place, and only discards the bytes it says it took.
+    ErrorOr<size_t> read_in_place(size_t, Function<ErrorOr<size_t>(UserOrKernelBuffer const&, size_t)> const& consumer);
+
     bool is_empty() const { return m_empty; }
 
+    size_t capacity() const { return m_capacity; }
     size_t space_for_writing() const { return m_space_for_writing; }
     size_t immediately_readable() const
     {
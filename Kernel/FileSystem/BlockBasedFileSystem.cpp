@@ -4,93 +4,221 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/FixedArray.h>
+#include <AK/HashMap.h>
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
+#include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Locking/MutexProtected.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
+static Atomic<u64> s_readahead_requests;
+static Atomic<u64> s_readahead_blocks;
+static Atomic<u64> s_readahead_hits;
+static Atomic<u64> s_readahead_wasted;
+static Atomic<size_t> s_cache_size;
+static Atomic<size_t> s_dirty_cache_size;
+static Atomic<u64> s_write_back_runs;
+static Atomic<u64> s_write_back_blocks;
+static Atomic<u64> s_throttled_writes;
+
+class CacheSegment;
+
 struct CacheEntry {
     IntrusiveListNode<CacheEntry> list_node;
+    BlockBasedFileSystem* fs { nullptr };
     BlockBasedFileSystem::BlockIndex block_index { 0 };
+    CacheSegment* segment { nullptr };
     u8* data { nullptr };
+    Time dirty_since;
+    bool is_in_use { false };
     bool has_data { false };
+    bool is_dirty { false };
+    bool was_read_ahead { false };
+    // The entry's data is on the way to disk. It must not be reused until it gets there, and uncached
+    // accesses to the block have to wait for it, as the disk doesn't have the data yet.
+    bool is_under_write_back { false };
 };
 
-class DiskCache {
-public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
-        : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
-    {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs->block_size();
-            m_clean_list.append(entries()[i]);
-        }
-    }
+struct CacheKey {
+    BlockBasedFileSystem const* fs { nullptr };
+    BlockBasedFileSystem::BlockIndex block_index { 0 };
+
+    bool operator==(CacheKey const&) const = default;
+};
+
+}
+
+template<>
+struct AK::Traits<Kernel::CacheKey> : public GenericTraits<Kernel::CacheKey> {
+    static unsigned hash(Kernel::CacheKey const& key) { return pair_int_hash(ptr_hash(key.fs), u64_hash(key.block_index.value())); }
+};
 
-    ~DiskCache() = default;
+namespace Kernel {
 
-    bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
+// The block cache is shared between all mounted file systems, and grows in
+// segments of equally-sized blocks as long as there is free memory to spare.
+class CacheSegment {
+public:
+    static constexpr size_t minimum_size = 64 * KiB;
 
-    void mark_all_clean()
+    static ErrorOr<NonnullOwnPtr<CacheSegment>> try_create(size_t block_size)
     {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+        auto size = max(minimum_size, block_size);
+        auto entry_count = size / block_size;
+        auto data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, entry_count * block_size));
+        auto entries = TRY(FixedArray<CacheEntry>::create(entry_count));
+        auto segment = TRY(adopt_nonnull_own_or_enomem(new (nothrow) CacheSegment(block_size, move(data), move(entries))));
+        s_cache_size.fetch_add(segment->size(), AK::MemoryOrder::memory_order_relaxed);
+        return segment;
     }
 
-    void mark_dirty(CacheEntry& entry)
+    ~CacheSegment()
     {
-        m_dirty_list.prepend(entry);
+        s_cache_size.fetch_sub(size(), AK::MemoryOrder::memory_order_relaxed);
     }
 
-    void mark_clean(CacheEntry& entry)
+    size_t block_size() const { return m_block_size; }
+    size_t size() const { return m_data->size(); }
+    Span<CacheEntry> entries() { return m_entries.span(); }
+
+private:
+    CacheSegment(size_t block_size, NonnullOwnPtr<KBuffer> data, FixedArray<CacheEntry> entries)
+        : m_block_size(block_size)
+        , m_data(move(data))
+        , m_entries(move(entries))
     {
-        m_clean_list.prepend(entry);
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            m_entries[i].segment = this;
+            m_entries[i].data = m_data->data() + i * m_block_size;
+        }
     }
 
-    CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
+    size_t m_block_size { 0 };
+    NonnullOwnPtr<KBuffer> m_data;
+    FixedArray<CacheEntry> m_entries;
+};
+
+static constexpr size_t minimum_cache_size = 4 * MiB;
+static Atomic<size_t> s_cache_target_size { minimum_cache_size };
+
+// Asking the memory manager how much memory is left takes its lock, so this isn't done on every cache miss.
+// Instead, the target is updated by the write-back task on every round, and whenever memory runs short.
+static void update_cache_target_size()
+{
+    // Let the cache have up to half of the memory that nobody else is using or has committed to use.
+    auto memory_info = MM.get_system_memory_info();
+    auto uncommitted_size = memory_info.physical_pages_uncommitted * PAGE_SIZE;
+    auto target_size = max(minimum_cache_size, (uncommitted_size + s_cache_size.load(AK::MemoryOrder::memory_order_relaxed)) / 2);
+    s_cache_target_size.store(target_size, AK::MemoryOrder::memory_order_relaxed);
+}
+
+static size_t cache_target_size()
+{
+    return s_cache_target_size.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+// Dirty blocks are written back by a background task once they have been dirty for a while, or as soon
+// as more than the background ratio of the cache is dirty. Only writers that dirty the cache beyond the
+// hard ratio have to wait for the write-back to catch up.
+static constexpr Time dirty_expire_time = Time::from_milliseconds(500);
+static constexpr Time write_back_interval = Time::from_milliseconds(100);
+static constexpr Time max_dirty_throttle_time = Time::from_milliseconds(100);
+static constexpr size_t dirty_background_ratio_percent = 10;
+static constexpr size_t dirty_ratio_percent = 40;
+static constexpr size_t max_write_back_run_size = 128 * KiB;
+
+static size_t dirty_background_threshold()
+{
+    return cache_target_size() / 100 * dirty_background_ratio_percent;
+}
+
+static size_t dirty_threshold()
+{
+    return cache_target_size() / 100 * dirty_ratio_percent;
+}
+
+static void write_cache_entry_to_disk(CacheEntry& entry)
+{
+    VERIFY(entry.is_dirty);
+    auto base_offset = entry.block_index.value() * entry.fs->block_size();
+    auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+    [[maybe_unused]] auto rc = entry.fs->file_description().write(base_offset, entry_data_buffer, entry.fs->block_size());
+}
+
+class CacheShard {
+public:
+    CacheEntry* get(BlockBasedFileSystem const& fs, BlockBasedFileSystem::BlockIndex block_index)
     {
-        auto it = m_hash.find(block_index);
+        auto it = m_hash.find({ &fs, block_index });
         if (it == m_hash.end())
             return nullptr;
-        auto& entry = const_cast<CacheEntry&>(*it->value);
+        auto& entry = *it->value;
+        VERIFY(entry.fs == &fs);
         VERIFY(entry.block_index == block_index);
+        if (!entry.is_dirty)
+            m_clean_list.prepend(entry);
         return &entry;
     }
 
-    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index) const
+    // Like get(), but doesn't count as a use of the entry.
+    CacheEntry* find(BlockBasedFileSystem const& fs, BlockBasedFileSystem::BlockIndex block_index)
+    {
+        auto it = m_hash.find({ &fs, block_index });
+        if (it == m_hash.end())
+            return nullptr;
+        return it->value;
+    }
+
+    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem& fs, BlockBasedFileSystem::BlockIndex block_index)
     {
-        if (auto* entry = get(block_index))
+        if (auto* entry = get(fs, block_index))
             return entry;
 
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs->flush_writes_impl();
-            return ensure(block_index);
-        }
+        auto& new_entry = *TRY(take_unused_entry(fs.block_size()));
+        TRY(m_hash.try_set({ &fs, block_index }, &new_entry));
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
+        new_entry.fs = &fs;
+        new_entry.block_index = block_index;
+        new_entry.is_in_use = true;
         m_clean_list.prepend(new_entry);
+        return &new_entry;
+    }
 
-        m_hash.remove(new_entry.block_index);
-        TRY(m_hash.try_set(block_index, &new_entry));
-
-        new_entry.block_index = block_index;
-        new_entry.has_data = false;
+    void mark_dirty(CacheEntry& entry)
+    {
+        if (!entry.is_dirty) {
+            entry.is_dirty = true;
+            entry.dirty_since = TimeManagement::the().monotonic_time();
+            s_dirty_cache_size.fetch_add(entry.segment->block_size(), AK::MemoryOrder::memory_order_relaxed);
+        }
+        m_dirty_list.prepend(entry);
+    }
 
-        return &new_entry;
+    void mark_clean(CacheEntry& entry)
+    {
+        if (entry.is_dirty) {
+            entry.is_dirty = false;
+            s_dirty_cache_size.fetch_sub(entry.segment->block_size(), AK::MemoryOrder::memory_order_relaxed);
+            // NOTE: Dirty entries are only marked clean once they're written back, or on their way there.
+            ++m_disk_write_count;
+        }
+        m_clean_list.prepend(entry);
     }
 
-    CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
+    // Counts the blocks of this shard that were sent to disk, so that readahead can tell whether the data
+    // it read with the shard unlocked may have been overwritten in the meantime.
+    u64 disk_write_count() const { return m_disk_write_count; }
+    void did_write_uncached() { ++m_disk_write_count; }
 
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
@@ -99,29 +227,390 @@ public:
             callback(entry);
     }
 
+    // Synchronously writes back dirty entries one by one, and returns how many were written.
+    // Entries that are still being written back by someone else are skipped, as writing them
+    // now could be overtaken by the older write-back.
+    size_t flush_dirty_entries(BlockBasedFileSystem const* fs = nullptr)
+    {
+        size_t flushed_count = 0;
+        for (auto it = m_dirty_list.begin(); it != m_dirty_list.end();) {
+            auto& entry = *it;
+            ++it;
+            if (fs && entry.fs != fs)
+                continue;
+            if (entry.is_under_write_back)
+                continue;
+            write_cache_entry_to_disk(entry);
+            mark_clean(entry);
+            ++flushed_count;
+        }
+        return flushed_count;
+    }
+
+    void remove_all_entries_for(BlockBasedFileSystem const& fs)
+    {
+        flush_dirty_entries(&fs);
+        for (auto it = m_clean_list.begin(); it != m_clean_list.end();) {
+            auto& entry = *it;
+            ++it;
+            if (entry.fs == &fs)
+                release_entry(entry);
+        }
+    }
+
+    // Gives back all segments that only contain clean entries, and returns the number of pages released.
+    size_t release_clean_segments()
+    {
+        size_t released_size = 0;
+        for (size_t i = 0; i < m_segments.size();) {
+            auto segment_size = try_release_segment(i, false);
+            if (segment_size == 0)
+                ++i;
+            released_size += segment_size;
+        }
+        return released_size / PAGE_SIZE;
+    }
+
 private:
-    mutable NonnullRefPtr<BlockBasedFileSystem> m_fs;
-    mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
-    mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
-    mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
-    NonnullOwnPtr<KBuffer> m_entries;
+    ErrorOr<CacheEntry*> take_unused_entry(size_t block_size)
+    {
+        for (auto& entry : m_unused_list) {
+            if (entry.segment->block_size() == block_size)
+                return &entry;
+        }
+
+        auto target_size = cache_target_size();
+        auto cache_size = s_cache_size.load(AK::MemoryOrder::memory_order_relaxed);
+
+        // If we grew past our share of memory (e.g. because someone else needed it since), shrink back down.
+        if (cache_size > target_size + CacheSegment::minimum_size)
+            (void)try_release_segment(0, true);
+
+        if (cache_size + max(CacheSegment::minimum_size, block_size) <= target_size || !has_segment_for(block_size)) {
+            if (!add_segment(block_size).is_error())
+                return take_unused_entry(block_size);
+            // We're running short on memory, so the target is likely out of date.
+            update_cache_target_size();
+        }
+
+        // Reuse the least recently used clean entry of the right size.
+        for (auto it = m_clean_list.rbegin(); it != m_clean_list.rend(); ++it) {
+            auto& entry = *it;
+            if (entry.segment->block_size() != block_size || entry.is_under_write_back)
+                continue;
+            release_entry(entry);
+            return &entry;
+        }
+
+        // Not a single clean entry! Flush writes and try again.
+        if (flush_dirty_entries() > 0)
+            return take_unused_entry(block_size);
+
+        // Everything we have is currently being written back. Rather than waiting for that, go over budget.
+        TRY(add_segment(block_size));
+        return take_unused_entry(block_size);
+    }
+
+    ErrorOr<void> add_segment(size_t block_size)
+    {
+        auto segment = TRY(CacheSegment::try_create(block_size));
+        TRY(m_segments.try_ensure_capacity(m_segments.size() + 1));
+        for (auto& entry : segment->entries())
+            m_unused_list.append(entry);
+        m_segments.unchecked_append(move(segment));
+        return {};
+    }
+
+    bool has_segment_for(size_t block_size) const
+    {
+        for (auto& segment : m_segments) {
+            if (segment->block_size() == block_size)
+                return true;
+        }
+        return false;
+    }
+
+    void release_entry(CacheEntry& entry)
+    {
+        VERIFY(!entry.is_dirty);
+        VERIFY(!entry.is_under_write_back);
+        if (entry.was_read_ahead)
+            s_readahead_wasted.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        if (entry.is_in_use)
+            m_hash.remove({ entry.fs, entry.block_index });
+        entry.fs = nullptr;
+        entry.block_index = 0;
+        entry.is_in_use = false;
+        entry.has_data = false;
+        entry.was_read_ahead = false;
+        m_unused_list.prepend(entry);
+    }
+
+    // Returns the size of the released segment, or 0 if it couldn't be released.
+    // NOTE: The last segment is always kept, so that the cache never has to start over from nothing.
+    size_t try_release_segment(size_t index, bool flush_dirty_entries)
+    {
+        if (m_segments.size() <= 1)
+            return 0;
+        auto& segment = *m_segments[index];
+        for (auto& entry : segment.entries()) {
+            if (entry.is_under_write_back)
+                return 0;
+        }
+        for (auto& entry : segment.entries()) {
+            if (!entry.is_dirty)
+                continue;
+            if (!flush_dirty_entries)
+                return 0;
+            write_cache_entry_to_disk(entry);
+            mark_clean(entry);
+        }
+        for (auto& entry : segment.entries()) {
+            release_entry(entry);
+            m_unused_list.remove(entry);
+        }
+        auto segment_size = segment.size();
+        m_segments.remove(index);
+        return segment_size;
+    }
+
+    IntrusiveList<&CacheEntry::list_node> m_dirty_list;
+    IntrusiveList<&CacheEntry::list_node> m_clean_list;
+    IntrusiveList<&CacheEntry::list_node> m_unused_list;
+    HashMap<CacheKey, CacheEntry*> m_hash;
+    Vector<NonnullOwnPtr<CacheSegment>> m_segments;
+    u64 m_disk_write_count { 0 };
+};
+
+// The cache is split into shards with a lock each, so that accesses to different parts of
+// the disk (or different disks) don't contend. Neighboring blocks share a shard, so that
+// runs of consecutive blocks can be handled while holding just one lock.
+static constexpr size_t cache_shard_count = 16;
+static constexpr u64 blocks_per_cache_shard_stripe = 32;
+static Singleton<Array<MutexProtected<CacheShard>, cache_shard_count>> s_cache_shards;
+
+static MutexProtected<CacheShard>& cache_shard_for(BlockBasedFileSystem const& fs, BlockBasedFileSystem::BlockIndex block_index)
+{
+    auto hash = pair_int_hash(ptr_hash(&fs), u64_hash(block_index.value() / blocks_per_cache_shard_stripe));
+    return s_cache_shards->at(hash % cache_shard_count);
+}
+
+struct WriteBackState {
+    // Held by whoever is writing back runs of blocks with the shard unlocked, and by anyone who needs to know that
+    // no such write is in progress (e.g. because the file system is going away).
+    Mutex lock { "BlockCacheWriteBack"sv };
+    OwnPtr<KBuffer> staging_buffer;
+    WaitQueue task_wait_queue;
+    WaitQueue throttle_wait_queue;
+    WaitQueue run_done_wait_queue;
+    Atomic<Thread*> task_thread { nullptr };
+};
+
+static Singleton<WriteBackState> s_write_back;
+
+struct WriteBackFilter {
+    BlockBasedFileSystem const* fs { nullptr };
+    Optional<Time> dirtied_before;
 };
 
+static bool ensure_write_back_staging_buffer()
+{
+    auto& state = *s_write_back;
+    VERIFY(state.lock.is_exclusively_locked_by_current_thread());
+    if (state.staging_buffer)
+        return true;
+    auto buffer_or_error = KBuffer::try_create_with_size("BlockBasedFS: Write-back"sv, max_write_back_run_size);
+    if (buffer_or_error.is_error())
+        return false;
+    state.staging_buffer = buffer_or_error.release_value();
+    return true;
+}
+
+// Writes back the dirty entries of a shard that match the filter, together with any dirty neighbors, so that
+// each run of consecutive blocks goes to disk in a single write. The shard is only locked while a run is being
+// gathered into the staging buffer, so the cache remains usable while the data is on its way to disk.
+static size_t write_back_shard(MutexProtected<CacheShard>& shard, WriteBackFilter const& filter)
+{
+    auto& state = *s_write_back;
+    VERIFY(state.lock.is_exclusively_locked_by_current_thread());
+    VERIFY(state.staging_buffer);
+
+    Vector<CacheKey> seeds;
+    shard.with_exclusive([&](auto& cache) {
+        cache.for_each_dirty_entry([&](CacheEntry& entry) {
+            if (entry.is_under_write_back || (filter.fs && entry.fs != filter.fs))
+                return;
+            if (filter.dirtied_before.has_value() && entry.dirty_since > filter.dirtied_before.value())
+                return;
+            // NOTE: If we can't remember all of them, the rest will be picked up next time.
+            (void)seeds.try_append({ entry.fs, entry.block_index });
+        });
+    });
+    quick_sort(seeds, [](CacheKey const& a, CacheKey const& b) {
+        if (a.fs != b.fs)
+            return a.fs < b.fs;
+        return a.block_index < b.block_index;
+    });
+
+    size_t written_block_count = 0;
+    for (auto const& seed : seeds) {
+        auto& fs = const_cast<BlockBasedFileSystem&>(*seed.fs);
+        auto block_size = fs.block_size();
+        auto max_run_length = state.staging_buffer->size() / block_size;
+        if (max_run_length == 0)
+            continue;
+
+        u64 run_start = 0;
+        u64 run_end = 0;
+        shard.with_exclusive([&](auto& cache) {
+            auto can_write_back = [&](u64 block) {
+                BlockBasedFileSystem::BlockIndex index { block };
+                if (&cache_shard_for(fs, index) != &shard)
+                    return false;
+                auto* entry = cache.find(fs, index);
+                return entry && entry->is_dirty && !entry->is_under_write_back;
+            };
+
+            // The seed may have been written back as part of an earlier run already.
+            if (!can_write_back(seed.block_index.value()))
+                return;
+            run_start = seed.block_index.value();
+            run_end = run_start + 1;
+            while (run_start > 0 && run_end - run_start < max_run_length && can_write_back(run_start - 1))
+                --run_start;
+            while (run_end - run_start < max_run_length && can_write_back(run_end))
+                ++run_end;
+
+            for (auto block = run_start; block < run_end; ++block) {
+                auto& entry = *cache.find(fs, BlockBasedFileSystem::BlockIndex { block });
+                memcpy(state.staging_buffer->data() + (block - run_start) * block_size, entry.data, block_size);
+                entry.is_under_write_back = true;
+                cache.mark_clean(entry);
+            }
+        });
+        if (run_start == run_end)
+            continue;
+
+        auto run_length = run_end - run_start;
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(state.staging_buffer->data());
+        auto nwritten_or_error = fs.file_description().write(run_start * block_size, buffer, run_length * block_size);
+        if (nwritten_or_error.is_error())
+            dbgln("{}: Failed to write back blocks {}-{}: {}", fs.class_name(), run_start, run_end - 1, nwritten_or_error.error());
+
+        shard.with_exclusive([&](auto& cache) {
+            for (auto block = run_start; block < run_end; ++block) {
+                auto* entry = cache.find(fs, BlockBasedFileSystem::BlockIndex { block });
+                VERIFY(entry && entry->is_under_write_back);
+                entry->is_under_write_back = false;
+            }
+        });
+
+        written_block_count += run_length;
+        s_write_back_runs.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        s_write_back_blocks.fetch_add(run_length, AK::MemoryOrder::memory_order_relaxed);
+        state.throttle_wait_queue.wake_all();
+        state.run_done_wait_queue.wake_all();
+    }
+    return written_block_count;
+}
+
+// Runs an uncached access to a block with its shard locked, once the block isn't being written back.
+// The write-back doesn't hold the shard lock while a run is on its way to disk, so an uncached read
+// could otherwise see the old data on disk, and an uncached write could be overtaken by it.
+template<typename Callback>
+static ErrorOr<void> with_block_not_under_write_back(BlockBasedFileSystem const& fs, BlockBasedFileSystem::BlockIndex index, Callback callback)
+{
+    auto& shard = cache_shard_for(fs, index);
+    for (;;) {
+        auto did_run = TRY(shard.with_exclusive([&](auto& cache) -> ErrorOr<bool> {
+            if (auto* entry = cache.find(fs, index); entry && entry->is_under_write_back)
+                return false;
+            TRY(callback(cache));
+            return true;
+        }));
+        if (did_run)
+            return {};
+        // NOTE: The run may finish before we get to wait, so don't wait for longer than a write-back interval.
+        auto timeout_time = write_back_interval;
+        [[maybe_unused]] auto result = s_write_back->run_done_wait_queue.wait_on(Thread::BlockTimeout { false, &timeout_time }, "BlockCacheWriteBackRun"sv);
+    }
+}
+
+static void wake_write_back_task_if_needed()
+{
+    if (s_dirty_cache_size.load(AK::MemoryOrder::memory_order_relaxed) > dirty_background_threshold())
+        s_write_back->task_wait_queue.wake_all();
+}
+
+static void throttle_dirtying_if_needed()
+{
+    auto& state = *s_write_back;
+    if (s_dirty_cache_size.load(AK::MemoryOrder::memory_order_relaxed) <= dirty_threshold())
+        return;
+
+    // NOTE: The write-back task itself may dirty blocks if a file system is backed by a file on another one.
+    auto* task_thread = state.task_thread.load(AK::MemoryOrder::memory_order_relaxed);
+    if (!task_thread || task_thread == Thread::current())
+        return;
+
+    s_throttled_writes.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    state.task_wait_queue.wake_all();
+    auto timeout_time = max_dirty_throttle_time;
+    [[maybe_unused]] auto result = state.throttle_wait_queue.wait_on(Thread::BlockTimeout { false, &timeout_time }, "BlockCacheThrottle"sv);
+}
+
+UNMAP_AFTER_INIT void BlockBasedFileSystem::spawn_write_back_task()
+{
+    LockRefPtr<Thread> write_back_thread;
+    (void)Process::create_kernel_process(write_back_thread, KString::must_create("Block Cache Write-back Task"sv), [] {
+        auto& state = *s_write_back;
+        state.task_thread.store(Thread::current(), AK::MemoryOrder::memory_order_relaxed);
+        for (;;) {
+            auto timeout_time = write_back_interval;
+            [[maybe_unused]] auto result = state.task_wait_queue.wait_on(Thread::BlockTimeout { false, &timeout_time }, "BlockCacheWriteBack"sv);
+
+            MutexLocker locker(state.lock);
+            if (!ensure_write_back_staging_buffer())
+                continue;
+            update_cache_target_size();
+            auto now = TimeManagement::the().monotonic_time();
+            for (auto& shard : *s_cache_shards) {
+                WriteBackFilter filter;
+                if (s_dirty_cache_size.load(AK::MemoryOrder::memory_order_relaxed) <= dirty_background_threshold())
+                    filter.dirtied_before = now - dirty_expire_time;
+                (void)write_back_shard(shard, filter);
+            }
+            state.throttle_wait_queue.wake_all();
+        }
+    });
+}
+
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
     : FileBackedFileSystem(file_description)
 {
     VERIFY(file_description.file().is_seekable());
 }
 
-BlockBasedFileSystem::~BlockBasedFileSystem() = default;
+BlockBasedFileSystem::~BlockBasedFileSystem()
+{
+    // NOTE: Queued readahead may have repopulated the cache after the last unmount.
+    remove_all_cache_entries();
+}
+
+void BlockBasedFileSystem::remove_all_cache_entries()
+{
+    MutexLocker locker(s_write_back->lock);
+    for (auto& shard : *s_cache_shards) {
+        shard.with_exclusive([&](auto& cache) {
+            cache.remove_all_entries_for(*this);
+        });
+    }
+}
 
 void BlockBasedFileSystem::remove_disk_cache_before_last_unmount()
 {
     VERIFY(m_lock.is_locked());
-    m_cache.with_exclusive([&](auto& cache) {
-        cache.clear();
-    });
+    remove_all_cache_entries();
 }
 
 ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
@@ -129,13 +618,6 @@ ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
     VERIFY(m_lock.is_locked());
     VERIFY(!is_initialized_while_locked());
     VERIFY(block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCache::EntryCount * block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
-
-    m_cache.with_exclusive([&](auto& cache) {
-        cache = move(disk_cache);
-    });
     return {};
 }
 
@@ -152,26 +634,37 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
 
     TRY(data.read(buffered_data.bytes()));
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
-        if (!allow_cache) {
+    if (!allow_cache) {
+        return with_block_not_under_write_back(*this, index, [&](auto& cache) -> ErrorOr<void> {
             flush_specific_block_if_needed(index);
             u64 base_offset = index.value() * block_size() + offset;
             auto nwritten = TRY(file_description().write(base_offset, data, count));
             VERIFY(nwritten == count);
+            cache.did_write_uncached();
+            // Keep a clean copy of the block that is still in the cache up to date.
+            if (auto* entry = cache.get(*this, index); entry && entry->has_data)
+                memcpy(entry->data + offset, buffered_data.data(), count);
             return {};
-        }
+        });
+    }
+
+    throttle_dirtying_if_needed();
 
-        auto entry = TRY(cache->ensure(index));
+    TRY(cache_shard_for(*this, index).with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        auto entry = TRY(cache.ensure(*this, index));
         if (count < block_size()) {
             // Fill the cache first.
             TRY(read_block(index, nullptr, block_size()));
         }
         memcpy(entry->data + offset, buffered_data.data(), count);
 
-        cache->mark_dirty(*entry);
+        cache.mark_dirty(*entry);
         entry->has_data = true;
         return {};
-    });
+    }));
+
+    wake_write_back_task_if_needed();
+    return {};
 }
 
 ErrorOr<void> BlockBasedFileSystem::raw_read(BlockIndex index, UserOrKernelBuffer& buffer)
@@ -226,22 +719,27 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
     VERIFY(offset + count <= block_size());
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_block {}", index);
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
-        if (!allow_cache) {
+    if (!allow_cache) {
+        return with_block_not_under_write_back(*this, index, [&](auto&) -> ErrorOr<void> {
             const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index);
             u64 base_offset = index.value() * block_size() + offset;
             auto nread = TRY(file_description().read(*buffer, base_offset, count));
             VERIFY(nread == count);
             return {};
-        }
+        });
+    }
 
-        auto* entry = TRY(cache->ensure(index));
+    return cache_shard_for(*this, index).with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        auto* entry = TRY(cache.ensure(const_cast<BlockBasedFileSystem&>(*this), index));
         if (!entry->has_data) {
             auto base_offset = index.value() * block_size();
             auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
             auto nread = TRY(file_description().read(entry_data_buffer, base_offset, block_size()));
             VERIFY(nread == block_size());
             entry->has_data = true;
+        } else if (entry->was_read_ahead) {
+            s_readahead_hits.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+            entry->was_read_ahead = false;
         }
         if (buffer)
             TRY(buffer->write(entry->data + offset, count));
@@ -265,37 +763,151 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
     return {};
 }
 
-void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
+void BlockBasedFileSystem::readahead_blocks(Vector<BlockIndex>&& blocks) const
+{
+    if (blocks.is_empty())
+        return;
+    s_readahead_requests.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+
+    // NOTE: Readahead is only a hint, so if we can't queue it we simply don't do it.
+    auto fs = NonnullRefPtr { const_cast<BlockBasedFileSystem&>(*this) };
+    [[maybe_unused]] auto result = g_io_work->try_queue([fs = move(fs), blocks = move(blocks)] {
+        fs->read_blocks_into_cache_impl(blocks, true);
+    });
+}
+
+void BlockBasedFileSystem::read_blocks_into_cache(Span<BlockIndex const> blocks) const
 {
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
+    const_cast<BlockBasedFileSystem*>(this)->read_blocks_into_cache_impl(blocks, false);
+}
+
+void BlockBasedFileSystem::read_blocks_into_cache_impl(Span<BlockIndex const> blocks, bool is_readahead)
+{
+    if (blocks.is_empty())
+        return;
+    auto buffer_or_error = KBuffer::try_create_with_size("BlockBasedFS: Read into cache"sv, blocks.size() * block_size());
+    if (buffer_or_error.is_error())
+        return;
+    auto buffer = buffer_or_error.release_value();
+
+    // Gather runs of consecutive uncached blocks, so each of them can be fetched with a single read.
+    // NOTE: The shard is not locked while a run is being read, so that cache hits don't have to wait for the disk.
+    size_t index = 0;
+    while (index < blocks.size()) {
+        auto run_start = blocks[index];
+        auto& shard = cache_shard_for(*this, run_start);
+        size_t run_length = 0;
+        u64 disk_write_count = 0;
+        shard.with_exclusive([&](auto& cache) {
+            if (auto* entry = cache.find(*this, run_start); entry && entry->has_data) {
+                ++index;
+                return;
+            }
+
+            run_length = 1;
+            while (index + run_length < blocks.size()) {
+                auto block = blocks[index + run_length];
+                if (block.value() != run_start.value() + run_length || &cache_shard_for(*this, block) != &shard)
+                    break;
+                if (auto* entry = cache.find(*this, block); entry && entry->has_data)
+                    break;
+                ++run_length;
+            }
+            index += run_length;
+            disk_write_count = cache.disk_write_count();
+        });
+        if (run_length == 0)
+            continue;
+
+        auto user_or_kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+        auto nread_or_error = file_description().read(user_or_kernel_buffer, run_start.value() * block_size(), run_length * block_size());
+        if (nread_or_error.is_error() || nread_or_error.value() != run_length * block_size())
+            return;
+
+        bool should_continue = shard.with_exclusive([&](auto& cache) {
+            // Something was written to the disk while we were reading from it, so what we have might be stale.
+            if (cache.disk_write_count() != disk_write_count)
+                return true;
+
+            for (size_t i = 0; i < run_length; ++i) {
+                auto entry_or_error = cache.ensure(*this, BlockIndex { run_start.value() + i });
+                if (entry_or_error.is_error())
+                    return false;
+                auto* entry = entry_or_error.release_value();
+                // The block was cached by someone else while we were reading it, and their copy may well be newer.
+                if (entry->has_data)
+                    continue;
+                memcpy(entry->data, buffer->data() + i * block_size(), block_size());
+                entry->has_data = true;
+                if (is_readahead) {
+                    entry->was_read_ahead = true;
+                    s_readahead_blocks.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+                }
+            }
+            return true;
+        });
+        if (!should_continue)
             return;
-        auto* entry = cache->get(index);
+    }
+}
+
+BlockCacheStatistics BlockBasedFileSystem::cache_statistics()
+{
+    BlockCacheStatistics statistics;
+    statistics.cache_size = s_cache_size.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.dirty_size = s_dirty_cache_size.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.target_size = cache_target_size();
+    statistics.readahead_requests = s_readahead_requests.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.readahead_blocks = s_readahead_blocks.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.readahead_hits = s_readahead_hits.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.readahead_wasted = s_readahead_wasted.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.write_back_runs = s_write_back_runs.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.write_back_blocks = s_write_back_blocks.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.throttled_writes = s_throttled_writes.load(AK::MemoryOrder::memory_order_relaxed);
+    return statistics;
+}
+
+size_t BlockBasedFileSystem::release_all_clean_cache_pages()
+{
+    size_t released_page_count = 0;
+    for (auto& shard : *s_cache_shards) {
+        released_page_count += shard.with_exclusive([&](auto& cache) {
+            return cache.release_clean_segments();
+        });
+    }
+    // We're only asked to do this when memory is running short, so our share of it has likely changed.
+    update_cache_target_size();
+    return released_page_count;
+}
+
+void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
+{
+    cache_shard_for(*this, index).with_exclusive([&](auto& cache) {
+        auto* entry = cache.get(*this, index);
         if (!entry)
             return;
-        if (!cache->entry_is_dirty(*entry))
+        if (!entry->is_dirty || entry->is_under_write_back)
             return;
-        size_t base_offset = entry->block_index.value() * block_size();
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
-        (void)file_description().write(base_offset, entry_data_buffer, block_size());
+        write_cache_entry_to_disk(*entry);
+        cache.mark_clean(*entry);
     });
 }
 
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
-            ++count;
+    MutexLocker locker(s_write_back->lock);
+    bool can_write_back_runs = ensure_write_back_staging_buffer();
+    for (auto& shard : *s_cache_shards) {
+        if (can_write_back_runs)
+            count += write_back_shard(shard, { this, {} });
+        // Whatever couldn't be written back in runs (e.g. because we ran out of memory) is flushed block by block.
+        count += shard.with_exclusive([&](auto& cache) {
+            return cache.flush_dirty_entries(this);
         });
-        cache->mark_all_clean();
+    }
+    if (count > 0)
         dbgln("{}: Flushed {} blocks to disk", class_name(), count);
-    });
 }
 
 void BlockBasedFileSystem::flush_writes()
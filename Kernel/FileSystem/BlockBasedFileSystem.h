@@ -7,10 +7,22 @@
 #pragma once
 
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
-#include <Kernel/Locking/MutexProtected.h>
 
 namespace Kernel {
 
+struct BlockCacheStatistics {
+    size_t cache_size { 0 };
+    size_t dirty_size { 0 };
+    size_t target_size { 0 };
+    u64 readahead_requests { 0 };
+    u64 readahead_blocks { 0 };
+    u64 readahead_hits { 0 };
+    u64 readahead_wasted { 0 };
+    u64 write_back_runs { 0 };
+    u64 write_back_blocks { 0 };
+    u64 throttled_writes { 0 };
+};
+
 class BlockBasedFileSystem : public FileBackedFileSystem {
 public:
     AK_TYPEDEF_DISTINCT_ORDERED_ID(u64, BlockIndex);
@@ -22,6 +34,11 @@ public:
     virtual void flush_writes() override;
     void flush_writes_impl();
 
+    static BlockCacheStatistics cache_statistics();
+    static size_t release_all_clean_cache_pages();
+
+    static void spawn_write_back_task();
+
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
 
@@ -39,14 +56,20 @@ protected:
     ErrorOr<void> write_block(BlockIndex, UserOrKernelBuffer const&, size_t count, u64 offset = 0, bool allow_cache = true);
     ErrorOr<void> write_blocks(BlockIndex, unsigned count, UserOrKernelBuffer const&, bool allow_cache = true);
 
+    // Asynchronously reads the given blocks into the cache, if they aren't cached already.
+    void readahead_blocks(Vector<BlockIndex>&&) const;
+    // Like readahead_blocks(), but waits for the reads to finish. Blocks that can't be read into the cache
+    // are simply left out, they will be read one by one when they are actually needed.
+    void read_blocks_into_cache(Span<BlockIndex const>) const;
+
     u64 m_logical_block_size { 512 };
 
     void remove_disk_cache_before_last_unmount();
 
 private:
     void flush_specific_block_if_needed(BlockIndex index);
-
-    mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+    void read_blocks_into_cache_impl(Span<BlockIndex const>, bool is_readahead);
+    void remove_all_cache_entries();
 };
 
 }
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <AK/StringHash.h>
+#include <Kernel/API/POSIX/errno.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static Singleton<DirectoryEntryCache> s_the;
+
+DirectoryEntryCache& DirectoryEntryCache::the()
+{
+    return *s_the;
+}
+
+unsigned DirectoryEntryCache::hash_for(InodeIdentifier parent, StringView name)
+{
+    return pair_int_hash(Traits<InodeIdentifier>::hash(parent), string_hash(name.characters_without_null_termination(), name.length()));
+}
+
+ErrorOr<NonnullRefPtr<Inode>> DirectoryEntryCache::lookup(Inode& parent, StringView name)
+{
+    if (!parent.fs().supports_directory_entry_cache())
+        return parent.lookup(name);
+
+    auto parent_id = parent.identifier();
+    auto hash = hash_for(parent_id, name);
+
+    // An empty Optional is a miss, a null inode is a cached ENOENT.
+    u64 generation = 0;
+    auto cached_inode = m_state.with([&](State& state) -> Optional<RefPtr<Inode>> {
+        auto it = state.entries.find(hash, [&](Entry const* entry) { return entry->matches(parent_id, name); });
+        if (it == state.entries.end()) {
+            generation = state.generation;
+            return {};
+        }
+        auto& entry = **it;
+        state.lru_list.prepend(entry);
+        return entry.inode;
+    });
+
+    if (cached_inode.has_value()) {
+        if (!cached_inode->is_null())
+            return cached_inode->release_nonnull();
+        return ENOENT;
+    }
+
+    auto child_or_error = parent.lookup(name);
+    if (!child_or_error.is_error())
+        insert(parent_id, name, hash, child_or_error.value(), generation);
+    else if (child_or_error.error().code() == ENOENT)
+        insert(parent_id, name, hash, nullptr, generation);
+    return child_or_error;
+}
+
+void DirectoryEntryCache::insert(InodeIdentifier parent, StringView name, unsigned hash, RefPtr<Inode> inode, u64 generation)
+{
+    // NOTE: Failing to cache something is not an error, we'll just have to look it up again next time.
+    auto name_string = KString::try_create(name);
+    if (name_string.is_error())
+        return;
+    auto* entry = new (nothrow) Entry { parent, name_string.release_value(), move(inode), hash, {} };
+    if (!entry)
+        return;
+
+    EntryList removed_entries;
+    bool did_insert = m_state.with([&](State& state) {
+        if (state.generation != generation)
+            return false;
+        if (state.entries.find(hash, [&](Entry const* other) { return other->matches(parent, name); }) != state.entries.end())
+            return false;
+        if (state.entries.try_set(entry).is_error())
+            return false;
+        auto count = state.entry_count_per_directory.get(parent).value_or(0);
+        if (state.entry_count_per_directory.try_set(parent, count + 1).is_error()) {
+            state.entries.remove(entry);
+            return false;
+        }
+        state.lru_list.prepend(*entry);
+
+        while (state.entries.size() > maximum_entry_count)
+            remove_while_locked(state, *state.lru_list.last(), removed_entries);
+        return true;
+    });
+
+    if (!did_insert) {
+        // Balanced by `new` above
+        delete entry;
+    }
+    destroy(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate(InodeIdentifier parent, StringView name)
+{
+    auto hash = hash_for(parent, name);
+    EntryList removed_entries;
+    m_state.with([&](State& state) {
+        ++state.generation;
+        auto it = state.entries.find(hash, [&](Entry const* entry) { return entry->matches(parent, name); });
+        if (it != state.entries.end())
+            remove_while_locked(state, **it, removed_entries);
+    });
+    destroy(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_directory(InodeIdentifier directory)
+{
+    EntryList removed_entries;
+    m_state.with([&](State& state) {
+        ++state.generation;
+        // Most removed inodes aren't directories with cached entries, so avoid walking the whole cache for them.
+        if (!state.entry_count_per_directory.contains(directory))
+            return;
+        for (auto it = state.lru_list.begin(); it != state.lru_list.end();) {
+            auto& entry = *it;
+            ++it;
+            if (entry.parent == directory)
+                remove_while_locked(state, entry, removed_entries);
+        }
+    });
+    destroy(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_file_system(FileSystemID fsid)
+{
+    EntryList removed_entries;
+    m_state.with([&](State& state) {
+        ++state.generation;
+        for (auto it = state.lru_list.begin(); it != state.lru_list.end();) {
+            auto& entry = *it;
+            ++it;
+            if (entry.parent.fsid() == fsid)
+                remove_while_locked(state, entry, removed_entries);
+        }
+    });
+    destroy(removed_entries);
+}
+
+void DirectoryEntryCache::remove_while_locked(State& state, Entry& entry, EntryList& removed_entries)
+{
+    state.entries.remove(&entry);
+    auto count = state.entry_count_per_directory.find(entry.parent);
+    VERIFY(count != state.entry_count_per_directory.end());
+    if (--count->value == 0)
+        state.entry_count_per_directory.remove(count);
+    removed_entries.append(entry);
+}
+
+void DirectoryEntryCache::destroy(EntryList& removed_entries)
+{
+    // NOTE: This happens outside of our lock, since dropping the last reference to an inode may need to block.
+    while (auto* entry = removed_entries.take_first()) {
+        // Balanced by `new` in insert()
+        delete entry;
+    }
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/InodeIdentifier.h>
+#include <Kernel/KString.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+
+namespace Kernel {
+
+// Remembers the result of Inode::lookup() for recently resolved path components, so that
+// resolving the same paths over and over doesn't have to search the directories every time.
+// Names that don't exist are cached as well (as entries without an inode), because build
+// tools and shells spend a lot of their time probing for files that aren't there.
+//
+// Entries are keyed by the identifier of the directory and the name inside of it, and are
+// dropped whenever a file system adds or removes a child under that name. Only file systems
+// that opt in through FileSystem::supports_directory_entry_cache() are cached.
+class DirectoryEntryCache {
+public:
+    static constexpr size_t maximum_entry_count = 8192;
+
+    static DirectoryEntryCache& the();
+
+    ErrorOr<NonnullRefPtr<Inode>> lookup(Inode& parent, StringView name);
+
+    void invalidate(InodeIdentifier parent, StringView name);
+    void invalidate_directory(InodeIdentifier directory);
+    void invalidate_file_system(FileSystemID);
+
+private:
+    struct Entry {
+        InodeIdentifier parent;
+        NonnullOwnPtr<KString> name;
+        RefPtr<Inode> inode;
+        unsigned hash { 0 };
+        IntrusiveListNode<Entry> list_node;
+
+        bool matches(InodeIdentifier other_parent, StringView other_name) const { return parent == other_parent && name->view() == other_name; }
+    };
+
+    struct EntryTraits : public GenericTraits<Entry*> {
+        static unsigned hash(Entry const* entry) { return entry->hash; }
+        static bool equals(Entry const* a, Entry const* b) { return a->matches(b->parent, b->name->view()); }
+    };
+
+    using EntryList = IntrusiveList<&Entry::list_node>;
+
+    struct State {
+        HashTable<Entry*, EntryTraits> entries;
+        // Least recently used entries are at the end.
+        EntryList lru_list;
+        HashMap<InodeIdentifier, size_t> entry_count_per_directory;
+        // Bumped by every invalidation, so that a lookup that raced with one doesn't cache a stale result.
+        u64 generation { 0 };
+    };
+
+    static unsigned hash_for(InodeIdentifier parent, StringView name);
+
+    void insert(InodeIdentifier parent, StringView name, unsigned hash, RefPtr<Inode>, u64 generation);
+    static void remove_while_locked(State&, Entry&, EntryList& removed_entries);
+    static void destroy(EntryList& removed_entries);
+
+    SpinlockProtected<State, LockRank::None> m_state {};
+};
+
+}
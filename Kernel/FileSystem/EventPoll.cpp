@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+static constexpr u32 supported_event_flags = EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLRDHUP | EPOLLONESHOT | EPOLLET;
+
+static BlockFlags block_flags_for(u32 events)
+{
+    auto block_flags = BlockFlags::None;
+    if (events & EPOLLIN)
+        block_flags |= BlockFlags::Read;
+    if (events & EPOLLOUT)
+        block_flags |= BlockFlags::Write;
+    if (events & EPOLLPRI)
+        block_flags |= BlockFlags::ReadPriority;
+    if (events & EPOLLRDHUP)
+        block_flags |= BlockFlags::ReadHangUp;
+    return block_flags;
+}
+
+static u32 events_for(BlockFlags block_flags)
+{
+    u32 events = 0;
+    if (has_flag(block_flags, BlockFlags::Read))
+        events |= EPOLLIN;
+    if (has_flag(block_flags, BlockFlags::Write))
+        events |= EPOLLOUT;
+    if (has_flag(block_flags, BlockFlags::ReadPriority))
+        events |= EPOLLPRI;
+    if (has_flag(block_flags, BlockFlags::ReadHangUp))
+        events |= EPOLLRDHUP;
+    if (has_flag(block_flags, BlockFlags::WriteError))
+        events |= EPOLLERR;
+    if (has_flag(block_flags, BlockFlags::WriteHangUp))
+        events |= EPOLLHUP;
+    return events;
+}
+
+EventPoll::Watch::Watch(EventPoll& event_poll, int fd, OpenFileDescription& description, epoll_event const& event)
+    : FileReadinessObserver(description, block_flags_for(event.events))
+    , m_event_poll(event_poll)
+    , m_file(description.file())
+    , m_key { fd, &description }
+    , m_events(event.events)
+    , m_data(event.data.u64)
+{
+}
+
+void EventPoll::Watch::update(epoll_event const& event)
+{
+    m_events = event.events;
+    m_data = event.data.u64;
+}
+
+void EventPoll::Watch::observed_description_became_ready(BlockFlags)
+{
+    m_event_poll.queue_ready_watch(*this);
+}
+
+void EventPoll::Watch::observed_description_was_closed()
+{
+    // Let the next wait() notice that this watch is gone.
+    m_event_poll.queue_ready_watch(*this);
+}
+
+ErrorOr<NonnullRefPtr<EventPoll>> EventPoll::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EventPoll);
+}
+
+EventPoll::~EventPoll()
+{
+    (void)close();
+}
+
+bool EventPoll::can_read(OpenFileDescription const&, u64) const
+{
+    SpinlockLocker lock(m_ready_lock);
+    return !m_ready_watches.is_empty();
+}
+
+ErrorOr<void> EventPoll::close()
+{
+    MutexLocker locker(m_lock);
+    for (auto& it : m_watches)
+        remove_watch_locked(*it.value);
+    m_watches.clear();
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EventPoll::pseudo_path(OpenFileDescription const&) const
+{
+    return KString::formatted("EventPoll:({})", m_watches.size());
+}
+
+void EventPoll::queue_ready_watch(Watch& watch)
+{
+    {
+        SpinlockLocker lock(m_ready_lock);
+        if (watch.m_is_queued || watch.m_is_disabled)
+            return;
+        watch.m_is_queued = true;
+        m_ready_watches.append(watch);
+    }
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+void EventPoll::remove_watch_locked(Watch& watch)
+{
+    VERIFY(m_lock.is_exclusively_locked_by_current_thread());
+    // NOTE: Once the watch is no longer observing its file, nobody can queue it anymore.
+    watch.file().blocker_set().remove_observer(watch);
+    SpinlockLocker lock(m_ready_lock);
+    m_ready_watches.remove(watch);
+    watch.m_is_queued = false;
+}
+
+ErrorOr<void> EventPoll::add_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    if (event.events & ~supported_event_flags)
+        return EINVAL;
+    // NOTE: Watching other EventPolls could create cycles between their blocker set locks, so we don't allow it.
+    if (description.is_event_poll())
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    WatchKey key { fd, &description };
+    if (auto it = m_watches.find(key); it != m_watches.end()) {
+        // The description could have been closed, and a new one created at the same address.
+        if (!it->value->file().blocker_set().observed_ready_flags(*it->value).has_value()) {
+            remove_watch_locked(*it->value);
+            m_watches.remove(it);
+        } else {
+            return EEXIST;
+        }
+    }
+
+    auto watch = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Watch(*this, fd, description, event)));
+    auto& watch_ref = *watch;
+    TRY(m_watches.try_set(key, move(watch)));
+    // NOTE: This queues the watch right away if the description is already ready.
+    description.blocker_set().add_observer(watch_ref);
+    return {};
+}
+
+ErrorOr<void> EventPoll::modify_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    if (event.events & ~supported_event_flags)
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    auto it = m_watches.find({ fd, &description });
+    if (it == m_watches.end())
+        return ENOENT;
+    auto& watch = *it->value;
+    watch.update(event);
+    {
+        SpinlockLocker lock(m_ready_lock);
+        watch.m_is_disabled = false;
+    }
+    watch.file().blocker_set().set_observed_flags(watch, block_flags_for(event.events));
+    return {};
+}
+
+ErrorOr<void> EventPoll::remove_watch(int fd, OpenFileDescription& description)
+{
+    MutexLocker locker(m_lock);
+    auto it = m_watches.find({ fd, &description });
+    if (it == m_watches.end())
+        return ENOENT;
+    remove_watch_locked(*it->value);
+    m_watches.remove(it);
+    return {};
+}
+
+ErrorOr<size_t> EventPoll::collect_ready_events(Span<epoll_event> events)
+{
+    MutexLocker locker(m_lock);
+
+    // NOTE: Level-triggered watches that are still ready go back to the end of the list once we're done,
+    //       so only look at the ones that were queued when we started.
+    size_t queued_count = 0;
+    {
+        SpinlockLocker lock(m_ready_lock);
+        queued_count = m_ready_watches.size_slow();
+    }
+
+    Vector<Watch&> still_ready_watches;
+    size_t event_count = 0;
+    for (size_t i = 0; i < queued_count && event_count < events.size(); ++i) {
+        Watch* watch = nullptr;
+        {
+            SpinlockLocker lock(m_ready_lock);
+            watch = m_ready_watches.take_first();
+            if (!watch)
+                break;
+            watch->m_is_queued = false;
+        }
+
+        auto ready_flags = watch->file().blocker_set().observed_ready_flags(*watch);
+        if (!ready_flags.has_value()) {
+            // The description has been closed since.
+            auto key = watch->key();
+            remove_watch_locked(*watch);
+            m_watches.remove(key);
+            continue;
+        }
+
+        auto ready_events = events_for(ready_flags.value()) & watch->events();
+        if (ready_events == 0)
+            continue;
+
+        events[event_count++] = { ready_events, { .u64 = watch->data() } };
+
+        if (watch->events() & EPOLLONESHOT) {
+            SpinlockLocker lock(m_ready_lock);
+            watch->m_is_disabled = true;
+        } else if (!(watch->events() & EPOLLET)) {
+            TRY(still_ready_watches.try_append(*watch));
+        }
+    }
+
+    if (!still_ready_watches.is_empty()) {
+        SpinlockLocker lock(m_ready_lock);
+        for (auto& watch : still_ready_watches) {
+            if (watch.m_is_queued || watch.m_is_disabled)
+                continue;
+            watch.m_is_queued = true;
+            m_ready_watches.append(watch);
+        }
+    }
+
+    return event_count;
+}
+
+ErrorOr<size_t> EventPoll::wait(Span<epoll_event> events, Optional<Thread::BlockTimeout> const& timeout)
+{
+    for (;;) {
+        auto event_count = TRY(collect_ready_events(events));
+        if (event_count > 0 || !timeout.has_value())
+            return event_count;
+
+        auto result = m_wait_queue.wait_on(timeout.value(), "EventPoll"sv);
+        if (result.was_interrupted())
+            return EINTR;
+        if (result == Thread::BlockResult::InterruptedByTimeout)
+            return collect_ready_events(events);
+    }
+}
+
+}
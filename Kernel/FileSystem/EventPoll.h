@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// An EventPoll keeps a persistent list of file descriptions that someone is interested in. Each of them is
+// observed via its file's blocker set, so finding out which ones are ready doesn't require looking at all of them.
+class EventPoll final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<EventPoll>> try_create();
+    virtual ~EventPoll() override;
+
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EventPoll"sv; }
+    virtual bool is_event_poll() const override { return true; }
+
+    ErrorOr<void> add_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove_watch(int fd, OpenFileDescription&);
+
+    // Blocks until at least one watched description is ready, and returns how many events were stored.
+    // Without a timeout, this only collects the events that are pending already.
+    ErrorOr<size_t> wait(Span<epoll_event>, Optional<Thread::BlockTimeout> const&);
+
+private:
+    // NOTE: Like on other systems, a watch is identified by both the fd and the description it was added with.
+    struct WatchKey {
+        int fd { -1 };
+        OpenFileDescription const* description { nullptr };
+
+        bool operator==(WatchKey const&) const = default;
+    };
+
+    struct WatchKeyTraits : public GenericTraits<WatchKey> {
+        static unsigned hash(WatchKey const& key) { return pair_int_hash(int_hash(key.fd), ptr_hash(key.description)); }
+    };
+
+    class Watch final : public FileReadinessObserver {
+    public:
+        Watch(EventPoll&, int fd, OpenFileDescription&, epoll_event const&);
+
+        File& file() { return *m_file; }
+        WatchKey const& key() const { return m_key; }
+
+        u32 events() const { return m_events; }
+        u64 data() const { return m_data; }
+        void update(epoll_event const&);
+
+    private:
+        friend class EventPoll;
+
+        virtual void observed_description_became_ready(BlockFlags) override;
+        virtual void observed_description_was_closed() override;
+
+        EventPoll& m_event_poll;
+        NonnullRefPtr<File> m_file;
+        WatchKey m_key;
+        u32 m_events { 0 };
+        u64 m_data { 0 };
+
+        // NOTE: These are protected by the EventPoll's ready lock.
+        bool m_is_queued { false };
+        bool m_is_disabled { false };
+        IntrusiveListNode<Watch> m_ready_list_node;
+
+    public:
+        using ReadyList = IntrusiveList<&Watch::m_ready_list_node>;
+    };
+
+    EventPoll() = default;
+
+    void queue_ready_watch(Watch&);
+    void remove_watch_locked(Watch&);
+    ErrorOr<size_t> collect_ready_events(Span<epoll_event>);
+
+    Mutex m_lock { "EventPoll"sv };
+    HashMap<WatchKey, NonnullOwnPtr<Watch>, WatchKeyTraits> m_watches;
+
+    mutable Spinlock<LockRank::None> m_ready_lock;
+    Watch::ReadyList m_ready_watches;
+
+    WaitQueue m_wait_queue;
+};
+
+}
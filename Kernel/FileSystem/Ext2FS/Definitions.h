@@ -207,6 +207,42 @@ struct ext2_dx_countlimit {
     __u16 count;
 };
 
+/*
+ * Extent trees (ext4)
+ *
+ * Each node starts with an ext4_extent_header. Leaves (depth 0) hold
+ * ext4_extent entries, interior nodes hold ext4_extent_idx entries.
+ * The root node lives in the i_block array of the inode.
+ */
+#define EXT4_EXT_MAGIC 0xf30a
+#define EXT4_EXT_MAX_DEPTH 5
+
+/* Extents longer than this are "unwritten" (preallocated but not initialized) */
+#define EXT4_EXT_INIT_MAX_LEN (1u << 15)
+#define EXT4_EXT_UNWRITTEN_MAX_LEN (EXT4_EXT_INIT_MAX_LEN - 1)
+
+struct ext4_extent_header {
+    __u16 eh_magic;      /* probably will support different formats */
+    __u16 eh_entries;    /* number of valid entries */
+    __u16 eh_max;        /* capacity of store in entries */
+    __u16 eh_depth;      /* has tree real underlying blocks? */
+    __u32 eh_generation; /* generation of the tree */
+};
+
+struct ext4_extent {
+    __u32 ee_block;    /* first logical block extent covers */
+    __u16 ee_len;      /* number of blocks covered by extent */
+    __u16 ee_start_hi; /* high 16 bits of physical block */
+    __u32 ee_start_lo; /* low 32 bits of physical block */
+};
+
+struct ext4_extent_idx {
+    __u32 ei_block;   /* index covers logical blocks from 'block' */
+    __u32 ei_leaf_lo; /* pointer to the physical block of the next level */
+    __u16 ei_leaf_hi; /* high 16 bits of physical block */
+    __u16 ei_unused;
+};
+
 /*
  * Macro-instructions used to manage group descriptors
  */
@@ -0,0 +1,800 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/IterationDecision.h>
+#include <AK/QuickSort.h>
+#include <Kernel/API/POSIX/errno.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/Ext2FS/DirectoryIndex.h>
+#include <Kernel/FileSystem/Ext2FS/Inode.h>
+
+namespace Kernel {
+
+// The directory hash functions, as implemented by e2fsprogs and Linux. They are part of the
+// on-disk format, so they must match bit for bit, including the signedness of `char`.
+
+static constexpr u32 rotate_left(u32 value, u32 shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+static i32 hash_character(char character, bool is_signed)
+{
+    if (is_signed)
+        return static_cast<i8>(character);
+    return static_cast<u8>(character);
+}
+
+static u32 legacy_hash(StringView name, bool is_signed)
+{
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (auto character : name) {
+        u32 hash = hash1 + (hash0 ^ static_cast<u32>(hash_character(character, is_signed) * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static void string_to_hash_buffer(StringView message, bool is_signed, u32* buffer, int count)
+{
+    u32 padding = static_cast<u32>(message.length()) | (static_cast<u32>(message.length()) << 8);
+    padding |= padding << 16;
+
+    u32 value = padding;
+    auto length = min(message.length(), static_cast<size_t>(count) * 4);
+    for (size_t i = 0; i < length; ++i) {
+        value = static_cast<u32>(hash_character(message[i], is_signed)) + (value << 8);
+        if ((i % 4) == 3) {
+            *buffer++ = value;
+            value = padding;
+            --count;
+        }
+    }
+    if (--count >= 0)
+        *buffer++ = value;
+    while (--count >= 0)
+        *buffer++ = padding;
+}
+
+static void tea_transform(u32 (&buffer)[4], u32 const* input)
+{
+    constexpr u32 delta = 0x9e3779b9;
+    u32 sum = 0;
+    u32 b0 = buffer[0];
+    u32 b1 = buffer[1];
+    for (int i = 0; i < 16; ++i) {
+        sum += delta;
+        b0 += ((b1 << 4) + input[0]) ^ (b1 + sum) ^ ((b1 >> 5) + input[1]);
+        b1 += ((b0 << 4) + input[2]) ^ (b0 + sum) ^ ((b0 >> 5) + input[3]);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
+static void half_md4_transform(u32 (&buffer)[4], u32 const* input)
+{
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+    auto round = [](auto function, u32& a, u32 b, u32 c, u32 d, u32 x, u32 shift) {
+        a = rotate_left(a + function(b, c, d) + x, shift);
+    };
+    constexpr u32 k2 = 0x5a827999;
+    constexpr u32 k3 = 0x6ed9eba1;
+
+    u32 a = buffer[0];
+    u32 b = buffer[1];
+    u32 c = buffer[2];
+    u32 d = buffer[3];
+
+    round(f, a, b, c, d, input[0], 3);
+    round(f, d, a, b, c, input[1], 7);
+    round(f, c, d, a, b, input[2], 11);
+    round(f, b, c, d, a, input[3], 19);
+    round(f, a, b, c, d, input[4], 3);
+    round(f, d, a, b, c, input[5], 7);
+    round(f, c, d, a, b, input[6], 11);
+    round(f, b, c, d, a, input[7], 19);
+
+    round(g, a, b, c, d, input[1] + k2, 3);
+    round(g, d, a, b, c, input[3] + k2, 5);
+    round(g, c, d, a, b, input[5] + k2, 9);
+    round(g, b, c, d, a, input[7] + k2, 13);
+    round(g, a, b, c, d, input[0] + k2, 3);
+    round(g, d, a, b, c, input[2] + k2, 5);
+    round(g, c, d, a, b, input[4] + k2, 9);
+    round(g, b, c, d, a, input[6] + k2, 13);
+
+    round(h, a, b, c, d, input[3] + k3, 3);
+    round(h, d, a, b, c, input[7] + k3, 9);
+    round(h, c, d, a, b, input[2] + k3, 11);
+    round(h, b, c, d, a, input[6] + k3, 15);
+    round(h, a, b, c, d, input[1] + k3, 3);
+    round(h, d, a, b, c, input[5] + k3, 9);
+    round(h, c, d, a, b, input[0] + k3, 11);
+    round(h, b, c, d, a, input[4] + k3, 15);
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+Optional<Ext2FSDirectoryHash> ext2_directory_hash(StringView name, u8 hash_version, u32 const (&seed)[4])
+{
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    if (seed[0] || seed[1] || seed[2] || seed[3]) {
+        for (size_t i = 0; i < 4; ++i)
+            buffer[i] = seed[i];
+    }
+
+    u32 input[8];
+    Ext2FSDirectoryHash hash;
+    switch (hash_version) {
+    case EXT2_HASH_LEGACY:
+    case EXT2_HASH_LEGACY_UNSIGNED:
+        hash.major = legacy_hash(name, hash_version == EXT2_HASH_LEGACY);
+        break;
+    case EXT2_HASH_HALF_MD4:
+    case EXT2_HASH_HALF_MD4_UNSIGNED:
+        for (size_t offset = 0; offset < name.length(); offset += 32) {
+            string_to_hash_buffer(name.substring_view(offset), hash_version == EXT2_HASH_HALF_MD4, input, 8);
+            half_md4_transform(buffer, input);
+        }
+        hash.major = buffer[1];
+        hash.minor = buffer[2];
+        break;
+    case EXT2_HASH_TEA:
+    case EXT2_HASH_TEA_UNSIGNED:
+        for (size_t offset = 0; offset < name.length(); offset += 16) {
+            string_to_hash_buffer(name.substring_view(offset), hash_version == EXT2_HASH_TEA, input, 4);
+            tea_transform(buffer, input);
+        }
+        hash.major = buffer[0];
+        hash.minor = buffer[1];
+        break;
+    default:
+        return {};
+    }
+
+    // The lowest bit is reserved for the collision marker, and the highest possible value
+    // means "end of directory" to readdir() cookies on Linux.
+    hash.major &= ~ext2_directory_index_collision_bit;
+    if (hash.major == (0x7fffffffu << 1))
+        hash.major = (0x7fffffffu - 1) << 1;
+    return hash;
+}
+
+// Only the lower 28 bits of an index entry's block number are used, the rest is reserved.
+static constexpr u32 index_entry_block_mask = 0x0fffffff;
+
+struct Ext2FSDirectoryIndexPath {
+    struct Level {
+        u64 block { 0 };
+        ByteBuffer data;
+        size_t entries_offset { 0 };
+        size_t position { 0 };
+
+        // NOTE: The count and limit live where the hash of the first entry would be.
+        ext2_dx_countlimit& count_limit() { return *reinterpret_cast<ext2_dx_countlimit*>(data.data() + entries_offset); }
+        ext2_dx_entry* entries() { return reinterpret_cast<ext2_dx_entry*>(data.data() + entries_offset); }
+        ext2_dx_entry& current() { return entries()[position]; }
+        u64 current_block() { return current().block & index_entry_block_mask; }
+        bool is_full() { return count_limit().count >= count_limit().limit; }
+    };
+
+    ext2_dx_root_info& root_info() { return *reinterpret_cast<ext2_dx_root_info*>(levels[0].data.data() + ext2_directory_index_root_info_offset); }
+
+    Vector<Level, ext2_directory_index_maximum_indirect_levels + 1> levels;
+    u32 hash { 0 };
+};
+
+struct Ext2FSDirectoryIndexLocation {
+    u64 block { 0 };
+    ByteBuffer data;
+    size_t offset { 0 };
+    Optional<size_t> previous_offset;
+};
+
+static ext2_dir_entry_2& directory_entry_at(Bytes block, size_t offset)
+{
+    return *reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+}
+
+static void write_directory_entry(Bytes block, size_t offset, size_t record_length, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    auto& entry = directory_entry_at(block, offset);
+    entry.inode = inode_index.value();
+    entry.rec_len = record_length;
+    entry.name_len = name.length();
+    entry.file_type = file_type;
+    memcpy(entry.name, name.characters_without_null_termination(), name.length());
+}
+
+template<typename Callback>
+static ErrorOr<void> for_each_entry_in_block(Bytes block, Callback callback)
+{
+    size_t offset = 0;
+    while (offset < block.size()) {
+        if (block.size() - offset < 8)
+            return EIO;
+        auto& entry = directory_entry_at(block, offset);
+        if (entry.rec_len < 8 || entry.rec_len % 4 != 0 || entry.rec_len > block.size() - offset || entry.name_len + 8u > entry.rec_len)
+            return EIO;
+        if (callback(offset, entry) == IterationDecision::Break)
+            return {};
+        offset += entry.rec_len;
+    }
+    return {};
+}
+
+static size_t index_entry_limit(size_t block_size, size_t entries_offset)
+{
+    return (block_size - entries_offset) / sizeof(ext2_dx_entry);
+}
+
+static void initialize_index_node(Bytes block)
+{
+    memset(block.data(), 0, block.size());
+    auto& fake_entry = directory_entry_at(block, 0);
+    fake_entry.inode = 0;
+    fake_entry.rec_len = block.size();
+}
+
+bool Ext2FSInode::has_directory_index() const
+{
+    return is_directory() && (m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().has_directory_index_feature();
+}
+
+Optional<Ext2FSDirectoryHash> Ext2FSInode::directory_index_hash(StringView name, u8 hash_version) const
+{
+    auto const& super_block = fs().super_block();
+    // The signed and unsigned variants only exist in memory, the index itself always stores the signed one.
+    if (hash_version <= EXT2_HASH_TEA && (super_block.s_flags & EXT2_FLAGS_UNSIGNED_HASH))
+        hash_version += EXT2_HASH_LEGACY_UNSIGNED;
+    return ext2_directory_hash(name, hash_version, super_block.s_hash_seed);
+}
+
+ErrorOr<ByteBuffer> Ext2FSInode::read_directory_block(u64 block) const
+{
+    auto block_size = fs().block_size();
+    if ((block + 1) * block_size > size())
+        return EIO;
+    auto data = TRY(ByteBuffer::create_uninitialized(block_size));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(data.data());
+    auto nread = TRY(read_bytes(block * block_size, block_size, buffer, nullptr));
+    if (nread != block_size)
+        return EIO;
+    return data;
+}
+
+ErrorOr<void> Ext2FSInode::write_directory_block(u64 block, ReadonlyBytes data)
+{
+    auto block_size = fs().block_size();
+    VERIFY(data.size() == block_size);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(data.data()));
+    auto nwritten = TRY(write_bytes(block * block_size, block_size, buffer, nullptr));
+    if (nwritten != block_size)
+        return EIO;
+    return {};
+}
+
+ErrorOr<u64> Ext2FSInode::append_directory_block()
+{
+    auto block_size = fs().block_size();
+    auto new_block = size() / block_size;
+    TRY(resize((new_block + 1) * block_size));
+    return new_block;
+}
+
+ErrorOr<void> Ext2FSInode::read_directory_index_level(Ext2FSDirectoryIndexPath& path, size_t level, u64 block)
+{
+    auto block_size = fs().block_size();
+    if (block == 0 || (block + 1) * block_size > size()) {
+        dbgln("Ext2FSInode[{}]: Directory index points at invalid block {}", identifier(), block);
+        return EIO;
+    }
+
+    auto data = TRY(read_directory_block(block));
+    if (level == path.levels.size())
+        TRY(path.levels.try_append({ block, move(data), ext2_directory_index_node_entries_offset, 0 }));
+    else
+        path.levels[level] = { block, move(data), ext2_directory_index_node_entries_offset, 0 };
+
+    auto& count_limit = path.levels[level].count_limit();
+    if (count_limit.limit != index_entry_limit(block_size, ext2_directory_index_node_entries_offset) || count_limit.count == 0 || count_limit.count > count_limit.limit) {
+        dbgln("Ext2FSInode[{}]: Directory index node in block {} is corrupt", identifier(), block);
+        return EIO;
+    }
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::probe_directory_index(StringView name, Ext2FSDirectoryIndexPath& path)
+{
+    auto block_size = fs().block_size();
+    auto root = TRY(read_directory_block(0));
+    TRY(path.levels.try_append({ 0, move(root), ext2_directory_index_root_entries_offset, 0 }));
+
+    auto& root_info = path.root_info();
+    auto& root_count_limit = path.levels[0].count_limit();
+    if (root_info.reserved_zero != 0 || root_info.info_length != 8 || root_info.indirect_levels > ext2_directory_index_maximum_indirect_levels
+        || root_count_limit.limit != index_entry_limit(block_size, ext2_directory_index_root_entries_offset)
+        || root_count_limit.count == 0 || root_count_limit.count > root_count_limit.limit) {
+        dbgln("Ext2FSInode[{}]: Directory index root is corrupt", identifier());
+        return EIO;
+    }
+
+    auto hash = directory_index_hash(name, root_info.hash_version);
+    if (!hash.has_value()) {
+        dbgln("Ext2FSInode[{}]: Directory index uses unknown hash version {}", identifier(), root_info.hash_version);
+        return EIO;
+    }
+    path.hash = hash->major;
+
+    auto indirect_levels = root_info.indirect_levels;
+    for (size_t level = 0;; ++level) {
+        auto& current = path.levels[level];
+        // Find the last entry whose hash is at most ours. The first entry implicitly covers everything below the second one.
+        auto* entries = current.entries();
+        size_t low = 1;
+        size_t high = current.count_limit().count;
+        while (low < high) {
+            auto middle = low + (high - low) / 2;
+            if (entries[middle].hash > path.hash)
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        current.position = low - 1;
+
+        if (level == indirect_levels)
+            break;
+        TRY(read_directory_index_level(path, level + 1, current.current_block()));
+    }
+
+    auto leaf_block = path.levels.last().current_block();
+    if (leaf_block == 0 || (leaf_block + 1) * block_size > size()) {
+        dbgln("Ext2FSInode[{}]: Directory index points at invalid leaf block {}", identifier(), leaf_block);
+        return EIO;
+    }
+    return {};
+}
+
+ErrorOr<bool> Ext2FSInode::advance_to_next_directory_index_leaf(Ext2FSDirectoryIndexPath& path)
+{
+    // Names with the same hash may spill over into the following leaves, which then have the
+    // collision bit set in the index entry that points to them.
+    size_t level = path.levels.size() - 1;
+    for (;;) {
+        auto& current = path.levels[level];
+        if (current.position + 1 < current.count_limit().count) {
+            ++current.position;
+            break;
+        }
+        if (level == 0)
+            return false;
+        --level;
+    }
+
+    auto next_hash = path.levels[level].current().hash;
+    if (!(next_hash & ext2_directory_index_collision_bit) || (next_hash & ~ext2_directory_index_collision_bit) != path.hash)
+        return false;
+
+    for (++level; level < path.levels.size(); ++level)
+        TRY(read_directory_index_level(path, level, path.levels[level - 1].current_block()));
+    return true;
+}
+
+ErrorOr<Ext2FSDirectoryIndexLocation> Ext2FSInode::find_in_directory_index(StringView name)
+{
+    auto find_in_block = [&](u64 block) -> ErrorOr<Optional<Ext2FSDirectoryIndexLocation>> {
+        Ext2FSDirectoryIndexLocation location { block, TRY(read_directory_block(block)), 0, {} };
+        bool found = false;
+        Optional<size_t> previous_offset;
+        TRY(for_each_entry_in_block(location.data.bytes(), [&](size_t offset, auto& entry) {
+            if (entry.inode != 0 && name == StringView { entry.name, entry.name_len }) {
+                location.offset = offset;
+                location.previous_offset = previous_offset;
+                found = true;
+                return IterationDecision::Break;
+            }
+            previous_offset = offset;
+            return IterationDecision::Continue;
+        }));
+        if (!found)
+            return Optional<Ext2FSDirectoryIndexLocation> {};
+        return location;
+    };
+
+    // "." and ".." aren't part of the index, but always live at the start of the root block.
+    if (name == "."sv || name == ".."sv) {
+        auto location = TRY(find_in_block(0));
+        if (!location.has_value())
+            return ENOENT;
+        return location.release_value();
+    }
+
+    Ext2FSDirectoryIndexPath path;
+    TRY(probe_directory_index(name, path));
+    do {
+        auto location = TRY(find_in_block(path.levels.last().current_block()));
+        if (location.has_value())
+            return location.release_value();
+    } while (TRY(advance_to_next_directory_index_leaf(path)));
+
+    return ENOENT;
+}
+
+ErrorOr<InodeIndex> Ext2FSInode::lookup_in_directory_index(StringView name)
+{
+    VERIFY(m_inode_lock.is_locked());
+    auto location = TRY(find_in_directory_index(name));
+    return InodeIndex { directory_entry_at(location.data.bytes(), location.offset).inode };
+}
+
+ErrorOr<void> Ext2FSInode::add_entry_to_directory_index(StringView name, InodeIndex inode_index, u8 file_type)
+{
+    VERIFY(m_inode_lock.is_exclusively_locked_by_current_thread());
+    auto record_length = EXT2_DIR_REC_LEN(name.length());
+
+    // Every attempt either finds room for the new entry in its leaf, or splits whatever is
+    // full (the leaf or an index node above it) and tries again.
+    constexpr size_t maximum_attempts = 2 * (ext2_directory_index_maximum_indirect_levels + 2);
+    for (size_t attempt = 0; attempt < maximum_attempts; ++attempt) {
+        Ext2FSDirectoryIndexPath path;
+        TRY(probe_directory_index(name, path));
+        auto leaf_block = path.levels.last().current_block();
+        auto leaf = TRY(read_directory_block(leaf_block));
+
+        Optional<size_t> free_offset;
+        TRY(for_each_entry_in_block(leaf.bytes(), [&](size_t offset, auto& entry) {
+            size_t used = entry.inode != 0 ? EXT2_DIR_REC_LEN(entry.name_len) : 0;
+            if (entry.rec_len - used < record_length)
+                return IterationDecision::Continue;
+            free_offset = offset + used;
+            if (used != 0) {
+                // Give the free space at the end of this entry to the new one.
+                auto available = entry.rec_len - used;
+                entry.rec_len = used;
+                write_directory_entry(leaf.bytes(), offset + used, available, name, inode_index, file_type);
+            } else {
+                write_directory_entry(leaf.bytes(), offset, entry.rec_len, name, inode_index, file_type);
+            }
+            return IterationDecision::Break;
+        }));
+        if (free_offset.has_value())
+            return write_directory_block(leaf_block, leaf);
+
+        if (!path.levels.last().is_full()) {
+            TRY(split_directory_index_leaf(path, leaf_block, leaf));
+            continue;
+        }
+
+        // Find the highest full node on our path whose parent still has room, and split it.
+        // If everything up to the root is full, the tree has to grow a level instead.
+        size_t level = path.levels.size() - 1;
+        while (level > 0 && path.levels[level - 1].is_full())
+            --level;
+        if (level > 0) {
+            TRY(split_directory_index_node(path, level));
+            continue;
+        }
+        if (path.root_info().indirect_levels >= ext2_directory_index_maximum_indirect_levels_to_create) {
+            dbgln("Ext2FSInode[{}]: Directory index is full", identifier());
+            return ENOSPC;
+        }
+        TRY(grow_directory_index(path));
+    }
+
+    dbgln("Ext2FSInode[{}]: Couldn't make room for '{}' in the directory index", identifier(), name);
+    return EIO;
+}
+
+ErrorOr<void> Ext2FSInode::insert_into_directory_index_level(Ext2FSDirectoryIndexPath& path, size_t level, u32 hash, u64 block)
+{
+    auto& node = path.levels[level];
+    auto& count_limit = node.count_limit();
+    VERIFY(count_limit.count < count_limit.limit);
+
+    // NOTE: The new entry always goes after the one we came through, so the first entry (and thus the count) stays in place.
+    auto* entries = node.entries();
+    auto position = node.position + 1;
+    memmove(&entries[position + 1], &entries[position], (count_limit.count - position) * sizeof(ext2_dx_entry));
+    entries[position].hash = hash;
+    entries[position].block = block;
+    ++count_limit.count;
+    return write_directory_block(node.block, node.data);
+}
+
+ErrorOr<void> Ext2FSInode::split_directory_index_leaf(Ext2FSDirectoryIndexPath& path, u64 leaf_block, ByteBuffer& leaf)
+{
+    struct HashedEntry {
+        Ext2FSDirectoryHash hash;
+        size_t offset { 0 };
+        size_t record_length { 0 };
+    };
+
+    auto hash_version = path.root_info().hash_version;
+    Vector<HashedEntry> entries;
+    size_t total_length = 0;
+    Optional<Error> error;
+    TRY(for_each_entry_in_block(leaf.bytes(), [&](size_t offset, auto& entry) {
+        if (entry.inode == 0)
+            return IterationDecision::Continue;
+        auto hash = directory_index_hash({ entry.name, entry.name_len }, hash_version);
+        VERIFY(hash.has_value());
+        size_t record_length = EXT2_DIR_REC_LEN(entry.name_len);
+        if (auto result = entries.try_append({ hash.value(), offset, record_length }); result.is_error()) {
+            error = result.release_error();
+            return IterationDecision::Break;
+        }
+        total_length += record_length;
+        return IterationDecision::Continue;
+    }));
+    if (error.has_value())
+        return error.release_value();
+    if (entries.size() < 2) {
+        dbgln("Ext2FSInode[{}]: Can't split directory index leaf in block {}", identifier(), leaf_block);
+        return EIO;
+    }
+
+    quick_sort(entries, [](HashedEntry const& a, HashedEntry const& b) {
+        if (a.hash.major != b.hash.major)
+            return a.hash.major < b.hash.major;
+        return a.hash.minor < b.hash.minor;
+    });
+
+    // Move the upper half of the entries (by size) into a new leaf.
+    size_t split = 0;
+    size_t kept_length = 0;
+    while (split < entries.size() - 1 && kept_length + entries[split].record_length <= total_length / 2)
+        kept_length += entries[split++].record_length;
+    split = max<size_t>(split, 1);
+
+    auto split_hash = entries[split].hash.major;
+    if (entries[split - 1].hash.major == split_hash)
+        split_hash |= ext2_directory_index_collision_bit;
+
+    auto block_size = fs().block_size();
+    auto old_leaf = TRY(ByteBuffer::copy(leaf.bytes()));
+    auto new_leaf = TRY(ByteBuffer::create_zeroed(block_size));
+    auto write_entries = [&](Bytes block, Span<HashedEntry const> hashed_entries) {
+        memset(block.data(), 0, block.size());
+        size_t offset = 0;
+        for (size_t i = 0; i < hashed_entries.size(); ++i) {
+            auto& entry = directory_entry_at(old_leaf.bytes(), hashed_entries[i].offset);
+            auto record_length = i + 1 == hashed_entries.size() ? block.size() - offset : hashed_entries[i].record_length;
+            write_directory_entry(block, offset, record_length, { entry.name, entry.name_len }, entry.inode, entry.file_type);
+            offset += hashed_entries[i].record_length;
+        }
+    };
+    write_entries(leaf.bytes(), entries.span().slice(0, split));
+    write_entries(new_leaf.bytes(), entries.span().slice(split));
+
+    auto new_leaf_block = TRY(append_directory_block());
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::split_directory_index_leaf(): Moving {} of {} entries from block {} to {}", identifier(), entries.size() - split, entries.size(), leaf_block, new_leaf_block);
+
+    TRY(write_directory_block(new_leaf_block, new_leaf));
+    TRY(write_directory_block(leaf_block, leaf));
+    return insert_into_directory_index_level(path, path.levels.size() - 1, split_hash, new_leaf_block);
+}
+
+ErrorOr<void> Ext2FSInode::split_directory_index_node(Ext2FSDirectoryIndexPath& path, size_t level)
+{
+    VERIFY(level > 0);
+    auto block_size = fs().block_size();
+    auto new_node_block = TRY(append_directory_block());
+    auto new_node = TRY(ByteBuffer::create_uninitialized(block_size));
+    initialize_index_node(new_node.bytes());
+
+    auto& node = path.levels[level];
+    auto count = node.count_limit().count;
+    auto kept = count / 2;
+    auto split_hash = node.entries()[kept].hash;
+
+    auto* new_entries = reinterpret_cast<ext2_dx_entry*>(new_node.data() + ext2_directory_index_node_entries_offset);
+    memcpy(new_entries, node.entries() + kept, (count - kept) * sizeof(ext2_dx_entry));
+    // NOTE: This overwrites the hash of the first moved entry, which now lives in the parent instead.
+    auto& new_count_limit = *reinterpret_cast<ext2_dx_countlimit*>(new_entries);
+    new_count_limit.limit = index_entry_limit(block_size, ext2_directory_index_node_entries_offset);
+    new_count_limit.count = count - kept;
+    node.count_limit().count = kept;
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::split_directory_index_node(): Moving {} of {} index entries from block {} to {}", identifier(), count - kept, count, node.block, new_node_block);
+
+    TRY(write_directory_block(new_node_block, new_node));
+    TRY(write_directory_block(node.block, node.data));
+    return insert_into_directory_index_level(path, level - 1, split_hash, new_node_block);
+}
+
+ErrorOr<void> Ext2FSInode::grow_directory_index(Ext2FSDirectoryIndexPath& path)
+{
+    // Move all of the root's entries into a new node, and make that the only child of the root.
+    auto block_size = fs().block_size();
+    auto new_node_block = TRY(append_directory_block());
+    auto new_node = TRY(ByteBuffer::create_uninitialized(block_size));
+    initialize_index_node(new_node.bytes());
+
+    auto& root = path.levels[0];
+    auto count = root.count_limit().count;
+    auto* new_entries = reinterpret_cast<ext2_dx_entry*>(new_node.data() + ext2_directory_index_node_entries_offset);
+    memcpy(new_entries, root.entries(), count * sizeof(ext2_dx_entry));
+    auto& new_count_limit = *reinterpret_cast<ext2_dx_countlimit*>(new_entries);
+    new_count_limit.limit = index_entry_limit(block_size, ext2_directory_index_node_entries_offset);
+    new_count_limit.count = count;
+
+    root.count_limit().count = 1;
+    root.entries()[0].block = new_node_block;
+    ++path.root_info().indirect_levels;
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::grow_directory_index(): Directory index now has {} levels", identifier(), path.root_info().indirect_levels + 1);
+
+    TRY(write_directory_block(new_node_block, new_node));
+    return write_directory_block(0, root.data);
+}
+
+ErrorOr<InodeIndex> Ext2FSInode::remove_entry_from_directory_index(StringView name)
+{
+    VERIFY(m_inode_lock.is_exclusively_locked_by_current_thread());
+    auto location = TRY(find_in_directory_index(name));
+    auto& entry = directory_entry_at(location.data.bytes(), location.offset);
+    InodeIndex inode_index = entry.inode;
+
+    // Leaves are never merged again, the space simply becomes available for new entries.
+    if (location.previous_offset.has_value())
+        directory_entry_at(location.data.bytes(), location.previous_offset.value()).rec_len += entry.rec_len;
+    else
+        entry.inode = 0;
+
+    TRY(write_directory_block(location.block, location.data));
+    return inode_index;
+}
+
+ErrorOr<InodeIndex> Ext2FSInode::replace_entry_in_directory_index(StringView name, InodeIndex inode_index, u8 file_type)
+{
+    VERIFY(m_inode_lock.is_exclusively_locked_by_current_thread());
+    auto location = TRY(find_in_directory_index(name));
+    auto& entry = directory_entry_at(location.data.bytes(), location.offset);
+    InodeIndex old_inode_index = entry.inode;
+    entry.inode = inode_index.value();
+    entry.file_type = file_type;
+    TRY(write_directory_block(location.block, location.data));
+    return old_inode_index;
+}
+
+ErrorOr<bool> Ext2FSInode::write_indexed_directory(Vector<Ext2FSDirectoryEntry>& entries)
+{
+    VERIFY(m_inode_lock.is_exclusively_locked_by_current_thread());
+    if (!is_directory() || !fs().has_directory_index_feature())
+        return false;
+    if (entries.size() < 3 || entries[0].name->view() != "."sv || entries[1].name->view() != ".."sv)
+        return false;
+
+    struct HashedEntry {
+        Ext2FSDirectoryHash hash;
+        size_t index { 0 };
+    };
+
+    auto hash_version = fs().super_block().s_def_hash_version;
+    Vector<HashedEntry> hashed_entries;
+    TRY(hashed_entries.try_ensure_capacity(entries.size() - 2));
+    for (size_t i = 2; i < entries.size(); ++i) {
+        auto hash = directory_index_hash(entries[i].name->view(), hash_version);
+        if (!hash.has_value())
+            return false;
+        hashed_entries.unchecked_append({ hash.value(), i });
+    }
+    quick_sort(hashed_entries, [](HashedEntry const& a, HashedEntry const& b) {
+        if (a.hash.major != b.hash.major)
+            return a.hash.major < b.hash.major;
+        return a.hash.minor < b.hash.minor;
+    });
+
+    // Fill up the leaves in hash order.
+    struct Leaf {
+        u32 hash { 0 };
+        size_t first_entry { 0 };
+        size_t entry_count { 0 };
+    };
+
+    auto block_size = fs().block_size();
+    Vector<Leaf> leaves;
+    size_t used_in_leaf = 0;
+    for (size_t i = 0; i < hashed_entries.size(); ++i) {
+        auto record_length = EXT2_DIR_REC_LEN(entries[hashed_entries[i].index].name->length());
+        if (leaves.is_empty() || used_in_leaf + record_length > block_size) {
+            auto hash = hashed_entries[i].hash.major;
+            if (i > 0 && hashed_entries[i - 1].hash.major == hash)
+                hash |= ext2_directory_index_collision_bit;
+            TRY(leaves.try_append({ hash, i, 0 }));
+            used_in_leaf = 0;
+        }
+        ++leaves.last().entry_count;
+        used_in_leaf += record_length;
+    }
+
+    auto root_limit = index_entry_limit(block_size, ext2_directory_index_root_entries_offset);
+    auto node_limit = index_entry_limit(block_size, ext2_directory_index_node_entries_offset);
+    u8 indirect_levels = leaves.size() > root_limit ? 1 : 0;
+    size_t node_count = indirect_levels ? ceil_div(leaves.size(), node_limit) : 0;
+    if (node_count > root_limit)
+        return false;
+
+    // Block 0 is the root, followed by the leaves and then the interior nodes (if any).
+    auto directory_data = TRY(ByteBuffer::create_zeroed((1 + leaves.size() + node_count) * block_size));
+    auto block_at = [&](size_t block) { return directory_data.bytes().slice(block * block_size, block_size); };
+
+    auto root = block_at(0);
+    write_directory_entry(root, 0, 12, "."sv, entries[0].inode_index, entries[0].file_type);
+    write_directory_entry(root, 12, block_size - 12, ".."sv, entries[1].inode_index, entries[1].file_type);
+    auto& root_info = *reinterpret_cast<ext2_dx_root_info*>(root.data() + ext2_directory_index_root_info_offset);
+    root_info.hash_version = hash_version;
+    root_info.info_length = 8;
+    root_info.indirect_levels = indirect_levels;
+
+    for (size_t leaf_index = 0; leaf_index < leaves.size(); ++leaf_index) {
+        auto& leaf = leaves[leaf_index];
+        auto block = block_at(1 + leaf_index);
+        size_t offset = 0;
+        for (size_t i = 0; i < leaf.entry_count; ++i) {
+            auto& entry = entries[hashed_entries[leaf.first_entry + i].index];
+            auto record_length = EXT2_DIR_REC_LEN(entry.name->length());
+            if (i + 1 == leaf.entry_count)
+                record_length = block_size - offset;
+            write_directory_entry(block, offset, record_length, entry.name->view(), entry.inode_index, entry.file_type);
+            offset += record_length;
+        }
+    }
+
+    auto write_index_entries = [&](Bytes block, size_t entries_offset, size_t limit, size_t count, auto hash_and_block_for) {
+        auto* index_entries = reinterpret_cast<ext2_dx_entry*>(block.data() + entries_offset);
+        for (size_t i = 0; i < count; ++i) {
+            auto index_entry = hash_and_block_for(i);
+            if (i > 0)
+                index_entries[i].hash = index_entry.hash;
+            index_entries[i].block = index_entry.block;
+        }
+        auto& count_limit = *reinterpret_cast<ext2_dx_countlimit*>(index_entries);
+        count_limit.limit = limit;
+        count_limit.count = count;
+    };
+    auto leaf_entry = [&](size_t leaf_index) { return ext2_dx_entry { leaves[leaf_index].hash, static_cast<u32>(1 + leaf_index) }; };
+
+    if (indirect_levels == 0) {
+        write_index_entries(root, ext2_directory_index_root_entries_offset, root_limit, leaves.size(), leaf_entry);
+    } else {
+        auto first_node_block = 1 + leaves.size();
+        for (size_t node_index = 0; node_index < node_count; ++node_index) {
+            auto node = block_at(first_node_block + node_index);
+            initialize_index_node(node);
+            auto first_leaf = node_index * node_limit;
+            auto leaf_count = min(node_limit, leaves.size() - first_leaf);
+            write_index_entries(node, ext2_directory_index_node_entries_offset, node_limit, leaf_count, [&](size_t i) { return leaf_entry(first_leaf + i); });
+        }
+        write_index_entries(root, ext2_directory_index_root_entries_offset, root_limit, node_count, [&](size_t node_index) {
+            return ext2_dx_entry { leaves[node_index * node_limit].hash, static_cast<u32>(first_node_block + node_index) };
+        });
+    }
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_indexed_directory(): Indexing {} entries in {} leaves", identifier(), hashed_entries.size(), leaves.size());
+
+    TRY(resize(directory_data.size()));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(directory_data.data());
+    auto nwritten = TRY(write_bytes(0, directory_data.size(), buffer, nullptr));
+    if (nwritten != directory_data.size())
+        return EIO;
+
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    return true;
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Hash-indexed ("htree") directories, as introduced by ext3 and used by ext4.
+//
+// The first block of an indexed directory contains the "." and ".." entries, followed by
+// the root of a shallow B-tree that maps name hashes to the directory blocks holding the
+// entries. All other blocks are either ordinary directory blocks (the leaves), or interior
+// index nodes that disguise themselves as a single empty directory entry. This keeps the
+// directory readable by code that doesn't know about the index at all.
+
+struct Ext2FSDirectoryIndexPath;
+struct Ext2FSDirectoryIndexLocation;
+
+struct Ext2FSDirectoryHash {
+    u32 major { 0 };
+    u32 minor { 0 };
+};
+
+// Returns an empty Optional for unknown hash versions.
+Optional<Ext2FSDirectoryHash> ext2_directory_hash(StringView name, u8 hash_version, u32 const (&seed)[4]);
+
+// The hash is stored in index entries without its lowest bit, which is used to mark entries
+// whose leaf continues a run of names with the same hash from the previous leaf.
+static constexpr u32 ext2_directory_index_collision_bit = 1;
+
+// Offsets inside the first block of an indexed directory.
+static constexpr size_t ext2_directory_index_root_info_offset = 24;
+static constexpr size_t ext2_directory_index_root_entries_offset = 32;
+// Interior nodes begin with a fake, empty directory entry that spans the whole block.
+static constexpr size_t ext2_directory_index_node_entries_offset = 8;
+
+// Without the "largedir" feature, ext4 only allows a root plus a single level of interior
+// nodes. We read deeper indexes, but don't create them ourselves.
+static constexpr u8 ext2_directory_index_maximum_indirect_levels = 2;
+static constexpr u8 ext2_directory_index_maximum_indirect_levels_to_create = 1;
+
+}
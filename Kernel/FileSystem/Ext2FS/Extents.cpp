@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <Kernel/API/POSIX/errno.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/Ext2FS/Extents.h>
+#include <Kernel/FileSystem/Ext2FS/Inode.h>
+
+namespace Kernel {
+
+void ext2_initialize_extent_tree_root(ext2_inode& e2inode)
+{
+    memset(e2inode.i_block, 0, sizeof(e2inode.i_block));
+    auto& header = *reinterpret_cast<ext4_extent_header*>(e2inode.i_block);
+    header.eh_magic = EXT4_EXT_MAGIC;
+    header.eh_max = ext2_extent_tree_root_entry_count;
+}
+
+static size_t extent_tree_entries_per_block(size_t block_size)
+{
+    return (block_size - sizeof(ext4_extent_header)) / sizeof(ext4_extent);
+}
+
+static void write_extent_tree_node(Bytes node, u16 depth, size_t maximum_entry_count, Span<Ext2FSExtent const> extents, Span<ext4_extent_idx const> index_entries)
+{
+    node.fill(0);
+    auto& header = *reinterpret_cast<ext4_extent_header*>(node.data());
+    header.eh_magic = EXT4_EXT_MAGIC;
+    header.eh_max = maximum_entry_count;
+    header.eh_depth = depth;
+
+    if (depth != 0) {
+        VERIFY(index_entries.size() <= maximum_entry_count);
+        header.eh_entries = index_entries.size();
+        memcpy(node.offset(sizeof(ext4_extent_header)), index_entries.data(), index_entries.size() * sizeof(ext4_extent_idx));
+        return;
+    }
+
+    VERIFY(extents.size() <= maximum_entry_count);
+    header.eh_entries = extents.size();
+    auto* entries = reinterpret_cast<ext4_extent*>(node.offset(sizeof(ext4_extent_header)));
+    for (size_t i = 0; i < extents.size(); ++i) {
+        auto const& extent = extents[i];
+        entries[i].ee_block = extent.logical_block;
+        entries[i].ee_len = extent.length + (extent.unwritten ? EXT4_EXT_INIT_MAX_LEN : 0);
+        entries[i].ee_start_hi = extent.physical_block >> 32;
+        entries[i].ee_start_lo = extent.physical_block & 0xffffffff;
+    }
+}
+
+bool Ext2FSInode::uses_extents() const
+{
+    return m_raw_inode.i_flags & EXT4_EXTENTS_FL;
+}
+
+ErrorOr<void> Ext2FSInode::read_extent_tree(ext2_inode const& e2inode, Vector<Ext2FSExtent>& extents, Vector<BlockBasedFileSystem::BlockIndex>* tree_blocks) const
+{
+    return read_extent_tree_node({ reinterpret_cast<u8 const*>(e2inode.i_block), sizeof(e2inode.i_block) }, {}, extents, tree_blocks);
+}
+
+ErrorOr<void> Ext2FSInode::read_extent_tree_node(ReadonlyBytes node, Optional<u16> expected_depth, Vector<Ext2FSExtent>& extents, Vector<BlockBasedFileSystem::BlockIndex>* tree_blocks) const
+{
+    auto const& header = *reinterpret_cast<ext4_extent_header const*>(node.data());
+    if (header.eh_magic != EXT4_EXT_MAGIC || header.eh_depth > EXT4_EXT_MAX_DEPTH || header.eh_entries > header.eh_max
+        || sizeof(ext4_extent_header) + header.eh_max * sizeof(ext4_extent) > node.size()
+        || (expected_depth.has_value() && header.eh_depth != expected_depth.value())) {
+        dbgln("Ext2FSInode[{}]::read_extent_tree_node(): Bad extent tree node (magic {:#04x}, depth {}, {}/{} entries)", identifier(), header.eh_magic, header.eh_depth, header.eh_entries, header.eh_max);
+        return EIO;
+    }
+
+    if (header.eh_depth == 0) {
+        auto const* entries = reinterpret_cast<ext4_extent const*>(node.offset(sizeof(ext4_extent_header)));
+        for (size_t i = 0; i < header.eh_entries; ++i) {
+            Ext2FSExtent extent;
+            extent.logical_block = entries[i].ee_block;
+            extent.physical_block = static_cast<u64>(entries[i].ee_start_hi) << 32 | entries[i].ee_start_lo;
+            extent.length = entries[i].ee_len;
+            if (extent.length > EXT4_EXT_INIT_MAX_LEN) {
+                extent.length -= EXT4_EXT_INIT_MAX_LEN;
+                extent.unwritten = true;
+            }
+
+            // Extents have to be sorted and must not overlap.
+            bool overlaps_previous = !extents.is_empty() && extent.logical_block < extents.last().logical_block + extents.last().length;
+            if (extent.length == 0 || extent.physical_block == 0 || overlaps_previous) {
+                dbgln("Ext2FSInode[{}]::read_extent_tree_node(): Bad extent {}+{} -> {}", identifier(), extent.logical_block, extent.length, extent.physical_block);
+                return EIO;
+            }
+            TRY(extents.try_append(extent));
+        }
+        return {};
+    }
+
+    auto block_contents = TRY(ByteBuffer::create_uninitialized(fs().block_size()));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(block_contents.data());
+    auto const* entries = reinterpret_cast<ext4_extent_idx const*>(node.offset(sizeof(ext4_extent_header)));
+    for (size_t i = 0; i < header.eh_entries; ++i) {
+        BlockBasedFileSystem::BlockIndex child = static_cast<u64>(entries[i].ei_leaf_hi) << 32 | entries[i].ei_leaf_lo;
+        if (child == 0)
+            return EIO;
+        if (tree_blocks)
+            TRY(tree_blocks->try_append(child));
+        TRY(fs().read_block(child, &buffer, fs().block_size()));
+        TRY(read_extent_tree_node(block_contents.bytes(), header.eh_depth - 1, extents, tree_blocks));
+    }
+    return {};
+}
+
+static ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> block_list_from_extents(Vector<Ext2FSExtent> const& extents, u64 block_count)
+{
+    // Blocks past the end of the file may still be allocated to it, so make sure we don't lose track of them.
+    if (!extents.is_empty())
+        block_count = max(block_count, extents.last().logical_block + extents.last().length);
+
+    Vector<BlockBasedFileSystem::BlockIndex> list;
+    TRY(list.try_resize(block_count));
+    for (auto const& extent : extents) {
+        for (u64 i = 0; i < extent.length; ++i)
+            list[extent.logical_block + i] = extent.physical_block + i;
+    }
+    return list;
+}
+
+ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> Ext2FSInode::compute_block_list_from_extents(ext2_inode const& e2inode, bool include_tree_blocks) const
+{
+    Vector<Ext2FSExtent> extents;
+    Vector<BlockBasedFileSystem::BlockIndex> tree_blocks;
+    TRY(read_extent_tree(e2inode, extents, include_tree_blocks ? &tree_blocks : nullptr));
+
+    auto list = TRY(block_list_from_extents(extents, ceil_div(size(), static_cast<u64>(fs().block_size()))));
+    TRY(list.try_extend(move(tree_blocks)));
+    return list;
+}
+
+ErrorOr<void> Ext2FSInode::load_extent_block_list()
+{
+    Vector<Ext2FSExtent> extents;
+    Vector<BlockBasedFileSystem::BlockIndex> tree_blocks;
+    TRY(read_extent_tree(m_raw_inode, extents, &tree_blocks));
+
+    Vector<Ext2FSBlockRange> unwritten_blocks;
+    for (auto const& extent : extents) {
+        if (!extent.unwritten)
+            continue;
+        if (!unwritten_blocks.is_empty() && unwritten_blocks.last().end_block == extent.logical_block)
+            unwritten_blocks.last().end_block += extent.length;
+        else
+            TRY(unwritten_blocks.try_append({ extent.logical_block, extent.logical_block + extent.length }));
+    }
+
+    m_block_list = TRY(block_list_from_extents(extents, ceil_div(size(), static_cast<u64>(fs().block_size()))));
+    m_extents = move(extents);
+    m_extent_tree_blocks = move(tree_blocks);
+    m_unwritten_blocks = move(unwritten_blocks);
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::flush_extent_tree()
+{
+    VERIFY(m_inode_lock.is_locked());
+
+    // Turn the block list back into runs of contiguous blocks.
+    Vector<Ext2FSExtent> extents;
+    size_t data_block_count = 0;
+    for (size_t i = 0; i < m_block_list.size(); ++i) {
+        auto block = m_block_list[i].value();
+        if (block == 0)
+            continue;
+        ++data_block_count;
+        bool unwritten = is_block_unwritten(i);
+        u32 maximum_length = unwritten ? EXT4_EXT_UNWRITTEN_MAX_LEN : EXT4_EXT_INIT_MAX_LEN;
+        if (!extents.is_empty()) {
+            auto& last = extents.last();
+            if (last.logical_block + last.length == i && last.physical_block + last.length == block && last.unwritten == unwritten && last.length < maximum_length) {
+                ++last.length;
+                continue;
+            }
+        }
+        TRY(extents.try_append({ i, block, 1, unwritten }));
+    }
+
+    // Figure out how many nodes each level of the tree needs, from the leaves up to (but not including) the root.
+    auto const entries_per_block = extent_tree_entries_per_block(fs().block_size());
+    Vector<size_t, EXT4_EXT_MAX_DEPTH> nodes_per_level;
+    size_t tree_block_count = 0;
+    for (auto entry_count = extents.size(); entry_count > ext2_extent_tree_root_entry_count;) {
+        entry_count = ceil_div(entry_count, entries_per_block);
+        if (nodes_per_level.size() == EXT4_EXT_MAX_DEPTH)
+            return EFBIG;
+        nodes_per_level.unchecked_append(entry_count);
+        tree_block_count += entry_count;
+    }
+    u16 const depth = nodes_per_level.size();
+
+    // The tree blocks are handed out in the same order every time, so if the shape of the tree didn't change,
+    // every leaf ends up in the same block as before and we only have to write the ones whose extents changed.
+    auto const& old_root = *reinterpret_cast<ext4_extent_header const*>(m_raw_inode.i_block);
+    bool const can_skip_unchanged_leaves = old_root.eh_depth == depth && m_extent_tree_blocks.size() == tree_block_count;
+
+    if (m_extent_tree_blocks.size() < tree_block_count) {
+        auto new_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), tree_block_count - m_extent_tree_blocks.size()));
+        dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_extent_tree(): Allocated {} extent tree block(s)", identifier(), new_blocks.size());
+        TRY(m_extent_tree_blocks.try_extend(move(new_blocks)));
+    } else if (m_extent_tree_blocks.size() > tree_block_count) {
+        dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_extent_tree(): Freeing {} extent tree block(s)", identifier(), m_extent_tree_blocks.size() - tree_block_count);
+        TRY(fs().free_blocks(m_extent_tree_blocks.span().slice(tree_block_count)));
+        m_extent_tree_blocks.shrink(tree_block_count);
+    }
+
+    auto block_contents = TRY(ByteBuffer::create_zeroed(fs().block_size()));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(block_contents.data());
+    Vector<ext4_extent_idx> child_entries;
+    size_t next_tree_block = 0;
+    for (u16 level = 0; level < depth; ++level) {
+        Vector<ext4_extent_idx> entries;
+        TRY(entries.try_ensure_capacity(nodes_per_level[level]));
+        auto const entry_count = level == 0 ? extents.size() : child_entries.size();
+        for (size_t node = 0; node < nodes_per_level[level]; ++node) {
+            auto const first_entry = node * entries_per_block;
+            auto const count = min(entries_per_block, entry_count - first_entry);
+            auto const block = m_extent_tree_blocks[next_tree_block++];
+
+            ext4_extent_idx entry {};
+            entry.ei_block = level == 0 ? extents[first_entry].logical_block : child_entries[first_entry].ei_block;
+            entry.ei_leaf_hi = block.value() >> 32;
+            entry.ei_leaf_lo = block.value() & 0xffffffff;
+            entries.unchecked_append(entry);
+
+            if (level == 0 && can_skip_unchanged_leaves && m_extents.size() > first_entry && min(entries_per_block, m_extents.size() - first_entry) == count) {
+                bool unchanged = true;
+                for (size_t i = first_entry; unchanged && i < first_entry + count; ++i)
+                    unchanged = extents[i] == m_extents[i];
+                if (unchanged)
+                    continue;
+            }
+
+            if (level == 0)
+                write_extent_tree_node(block_contents.bytes(), level, entries_per_block, extents.span().slice(first_entry, count), {});
+            else
+                write_extent_tree_node(block_contents.bytes(), level, entries_per_block, {}, child_entries.span().slice(first_entry, count));
+            TRY(fs().write_block(block, buffer, block_contents.size()));
+        }
+        child_entries = move(entries);
+    }
+    VERIFY(next_tree_block == tree_block_count);
+
+    Bytes root { reinterpret_cast<u8*>(m_raw_inode.i_block), sizeof(m_raw_inode.i_block) };
+    write_extent_tree_node(root, depth, ext2_extent_tree_root_entry_count, extents, child_entries);
+    m_raw_inode.i_blocks = (data_block_count + tree_block_count) * (fs().block_size() / 512);
+    dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_extent_tree(): Wrote {} extent(s), depth {}, {} tree block(s)", identifier(), extents.size(), depth, tree_block_count);
+
+    m_extents = move(extents);
+    set_metadata_dirty(true);
+    return {};
+}
+
+bool Ext2FSInode::is_block_unwritten(u64 block) const
+{
+    // The ranges are sorted and don't overlap, so we can binary search them.
+    size_t low = 0;
+    size_t high = m_unwritten_blocks.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        auto const& range = m_unwritten_blocks[middle];
+        if (block < range.first_block)
+            high = middle;
+        else if (block >= range.end_block)
+            low = middle + 1;
+        else
+            return true;
+    }
+    return false;
+}
+
+ErrorOr<void> Ext2FSInode::set_blocks_unwritten(Ext2FSBlockRange blocks, bool unwritten)
+{
+    if (blocks.first_block >= blocks.end_block || (!unwritten && m_unwritten_blocks.is_empty()))
+        return {};
+
+    // Cutting the new range out of the existing ones splits at most one of them in two.
+    Vector<Ext2FSBlockRange> ranges;
+    TRY(ranges.try_ensure_capacity(m_unwritten_blocks.size() + 2));
+    for (auto const& range : m_unwritten_blocks) {
+        if (range.end_block <= blocks.first_block || range.first_block >= blocks.end_block) {
+            ranges.unchecked_append(range);
+            continue;
+        }
+        if (range.first_block < blocks.first_block)
+            ranges.unchecked_append({ range.first_block, blocks.first_block });
+        if (range.end_block > blocks.end_block)
+            ranges.unchecked_append({ blocks.end_block, range.end_block });
+    }
+
+    if (unwritten) {
+        size_t position = 0;
+        while (position < ranges.size() && ranges[position].first_block < blocks.first_block)
+            ++position;
+        TRY(ranges.try_insert(position, blocks));
+
+        size_t merged_count = 0;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (merged_count > 0 && ranges[merged_count - 1].end_block >= ranges[i].first_block)
+                ranges[merged_count - 1].end_block = max(ranges[merged_count - 1].end_block, ranges[i].end_block);
+            else
+                ranges[merged_count++] = ranges[i];
+        }
+        ranges.shrink(merged_count);
+    }
+
+    m_unwritten_blocks = move(ranges);
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::allocate_blocks_for_holes(Ext2FSBlockRange blocks)
+{
+    VERIFY(m_inode_lock.is_locked());
+    VERIFY(uses_extents());
+
+    blocks.end_block = min(blocks.end_block, static_cast<u64>(m_block_list.size()));
+    size_t hole_count = 0;
+    for (auto i = blocks.first_block; i < blocks.end_block; ++i) {
+        if (m_block_list[i] == 0)
+            ++hole_count;
+    }
+    if (hole_count == 0)
+        return {};
+    if (hole_count > fs().super_block().s_free_blocks_count)
+        return ENOSPC;
+
+    // Try to place the new blocks right behind the ones in front of the first hole.
+    Ext2FS::BlockIndex goal = 0;
+    for (auto i = blocks.first_block; i > 0; --i) {
+        if (m_block_list[i - 1] != 0) {
+            goal = m_block_list[i - 1].value() + 1;
+            break;
+        }
+    }
+
+    auto new_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), hole_count, goal));
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::allocate_blocks_for_holes(): Filling {} hole(s) between blocks {} and {}", identifier(), hole_count, blocks.first_block, blocks.end_block);
+
+    // Until something is written to them, the new blocks have to keep reading back as zeroes.
+    size_t next_block = 0;
+    Optional<Ext2FSBlockRange> run;
+    for (auto i = blocks.first_block; i < blocks.end_block; ++i) {
+        if (m_block_list[i] != 0)
+            continue;
+        m_block_list[i] = new_blocks[next_block++];
+        if (run.has_value() && run->end_block == i) {
+            ++run->end_block;
+            continue;
+        }
+        if (run.has_value())
+            TRY(set_blocks_unwritten(*run, true));
+        run = Ext2FSBlockRange { i, i + 1 };
+    }
+    if (run.has_value())
+        TRY(set_blocks_unwritten(*run, true));
+
+    return flush_block_list();
+}
+
+}
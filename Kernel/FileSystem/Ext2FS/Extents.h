@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/Ext2FS/Definitions.h>
+
+namespace Kernel {
+
+// Extent-mapped files, as introduced by ext4.
+//
+// Instead of one pointer per block, the file's blocks are described by a short list of
+// contiguous runs, kept in a B-tree whose root lives in the i_block array of the inode.
+// A run can also be "unwritten", in which case its blocks are allocated to the file, but
+// read back as zeroes until something is written to them.
+
+struct Ext2FSExtent {
+    u64 logical_block { 0 };
+    u64 physical_block { 0 };
+    u32 length { 0 };
+    bool unwritten { false };
+
+    bool operator==(Ext2FSExtent const&) const = default;
+};
+
+// A range of logical blocks in a file.
+struct Ext2FSBlockRange {
+    u64 first_block { 0 };
+    u64 end_block { 0 };
+};
+
+// The root of the tree has to fit into the 60 bytes of the i_block array.
+static constexpr size_t ext2_extent_tree_root_entry_count = (sizeof(ext2_inode::i_block) - sizeof(ext4_extent_header)) / sizeof(ext4_extent);
+
+void ext2_initialize_extent_tree_root(ext2_inode&);
+
+}
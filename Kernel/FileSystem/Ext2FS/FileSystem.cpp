@@ -223,9 +223,9 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal) -> ErrorOr<Vector<BlockIndex>>
 {
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, goal {})", preferred_group_index, count, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -233,6 +233,15 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
+
+    // If the caller knows where its previous block went, try to continue right behind it, and otherwise at least stay in the same group.
+    if (goal != 0 && goal < super_block().s_blocks_count) {
+        auto allocated_count = TRY(allocate_blocks_at(goal, count));
+        for (size_t i = 0; i < allocated_count; ++i)
+            blocks.unchecked_append(goal.value() + i);
+        preferred_group_index = group_index_from_block_index(goal);
+    }
+
     auto group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -263,15 +272,21 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
         auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
 
         BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
-        size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
+        auto blocks_remaining = count - blocks.size();
+
+        // Prefer a free region that can hold everything that's left, and only split the allocation if there is none.
+        size_t free_region_size = blocks_remaining;
+        auto first_unset_bit_index = block_bitmap.find_first_fit(blocks_remaining);
+        if (!first_unset_bit_index.has_value())
+            first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(blocks_remaining, free_region_size);
         VERIFY(first_unset_bit_index.has_value());
         dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", free_region_size, group_index);
+
+        BlockIndex first_block = first_unset_bit_index.value() + first_block_in_group.value();
+        TRY(set_block_range_allocation_state(first_block, free_region_size, true));
         for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group.value();
-            TRY(set_block_allocation_state(block_index, true));
-            blocks.unchecked_append(block_index);
-            dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
+            blocks.unchecked_append(first_block.value() + i);
+            dbgln_if(EXT2_DEBUG, "  allocated > {}", blocks.last());
         }
     }
 
@@ -279,6 +294,52 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     return blocks;
 }
 
+ErrorOr<size_t> Ext2FS::allocate_blocks_at(BlockIndex first_block, size_t maximum_count)
+{
+    MutexLocker locker(m_lock);
+    if (first_block < first_block_index() || first_block >= super_block().s_blocks_count || maximum_count == 0)
+        return 0;
+
+    auto group_index = group_index_from_block_index(first_block);
+    auto const& bgd = group_descriptor(group_index);
+    if (!bgd.bg_free_blocks_count)
+        return 0;
+
+    BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+    size_t blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count - first_block_in_group.value());
+    size_t first_bit_index = first_block.value() - first_block_in_group.value();
+
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    auto block_bitmap = cached_bitmap->bitmap(blocks_per_group());
+    size_t count = 0;
+    while (count < maximum_count && first_bit_index + count < blocks_in_group && !block_bitmap.get(first_bit_index + count))
+        ++count;
+
+    if (count != 0)
+        TRY(set_block_range_allocation_state(first_block, count, true));
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks_at(): Allocated {} of {} block(s) at {}", count, maximum_count, first_block);
+    return count;
+}
+
+ErrorOr<void> Ext2FS::free_blocks(Span<BlockIndex const> blocks)
+{
+    MutexLocker locker(m_lock);
+
+    // Free runs of consecutive blocks in one go, holes are skipped.
+    for (size_t i = 0; i < blocks.size();) {
+        if (blocks[i] == 0) {
+            ++i;
+            continue;
+        }
+        size_t run_length = 1;
+        while (i + run_length < blocks.size() && blocks[i + run_length].value() == blocks[i].value() + run_length)
+            ++run_length;
+        TRY(set_block_range_allocation_state(blocks[i], run_length, false));
+        i += run_length;
+    }
+    return {};
+}
+
 ErrorOr<InodeIndex> Ext2FS::allocate_inode(GroupIndex preferred_group)
 {
     dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_inode(preferred_group: {})", preferred_group);
@@ -343,7 +404,7 @@ Ext2FS::GroupIndex Ext2FS::group_index_from_block_index(BlockIndex block_index)
 {
     if (!block_index)
         return 0;
-    return (block_index.value() - 1) / blocks_per_group() + 1;
+    return (block_index.value() - first_block_index().value()) / blocks_per_group() + 1;
 }
 
 auto Ext2FS::group_index_from_inode(InodeIndex inode) const -> GroupIndex
@@ -367,23 +428,24 @@ ErrorOr<bool> Ext2FS::get_inode_allocation_state(InodeIndex index) const
     return cached_bitmap->bitmap(inodes_per_group()).get(bit_index);
 }
 
-ErrorOr<void> Ext2FS::update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter)
+ErrorOr<void> Ext2FS::update_bitmap_block(BlockIndex bitmap_block, size_t first_bit_index, size_t count, bool new_state, u32& super_block_counter, u16& group_descriptor_counter)
 {
     auto* cached_bitmap = TRY(get_bitmap_block(bitmap_block));
-    bool current_state = cached_bitmap->bitmap(blocks_per_group()).get(bit_index);
-    if (current_state == new_state) {
-        dbgln("Ext2FS: Bit {} in bitmap block {} had unexpected state {}", bit_index, bitmap_block, current_state);
+    auto bitmap = cached_bitmap->bitmap(blocks_per_group());
+    VERIFY(first_bit_index + count <= bitmap.size());
+    if (auto unexpected_bits = bitmap.count_in_range(first_bit_index, count, new_state); unexpected_bits != 0) {
+        dbgln("Ext2FS: {} of bits {}-{} in bitmap block {} already had state {}", unexpected_bits, first_bit_index, first_bit_index + count - 1, bitmap_block, new_state);
         return EIO;
     }
-    cached_bitmap->bitmap(blocks_per_group()).set(bit_index, new_state);
+    bitmap.set_range(first_bit_index, count, new_state);
     cached_bitmap->dirty = true;
 
     if (new_state) {
-        --super_block_counter;
-        --group_descriptor_counter;
+        super_block_counter -= count;
+        group_descriptor_counter -= count;
     } else {
-        ++super_block_counter;
-        ++group_descriptor_counter;
+        super_block_counter += count;
+        group_descriptor_counter += count;
     }
 
     m_super_block_dirty = true;
@@ -400,7 +462,7 @@ ErrorOr<void> Ext2FS::set_inode_allocation_state(InodeIndex inode_index, bool ne
 
     dbgln_if(EXT2_DEBUG, "Ext2FS: set_inode_allocation_state: Inode {} -> {}", inode_index, new_state);
     auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
-    return update_bitmap_block(bgd.bg_inode_bitmap, bit_index, new_state, m_super_block.s_free_inodes_count, bgd.bg_free_inodes_count);
+    return update_bitmap_block(bgd.bg_inode_bitmap, bit_index, 1, new_state, m_super_block.s_free_inodes_count, bgd.bg_free_inodes_count);
 }
 
 Ext2FS::BlockIndex Ext2FS::first_block_index() const
@@ -425,16 +487,28 @@ ErrorOr<Ext2FS::CachedBitmap*> Ext2FS::get_bitmap_block(BlockIndex bitmap_block_
 
 ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool new_state)
 {
-    VERIFY(block_index != 0);
+    return set_block_range_allocation_state(block_index, 1, new_state);
+}
+
+ErrorOr<void> Ext2FS::set_block_range_allocation_state(BlockIndex first_block, size_t count, bool new_state)
+{
+    VERIFY(first_block != 0);
     MutexLocker locker(m_lock);
 
-    auto group_index = group_index_from_block_index(block_index);
-    unsigned index_in_group = (block_index.value() - first_block_index().value()) - ((group_index.value() - 1) * blocks_per_group());
-    unsigned bit_index = index_in_group % blocks_per_group();
-    auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+    while (count) {
+        auto group_index = group_index_from_block_index(first_block);
+        unsigned index_in_group = (first_block.value() - first_block_index().value()) - ((group_index.value() - 1) * blocks_per_group());
+        unsigned bit_index = index_in_group % blocks_per_group();
+        size_t count_in_group = min(count, blocks_per_group() - bit_index);
+        auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+
+        dbgln_if(EXT2_DEBUG, "Ext2FS: Blocks {}-{} state -> {} (in bitmap block {})", first_block, first_block.value() + count_in_group - 1, new_state, bgd.bg_block_bitmap);
+        TRY(update_bitmap_block(bgd.bg_block_bitmap, bit_index, count_in_group, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count));
 
-    dbgln_if(EXT2_DEBUG, "Ext2FS: Block {} state -> {} (in bitmap block {})", block_index, new_state, bgd.bg_block_bitmap);
-    return update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count);
+        first_block = first_block.value() + count_in_group;
+        count -= count_in_group;
+    }
+    return {};
 }
 
 ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_directory(Ext2FSInode& parent_inode, StringView name, mode_t mode, UserID uid, GroupID gid)
@@ -490,6 +564,11 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_inode(Ext2FSInode& parent_inode, St
     else if (is_block_device(mode))
         e2inode.i_block[1] = dev;
 
+    if (has_extents_feature() && (is_regular_file(mode) || is_directory(mode))) {
+        e2inode.i_flags |= EXT4_EXTENTS_FL;
+        ext2_initialize_extent_tree_root(e2inode);
+    }
+
     auto inode_id = TRY(allocate_inode());
 
     dbgln_if(EXT2_DEBUG, "Ext2FS: writing initial metadata for inode {}", inode_id.value());
@@ -540,6 +619,9 @@ ErrorOr<void> Ext2FS::prepare_to_clear_last_mount()
             return EBUSY;
     }
 
+    // NOTE: This also gives back the blocks that inodes reserved for future writes.
+    flush_writes();
+
     BlockBasedFileSystem::remove_disk_cache_before_last_unmount();
     m_inode_cache.clear();
     m_root_inode = nullptr;
@@ -555,11 +637,9 @@ ErrorOr<void> Ext2FS::free_inode(Ext2FSInode& inode)
     // Mark all blocks used by this inode as free.
     {
         auto blocks = TRY(inode.compute_block_list_with_meta_blocks());
-        for (auto block_index : blocks) {
+        for (auto block_index : blocks)
             VERIFY(block_index <= super_block().s_blocks_count);
-            if (block_index.value())
-                TRY(set_block_allocation_state(block_index, false));
-        }
+        TRY(free_blocks(blocks));
     }
 
     // If the inode being freed is a directory, update block group directory counter.
@@ -593,6 +673,24 @@ void Ext2FS::flush_block_group_descriptor_table()
 
 void Ext2FS::flush_writes()
 {
+    // Blocks that inodes reserved for future writes are marked as in use in the on-disk bitmaps.
+    // Give them back before writing those out, or they would stay lost if we don't get to
+    // do so later, for example because the system is shut down or crashes.
+    Vector<NonnullRefPtr<Ext2FSInode>> inodes_with_preallocation;
+    {
+        MutexLocker locker(m_lock);
+        for (auto& it : m_inode_cache) {
+            // NOTE: This is only a hint, discard_preallocation() checks again with the inode locked.
+            if (it.value && it.value->m_preallocation_count != 0)
+                (void)inodes_with_preallocation.try_append(*it.value);
+        }
+    }
+    for (auto& inode : inodes_with_preallocation) {
+        MutexLocker inode_locker(inode->m_inode_lock);
+        if (auto result = inode->discard_preallocation(); result.is_error())
+            dbgln("Ext2FS[{}]::flush_writes(): Failed to discard preallocated blocks of inode {}: {}", fsid(), inode->index(), result.error());
+    }
+
     {
         MutexLocker locker(m_lock);
         if (m_super_block_dirty) {
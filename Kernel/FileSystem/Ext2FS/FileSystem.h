@@ -37,6 +37,7 @@ public:
     virtual unsigned free_inode_count() const override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_directory_entry_cache() const override { return true; }
 
     virtual u8 internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const override;
 
@@ -51,6 +52,8 @@ private:
     explicit Ext2FS(OpenFileDescription&);
 
     ext2_super_block const& super_block() const { return m_super_block; }
+    bool has_directory_index_feature() const { return m_super_block.s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX; }
+    bool has_extents_feature() const { return m_super_block.s_rev_level > 0 && (m_super_block.s_feature_incompat & EXT3_FEATURE_INCOMPAT_EXTENTS); }
     ext2_group_desc const& group_descriptor(GroupIndex) const;
     ext2_group_desc* block_group_descriptors() { return (ext2_group_desc*)m_cached_group_descriptor_table->data(); }
     ext2_group_desc const* block_group_descriptors() const { return (ext2_group_desc const*)m_cached_group_descriptor_table->data(); }
@@ -78,13 +81,16 @@ private:
 
     BlockIndex first_block_index() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
+    ErrorOr<size_t> allocate_blocks_at(BlockIndex first_block, size_t maximum_count);
+    ErrorOr<void> free_blocks(Span<BlockIndex const>);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
     ErrorOr<bool> get_inode_allocation_state(InodeIndex) const;
     ErrorOr<void> set_inode_allocation_state(InodeIndex, bool);
     ErrorOr<void> set_block_allocation_state(BlockIndex, bool);
+    ErrorOr<void> set_block_range_allocation_state(BlockIndex first_block, size_t count, bool);
 
     void uncache_inode(InodeIndex);
     ErrorOr<void> free_inode(Ext2FSInode&);
@@ -122,7 +128,7 @@ private:
     };
 
     ErrorOr<CachedBitmap*> get_bitmap_block(BlockIndex);
-    ErrorOr<void> update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
+    ErrorOr<void> update_bitmap_block(BlockIndex bitmap_block, size_t first_bit_index, size_t count, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
     RefPtr<Ext2FSInode> m_root_inode;
@@ -10,6 +10,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Ext2FS/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -203,6 +204,9 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
 {
     MutexLocker locker(m_inode_lock);
 
+    if (uses_extents())
+        return flush_extent_tree();
+
     if (m_block_list.is_empty()) {
         m_raw_inode.i_blocks = 0;
         memset(m_raw_inode.i_block, 0, sizeof(m_raw_inode.i_block));
@@ -352,6 +356,9 @@ ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_impl(bool in
 
 ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_impl_internal(ext2_inode const& e2inode, bool include_block_list_blocks) const
 {
+    if (e2inode.i_flags & EXT4_EXTENTS_FL)
+        return compute_block_list_from_extents(e2inode, include_block_list_blocks);
+
     unsigned entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
 
     unsigned block_count = ceil_div(size(), static_cast<u64>(fs().block_size()));
@@ -451,10 +458,10 @@ Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
 
 Ext2FSInode::~Ext2FSInode()
 {
-    if (m_raw_inode.i_links_count == 0) {
-        // Alas, we have nowhere to propagate any errors that occur here.
+    // Alas, we have nowhere to propagate any errors that occur here.
+    (void)discard_preallocation();
+    if (m_raw_inode.i_links_count == 0)
         (void)fs().free_inode(*this);
-    }
 }
 
 u64 Ext2FSInode::size() const
@@ -516,7 +523,15 @@ ErrorOr<void> Ext2FSInode::compute_block_list_with_exclusive_locking()
     VERIFY(m_inode_lock.is_locked());
     MutexLocker block_list_locker(m_block_list_lock);
     if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+        TRY(load_block_list());
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::load_block_list()
+{
+    if (uses_extents())
+        return load_extent_block_list();
+    m_block_list = TRY(compute_block_list());
     return {};
 }
 
@@ -567,13 +582,21 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
+    // Fetch whatever isn't cached yet with one read per run of consecutive blocks, rather than block by block below.
+    // This is what fills the page cache, so it's usually many blocks at once.
+    u64 last_block_to_read = (offset + remaining_count - 1) / block_size;
+    if (allow_cache && last_block_to_read > first_block_logical_index.value()) {
+        if (auto blocks = blocks_to_read_from_disk(first_block_logical_index.value(), last_block_to_read + 1); !blocks.is_error())
+            fs().read_blocks_into_cache(blocks.value());
+    }
+
     for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
         auto block_index = m_block_list[bi.value()];
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
         auto buffer_offset = buffer.offset(nread);
-        if (block_index.value() == 0) {
-            // This is a hole, act as if it's filled with zeroes.
+        if (block_index.value() == 0 || is_block_unwritten(bi.value())) {
+            // This is a hole (or a block nobody wrote to yet), act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
         } else {
             if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
@@ -585,9 +608,46 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
         nread += num_bytes_to_copy;
     }
 
+    if (allow_cache && description && nread > 0) {
+        u64 first_block_read = first_block_logical_index.value();
+        u64 last_block_read = (offset + nread - 1) / block_size;
+        if (auto readahead = description->did_read_blocks(first_block_read, last_block_read - first_block_read + 1, m_block_list.size(), block_size); readahead.has_value()) {
+            if (auto blocks = blocks_to_read_from_disk(readahead->first_block, readahead->first_block + readahead->block_count); !blocks.is_error())
+                fs().readahead_blocks(blocks.release_value());
+        }
+    }
+
     return nread;
 }
 
+ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> Ext2FSInode::blocks_to_read_from_disk(u64 first_block, u64 end_block) const
+{
+    end_block = min(end_block, static_cast<u64>(m_block_list.size()));
+    Vector<BlockBasedFileSystem::BlockIndex> blocks;
+    if (first_block >= end_block)
+        return blocks;
+    TRY(blocks.try_ensure_capacity(end_block - first_block));
+    for (auto bi = first_block; bi < end_block; ++bi) {
+        if (m_block_list[bi].value() != 0 && !is_block_unwritten(bi))
+            blocks.unchecked_append(m_block_list[bi]);
+    }
+    return blocks;
+}
+
+void Ext2FSInode::readahead(u64 offset, size_t length) const
+{
+    MutexLocker inode_locker(m_inode_lock, Mutex::Mode::Shared);
+    // NOTE: See read_bytes_locked() for why we bypass the const declaration here.
+    if (const_cast<Ext2FSInode&>(*this).compute_block_list_with_exclusive_locking().is_error())
+        return;
+
+    u64 const block_size = fs().block_size();
+    auto blocks_or_error = blocks_to_read_from_disk(offset / block_size, ceil_div(offset + length, block_size));
+    if (blocks_or_error.is_error())
+        return;
+    fs().readahead_blocks(blocks_or_error.release_value());
+}
+
 ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 {
     auto old_size = size();
@@ -606,18 +666,23 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
         dbgln("Ext2FSInode[{}]::resize(): Blocks needed after  (size is  {}): {}", identifier(), new_size, blocks_needed_after);
     }
 
-    if (blocks_needed_after > blocks_needed_before) {
-        auto additional_blocks_needed = blocks_needed_after - blocks_needed_before;
-        if (additional_blocks_needed > fs().super_block().s_free_blocks_count)
+    if (m_block_list.is_empty())
+        TRY(load_block_list());
+
+    // NOTE: Extent-mapped files can have blocks past their end, which we can reuse when growing.
+    if (blocks_needed_after > m_block_list.size()) {
+        auto additional_blocks_needed = blocks_needed_after - m_block_list.size();
+        if (additional_blocks_needed > fs().super_block().s_free_blocks_count + m_preallocation_count)
             return ENOSPC;
     }
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
-
-    if (blocks_needed_after > blocks_needed_before) {
-        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before));
+    if (blocks_needed_after > m_block_list.size()) {
+        u64 first_new_block = m_block_list.size();
+        auto blocks = TRY(allocate_blocks_for_growth(blocks_needed_after - first_new_block));
         TRY(m_block_list.try_extend(move(blocks)));
+        // New blocks of extent-mapped files don't have to be cleared, they read back as zeroes until they are written to.
+        if (uses_extents())
+            TRY(set_blocks_unwritten({ first_new_block, blocks_needed_after }, true));
     } else if (blocks_needed_after < blocks_needed_before) {
         if constexpr (EXT2_VERY_DEBUG) {
             dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block list is {} entries:", identifier(), m_block_list.size());
@@ -625,15 +690,15 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
                 dbgln("    # {}", block_index);
             }
         }
-        while (m_block_list.size() != blocks_needed_after) {
-            auto block_index = m_block_list.take_last();
-            if (block_index.value()) {
-                if (auto result = fs().set_block_allocation_state(block_index, false); result.is_error()) {
-                    dbgln("Ext2FSInode[{}]::resize(): Failed to free block {}: {}", identifier(), block_index, result.error());
-                    return result;
-                }
+        TRY(discard_preallocation());
+        if (m_block_list.size() > blocks_needed_after) {
+            if (auto result = fs().free_blocks(m_block_list.span().slice(blocks_needed_after)); result.is_error()) {
+                dbgln("Ext2FSInode[{}]::resize(): Failed to free blocks: {}", identifier(), result.error());
+                return result;
             }
+            m_block_list.shrink(blocks_needed_after);
         }
+        TRY(set_blocks_unwritten({ blocks_needed_after, NumericLimits<u64>::max() }, false));
     }
 
     TRY(flush_block_list());
@@ -646,14 +711,21 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 
     if (new_size > old_size) {
         // If we're growing the inode, make sure we zero out all the new space.
-        // FIXME: There are definitely more efficient ways to achieve this.
-        auto bytes_to_clear = new_size - old_size;
+        // Unwritten blocks already read back as zeroes, so we skip over those.
         auto clear_from = old_size;
         u8 zero_buffer[PAGE_SIZE] {};
-        while (bytes_to_clear) {
-            auto nwritten = TRY(write_bytes(clear_from, min(static_cast<u64>(sizeof(zero_buffer)), bytes_to_clear), UserOrKernelBuffer::for_kernel_buffer(zero_buffer), nullptr));
+        while (clear_from < new_size) {
+            auto block = clear_from / block_size;
+            auto next_block_offset = (block + 1) * block_size;
+            if (is_block_unwritten(block)) {
+                clear_from = next_block_offset;
+                continue;
+            }
+            auto bytes_to_clear = min(static_cast<u64>(sizeof(zero_buffer)), new_size - clear_from);
+            if (uses_extents())
+                bytes_to_clear = min(bytes_to_clear, next_block_offset - clear_from);
+            auto nwritten = TRY(write_bytes(clear_from, bytes_to_clear, UserOrKernelBuffer::for_kernel_buffer(zero_buffer), nullptr));
             VERIFY(nwritten != 0);
-            bytes_to_clear -= nwritten;
             clear_from += nwritten;
         }
     }
@@ -661,6 +733,62 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
     return {};
 }
 
+ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::allocate_blocks_for_growth(size_t count)
+{
+    VERIFY(m_inode_lock.is_locked());
+
+    // Try to continue right behind the last block of the file, so that it stays contiguous on disk.
+    Ext2FS::BlockIndex goal = 0;
+    for (auto i = m_block_list.size(); i > 0; --i) {
+        if (m_block_list[i - 1] != 0) {
+            goal = m_block_list[i - 1].value() + 1;
+            break;
+        }
+    }
+
+    Vector<Ext2FS::BlockIndex> blocks;
+    TRY(blocks.try_ensure_capacity(count));
+
+    // Blocks we reserved earlier are only useful if they still continue the file.
+    if (m_preallocation_count != 0 && m_preallocation_start != goal)
+        TRY(discard_preallocation());
+    auto preallocated_blocks_to_use = min(count, m_preallocation_count);
+    for (size_t i = 0; i < preallocated_blocks_to_use; ++i)
+        blocks.unchecked_append(m_preallocation_start.value() + i);
+    m_preallocation_start = m_preallocation_start.value() + preallocated_blocks_to_use;
+    m_preallocation_count -= preallocated_blocks_to_use;
+    if (preallocated_blocks_to_use != 0)
+        goal = m_preallocation_start;
+
+    if (blocks.size() < count) {
+        auto new_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), count - blocks.size(), goal));
+        TRY(blocks.try_extend(move(new_blocks)));
+    }
+
+    // Reserve some room for the next append. Large requests (like the ones coming from fallocate()) know
+    // how much space they need up front, and there's no point in holding on to blocks on an almost full disk.
+    bool should_preallocate = Kernel::is_regular_file(m_raw_inode.i_mode) && m_preallocation_count == 0
+        && count < maximum_preallocation_block_count
+        && fs().super_block().s_free_blocks_count > maximum_preallocation_block_count * 64;
+    if (should_preallocate) {
+        auto preallocation_count = clamp(m_block_list.size() + count, minimum_preallocation_block_count, maximum_preallocation_block_count);
+        m_preallocation_start = blocks.last().value() + 1;
+        m_preallocation_count = TRY(fs().allocate_blocks_at(m_preallocation_start, preallocation_count));
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::allocate_blocks_for_growth(): Preallocated {} block(s) at {}", identifier(), m_preallocation_count, m_preallocation_start);
+    }
+
+    return blocks;
+}
+
+ErrorOr<void> Ext2FSInode::discard_preallocation()
+{
+    if (m_preallocation_count == 0)
+        return {};
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::discard_preallocation(): Freeing {} preallocated block(s) at {}", identifier(), m_preallocation_count, m_preallocation_start);
+    auto count = exchange(m_preallocation_count, 0);
+    return fs().set_block_range_allocation_state(m_preallocation_start, count, false);
+}
+
 ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, UserOrKernelBuffer const& data, OpenFileDescription* description)
 {
     VERIFY(m_inode_lock.is_locked());
@@ -689,7 +817,7 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
     TRY(resize(new_size));
 
     if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+        TRY(load_block_list());
 
     if (m_block_list.is_empty()) {
         dbgln("Ext2FSInode[{}]::write_bytes(): Empty block list", identifier());
@@ -708,9 +836,23 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing {} bytes, {} bytes into inode from {}", identifier(), count, offset, data.user_or_kernel_ptr());
 
+    if (uses_extents())
+        TRY(allocate_blocks_for_holes({ first_block_logical_index.value(), last_block_logical_index.value() + 1 }));
+
+    Optional<Ext2FSBlockRange> written_unwritten_blocks;
     for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
+        if (is_block_unwritten(bi.value())) {
+            // The rest of the block still has to read back as zeroes once it's no longer unwritten.
+            if (num_bytes_to_copy != block_size) {
+                auto zeroes = TRY(ByteBuffer::create_zeroed(block_size));
+                TRY(fs().write_block(m_block_list[bi.value()], UserOrKernelBuffer::for_kernel_buffer(zeroes.data()), block_size, 0, allow_cache));
+            }
+            if (!written_unwritten_blocks.has_value())
+                written_unwritten_blocks = Ext2FSBlockRange { bi.value(), bi.value() };
+            written_unwritten_blocks->end_block = bi.value() + 1;
+        }
         dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
         if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
             dbgln("Ext2FSInode[{}]::write_bytes_locked(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
@@ -720,6 +862,11 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
         nwritten += num_bytes_to_copy;
     }
 
+    if (written_unwritten_blocks.has_value()) {
+        TRY(set_blocks_unwritten(*written_unwritten_blocks, false));
+        TRY(flush_block_list());
+    }
+
     did_modify_contents();
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): After write, i_size={}, i_blocks={} ({} blocks in list)", identifier(), size(), m_raw_inode.i_blocks, m_block_list.size());
@@ -809,6 +956,8 @@ ErrorOr<void> Ext2FSInode::write_directory(Vector<Ext2FSDirectoryEntry>& entries
 
     auto buffer = UserOrKernelBuffer::for_kernel_buffer(directory_data.data());
     auto nwritten = TRY(write_bytes(0, serialized_bytes_count, buffer, nullptr));
+    // NOTE: This is a plain list of entries, so any hash index the directory had is gone now.
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
     set_metadata_dirty(true);
     if (nwritten != directory_data.size())
         return EIO;
@@ -832,12 +981,27 @@ ErrorOr<void> Ext2FSInode::add_child(Inode& child, StringView name, mode_t mode)
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::add_child(): Adding inode {} with name '{}' and mode {:o} to directory {}", identifier(), child.index(), name, mode, index());
 
+    if (has_directory_index()) {
+        auto existing_child = lookup_in_directory_index(name);
+        if (!existing_child.is_error())
+            return EEXIST;
+        if (existing_child.error().code() != ENOENT)
+            return existing_child.release_error();
+
+        TRY(child.increment_link_count());
+        TRY(add_entry_to_directory_index(name, child.index(), to_ext2_file_type(mode)));
+        did_add_child(child.identifier(), name);
+        return {};
+    }
+
     Vector<Ext2FSDirectoryEntry> entries;
+    size_t directory_size = 0;
     TRY(traverse_as_directory([&](auto& entry) -> ErrorOr<void> {
         if (name == entry.name)
             return EEXIST;
         auto entry_name = TRY(KString::try_create(entry.name));
         TRY(entries.try_append({ move(entry_name), entry.inode.index(), entry.file_type }));
+        directory_size += EXT2_DIR_REC_LEN(entry.name.length());
         return {};
     }));
 
@@ -845,6 +1009,14 @@ ErrorOr<void> Ext2FSInode::add_child(Inode& child, StringView name, mode_t mode)
 
     auto entry_name = TRY(KString::try_create(name));
     TRY(entries.try_empend(move(entry_name), child.index(), to_ext2_file_type(mode)));
+    directory_size += EXT2_DIR_REC_LEN(name.length());
+
+    // Once a directory outgrows its first block, searching it linearly starts to hurt, so index it instead.
+    if (directory_size > fs().block_size() && TRY(write_indexed_directory(entries))) {
+        m_lookup_cache.clear();
+        did_add_child(child.identifier(), name);
+        return {};
+    }
 
     TRY(write_directory(entries));
     TRY(populate_lookup_cache());
@@ -861,6 +1033,15 @@ ErrorOr<void> Ext2FSInode::remove_child(StringView name)
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::remove_child(): Removing '{}'", identifier(), name);
     VERIFY(is_directory());
 
+    // NOTE: Removing "." and ".." (as rmdir does) rewrites the directory as a plain list, which drops the index.
+    if (has_directory_index() && name != "."sv && name != ".."sv) {
+        InodeIdentifier child_id { fsid(), TRY(remove_entry_from_directory_index(name)) };
+        auto child_inode = TRY(fs().get_inode(child_id));
+        TRY(child_inode->decrement_link_count());
+        did_remove_child(child_id, name);
+        return {};
+    }
+
     TRY(populate_lookup_cache());
 
     auto it = m_lookup_cache.find(name);
@@ -896,11 +1077,22 @@ ErrorOr<void> Ext2FSInode::replace_child(StringView name, Inode& child)
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::replace_child(): Replacing '{}' with inode {}", identifier(), name, child.index());
     VERIFY(is_directory());
 
-    TRY(populate_lookup_cache());
-
     if (name.length() > EXT2_NAME_LEN)
         return ENAMETOOLONG;
 
+    if (has_directory_index()) {
+        auto old_child = TRY(fs().get_inode({ fsid(), TRY(lookup_in_directory_index(name)) }));
+        TRY(child.increment_link_count());
+        if (auto result = old_child->decrement_link_count(); result.is_error()) {
+            MUST(child.decrement_link_count());
+            return result;
+        }
+        TRY(replace_entry_in_directory_index(name, child.index(), to_ext2_file_type(child.mode())));
+        return {};
+    }
+
+    TRY(populate_lookup_cache());
+
     Vector<Ext2FSDirectoryEntry> entries;
 
     Optional<InodeIndex> old_child_index;
@@ -973,13 +1165,17 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FSInode::lookup(StringView name)
     InodeIndex inode_index;
     {
         MutexLocker locker(m_inode_lock);
-        TRY(populate_lookup_cache());
-        auto it = m_lookup_cache.find(name);
-        if (it == m_lookup_cache.end()) {
-            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): '{}' not found", identifier(), name);
-            return ENOENT;
+        if (has_directory_index()) {
+            inode_index = TRY(lookup_in_directory_index(name));
+        } else {
+            TRY(populate_lookup_cache());
+            auto it = m_lookup_cache.find(name);
+            if (it == m_lookup_cache.end()) {
+                dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): '{}' not found", identifier(), name);
+                return ENOENT;
+            }
+            inode_index = it->value;
         }
-        inode_index = it->value;
     }
 
     return fs().get_inode({ fsid(), inode_index });
@@ -1068,12 +1264,35 @@ ErrorOr<void> Ext2FSInode::truncate(u64 size)
     return {};
 }
 
+ErrorOr<void> Ext2FSInode::fallocate(u64 offset, u64 length)
+{
+    MutexLocker locker(m_inode_lock);
+
+    auto old_size = size();
+    auto new_size = max(old_size, offset + length);
+    TRY(resize(new_size));
+
+    // Only extent-mapped files can have blocks that read back as zeroes without being cleared, so we only fill holes in those.
+    if (uses_extents()) {
+        u64 block_size = fs().block_size();
+        if (m_block_list.is_empty())
+            TRY(load_block_list());
+        TRY(allocate_blocks_for_holes({ offset / block_size, ceil_div(offset + length, block_size) }));
+    }
+
+    if (new_size != old_size) {
+        if (auto page_cache = shared_vmobject())
+            page_cache->did_truncate(new_size);
+    }
+    return {};
+}
+
 ErrorOr<int> Ext2FSInode::get_block_address(int index)
 {
     MutexLocker locker(m_inode_lock);
 
     if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+        TRY(load_block_list());
 
     if (index < 0 || (size_t)index >= m_block_list.size())
         return 0;
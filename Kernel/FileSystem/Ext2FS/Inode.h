@@ -8,7 +8,9 @@
 
 #include <AK/HashMap.h>
 #include <Kernel/FileSystem/Ext2FS/Definitions.h>
+#include <Kernel/FileSystem/Ext2FS/DirectoryIndex.h>
 #include <Kernel/FileSystem/Ext2FS/DirectoryEntry.h>
+#include <Kernel/FileSystem/Ext2FS/Extents.h>
 #include <Kernel/FileSystem/Ext2FS/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/UnixTypes.h>
@@ -43,11 +45,38 @@ private:
     virtual ErrorOr<void> chmod(mode_t) override;
     virtual ErrorOr<void> chown(UserID, GroupID) override;
     virtual ErrorOr<void> truncate(u64) override;
+    virtual ErrorOr<void> fallocate(u64 offset, u64 length) override;
     virtual ErrorOr<int> get_block_address(int) override;
+    virtual void readahead(u64, size_t) const override;
+
+    // Returns the blocks backing the given part of the block list that have to be read from the disk, i.e. everything but holes and unwritten blocks.
+    ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> blocks_to_read_from_disk(u64 first_block, u64 end_block) const;
 
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
     ErrorOr<void> populate_lookup_cache();
+
+    // Hash-indexed directories, see DirectoryIndex.cpp.
+    bool has_directory_index() const;
+    ErrorOr<bool> write_indexed_directory(Vector<Ext2FSDirectoryEntry>&);
+    ErrorOr<InodeIndex> lookup_in_directory_index(StringView name);
+    ErrorOr<void> add_entry_to_directory_index(StringView name, InodeIndex, u8 file_type);
+    ErrorOr<InodeIndex> remove_entry_from_directory_index(StringView name);
+    ErrorOr<InodeIndex> replace_entry_in_directory_index(StringView name, InodeIndex, u8 file_type);
+    Optional<Ext2FSDirectoryHash> directory_index_hash(StringView name, u8 hash_version) const;
+    ErrorOr<ByteBuffer> read_directory_block(u64 block) const;
+    ErrorOr<void> write_directory_block(u64 block, ReadonlyBytes);
+    ErrorOr<u64> append_directory_block();
+    ErrorOr<void> read_directory_index_level(Ext2FSDirectoryIndexPath&, size_t level, u64 block);
+    ErrorOr<void> probe_directory_index(StringView name, Ext2FSDirectoryIndexPath&);
+    ErrorOr<bool> advance_to_next_directory_index_leaf(Ext2FSDirectoryIndexPath&);
+    ErrorOr<Ext2FSDirectoryIndexLocation> find_in_directory_index(StringView name);
+    ErrorOr<void> insert_into_directory_index_level(Ext2FSDirectoryIndexPath&, size_t level, u32 hash, u64 block);
+    ErrorOr<void> split_directory_index_leaf(Ext2FSDirectoryIndexPath&, u64 leaf_block, ByteBuffer& leaf);
+    ErrorOr<void> split_directory_index_node(Ext2FSDirectoryIndexPath&, size_t level);
+    ErrorOr<void> grow_directory_index(Ext2FSDirectoryIndexPath&);
     ErrorOr<void> resize(u64);
+    ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> allocate_blocks_for_growth(size_t count);
+    ErrorOr<void> discard_preallocation();
     ErrorOr<void> write_indirect_block(BlockBasedFileSystem::BlockIndex, Span<BlockBasedFileSystem::BlockIndex>);
     ErrorOr<void> grow_doubly_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
     ErrorOr<void> shrink_doubly_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
@@ -55,6 +84,18 @@ private:
     ErrorOr<void> shrink_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
     ErrorOr<void> flush_block_list();
 
+    // Extent-mapped files, see Extents.cpp.
+    bool uses_extents() const;
+    ErrorOr<void> read_extent_tree(ext2_inode const&, Vector<Ext2FSExtent>&, Vector<BlockBasedFileSystem::BlockIndex>* tree_blocks) const;
+    ErrorOr<void> read_extent_tree_node(ReadonlyBytes, Optional<u16> expected_depth, Vector<Ext2FSExtent>&, Vector<BlockBasedFileSystem::BlockIndex>* tree_blocks) const;
+    ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_from_extents(ext2_inode const&, bool include_tree_blocks) const;
+    ErrorOr<void> load_extent_block_list();
+    ErrorOr<void> flush_extent_tree();
+    bool is_block_unwritten(u64 block) const;
+    ErrorOr<void> set_blocks_unwritten(Ext2FSBlockRange, bool);
+    ErrorOr<void> allocate_blocks_for_holes(Ext2FSBlockRange);
+
+    ErrorOr<void> load_block_list();
     ErrorOr<void> compute_block_list_with_exclusive_locking();
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_with_meta_blocks() const;
@@ -65,7 +106,22 @@ private:
     Ext2FS const& fs() const;
     Ext2FSInode(Ext2FS&, InodeIndex);
 
+    // Growing regular files reserve a few free blocks right behind their last one, so that appends
+    // stay contiguous on disk even when several files are being written at the same time.
+    // The reserved blocks are marked as in use in the block bitmap, so they are given back whenever
+    // the file system flushes its writes, see Ext2FS::flush_writes().
+    static constexpr size_t minimum_preallocation_block_count = 8;
+    static constexpr size_t maximum_preallocation_block_count = 256;
+
     Vector<BlockBasedFileSystem::BlockIndex> m_block_list;
+    BlockBasedFileSystem::BlockIndex m_preallocation_start { 0 };
+    size_t m_preallocation_count { 0 };
+
+    // Only used by extent-mapped files: the extents as last written to disk, the blocks holding the
+    // non-root nodes of the extent tree, and the (sorted) ranges of blocks that are still unwritten.
+    Vector<Ext2FSExtent> m_extents;
+    Vector<BlockBasedFileSystem::BlockIndex> m_extent_tree_blocks;
+    Vector<Ext2FSBlockRange> m_unwritten_blocks;
     HashMap<NonnullOwnPtr<KString>, InodeIndex> m_lookup_cache;
     ext2_inode m_raw_inode {};
 
@@ -118,6 +118,17 @@ ErrorOr<size_t> FIFO::read(OpenFileDescription& fd, u64, UserOrKernelBuffer& buf
     return m_buffer->read(buffer, size);
 }
 
+ErrorOr<size_t> FIFO::splice_read(OpenFileDescription& fd, u64, size_t size, SpliceSink const& sink)
+{
+    if (m_buffer->is_empty()) {
+        if (!m_writers)
+            return 0;
+        if (!fd.is_blocking())
+            return EAGAIN;
+    }
+    return m_buffer->read_in_place(size, sink);
+}
+
 ErrorOr<size_t> FIFO::write(OpenFileDescription& fd, u64, UserOrKernelBuffer const& buffer, size_t size)
 {
     if (!m_readers)
@@ -42,6 +42,7 @@ private:
     // ^File
     virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override;
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
+    virtual ErrorOr<size_t> splice_read(OpenFileDescription&, u64, size_t, SpliceSink const&) override;
     virtual ErrorOr<struct stat> stat() const override;
     virtual bool can_read(OpenFileDescription const&, u64) const override;
     virtual bool can_write(OpenFileDescription const&, u64) const override;
@@ -8,10 +8,69 @@
 #include <AK/Userspace.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Process.h>
 
 namespace Kernel {
 
+void FileBlockerSet::add_observer(FileReadinessObserver& observer)
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(observer.m_description);
+    m_observers.append(observer);
+    notify_observer_locked(observer);
+}
+
+void FileBlockerSet::remove_observer(FileReadinessObserver& observer)
+{
+    SpinlockLocker lock(m_lock);
+    m_observers.remove(observer);
+}
+
+void FileBlockerSet::set_observed_flags(FileReadinessObserver& observer, Thread::FileBlocker::BlockFlags flags)
+{
+    SpinlockLocker lock(m_lock);
+    observer.m_flags = flags;
+    if (observer.m_description)
+        notify_observer_locked(observer);
+}
+
+void FileBlockerSet::detach_observers_of(OpenFileDescription const& description)
+{
+    SpinlockLocker lock(m_lock);
+    for (auto it = m_observers.begin(); it != m_observers.end();) {
+        auto& observer = *it;
+        ++it;
+        if (observer.m_description != &description)
+            continue;
+        m_observers.remove(observer);
+        observer.m_description = nullptr;
+        observer.observed_description_was_closed();
+    }
+}
+
+Optional<Thread::FileBlocker::BlockFlags> FileBlockerSet::observed_ready_flags(FileReadinessObserver& observer)
+{
+    SpinlockLocker lock(m_lock);
+    if (!observer.m_description)
+        return {};
+    return observer.m_description->should_unblock(observer.m_flags);
+}
+
+void FileBlockerSet::notify_observer_locked(FileReadinessObserver& observer)
+{
+    VERIFY(m_lock.is_locked());
+    auto ready_flags = observer.m_description->should_unblock(observer.m_flags);
+    if (ready_flags != Thread::FileBlocker::BlockFlags::None)
+        observer.observed_description_became_ready(ready_flags);
+}
+
+void FileBlockerSet::notify_observers_locked()
+{
+    for (auto& observer : m_observers)
+        notify_observer_locked(observer);
+}
+
 File::File() = default;
 File::~File() = default;
 
@@ -30,6 +89,41 @@ ErrorOr<void> File::close()
     return {};
 }
 
+ErrorOr<size_t> File::splice_read(OpenFileDescription& description, u64 offset, size_t count, SpliceSink const& sink)
+{
+    // NOTE: We can't put back what the sink didn't take, so this only works if we can simply read it again later.
+    if (!is_seekable())
+        return EINVAL;
+
+    static constexpr size_t bounce_buffer_size = 64 * KiB;
+    auto bounce_buffer = TRY(KBuffer::try_create_with_size("File: Splice bounce buffer"sv, bounce_buffer_size));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(bounce_buffer->data());
+
+    size_t nspliced = 0;
+    while (nspliced < count) {
+        auto nread_or_error = read(description, offset + nspliced, buffer, min(count - nspliced, bounce_buffer_size));
+        if (nread_or_error.is_error()) {
+            if (nspliced > 0)
+                break;
+            return nread_or_error.release_error();
+        }
+        auto nread = nread_or_error.value();
+        if (nread == 0)
+            break;
+
+        auto ntaken_or_error = sink(buffer, nread);
+        if (ntaken_or_error.is_error()) {
+            if (nspliced > 0)
+                break;
+            return ntaken_or_error.release_error();
+        }
+        nspliced += ntaken_or_error.value();
+        if (ntaken_or_error.value() < nread)
+            break;
+    }
+    return nspliced;
+}
+
 ErrorOr<void> File::ioctl(OpenFileDescription&, unsigned, Userspace<void*>)
 {
     return ENOTTY;
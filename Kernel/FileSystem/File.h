@@ -8,6 +8,8 @@
 
 #include <AK/AtomicRefCounted.h>
 #include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/IntrusiveList.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/Forward.h>
@@ -21,10 +23,46 @@ namespace Kernel {
 
 class File;
 
+// Unlike a blocker, an observer stays registered with a file until it is removed, and gets told every time
+// the description it observes becomes ready, without a thread having to block on it.
+class FileReadinessObserver {
+public:
+    using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+    virtual ~FileReadinessObserver() = default;
+
+protected:
+    FileReadinessObserver(OpenFileDescription& description, BlockFlags flags)
+        : m_description(&description)
+        , m_flags(flags)
+    {
+    }
+
+    // NOTE: These are called with the blocker set's lock held, so they must not block.
+    virtual void observed_description_became_ready(BlockFlags) = 0;
+    virtual void observed_description_was_closed() { }
+
+private:
+    friend class FileBlockerSet;
+
+    // NOTE: These are protected by the lock of the blocker set that we are registered with.
+    OpenFileDescription* m_description { nullptr };
+    BlockFlags m_flags { BlockFlags::None };
+    IntrusiveListNode<FileReadinessObserver> m_list_node;
+
+public:
+    using List = IntrusiveList<&FileReadinessObserver::m_list_node>;
+};
+
 class FileBlockerSet final : public Thread::BlockerSet {
 public:
     FileBlockerSet() { }
 
+    virtual ~FileBlockerSet() override
+    {
+        VERIFY(m_observers.is_empty());
+    }
+
     virtual bool should_add_blocker(Thread::Blocker& b, void* data) override
     {
         VERIFY(b.blocker_type() == Thread::Blocker::Type::File);
@@ -40,7 +78,22 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        notify_observers_locked();
     }
+
+    void add_observer(FileReadinessObserver&);
+    void remove_observer(FileReadinessObserver&);
+    void set_observed_flags(FileReadinessObserver&, Thread::FileBlocker::BlockFlags);
+    void detach_observers_of(OpenFileDescription const&);
+
+    // Returns an empty Optional if the observed description has been closed.
+    Optional<Thread::FileBlocker::BlockFlags> observed_ready_flags(FileReadinessObserver&);
+
+private:
+    void notify_observer_locked(FileReadinessObserver&);
+    void notify_observers_locked();
+
+    FileReadinessObserver::List m_observers;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -69,6 +122,13 @@ public:
 //   - Optional. If unimplemented, mmap() on this File will fail with -ENODEV.
 //   - Called by mmap() when userspace wants to memory-map this File somewhere.
 //   - Should return a VMObject suitable for mapping into the calling process.
+//
+// splice_read()
+//
+//   - Optional. Used by sendfile() to move data into another File without going through userspace.
+//   - Hands the data to a sink, ideally straight from where the File keeps it, and stops as soon as
+//     the sink takes less than it was offered. Returns the number of bytes the sink took.
+//   - If unimplemented, seekable Files go through a bounce buffer, and others fail with -EINVAL.
 
 class File
     : public AtomicRefCounted<File>
@@ -89,6 +149,10 @@ public:
     virtual void did_seek(OpenFileDescription&, off_t) { }
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) = 0;
     virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) = 0;
+
+    using SpliceSink = Function<ErrorOr<size_t>(UserOrKernelBuffer const&, size_t)>;
+    virtual ErrorOr<size_t> splice_read(OpenFileDescription&, u64, size_t, SpliceSink const&);
+
     virtual ErrorOr<void> ioctl(OpenFileDescription&, unsigned request, Userspace<void*> arg);
     virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared);
     virtual ErrorOr<struct stat> stat() const { return EBADF; }
@@ -114,6 +178,7 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_event_poll() const { return false; }
 
     virtual bool is_regular_file() const { return false; }
 
@@ -34,6 +34,10 @@ public:
     virtual Inode& root_inode() = 0;
     virtual bool supports_watchers() const { return false; }
 
+    // File systems whose directories only ever change through their own Inode::add_child() and
+    // Inode::remove_child() can have their lookups cached by the DirectoryEntryCache.
+    virtual bool supports_directory_entry_cache() const { return false; }
+
     bool is_readonly() const { return m_readonly; }
 
     virtual unsigned total_block_count() const { return 0; }
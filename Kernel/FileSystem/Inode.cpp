@@ -10,6 +10,7 @@
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -31,6 +32,19 @@ SpinlockProtected<Inode::AllInstancesList, LockRank::None>& Inode::all_instances
 void Inode::sync_all()
 {
     Vector<NonnullRefPtr<Inode>, 32> inodes;
+    Vector<NonnullLockRefPtr<Memory::SharedInodeVMObject>, 32> page_caches;
+    Inode::all_instances().with([&](auto& all_inodes) {
+        for (auto& inode : all_inodes) {
+            if (auto page_cache = inode.m_shared_vmobject.strong_ref())
+                page_caches.append(page_cache.release_nonnull());
+        }
+    });
+
+    for (auto& page_cache : page_caches) {
+        if (page_cache->amount_dirty() > 0)
+            (void)page_cache->write_back_dirty_pages();
+    }
+
     Inode::all_instances().with([&](auto& all_inodes) {
         for (auto& inode : all_inodes) {
             if (inode.is_metadata_dirty())
@@ -46,6 +60,8 @@ void Inode::sync_all()
 
 void Inode::sync()
 {
+    if (auto page_cache = shared_vmobject())
+        (void)page_cache->write_back_dirty_pages();
     if (is_metadata_dirty())
         (void)flush_metadata();
     fs().flush_writes();
@@ -109,15 +125,71 @@ ErrorOr<size_t> Inode::write_bytes(off_t offset, size_t length, UserOrKernelBuff
 {
     MutexLocker locker(m_inode_lock);
     TRY(prepare_to_write_data());
-    return write_bytes_locked(offset, length, target_buffer, open_description);
+
+    auto page_cache = m_shared_vmobject.strong_ref();
+    if (!page_cache || length == 0 || !metadata().is_regular_file())
+        return write_bytes_locked(offset, length, target_buffer, open_description);
+
+    // Overwriting data that the page cache covers only dirties the cached pages, they are written back later.
+    u64 end_offset = static_cast<u64>(offset) + length;
+    bool is_direct = open_description && open_description->is_direct();
+    if (!is_direct && end_offset <= size() && end_offset <= page_cache->size()) {
+        auto nwritten = TRY(page_cache->write_bytes(offset, length, target_buffer));
+        did_modify_contents();
+        return nwritten;
+    }
+
+    // Anything else (appends, writes past the end of the file, direct I/O) goes to the file system.
+    // Pending writes to the affected pages go first, and the pages are refreshed from the file system afterwards,
+    // including any hole that the write may have created between the old end of the file and the written data.
+    size_t first_page = min(static_cast<u64>(offset), static_cast<u64>(size())) / PAGE_SIZE;
+    size_t page_count = ceil_div(end_offset, static_cast<u64>(PAGE_SIZE)) - first_page;
+    TRY(page_cache->write_back_dirty_pages(first_page, page_count));
+    auto nwritten = TRY(write_bytes_locked(offset, length, target_buffer, open_description));
+    TRY(page_cache->reload_resident_pages(first_page, page_count));
+    return nwritten;
 }
 
 ErrorOr<size_t> Inode::read_bytes(off_t offset, size_t length, UserOrKernelBuffer& buffer, OpenFileDescription* open_description) const
+{
+    auto page_cache = shared_vmobject();
+    if (!page_cache || length == 0 || !metadata().is_regular_file())
+        return read_bytes_without_page_cache(offset, length, buffer, open_description);
+
+    if (open_description && open_description->is_direct()) {
+        // Direct I/O bypasses the page cache, so it must not miss data that hasn't been written back yet.
+        size_t first_page = offset / PAGE_SIZE;
+        size_t page_count = ceil_div(static_cast<u64>(offset) + length, static_cast<u64>(PAGE_SIZE)) - first_page;
+        TRY(page_cache->write_back_dirty_pages(first_page, page_count));
+        return read_bytes_without_page_cache(offset, length, buffer, open_description);
+    }
+
+    return page_cache->read_bytes(offset, length, buffer, open_description);
+}
+
+ErrorOr<size_t> Inode::read_bytes_without_page_cache(off_t offset, size_t length, UserOrKernelBuffer& buffer, OpenFileDescription* open_description) const
 {
     MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
     return read_bytes_locked(offset, length, buffer, open_description);
 }
 
+ErrorOr<void> Inode::truncate_and_update_page_cache(u64 size)
+{
+    MutexLocker locker(m_inode_lock);
+    TRY(truncate(size));
+    if (auto page_cache = m_shared_vmobject.strong_ref())
+        page_cache->did_truncate(size);
+    return {};
+}
+
+ErrorOr<void> Inode::fallocate(u64 offset, u64 length)
+{
+    // File systems that can't allocate storage ahead of time just make sure that the file is large enough.
+    if (size() >= offset + length)
+        return {};
+    return truncate_and_update_page_cache(offset + length);
+}
+
 ErrorOr<void> Inode::update_timestamps([[maybe_unused]] Optional<Time> atime, [[maybe_unused]] Optional<Time> ctime, [[maybe_unused]] Optional<Time> mtime)
 {
     return ENOTIMPL;
@@ -216,13 +288,22 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(InodeIdentifier, StringView name)
 {
+    if (fs().supports_directory_entry_cache())
+        DirectoryEntryCache::the().invalidate(identifier(), name);
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildCreated, name);
     });
 }
 
-void Inode::did_remove_child(InodeIdentifier, StringView name)
+void Inode::did_remove_child(InodeIdentifier child_id, StringView name)
 {
+    if (fs().supports_directory_entry_cache()) {
+        DirectoryEntryCache::the().invalidate(identifier(), name);
+        // If this was the last link to a directory, its inode number may be reused for a new one.
+        DirectoryEntryCache::the().invalidate_directory(child_id);
+    }
+
     if (name == "." || name == "..") {
         // These are just aliases and are not interesting to userspace.
         return;
@@ -267,7 +348,7 @@ ErrorOr<void> Inode::prepare_to_write_data()
 
 LockRefPtr<Memory::SharedInodeVMObject> Inode::shared_vmobject() const
 {
-    MutexLocker locker(m_inode_lock);
+    MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
     return m_shared_vmobject.strong_ref();
 }
 
@@ -33,6 +33,7 @@ class Inode : public ListedRefCounted<Inode, LockType::Spinlock>
     friend class VirtualFileSystem;
     friend class FileSystem;
     friend class InodeFile;
+    friend class Memory::SharedInodeVMObject;
 
 public:
     virtual ~Inode();
@@ -58,6 +59,9 @@ public:
     ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*);
     ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
 
+    // Bypasses the page cache (the shared VMObject), this is what fills it.
+    ErrorOr<size_t> read_bytes_without_page_cache(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
+
     virtual ErrorOr<void> attach(OpenFileDescription&) { return {}; }
     virtual void detach(OpenFileDescription&) { }
     virtual void did_seek(OpenFileDescription&, off_t) { }
@@ -72,10 +76,15 @@ public:
     virtual ErrorOr<void> chmod(mode_t) = 0;
     virtual ErrorOr<void> chown(UserID, GroupID) = 0;
     virtual ErrorOr<void> truncate(u64) { return {}; }
+    ErrorOr<void> truncate_and_update_page_cache(u64);
+    /// Make sure that the given range of the file is backed by storage, growing the file if needed.
+    virtual ErrorOr<void> fallocate(u64 offset, u64 length);
 
     ErrorOr<NonnullRefPtr<Custody>> resolve_as_link(Credentials const&, Custody& base, RefPtr<Custody>* out_parent, int options, int symlink_recursion_level) const;
 
     virtual ErrorOr<int> get_block_address(int) { return ENOTSUP; }
+    // Asks the file system to start reading the given range into its caches, without waiting for it.
+    virtual void readahead(u64, size_t) const { }
 
     LockRefPtr<LocalSocket> bound_socket() const;
     bool bind_socket(LocalSocket&);
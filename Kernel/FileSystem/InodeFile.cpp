@@ -24,11 +24,33 @@ InodeFile::InodeFile(NonnullRefPtr<Inode> inode)
 
 InodeFile::~InodeFile() = default;
 
+void InodeFile::attach_page_cache_if_needed()
+{
+    if (m_page_cache.with([](auto& page_cache) { return !page_cache.is_null(); }))
+        return;
+
+    // Only data that lives on some backing store is worth caching.
+    if (!m_inode->fs().is_file_backed() || !is_regular_file() || m_inode->size() == 0)
+        return;
+
+    // NOTE: If this fails, reads and writes simply keep going straight to the file system.
+    auto page_cache_or_error = Memory::SharedInodeVMObject::try_create_with_inode(*m_inode);
+    if (page_cache_or_error.is_error())
+        return;
+    m_page_cache.with([&](auto& page_cache) {
+        if (!page_cache)
+            page_cache = page_cache_or_error.release_value();
+    });
+}
+
 ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, UserOrKernelBuffer& buffer, size_t count)
 {
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
+    if (!description.is_direct())
+        attach_page_cache_if_needed();
+
     auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
     if (nread > 0) {
         Thread::current()->did_file_read(nread);
@@ -37,11 +59,47 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
     return nread;
 }
 
+ErrorOr<size_t> InodeFile::splice_read(OpenFileDescription& description, u64 offset, size_t count, SpliceSink const& sink)
+{
+    if (Checked<off_t>::addition_would_overflow(offset, count))
+        return EOVERFLOW;
+
+    if (!description.is_direct())
+        attach_page_cache_if_needed();
+
+    auto page_cache = m_page_cache.with([](auto& page_cache) { return page_cache; });
+    if (!page_cache || description.is_direct())
+        return File::splice_read(description, offset, count, sink);
+
+    size_t cached_count = 0;
+    if (offset < page_cache->size())
+        cached_count = min(count, page_cache->size() - offset);
+
+    auto nspliced = TRY(page_cache->splice_bytes(offset, cached_count, sink, &description));
+    if (nspliced == cached_count && nspliced < count && offset + nspliced < m_inode->size()) {
+        // The file has grown past the end of the page cache, so the rest has to go through a bounce buffer.
+        auto result = File::splice_read(description, offset + nspliced, count - nspliced, sink);
+        if (!result.is_error())
+            nspliced += result.value();
+        else if (nspliced == 0)
+            return result.release_error();
+    }
+
+    if (nspliced > 0) {
+        Thread::current()->did_file_read(nspliced);
+        evaluate_block_conditions();
+    }
+    return nspliced;
+}
+
 ErrorOr<size_t> InodeFile::write(OpenFileDescription& description, u64 offset, UserOrKernelBuffer const& data, size_t count)
 {
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
+    if (!description.is_direct())
+        attach_page_cache_if_needed();
+
     size_t nwritten = TRY(m_inode->write_bytes(offset, count, data, &description));
     if (nwritten > 0) {
         auto mtime_result = m_inode->update_timestamps({}, {}, kgettimeofday());
@@ -95,7 +153,7 @@ ErrorOr<NonnullOwnPtr<KString>> InodeFile::pseudo_path(OpenFileDescription const
 
 ErrorOr<void> InodeFile::truncate(u64 size)
 {
-    TRY(m_inode->truncate(size));
+    TRY(m_inode->truncate_and_update_page_cache(size));
     TRY(m_inode->update_timestamps({}, {}, kgettimeofday()));
     return {};
 }
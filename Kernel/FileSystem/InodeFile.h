@@ -7,6 +7,8 @@
 #pragma once
 
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 
 namespace Kernel {
 
@@ -32,6 +34,7 @@ public:
 
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
     virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override;
+    virtual ErrorOr<size_t> splice_read(OpenFileDescription&, u64, size_t, SpliceSink const&) override;
     virtual ErrorOr<void> ioctl(OpenFileDescription&, unsigned request, Userspace<void*> arg) override;
     virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
     virtual ErrorOr<struct stat> stat() const override { return inode().metadata().stat(); }
@@ -52,7 +55,11 @@ private:
     virtual bool is_regular_file() const override;
 
     explicit InodeFile(NonnullRefPtr<Inode>);
+    void attach_page_cache_if_needed();
+
     NonnullRefPtr<Inode> m_inode;
+    // Keeps the inode's page cache alive for as long as the file is open.
+    SpinlockProtected<LockRefPtr<Memory::SharedInodeVMObject>, LockRank::None> m_page_cache;
 };
 
 }
@@ -9,6 +9,7 @@
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
@@ -52,6 +53,7 @@ OpenFileDescription::OpenFileDescription(File& file)
 
 OpenFileDescription::~OpenFileDescription()
 {
+    blocker_set().detach_observers_of(*this);
     m_file->detach(*this);
     if (is_fifo())
         static_cast<FIFO*>(m_file.ptr())->detach(fifo_direction());
@@ -323,6 +325,18 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_event_poll() const
+{
+    return m_file->is_event_poll();
+}
+
+EventPoll* OpenFileDescription::event_poll()
+{
+    if (!is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
@@ -534,6 +548,11 @@ off_t OpenFileDescription::offset() const
     return m_state.with([](auto& state) { return state.current_offset; });
 }
 
+Optional<ReadaheadWindow::Range> OpenFileDescription::did_read_blocks(u64 first_block, u64 block_count, u64 file_block_count, size_t block_size)
+{
+    return m_state.with([&](auto& state) { return state.readahead_window.did_read(first_block, block_count, file_block_count, block_size); });
+}
+
 RefPtr<Custody const> OpenFileDescription::custody() const
 {
     return m_state.with([](auto& state) { return state.custody; });
@@ -13,6 +13,7 @@
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/FileSystem/ReadaheadWindow.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/VirtualAddress.h>
@@ -82,6 +83,9 @@ public:
     InodeWatcher const* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_event_poll() const;
+    EventPoll* event_poll();
+
     bool is_master_pty() const;
     MasterPTY const* master_pty() const;
     MasterPTY* master_pty();
@@ -122,6 +126,8 @@ public:
 
     off_t offset() const;
 
+    Optional<ReadaheadWindow::Range> did_read_blocks(u64 first_block, u64 block_count, u64 file_block_count, size_t block_size);
+
     ErrorOr<void> chown(Credentials const& credentials, UserID, GroupID);
 
     FileBlockerSet& blocker_set();
@@ -155,6 +161,7 @@ private:
         bool should_append : 1 { false };
         bool direct : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        ReadaheadWindow readahead_window;
     };
 
     SpinlockProtected<State, LockRank::None> m_state {};
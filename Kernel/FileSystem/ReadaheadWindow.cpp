@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/ReadaheadWindow.h>
+
+namespace Kernel {
+
+Optional<ReadaheadWindow::Range> ReadaheadWindow::did_read(u64 first_block, u64 block_count, u64 file_block_count, size_t block_size)
+{
+    VERIFY(block_size != 0);
+    auto end_block = first_block + block_count;
+
+    // Reads that don't line up with block boundaries will start in the last block the previous read ended in.
+    bool is_sequential = first_block == m_next_block || (m_next_block != 0 && first_block == m_next_block - 1);
+    m_next_block = end_block;
+
+    if (!is_sequential) {
+        m_window_blocks = 0;
+        m_prefetched_until_block = 0;
+        return {};
+    }
+
+    if (m_window_blocks == 0) {
+        m_window_blocks = max<u64>(initial_window_size / block_size, 1);
+        m_prefetched_until_block = end_block;
+    }
+
+    // Only start the next batch once the reader has consumed half of the previous one,
+    // so that the prefetch overlaps with the reader working through the rest of it.
+    if (m_prefetched_until_block > end_block + m_window_blocks / 2)
+        return {};
+
+    auto first_block_to_prefetch = max(m_prefetched_until_block, end_block);
+    if (first_block_to_prefetch >= file_block_count)
+        return {};
+
+    auto block_count_to_prefetch = min(m_window_blocks, file_block_count - first_block_to_prefetch);
+    m_prefetched_until_block = first_block_to_prefetch + block_count_to_prefetch;
+    m_window_blocks = min(m_window_blocks * 2, max<u64>(maximum_window_size / block_size, 1));
+    return Range { first_block_to_prefetch, block_count_to_prefetch };
+}
+
+}
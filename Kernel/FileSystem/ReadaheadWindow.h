@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Tracks how an open file description is being read, and decides when and how
+// far to read ahead of it. The window starts out small on the first sequential
+// read and doubles every time the reader catches up with it, up to a maximum.
+// Any non-sequential read collapses the window again.
+class ReadaheadWindow {
+public:
+    static constexpr size_t initial_window_size = 16 * KiB;
+    static constexpr size_t maximum_window_size = 512 * KiB;
+
+    struct Range {
+        u64 first_block { 0 };
+        u64 block_count { 0 };
+    };
+
+    // Called after blocks [first_block, first_block + block_count) of a file were read.
+    // Returns the blocks that should be prefetched next, if any.
+    Optional<Range> did_read(u64 first_block, u64 block_count, u64 file_block_count, size_t block_size);
+
+private:
+    u64 m_next_block { 0 };
+    u64 m_prefetched_until_block { 0 };
+    u64 m_window_blocks { 0 };
+};
+
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/BlockCache.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSBlockCache::SysFSBlockCache(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSBlockCache> SysFSBlockCache::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSBlockCache(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSBlockCache::try_generate(KBufferBuilder& builder)
+{
+    auto statistics = BlockBasedFileSystem::cache_statistics();
+
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("cache_size"sv, statistics.cache_size));
+    TRY(json.add("dirty_size"sv, statistics.dirty_size));
+    TRY(json.add("target_size"sv, statistics.target_size));
+    TRY(json.add("readahead_requests"sv, statistics.readahead_requests));
+    TRY(json.add("readahead_blocks"sv, statistics.readahead_blocks));
+    TRY(json.add("readahead_hits"sv, statistics.readahead_hits));
+    TRY(json.add("readahead_wasted"sv, statistics.readahead_wasted));
+    TRY(json.add("write_back_runs"sv, statistics.write_back_runs));
+    TRY(json.add("write_back_blocks"sv, statistics.write_back_blocks));
+    TRY(json.add("throttled_writes"sv, statistics.throttled_writes));
+    TRY(json.finish());
+    return {};
+}
+
+}
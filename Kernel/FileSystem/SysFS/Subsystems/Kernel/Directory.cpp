@@ -7,6 +7,7 @@
 #include <AK/Error.h>
 #include <AK/Try.h>
 #include <Kernel/FileSystem/SysFS/Component.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/BlockCache.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/CPUInfo.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Constants/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Directory.h>
@@ -35,6 +36,7 @@ UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSGlobalKernelStatsDirectory> SysFSGlobalK
         list.append(global_constants_directory);
         list.append(SysFSDiskUsage::must_create(*global_kernel_stats_directory));
         list.append(SysFSMemoryStatus::must_create(*global_kernel_stats_directory));
+        list.append(SysFSBlockCache::must_create(*global_kernel_stats_directory));
         list.append(SysFSSystemStatistics::must_create(*global_kernel_stats_directory));
         list.append(SysFSOverallProcesses::must_create(*global_kernel_stats_directory));
         list.append(SysFSCPUInformation::must_create(*global_kernel_stats_directory));
@@ -35,6 +35,10 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_available"sv, system_memory.physical_pages - system_memory.physical_pages_used));
     TRY(json.add("physical_committed"sv, system_memory.physical_pages_committed));
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
+    TRY(json.add("large_pages_mapped"sv, system_memory.large_pages_mapped));
+    TRY(json.add("large_page_allocations"sv, system_memory.large_page_allocations));
+    TRY(json.add("large_page_allocation_failures"sv, system_memory.large_page_allocation_failures));
+    TRY(json.add("large_page_splits"sv, system_memory.large_page_splits));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
     TRY(json.finish());
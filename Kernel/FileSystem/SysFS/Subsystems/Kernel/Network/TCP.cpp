@@ -41,6 +41,15 @@ ErrorOr<void> SysFSNetworkTCPStats::try_generate(KBufferBuilder& builder)
         TRY(obj.add("bytes_in"sv, socket.bytes_in()));
         TRY(obj.add("packets_out"sv, socket.packets_out()));
         TRY(obj.add("bytes_out"sv, socket.bytes_out()));
+        TRY(obj.add("retransmitted_packets"sv, socket.retransmitted_packets()));
+        TRY(obj.add("congestion_control"sv, socket.congestion_control().name()));
+        TRY(obj.add("congestion_window"sv, socket.congestion_control().congestion_window()));
+        TRY(obj.add("slow_start_threshold"sv, socket.congestion_control().slow_start_threshold()));
+        TRY(obj.add("send_window_size"sv, socket.send_window_size()));
+        TRY(obj.add("smoothed_rtt_us"sv, socket.smoothed_rtt().to_microseconds()));
+        TRY(obj.add("retransmission_timeout_ms"sv, socket.retransmission_timeout().to_milliseconds()));
+        TRY(obj.add("window_scaling"sv, socket.is_window_scaling_enabled()));
+        TRY(obj.add("sack"sv, socket.is_sack_enabled()));
         auto current_process_credentials = Process::current().credentials();
         if (current_process_credentials->is_superuser() || current_process_credentials->uid() == socket.origin_uid()) {
             TRY(obj.add("origin_pid"sv, socket.origin_pid().value()));
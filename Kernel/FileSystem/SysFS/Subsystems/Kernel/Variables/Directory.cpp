@@ -11,6 +11,9 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/CoredumpDirectory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/DumpKmallocStack.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/LoopbackPacketLoss.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/MutexAdaptiveSpinning.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/TCPCongestionControl.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/UBSANDeadly.h>
 
 namespace Kernel {
@@ -23,6 +26,9 @@ UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSGlobalKernelVariablesDirectory> SysFSGlo
         list.append(SysFSDumpKmallocStacks::must_create(*global_variables_directory));
         list.append(SysFSUBSANDeadly::must_create(*global_variables_directory));
         list.append(SysFSCoredumpDirectory::must_create(*global_variables_directory));
+        list.append(SysFSTCPCongestionControl::must_create(*global_variables_directory));
+        list.append(SysFSLoopbackPacketLoss::must_create(*global_variables_directory));
+        list.append(SysFSMutexAdaptiveSpinning::must_create(*global_variables_directory));
         return {};
     }));
     return global_variables_directory;
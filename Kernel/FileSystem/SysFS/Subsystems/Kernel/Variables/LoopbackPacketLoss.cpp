@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/LoopbackPacketLoss.h>
+#include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLoopbackPacketLoss::SysFSLoopbackPacketLoss(SysFSDirectory const& parent_directory)
+    : SysFSSystemStringVariable(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSLoopbackPacketLoss> SysFSLoopbackPacketLoss::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSLoopbackPacketLoss(parent_directory)).release_nonnull();
+}
+
+ErrorOr<NonnullOwnPtr<KString>> SysFSLoopbackPacketLoss::value() const
+{
+    return KString::formatted("{}", LoopbackAdapter::packet_loss_permille());
+}
+
+ErrorOr<void> SysFSLoopbackPacketLoss::set_value(NonnullOwnPtr<KString> new_value)
+{
+    auto permille = new_value->view().to_uint();
+    if (!permille.has_value() || permille.value() > 1000)
+        return EINVAL;
+    LoopbackAdapter::set_packet_loss_permille(permille.value());
+    return {};
+}
+
+mode_t SysFSLoopbackPacketLoss::permissions() const
+{
+    return S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+}
+
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/StringVariable.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+// How many of every 1000 packets the loopback adapter drops on purpose, to see how the network stack copes with loss.
+class SysFSLoopbackPacketLoss final : public SysFSSystemStringVariable {
+public:
+    virtual StringView name() const override { return "loopback_packet_loss_permille"sv; }
+    static NonnullLockRefPtr<SysFSLoopbackPacketLoss> must_create(SysFSDirectory const&);
+
+private:
+    virtual ErrorOr<NonnullOwnPtr<KString>> value() const override;
+    virtual ErrorOr<void> set_value(NonnullOwnPtr<KString> new_value) override;
+
+    explicit SysFSLoopbackPacketLoss(SysFSDirectory const&);
+
+    virtual mode_t permissions() const override;
+};
+
+}
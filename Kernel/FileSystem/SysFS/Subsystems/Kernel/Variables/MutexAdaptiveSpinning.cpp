@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/MutexAdaptiveSpinning.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSMutexAdaptiveSpinning::SysFSMutexAdaptiveSpinning(SysFSDirectory const& parent_directory)
+    : SysFSSystemBooleanVariable(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSMutexAdaptiveSpinning> SysFSMutexAdaptiveSpinning::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSMutexAdaptiveSpinning(parent_directory)).release_nonnull();
+}
+
+bool SysFSMutexAdaptiveSpinning::value() const
+{
+    return Mutex::is_adaptive_spinning_enabled();
+}
+
+void SysFSMutexAdaptiveSpinning::set_value(bool new_value)
+{
+    Mutex::set_adaptive_spinning_enabled(new_value);
+}
+
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/BooleanVariable.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+// Whether a contended Mutex spins for a while before blocking, as long as its holder is running on another processor.
+class SysFSMutexAdaptiveSpinning final : public SysFSSystemBooleanVariable {
+public:
+    virtual StringView name() const override { return "mutex_adaptive_spinning"sv; }
+    static NonnullLockRefPtr<SysFSMutexAdaptiveSpinning> must_create(SysFSDirectory const&);
+
+private:
+    virtual bool value() const override;
+    virtual void set_value(bool new_value) override;
+
+    explicit SysFSMutexAdaptiveSpinning(SysFSDirectory const&);
+};
+
+}
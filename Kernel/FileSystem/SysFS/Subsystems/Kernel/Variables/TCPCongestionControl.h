@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/StringVariable.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+class SysFSTCPCongestionControl final : public SysFSSystemStringVariable {
+public:
+    virtual StringView name() const override { return "tcp_congestion_control"sv; }
+    static NonnullLockRefPtr<SysFSTCPCongestionControl> must_create(SysFSDirectory const&);
+
+private:
+    virtual ErrorOr<NonnullOwnPtr<KString>> value() const override;
+    virtual ErrorOr<void> set_value(NonnullOwnPtr<KString> new_value) override;
+
+    explicit SysFSTCPCongestionControl(SysFSDirectory const&);
+
+    virtual mode_t permissions() const override;
+};
+
+}
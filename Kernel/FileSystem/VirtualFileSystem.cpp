@@ -14,6 +14,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -171,6 +172,8 @@ ErrorOr<void> VirtualFileSystem::unmount(Custody& mountpoint_custody)
             if (custody_path->view() != mountpoint_path->view())
                 continue;
             NonnullRefPtr<FileSystem> fs = mount.guest_fs();
+            // NOTE: Cached directory entries keep their inodes alive, which would make the file system look busy.
+            DirectoryEntryCache::the().invalidate_file_system(fs->fsid());
             TRY(fs->prepare_to_unmount());
             fs->mounted_count({}).with([&](auto& mounted_count) {
                 VERIFY(mounted_count > 0);
@@ -442,7 +445,7 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> VirtualFileSystem::open(Process cons
         return EROFS;
 
     if (should_truncate_file) {
-        TRY(inode.truncate(0));
+        TRY(inode.truncate_and_update_page_cache(0));
         TRY(inode.update_timestamps({}, {}, kgettimeofday()));
     }
     auto description = TRY(OpenFileDescription::try_create(custody));
@@ -1117,7 +1120,8 @@ ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(Cre
         }
 
         // Okay, let's look up this part.
-        auto child_or_error = parent.inode().lookup(part);
+        // NOTE: Mounts are looked at below, so the cache only ever has to know about the file systems' own directories.
+        auto child_or_error = DirectoryEntryCache::the().lookup(parent.inode(), part);
         if (child_or_error.is_error()) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
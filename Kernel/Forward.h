@@ -19,12 +19,12 @@ class Coredump;
 class Credentials;
 class Custody;
 class Device;
-class DiskCache;
 class DoubleBuffer;
 class File;
 class FATInode;
 class OpenFileDescription;
 class DisplayConnector;
+class EventPoll;
 class FileSystem;
 class FutexQueue;
 class IPv4Socket;
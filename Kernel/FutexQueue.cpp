@@ -33,57 +33,72 @@ bool FutexQueue::should_add_blocker(Thread::Blocker& b, void*)
 ErrorOr<u32> FutexQueue::wake_n_requeue(u32 wake_count, Function<ErrorOr<FutexQueue*>()> const& get_target_queue, u32 requeue_count, bool& is_empty, bool& is_empty_target)
 {
     is_empty_target = false;
-    SpinlockLocker lock(m_lock);
-
-    dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue({}, {})", this, wake_count, requeue_count);
-
     u32 did_wake = 0, did_requeue = 0;
-    unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
-        VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
-        auto& blocker = static_cast<Thread::FutexBlocker&>(b);
-
-        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
-        VERIFY(did_wake < wake_count);
-        if (blocker.unblock()) {
-            if (++did_wake >= wake_count)
-                stop_iterating = true;
-            return true;
-        }
-        return false;
-    });
-    is_empty = is_empty_and_no_imminent_waits_locked();
-    if (requeue_count > 0) {
-        auto blockers_to_requeue = do_take_blockers(requeue_count);
-        if (!blockers_to_requeue.is_empty()) {
-            if (auto* target_futex_queue = TRY(get_target_queue())) {
-                dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue requeueing {} blockers to {}", this, blockers_to_requeue.size(), target_futex_queue);
-
-                // While still holding m_lock, notify each blocker
-                for (auto& info : blockers_to_requeue) {
-                    VERIFY(info.blocker->blocker_type() == Thread::Blocker::Type::Futex);
-                    auto& blocker = *static_cast<Thread::FutexBlocker*>(info.blocker);
-                    blocker.begin_requeue();
+    bool has_waiters_to_requeue = false;
+    {
+        SpinlockLocker lock(m_lock);
+
+        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue({}, {})", this, wake_count, requeue_count);
+
+        // NOTE: A wake count of zero is valid here, and is used to move all waiters to the
+        //       target queue without waking any of them up.
+        if (wake_count > 0) {
+            unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
+                VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+                auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+
+                dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
+                VERIFY(did_wake < wake_count);
+                if (blocker.unblock()) {
+                    if (++did_wake >= wake_count)
+                        stop_iterating = true;
+                    return true;
                 }
-
-                lock.unlock();
-                did_requeue = blockers_to_requeue.size();
-
-                SpinlockLocker target_lock(target_futex_queue->m_lock);
-                // Now that we have the lock of the target, append the blockers
-                // and notify them that they completed the move
-                for (auto& info : blockers_to_requeue) {
-                    VERIFY(info.blocker->blocker_type() == Thread::Blocker::Type::Futex);
-                    auto& blocker = *static_cast<Thread::FutexBlocker*>(info.blocker);
-                    blocker.finish_requeue(*target_futex_queue);
-                }
-                target_futex_queue->do_append_blockers(move(blockers_to_requeue));
-                is_empty_target = target_futex_queue->is_empty_and_no_imminent_waits_locked();
-            } else {
-                dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue could not get target queue to requeue {} blockers", this, blockers_to_requeue.size());
-                do_append_blockers(move(blockers_to_requeue));
-            }
+                return false;
+            });
         }
+        is_empty = is_empty_and_no_imminent_waits_locked();
+        has_waiters_to_requeue = requeue_count > 0 && !is_empty_locked();
+    }
+    if (!has_waiters_to_requeue)
+        return did_wake;
+
+    // We only get (and possibly create) the target queue if there is anything to move to it.
+    auto* target_futex_queue = TRY(get_target_queue());
+    if (!target_futex_queue) {
+        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue could not get target queue", this);
+        return did_wake;
     }
+
+    // The blockers must be on one of the two queues at all times, or a wake on the target could
+    // miss them while they are in transit. So hold both locks while moving them, and take them in
+    // address order, so that two requeues in opposite directions can't deadlock.
+    if (target_futex_queue == this) {
+        SpinlockLocker lock(m_lock);
+        auto blockers_to_requeue = do_take_blockers(requeue_count);
+        did_requeue = blockers_to_requeue.size();
+        do_append_blockers(move(blockers_to_requeue));
+        return did_wake + did_requeue;
+    }
+    auto& first_queue = this < target_futex_queue ? *this : *target_futex_queue;
+    auto& second_queue = this < target_futex_queue ? *target_futex_queue : *this;
+    SpinlockLocker first_lock(first_queue.m_lock);
+    SpinlockLocker second_lock(second_queue.m_lock);
+
+    auto blockers_to_requeue = do_take_blockers(requeue_count);
+    dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue requeueing {} blockers to {}", this, blockers_to_requeue.size(), target_futex_queue);
+    for (auto& info : blockers_to_requeue) {
+        VERIFY(info.blocker->blocker_type() == Thread::Blocker::Type::Futex);
+        auto& blocker = *static_cast<Thread::FutexBlocker*>(info.blocker);
+        blocker.begin_requeue();
+        blocker.finish_requeue(*target_futex_queue);
+    }
+    did_requeue = blockers_to_requeue.size();
+    target_futex_queue->do_append_blockers(move(blockers_to_requeue));
+
+    // The requeued waiters may have been the last ones on this queue.
+    is_empty = is_empty_and_no_imminent_waits_locked();
+    is_empty_target = target_futex_queue->is_empty_and_no_imminent_waits_locked();
     return did_wake + did_requeue;
 }
 
@@ -10,12 +10,19 @@
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/PerformanceManager.h>
 #include <Kernel/Thread.h>
 
 extern bool g_in_early_boot;
 
 namespace Kernel {
 
+Atomic<bool> Mutex::s_adaptive_spinning_enabled { true };
+
+// How many times we check on the holder before we give up and block. This is in the same ballpark as
+// a round trip through the scheduler, so spinning for any longer than that wouldn't pay off.
+static constexpr u32 adaptive_spin_limit = 4096;
+
 void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
 {
     // NOTE: This may be called from an interrupt handler (not an IRQ handler)
@@ -30,6 +37,9 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     auto* current_thread = Thread::current();
 
     SpinlockLocker lock(m_lock);
+    if (current_thread && m_mode == Mode::Exclusive && m_holder != current_thread)
+        spin_while_holder_is_running(*current_thread, lock);
+
     bool did_block = false;
     Mode current_mode = m_mode;
     switch (current_mode) {
@@ -40,6 +50,7 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
         VERIFY(m_shared_holders == 0);
         if (mode == Mode::Exclusive) {
             m_holder = current_thread;
+            m_exclusive_since = PerformanceManager::lock_event_timestamp(PERF_EVENT_LOCK_HOLD);
         } else {
             VERIFY(mode == Mode::Shared);
             ++m_shared_holders;
@@ -207,8 +218,57 @@ void Mutex::unlock()
         VERIFY(current_mode == Mode::Exclusive ? !m_holder : m_shared_holders == 0);
 
         m_mode = Mode::Unlocked;
-        unblock_waiters(current_mode);
+        m_release_count.fetch_add(1, AK::memory_order_relaxed);
+        auto exclusive_since = exchange(m_exclusive_since, 0);
+        auto was_contended = unblock_waiters(current_mode);
+        if (current_mode == Mode::Exclusive && current_thread)
+            did_release_exclusive(*current_thread, exclusive_since, was_contended);
+    }
+}
+
+void Mutex::did_release_exclusive(Thread& current_thread, u64 exclusive_since, bool was_contended)
+{
+    // NOTE: Only contended hold times are interesting, as those are the ones that made somebody else wait.
+    if (exclusive_since != 0 && was_contended)
+        PerformanceManager::add_lock_hold_event(current_thread, this, m_name, exclusive_since);
+}
+
+void Mutex::spin_while_holder_is_running(Thread& current_thread, SpinlockLocker<Spinlock<LockRank::None>>& lock)
+{
+    VERIFY(m_mode == Mode::Exclusive);
+    VERIFY(m_holder != &current_thread);
+    if (!is_adaptive_spinning_enabled() || Processor::count() == 1)
+        return;
+    // NOTE: Our own m_lock is the only critical section we're allowed to be in, as we'd hold up deferred calls otherwise.
+    if (Processor::in_critical() > 1)
+        return;
+    // The holder can only finish up while it's running, so there's no point in spinning otherwise.
+    if (!m_holder || m_holder->state() != Thread::State::Running)
+        return;
+    // Releasing the lock hands it straight to the first blocked thread, so we'd only end up blocking behind them.
+    // This also keeps spinning threads from starving the ones that already went to sleep.
+    auto has_blocked_threads = m_blocked_thread_lists.with([](auto& lists) {
+        return !lists.exclusive.is_empty() || !lists.shared.is_empty() || !lists.exclusive_big_lock.is_empty();
+    });
+    if (has_blocked_threads)
+        return;
+
+    LockRefPtr<Thread> holder = m_holder;
+    auto release_count = m_release_count.load(AK::memory_order_relaxed);
+    lock.unlock();
+
+    dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) spinning while {} is running...", this, m_name, *holder);
+    for (u32 i = 0; i < adaptive_spin_limit; ++i) {
+        Processor::wait_check();
+        if (m_release_count.load(AK::memory_order_relaxed) != release_count)
+            break;
+        if (holder->state() != Thread::State::Running)
+            break;
     }
+
+    // NOTE: Let go of the holder before taking m_lock again, in case we are the last ones keeping it alive.
+    holder = nullptr;
+    lock.lock();
 }
 
 void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock, u32 requested_locks)
@@ -231,6 +291,7 @@ void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<Loc
     });
 
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waiting...", this, m_name);
+    auto wait_start = PerformanceManager::lock_event_timestamp(PERF_EVENT_LOCK_WAIT);
     current_thread.block(*this, lock, requested_locks);
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waited", this, m_name);
 
@@ -245,14 +306,16 @@ void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<Loc
         else
             remove_from_list(lists.list_for_mode(mode));
     });
+
+    PerformanceManager::add_lock_wait_event(current_thread, this, m_name, wait_start);
 }
 
-void Mutex::unblock_waiters(Mode previous_mode)
+bool Mutex::unblock_waiters(Mode previous_mode)
 {
     VERIFY(m_times_locked == 0);
     VERIFY(m_mode == Mode::Unlocked);
 
-    m_blocked_thread_lists.with([&](auto& lists) {
+    return m_blocked_thread_lists.with([&](auto& lists) {
         auto unblock_shared = [&]() {
             if (lists.shared.is_empty())
                 return false;
@@ -274,20 +337,17 @@ void Mutex::unblock_waiters(Mode previous_mode)
                 m_mode = Mode::Exclusive;
                 m_times_locked = next_exclusive_thread->unblock_from_mutex(*this);
                 m_holder = next_exclusive_thread;
+                m_exclusive_since = PerformanceManager::lock_event_timestamp(PERF_EVENT_LOCK_HOLD);
                 return true;
             }
             return false;
         };
 
-        if (m_behavior == MutexBehavior::BigLock) {
-            unblock_exclusive(lists.exclusive_big_lock);
-        } else if (previous_mode == Mode::Exclusive) {
-            if (!unblock_shared())
-                unblock_exclusive(lists.exclusive);
-        } else {
-            if (!unblock_exclusive(lists.exclusive))
-                unblock_shared();
-        }
+        if (m_behavior == MutexBehavior::BigLock)
+            return unblock_exclusive(lists.exclusive_big_lock);
+        if (previous_mode == Mode::Exclusive)
+            return unblock_shared() || unblock_exclusive(lists.exclusive);
+        return unblock_exclusive(lists.exclusive) || unblock_shared();
     });
 }
 
@@ -317,7 +377,10 @@ auto Mutex::force_unlock_exclusive_if_locked(u32& lock_count_to_restore) -> Mode
         lock_count_to_restore = m_times_locked;
         m_times_locked = 0;
         m_mode = Mode::Unlocked;
-        unblock_waiters(Mode::Exclusive);
+        m_release_count.fetch_add(1, AK::memory_order_relaxed);
+        auto exclusive_since = exchange(m_exclusive_since, 0);
+        auto was_contended = unblock_waiters(Mode::Exclusive);
+        did_release_exclusive(*current_thread, exclusive_since, was_contended);
         break;
     }
     case Mode::Unlocked: {
@@ -361,6 +424,7 @@ void Mutex::restore_exclusive_lock(u32 lock_count, [[maybe_unused]] LockLocation
             m_times_locked = lock_count;
             VERIFY(!m_holder);
             m_holder = current_thread;
+            m_exclusive_since = PerformanceManager::lock_event_timestamp(PERF_EVENT_LOCK_HOLD);
         } else {
             VERIFY(m_mode == Mode::Exclusive);
             VERIFY(m_holder == current_thread);
@@ -62,6 +62,9 @@ public:
 
     [[nodiscard]] StringView name() const { return m_name; }
 
+    static bool is_adaptive_spinning_enabled() { return s_adaptive_spinning_enabled.load(AK::memory_order_relaxed); }
+    static void set_adaptive_spinning_enabled(bool enabled) { s_adaptive_spinning_enabled.store(enabled, AK::memory_order_relaxed); }
+
     static StringView mode_to_string(Mode mode)
     {
         switch (mode) {
@@ -84,7 +87,9 @@ private:
 
     // FIXME: Allow any lock rank.
     void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32);
-    void unblock_waiters(Mode);
+    void spin_while_holder_is_running(Thread&, SpinlockLocker<Spinlock<LockRank::None>>&);
+    [[nodiscard]] bool unblock_waiters(Mode);
+    void did_release_exclusive(Thread&, u64 exclusive_since, bool was_contended);
 
     StringView m_name;
     Mode m_mode { Mode::Unlocked };
@@ -104,6 +109,15 @@ private:
     LockRefPtr<Thread> m_holder;
     size_t m_shared_holders { 0 };
 
+    // When the current exclusive holder got the lock, see PerformanceManager::lock_event_timestamp().
+    // This is only tracked while lock hold times are being profiled.
+    u64 m_exclusive_since { 0 };
+
+    // Bumped whenever the lock is released, so threads spinning without holding m_lock can notice.
+    Atomic<u32> m_release_count { 0 };
+
+    static Atomic<bool> s_adaptive_spinning_enabled;
+
     struct BlockedThreadLists {
         BlockedThreadList exclusive;
         BlockedThreadList shared;
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/PerformanceManager.h>
+
+namespace Kernel {
+
+u64 spinlock_wait_begin()
+{
+    return PerformanceManager::lock_event_timestamp(PERF_EVENT_LOCK_WAIT);
+}
+
+void spinlock_wait_end(void const* lock, u64 wait_start)
+{
+    if (wait_start == 0)
+        return;
+    // NOTE: IRQ handlers run on top of whatever thread they interrupted, so don't blame that one for their spinning.
+    if (Processor::current_in_irq())
+        return;
+    if (auto* current_thread = Thread::current())
+        PerformanceManager::add_lock_wait_event(*current_thread, lock, "Spinlock"sv, wait_start);
+}
+
+}
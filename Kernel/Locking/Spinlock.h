@@ -9,10 +9,16 @@
 #include <AK/Atomic.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/Processor.h>
+#include <Kernel/Locking/LockMode.h>
 #include <Kernel/Locking/LockRank.h>
 
 namespace Kernel {
 
+// Contended spinlocks report how long they spun as PERF_EVENT_LOCK_WAIT events while that is being profiled.
+// Note: These can't be inline, as the performance event machinery depends on this header.
+u64 spinlock_wait_begin();
+void spinlock_wait_end(void const* lock, u64 wait_start);
+
 template<LockRank Rank>
 class Spinlock {
     AK_MAKE_NONCOPYABLE(Spinlock);
@@ -26,8 +32,13 @@ public:
         InterruptsState previous_interrupts_state = processor_interrupts_state();
         Processor::enter_critical();
         Processor::disable_interrupts();
-        while (m_lock.exchange(1, AK::memory_order_acquire) != 0)
-            Processor::wait_check();
+        if (m_lock.exchange(1, AK::memory_order_acquire) != 0) [[unlikely]] {
+            auto wait_start = spinlock_wait_begin();
+            do {
+                Processor::wait_check();
+            } while (m_lock.exchange(1, AK::memory_order_acquire) != 0);
+            spinlock_wait_end(this, wait_start);
+        }
         track_lock_acquire(m_rank);
         return previous_interrupts_state;
     }
@@ -73,11 +84,13 @@ public:
         auto& proc = Processor::current();
         FlatPtr cpu = FlatPtr(&proc);
         FlatPtr expected = 0;
-        while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel)) {
-            if (expected == cpu)
-                break;
-            Processor::wait_check();
-            expected = 0;
+        if (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel) && expected != cpu) [[unlikely]] {
+            auto wait_start = spinlock_wait_begin();
+            do {
+                Processor::wait_check();
+                expected = 0;
+            } while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel));
+            spinlock_wait_end(this, wait_start);
         }
         if (m_recursions == 0)
             track_lock_acquire(m_rank);
@@ -85,6 +98,26 @@ public:
         return previous_interrupts_state;
     }
 
+    // Like lock(), but gives up right away instead of spinning if another processor holds the lock.
+    [[nodiscard]] bool try_lock(InterruptsState& previous_interrupts_state)
+    {
+        auto interrupts_state = processor_interrupts_state();
+        Processor::disable_interrupts();
+        Processor::enter_critical();
+        FlatPtr cpu = FlatPtr(&Processor::current());
+        FlatPtr expected = 0;
+        if (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel) && expected != cpu) {
+            Processor::leave_critical();
+            restore_processor_interrupts_state(interrupts_state);
+            return false;
+        }
+        if (m_recursions == 0)
+            track_lock_acquire(m_rank);
+        m_recursions++;
+        previous_interrupts_state = interrupts_state;
+        return true;
+    }
+
     void unlock(InterruptsState previous_interrupts_state)
     {
         VERIFY_INTERRUPTS_DISABLED();
@@ -120,6 +153,116 @@ private:
     static constexpr LockRank const m_rank { Rank };
 };
 
+// Lets any number of readers hold the lock at the same time, but only a single writer.
+// NOTE: A writer keeps new readers out while it waits, so a steady stream of them can't starve it.
+template<LockRank Rank>
+class RWSpinlock {
+    AK_MAKE_NONCOPYABLE(RWSpinlock);
+    AK_MAKE_NONMOVABLE(RWSpinlock);
+
+public:
+    RWSpinlock() = default;
+
+    InterruptsState lock_shared()
+    {
+        InterruptsState previous_interrupts_state = processor_interrupts_state();
+        Processor::enter_critical();
+        Processor::disable_interrupts();
+        for (;;) {
+            auto state = m_state.load(AK::memory_order_relaxed);
+            if (!(state & writer_bit) && m_state.compare_exchange_strong(state, state + 1, AK::memory_order_acquire))
+                break;
+            Processor::wait_check();
+        }
+        track_lock_acquire(m_rank);
+        return previous_interrupts_state;
+    }
+
+    void unlock_shared(InterruptsState previous_interrupts_state)
+    {
+        VERIFY((m_state.load(AK::memory_order_relaxed) & ~writer_bit) != 0);
+        track_lock_release(m_rank);
+        m_state.fetch_sub(1, AK::memory_order_release);
+
+        Processor::leave_critical();
+        restore_processor_interrupts_state(previous_interrupts_state);
+    }
+
+    InterruptsState lock_exclusive()
+    {
+        InterruptsState previous_interrupts_state = processor_interrupts_state();
+        Processor::enter_critical();
+        Processor::disable_interrupts();
+        if (auto state = m_state.fetch_or(writer_bit, AK::memory_order_acquire); state != 0) [[unlikely]] {
+            auto wait_start = spinlock_wait_begin();
+            while (state & writer_bit) {
+                Processor::wait_check();
+                state = m_state.fetch_or(writer_bit, AK::memory_order_acquire);
+            }
+            // Now that no new readers can get in, wait for the current ones to leave.
+            while (m_state.load(AK::memory_order_acquire) != writer_bit)
+                Processor::wait_check();
+            spinlock_wait_end(this, wait_start);
+        }
+        track_lock_acquire(m_rank);
+        return previous_interrupts_state;
+    }
+
+    void unlock_exclusive(InterruptsState previous_interrupts_state)
+    {
+        VERIFY(m_state.load(AK::memory_order_relaxed) == writer_bit);
+        track_lock_release(m_rank);
+        m_state.store(0, AK::memory_order_release);
+
+        Processor::leave_critical();
+        restore_processor_interrupts_state(previous_interrupts_state);
+    }
+
+    [[nodiscard]] ALWAYS_INLINE bool is_locked() const
+    {
+        return m_state.load(AK::memory_order_relaxed) != 0;
+    }
+
+    [[nodiscard]] ALWAYS_INLINE bool is_exclusively_locked() const
+    {
+        return m_state.load(AK::memory_order_relaxed) & writer_bit;
+    }
+
+private:
+    static constexpr u32 writer_bit = 1u << 31;
+
+    Atomic<u32> m_state { 0 };
+    static constexpr LockRank const m_rank { Rank };
+};
+
+template<LockRank Rank>
+class [[nodiscard]] RWSpinlockLocker {
+    AK_MAKE_NONCOPYABLE(RWSpinlockLocker);
+    AK_MAKE_NONMOVABLE(RWSpinlockLocker);
+
+public:
+    RWSpinlockLocker(RWSpinlock<Rank>& lock, LockMode mode)
+        : m_lock(lock)
+        , m_mode(mode)
+    {
+        VERIFY(m_mode == LockMode::Shared || m_mode == LockMode::Exclusive);
+        m_previous_interrupts_state = m_mode == LockMode::Shared ? m_lock.lock_shared() : m_lock.lock_exclusive();
+    }
+
+    ~RWSpinlockLocker()
+    {
+        if (m_mode == LockMode::Shared)
+            m_lock.unlock_shared(m_previous_interrupts_state);
+        else
+            m_lock.unlock_exclusive(m_previous_interrupts_state);
+    }
+
+private:
+    RWSpinlock<Rank>& m_lock;
+    LockMode m_mode;
+    InterruptsState m_previous_interrupts_state { InterruptsState::Disabled };
+};
+
 template<typename LockType>
 class [[nodiscard]] SpinlockLocker {
     AK_MAKE_NONCOPYABLE(SpinlockLocker);
@@ -66,6 +66,18 @@ public:
         return callback(*lock);
     }
 
+    // Runs the callback only if the lock can be taken without spinning, and returns whether it did.
+    template<typename Callback>
+    bool try_with(Callback callback)
+    {
+        InterruptsState previous_interrupts_state;
+        if (!m_spinlock.try_lock(previous_interrupts_state))
+            return false;
+        callback(m_value);
+        m_spinlock.unlock(previous_interrupts_state);
+        return true;
+    }
+
     template<typename Callback>
     void for_each_const(Callback callback) const
     {
@@ -275,6 +275,43 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_committed_large_page(Badge<Region>, size_t first_page_index)
+{
+    // Only a range that nobody has touched yet can be backed by a large page in one go.
+    auto is_untouched = [&] {
+        if (first_page_index + pages_per_large_page > page_count())
+            return false;
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            auto const& page = physical_pages()[first_page_index + i];
+            if (!page || !page->is_lazy_committed_page())
+                return false;
+        }
+        return true;
+    };
+
+    {
+        SpinlockLocker locker(m_lock);
+        if (!m_unused_committed_pages.has_value() || m_unused_committed_pages->page_count() < pages_per_large_page || !is_untouched())
+            return false;
+    }
+
+    // NOTE: Zeroing out the large page takes a while, so we don't hold the lock while doing that.
+    auto paddr = m_unused_committed_pages->take_large_page();
+    if (!paddr.has_value())
+        return false;
+
+    SpinlockLocker locker(m_lock);
+    if (!is_untouched()) {
+        // Someone else faulted in a page in this range in the meantime.
+        locker.unlock();
+        m_unused_committed_pages->return_large_page(paddr.value());
+        return false;
+    }
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        physical_pages()[first_page_index + i] = PhysicalPage::create(paddr->offset(i * PAGE_SIZE));
+    return true;
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -364,8 +364,10 @@ UNMAP_AFTER_INIT void MemoryManager::parse_memory_map()
             global_data.physical_regions.append(PhysicalRegion::try_create(range.lower, range.upper).release_nonnull());
         }
 
-        for (auto& region : global_data.physical_regions)
-            global_data.system_memory_info.physical_pages += region->size();
+        m_system_memory_info.with([&](auto& system_memory_info) {
+            for (auto& region : global_data.physical_regions)
+                system_memory_info.physical_pages += region->size();
+        });
 
         register_reserved_ranges();
         for (auto& range : global_data.reserved_memory_ranges) {
@@ -374,10 +376,12 @@ UNMAP_AFTER_INIT void MemoryManager::parse_memory_map()
 
         initialize_physical_pages();
 
-        VERIFY(global_data.system_memory_info.physical_pages > 0);
+        m_system_memory_info.with([&](auto& system_memory_info) {
+            VERIFY(system_memory_info.physical_pages > 0);
 
-        // We start out with no committed pages
-        global_data.system_memory_info.physical_pages_uncommitted = global_data.system_memory_info.physical_pages;
+            // We start out with no committed pages
+            system_memory_info.physical_pages_uncommitted = system_memory_info.physical_pages;
+        });
 
         for (auto& used_range : global_data.used_memory_ranges) {
             dmesgln("MM: {} range @ {} - {} (size {:#x})", UserMemoryRangeTypeNames[to_underlying(used_range.type)], used_range.start, used_range.end.offset(-1), used_range.end.as_ptr() - used_range.start.as_ptr());
@@ -437,8 +441,10 @@ UNMAP_AFTER_INIT void MemoryManager::initialize_physical_pages()
             VERIFY_NOT_REACHED();
         }
 
-        VERIFY(global_data.system_memory_info.physical_pages >= physical_page_array_pages_and_page_tables_count);
-        global_data.system_memory_info.physical_pages -= physical_page_array_pages_and_page_tables_count;
+        m_system_memory_info.with([&](auto& system_memory_info) {
+            VERIFY(system_memory_info.physical_pages >= physical_page_array_pages_and_page_tables_count);
+            system_memory_info.physical_pages -= physical_page_array_pages_and_page_tables_count;
+        });
 
         if (found_region->size() == physical_page_array_pages_and_page_tables_count) {
             // We're stealing the entire region
@@ -566,9 +572,13 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
     u32 page_table_index = (vaddr.get() >> 12) & 0x1ff;
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
-    PageDirectoryEntry const& pde = pd[page_directory_index];
+    PageDirectoryEntry& pde = pd[page_directory_index];
     if (!pde.is_present())
         return nullptr;
+#if ARCH(X86_64)
+    if (pde.is_huge())
+        split_large_page(page_directory, pde, vaddr);
+#endif
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
@@ -583,8 +593,13 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    if (pde.is_present()) {
+#if ARCH(X86_64)
+        if (pde.is_huge())
+            split_large_page(page_directory, pde, vaddr);
+#endif
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
+    }
 
     bool did_purge = false;
     auto page_table_or_error = allocate_physical_page(ShouldZeroFill::Yes, &did_purge);
@@ -625,6 +640,10 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
     if (pde.is_present()) {
+#if ARCH(X86_64)
+        if (pde.is_huge())
+            split_large_page(page_directory, pde, vaddr);
+#endif
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
         pte.clear();
@@ -647,6 +666,86 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+bool MemoryManager::try_map_large_page(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+#if ARCH(X86_64)
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % large_page_size == 0);
+    // NOTE: The kernel's own mappings are set up by hand, and nothing expects to find a large page there.
+    if (&page_directory == m_kernel_page_directory.ptr())
+        return false;
+
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (!pde.is_present() || pde.is_huge())
+        return false;
+
+    auto page_table_base = pde.page_table_base();
+    auto* page_table = quickmap_pt(PhysicalAddress(page_table_base));
+    auto const& first_pte = page_table[0];
+    // NOTE: The PAT bit lives somewhere else in a large page entry, so leave those alone.
+    if (!first_pte.is_present() || first_pte.is_pat() || first_pte.physical_page_base() % large_page_size != 0)
+        return false;
+    // NOTE: The CPU sets the accessed and dirty bits on its own, so they don't tell the pages apart.
+    static constexpr u64 accessed_and_dirty_bits = (1 << 5) | (1 << 6);
+    for (size_t i = 1; i < pages_per_large_page; ++i) {
+        if ((page_table[i].raw() | accessed_and_dirty_bits) != ((first_pte.raw() + i * PAGE_SIZE) | accessed_and_dirty_bits))
+            return false;
+    }
+
+    // NOTE: We keep the page table around (and populated), so that splitting the large page up again
+    //       never needs to allocate anything.
+    if (page_directory.m_page_tables_behind_large_pages.try_set(vaddr.get(), page_table_base).is_error())
+        return false;
+
+    pde.set_page_table_base(first_pte.physical_page_base());
+    pde.set_user_allowed(first_pte.is_user_allowed());
+    pde.set_writable(first_pte.is_writable());
+    pde.set_write_through(first_pte.is_write_through());
+    pde.set_cache_disabled(first_pte.is_cache_disabled());
+    pde.set_global(first_pte.is_global());
+    pde.set_execute_disabled(first_pte.is_execute_disabled());
+    pde.set_huge(true);
+    flush_tlb(&page_directory, vaddr, pages_per_large_page);
+
+    m_system_memory_info.with([](auto& system_memory_info) {
+        ++system_memory_info.large_pages_mapped;
+    });
+    return true;
+#else
+    (void)page_directory;
+    (void)vaddr;
+    return false;
+#endif
+}
+
+#if ARCH(X86_64)
+void MemoryManager::split_large_page(PageDirectory& page_directory, PageDirectoryEntry& pde, VirtualAddress vaddr)
+{
+    auto large_page_vaddr = VirtualAddress { vaddr.get() & ~(large_page_size - 1) };
+    auto page_table_base = page_directory.m_page_tables_behind_large_pages.take(large_page_vaddr.get());
+    VERIFY(page_table_base.has_value());
+
+    // The page table still describes the same mapping, so all we have to do is to point at it again.
+    pde.clear();
+    pde.set_page_table_base(page_table_base.value());
+    pde.set_user_allowed(true);
+    pde.set_present(true);
+    pde.set_writable(true);
+    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    flush_tlb(&page_directory, large_page_vaddr, pages_per_large_page);
+
+    m_system_memory_info.with([](auto& system_memory_info) {
+        --system_memory_info.large_pages_mapped;
+        ++system_memory_info.large_page_splits;
+    });
+}
+#endif
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     dmesgln("Initialize MMU");
@@ -843,14 +942,14 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region_with_vmobje
 ErrorOr<CommittedPhysicalPageSet> MemoryManager::commit_physical_pages(size_t page_count)
 {
     VERIFY(page_count > 0);
-    auto result = m_global_data.with([&](auto& global_data) -> ErrorOr<CommittedPhysicalPageSet> {
-        if (global_data.system_memory_info.physical_pages_uncommitted < page_count) {
-            dbgln("MM: Unable to commit {} pages, have only {}", page_count, global_data.system_memory_info.physical_pages_uncommitted);
+    auto result = m_system_memory_info.with([&](auto& system_memory_info) -> ErrorOr<CommittedPhysicalPageSet> {
+        if (system_memory_info.physical_pages_uncommitted < page_count) {
+            dbgln("MM: Unable to commit {} pages, have only {}", page_count, system_memory_info.physical_pages_uncommitted);
             return ENOMEM;
         }
 
-        global_data.system_memory_info.physical_pages_uncommitted -= page_count;
-        global_data.system_memory_info.physical_pages_committed += page_count;
+        system_memory_info.physical_pages_uncommitted -= page_count;
+        system_memory_info.physical_pages_committed += page_count;
         return CommittedPhysicalPageSet { {}, page_count };
     });
     if (result.is_error()) {
@@ -881,132 +980,321 @@ void MemoryManager::uncommit_physical_pages(Badge<CommittedPhysicalPageSet>, siz
 {
     VERIFY(page_count > 0);
 
-    m_global_data.with([&](auto& global_data) {
-        VERIFY(global_data.system_memory_info.physical_pages_committed >= page_count);
+    m_system_memory_info.with([&](auto& system_memory_info) {
+        VERIFY(system_memory_info.physical_pages_committed >= page_count);
 
-        global_data.system_memory_info.physical_pages_uncommitted += page_count;
-        global_data.system_memory_info.physical_pages_committed -= page_count;
+        system_memory_info.physical_pages_uncommitted += page_count;
+        system_memory_info.physical_pages_committed -= page_count;
     });
 }
 
-void MemoryManager::deallocate_physical_page(PhysicalAddress paddr)
+size_t MemoryManager::take_free_pages_from_regions(Span<PhysicalAddress> pages)
 {
     return m_global_data.with([&](auto& global_data) {
-        // Are we returning a user page?
+        size_t count = 0;
         for (auto& region : global_data.physical_regions) {
-            if (!region->contains(paddr))
-                continue;
+            while (count < pages.size()) {
+                auto paddr = region->take_free_page();
+                if (!paddr.has_value())
+                    break;
+                pages[count++] = paddr.value();
+            }
+            if (count == pages.size())
+                break;
+        }
+        return count;
+    });
+}
 
-            region->return_page(paddr);
-            --global_data.system_memory_info.physical_pages_used;
+void MemoryManager::return_free_pages_to_regions(ReadonlySpan<PhysicalAddress> pages)
+{
+    if (pages.is_empty())
+        return;
 
-            // Always return pages to the uncommitted pool. Pages that were
-            // committed and allocated are only freed upon request. Once
-            // returned there is no guarantee being able to get them back.
-            ++global_data.system_memory_info.physical_pages_uncommitted;
+    m_global_data.with([&](auto& global_data) {
+        for (auto paddr : pages) {
+            auto it = global_data.physical_regions.find_if([&](auto& region) { return region->contains(paddr); });
+            if (it.is_end())
+                PANIC("MM: return_free_pages_to_regions couldn't figure out region for page @ {}", paddr);
+            (*it)->return_page(paddr);
+        }
+    });
+}
+
+void MemoryManager::drain_physical_page_magazines()
+{
+    Processor::for_each([&](Processor& processor) {
+        auto* data = processor.get_specific<MemoryManagerData>();
+        if (!data)
             return;
+        data->m_physical_page_magazine.with([&](auto& magazine) {
+            return_free_pages_to_regions(magazine.pages.span().trim(magazine.page_count));
+            magazine.page_count = 0;
+            return_free_pages_to_regions(magazine.zeroed_pages.span().trim(magazine.zeroed_page_count));
+            magazine.zeroed_page_count = 0;
+        });
+    });
+}
+
+Optional<PhysicalAddress> MemoryManager::take_free_physical_page(ShouldZeroFill should_zero_fill, bool& is_zeroed, bool committed)
+{
+    using PhysicalPageMagazine = MemoryManagerData::PhysicalPageMagazine;
+
+    // NOTE: We may get moved to another processor after looking up the magazine, but that's fine, since it's
+    //       only about keeping lock contention down. The magazine's own lock keeps it consistent either way.
+    auto take_from_magazine = [&](MemoryManagerData& data) -> Optional<PhysicalAddress> {
+        return data.m_physical_page_magazine.with([&](auto& magazine) -> Optional<PhysicalAddress> {
+            // There aren't that many pre-zeroed pages, so keep them for the allocations that want zeroes.
+            if (should_zero_fill == ShouldZeroFill::Yes && magazine.zeroed_page_count > 0) {
+                is_zeroed = true;
+                return magazine.zeroed_pages[--magazine.zeroed_page_count];
+            }
+            if (magazine.page_count == 0)
+                magazine.page_count = take_free_pages_from_regions(magazine.pages.span().trim(PhysicalPageMagazine::batch_size));
+            if (magazine.page_count > 0)
+                return magazine.pages[--magazine.page_count];
+            if (magazine.zeroed_page_count > 0) {
+                is_zeroed = true;
+                return magazine.zeroed_pages[--magazine.zeroed_page_count];
+            }
+            return {};
+        });
+    };
+
+    if (auto paddr = take_from_magazine(get_data()); paddr.has_value())
+        return paddr;
+
+    // The physical regions have run dry, but the other processors may still be holding on to some free pages.
+    for (;;) {
+        Optional<PhysicalAddress> paddr;
+        Processor::for_each([&](Processor& processor) {
+            auto* data = processor.get_specific<MemoryManagerData>();
+            if (!data || paddr.has_value())
+                return;
+            paddr = take_from_magazine(*data);
+        });
+        if (paddr.has_value() || !committed)
+            return paddr;
+
+        // A committed page is guaranteed to be free somewhere, but it may have moved between a magazine and
+        // the regions behind our back (e.g. because a magazine overflowed), so keep looking until we find it.
+        Processor::wait_check();
+    }
+}
+
+void MemoryManager::deallocate_physical_page(PhysicalAddress paddr)
+{
+    using PhysicalPageMagazine = MemoryManagerData::PhysicalPageMagazine;
+
+    // NOTE: The page has to be back in a magazine before it's accounted as free, or a committed
+    //       allocation could come looking for it before it can be found.
+    get_data().m_physical_page_magazine.with([&](auto& magazine) {
+        if (magazine.page_count == PhysicalPageMagazine::capacity) {
+            // Hand back the pages that have been sitting here the longest, and keep the recently
+            // freed ones, which are more likely to still be in the cache.
+            return_free_pages_to_regions(magazine.pages.span().trim(PhysicalPageMagazine::batch_size));
+            for (size_t i = PhysicalPageMagazine::batch_size; i < PhysicalPageMagazine::capacity; ++i)
+                magazine.pages[i - PhysicalPageMagazine::batch_size] = magazine.pages[i];
+            magazine.page_count -= PhysicalPageMagazine::batch_size;
         }
-        PANIC("MM: deallocate_physical_page couldn't figure out region for page @ {}", paddr);
+        magazine.pages[magazine.page_count++] = paddr;
+    });
+
+    m_system_memory_info.with([&](auto& system_memory_info) {
+        --system_memory_info.physical_pages_used;
+
+        // Always return pages to the uncommitted pool. Pages that were
+        // committed and allocated are only freed upon request. Once
+        // returned there is no guarantee being able to get them back.
+        ++system_memory_info.physical_pages_uncommitted;
     });
 }
 
-RefPtr<PhysicalPage> MemoryManager::find_free_physical_page(bool committed)
+RefPtr<PhysicalPage> MemoryManager::find_free_physical_page(bool committed, ShouldZeroFill should_zero_fill)
 {
-    RefPtr<PhysicalPage> page;
-    m_global_data.with([&](auto& global_data) {
+    bool did_account_for_page = m_system_memory_info.with([&](auto& system_memory_info) {
         if (committed) {
             // Draw from the committed pages pool. We should always have these pages available
-            VERIFY(global_data.system_memory_info.physical_pages_committed > 0);
-            global_data.system_memory_info.physical_pages_committed--;
+            VERIFY(system_memory_info.physical_pages_committed > 0);
+            system_memory_info.physical_pages_committed--;
         } else {
             // We need to make sure we don't touch pages that we have committed to
-            if (global_data.system_memory_info.physical_pages_uncommitted == 0)
-                return;
-            global_data.system_memory_info.physical_pages_uncommitted--;
-        }
-        for (auto& region : global_data.physical_regions) {
-            page = region->take_free_page();
-            if (!page.is_null()) {
-                ++global_data.system_memory_info.physical_pages_used;
-                break;
-            }
+            if (system_memory_info.physical_pages_uncommitted == 0)
+                return false;
+            system_memory_info.physical_pages_uncommitted--;
         }
+        ++system_memory_info.physical_pages_used;
+        return true;
     });
 
-    if (page.is_null())
+    bool is_zeroed = false;
+    Optional<PhysicalAddress> paddr;
+    if (did_account_for_page) {
+        paddr = take_free_physical_page(should_zero_fill, is_zeroed, committed);
+        if (!paddr.has_value()) {
+            m_system_memory_info.with([&](auto& system_memory_info) {
+                --system_memory_info.physical_pages_used;
+                if (committed)
+                    system_memory_info.physical_pages_committed++;
+                else
+                    system_memory_info.physical_pages_uncommitted++;
+            });
+        }
+    }
+
+    if (!paddr.has_value()) {
         dbgln("MM: couldn't find free physical page. Continuing...");
+        return {};
+    }
+
+    if (should_zero_fill == ShouldZeroFill::Yes && !is_zeroed) {
+        InterruptDisabler disabler;
+        auto* ptr = quickmap_page(paddr.value());
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+
+    return PhysicalPage::create(paddr.value());
+}
 
-    return page;
+bool MemoryManager::zero_free_physical_page()
+{
+    using PhysicalPageMagazine = MemoryManagerData::PhysicalPageMagazine;
+
+    // NOTE: The page is still accounted as free while we're clearing it, but it's not in any magazine or region,
+    //       so don't let anything else run on this processor until it's back where a committed allocation can find it.
+    InterruptDisabler disabler;
+    auto& magazine = get_data().m_physical_page_magazine;
+    auto paddr = magazine.with([&](auto& magazine) -> Optional<PhysicalAddress> {
+        if (magazine.zeroed_page_count == PhysicalPageMagazine::zeroed_capacity)
+            return {};
+        if (magazine.page_count == 0)
+            magazine.page_count = take_free_pages_from_regions(magazine.pages.span().trim(PhysicalPageMagazine::batch_size));
+        if (magazine.page_count == 0)
+            return {};
+        return magazine.pages[--magazine.page_count];
+    });
+    if (!paddr.has_value())
+        return false;
+
+    auto* ptr = quickmap_page(paddr.value());
+    memset(ptr, 0, PAGE_SIZE);
+    unquickmap_page();
+
+    magazine.with([&](auto& magazine) {
+        if (magazine.zeroed_page_count < PhysicalPageMagazine::zeroed_capacity)
+            magazine.zeroed_pages[magazine.zeroed_page_count++] = paddr.value();
+        else
+            return_free_pages_to_regions({ &paddr.value(), 1 });
+    });
+    return true;
 }
 
 NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill should_zero_fill)
 {
-    auto page = find_free_physical_page(true);
+    auto page = find_free_physical_page(true, should_zero_fill);
     VERIFY(page);
-    if (should_zero_fill == ShouldZeroFill::Yes) {
+    return page.release_nonnull();
+}
+
+Optional<PhysicalAddress> MemoryManager::allocate_committed_large_page(Badge<CommittedPhysicalPageSet>)
+{
+    // NOTE: Unlike single pages, we don't go looking through the magazines here. A large page
+    //       is only ever an optimization, and the caller can always fall back to single pages.
+    auto paddr = m_global_data.with([&](auto& global_data) -> Optional<PhysicalAddress> {
+        for (auto& region : global_data.physical_regions) {
+            if (auto paddr = region->take_free_large_page(); paddr.has_value())
+                return paddr;
+        }
+        return {};
+    });
+
+    m_system_memory_info.with([&](auto& system_memory_info) {
+        if (!paddr.has_value()) {
+            ++system_memory_info.large_page_allocation_failures;
+            return;
+        }
+        VERIFY(system_memory_info.physical_pages_committed >= pages_per_large_page);
+        system_memory_info.physical_pages_committed -= pages_per_large_page;
+        system_memory_info.physical_pages_used += pages_per_large_page;
+        ++system_memory_info.large_page_allocations;
+    });
+
+    if (!paddr.has_value())
+        return {};
+
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
         InterruptDisabler disabler;
-        auto* ptr = quickmap_page(*page);
+        auto* ptr = quickmap_page(paddr->offset(i * PAGE_SIZE));
         memset(ptr, 0, PAGE_SIZE);
         unquickmap_page();
     }
-    return page.release_nonnull();
+    return paddr;
+}
+
+void MemoryManager::deallocate_committed_large_page(Badge<CommittedPhysicalPageSet>, PhysicalAddress paddr)
+{
+    Array<PhysicalAddress, pages_per_large_page> pages;
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        pages[i] = paddr.offset(i * PAGE_SIZE);
+    return_free_pages_to_regions(pages.span());
+
+    m_system_memory_info.with([&](auto& system_memory_info) {
+        VERIFY(system_memory_info.physical_pages_used >= pages_per_large_page);
+        system_memory_info.physical_pages_used -= pages_per_large_page;
+        system_memory_info.physical_pages_committed += pages_per_large_page;
+    });
 }
 
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
-    return m_global_data.with([&](auto&) -> ErrorOr<NonnullRefPtr<PhysicalPage>> {
-        auto page = find_free_physical_page(false);
-        bool purged_pages = false;
-
-        if (!page) {
-            // We didn't have a single free physical page. Let's try to free something up!
-            // First, we look for a purgeable VMObject in the volatile state.
-            for_each_vmobject([&](auto& vmobject) {
-                if (!vmobject.is_anonymous())
-                    return IterationDecision::Continue;
-                auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject);
-                if (!anonymous_vmobject.is_purgeable() || !anonymous_vmobject.is_volatile())
-                    return IterationDecision::Continue;
-                if (auto purged_page_count = anonymous_vmobject.purge()) {
-                    dbgln("MM: Purge saved the day! Purged {} pages from AnonymousVMObject", purged_page_count);
-                    page = find_free_physical_page(false);
-                    purged_pages = true;
-                    VERIFY(page);
-                    return IterationDecision::Break;
-                }
+    auto page = find_free_physical_page(false, should_zero_fill);
+    bool purged_pages = false;
+
+    // NOTE: Other processors may be allocating while we free something up below, so whatever
+    //       we release isn't guaranteed to still be there by the time we try to take it.
+    if (!page) {
+        // We didn't have a single free physical page. Let's try to free something up!
+        // First, we look for a purgeable VMObject in the volatile state.
+        for_each_vmobject([&](auto& vmobject) {
+            if (!vmobject.is_anonymous())
                 return IterationDecision::Continue;
-            });
-        }
-        if (!page) {
-            // Second, we look for a file-backed VMObject with clean pages.
-            for_each_vmobject([&](auto& vmobject) {
-                if (!vmobject.is_inode())
-                    return IterationDecision::Continue;
-                auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject);
-                if (auto released_page_count = inode_vmobject.try_release_clean_pages(1)) {
-                    dbgln("MM: Clean inode release saved the day! Released {} pages from InodeVMObject", released_page_count);
-                    page = find_free_physical_page(false);
-                    VERIFY(page);
+            auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject);
+            if (!anonymous_vmobject.is_purgeable() || !anonymous_vmobject.is_volatile())
+                return IterationDecision::Continue;
+            if (auto purged_page_count = anonymous_vmobject.purge()) {
+                dbgln("MM: Purge saved the day! Purged {} pages from AnonymousVMObject", purged_page_count);
+                purged_pages = true;
+                page = find_free_physical_page(false, should_zero_fill);
+                if (page)
                     return IterationDecision::Break;
-                }
+            }
+            return IterationDecision::Continue;
+        });
+    }
+    if (!page) {
+        // Second, we look for a file-backed VMObject with clean pages.
+        for_each_vmobject([&](auto& vmobject) {
+            if (!vmobject.is_inode())
                 return IterationDecision::Continue;
-            });
-        }
-        if (!page) {
-            dmesgln("MM: no physical pages available");
-            return ENOMEM;
-        }
-
-        if (should_zero_fill == ShouldZeroFill::Yes) {
-            auto* ptr = quickmap_page(*page);
-            memset(ptr, 0, PAGE_SIZE);
-            unquickmap_page();
-        }
+            auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject);
+            if (auto released_page_count = inode_vmobject.try_release_clean_pages(1)) {
+                dbgln("MM: Clean inode release saved the day! Released {} pages from InodeVMObject", released_page_count);
+                page = find_free_physical_page(false, should_zero_fill);
+                if (page)
+                    return IterationDecision::Break;
+            }
+            return IterationDecision::Continue;
+        });
+    }
+    if (!page) {
+        dmesgln("MM: no physical pages available");
+        return ENOMEM;
+    }
 
-        if (did_purge)
-            *did_purge = purged_pages;
-        return page.release_nonnull();
-    });
+    if (did_purge)
+        *did_purge = purged_pages;
+    return page.release_nonnull();
 }
 
 ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_contiguous_physical_pages(size_t size)
@@ -1014,22 +1302,40 @@ ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_contiguous_
     VERIFY(!(size % PAGE_SIZE));
     size_t page_count = ceil_div(size, static_cast<size_t>(PAGE_SIZE));
 
-    auto physical_pages = TRY(m_global_data.with([&](auto& global_data) -> ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> {
-        // We need to make sure we don't touch pages that we have committed to
-        if (global_data.system_memory_info.physical_pages_uncommitted < page_count)
+    // We need to make sure we don't touch pages that we have committed to
+    TRY(m_system_memory_info.with([&](auto& system_memory_info) -> ErrorOr<void> {
+        if (system_memory_info.physical_pages_uncommitted < page_count)
             return ENOMEM;
+        system_memory_info.physical_pages_uncommitted -= page_count;
+        system_memory_info.physical_pages_used += page_count;
+        return {};
+    }));
 
-        for (auto& physical_region : global_data.physical_regions) {
-            auto physical_pages = physical_region->take_contiguous_free_pages(page_count);
-            if (!physical_pages.is_empty()) {
-                global_data.system_memory_info.physical_pages_uncommitted -= page_count;
-                global_data.system_memory_info.physical_pages_used += page_count;
-                return physical_pages;
+    auto take_contiguous_free_pages = [&] {
+        return m_global_data.with([&](auto& global_data) -> Vector<NonnullRefPtr<PhysicalPage>> {
+            for (auto& physical_region : global_data.physical_regions) {
+                auto physical_pages = physical_region->take_contiguous_free_pages(page_count);
+                if (!physical_pages.is_empty())
+                    return physical_pages;
             }
-        }
+            return {};
+        });
+    };
+
+    auto physical_pages = take_contiguous_free_pages();
+    if (physical_pages.is_empty()) {
+        // The pages held by the per-processor magazines could be what's keeping the free blocks apart.
+        drain_physical_page_magazines();
+        physical_pages = take_contiguous_free_pages();
+    }
+    if (physical_pages.is_empty()) {
+        m_system_memory_info.with([&](auto& system_memory_info) {
+            system_memory_info.physical_pages_uncommitted += page_count;
+            system_memory_info.physical_pages_used -= page_count;
+        });
         dmesgln("MM: no contiguous physical pages available");
         return ENOMEM;
-    }));
+    }
 
     {
         auto cleanup_region = TRY(MM.allocate_kernel_region(physical_pages[0]->paddr(), PAGE_SIZE * page_count, {}, Region::Access::Read | Region::Access::Write));
@@ -1137,8 +1443,18 @@ bool MemoryManager::validate_user_stack(AddressSpace& space, VirtualAddress vadd
     if (!is_user_address(vaddr))
         return false;
 
-    auto* region = find_user_region_from_vaddr(space, vaddr);
-    return region && region->is_user() && region->is_stack();
+    return space.region_tree().with_region_containing(vaddr, [](Region* region) {
+        return region && region->is_user() && region->is_stack();
+    });
+}
+
+bool MemoryManager::validate_user_stack_of_current_address_space(VirtualAddress vaddr) const
+{
+    // NOTE: This doesn't take the address space lock, the region tree's own lock keeps the region alive while we check it.
+    auto page_directory = PageDirectory::find_current();
+    if (!page_directory || !page_directory->address_space())
+        return false;
+    return validate_user_stack(*page_directory->address_space(), vaddr);
 }
 
 void MemoryManager::unregister_kernel_region(Region& region)
@@ -1201,6 +1517,22 @@ void CommittedPhysicalPageSet::uncommit_one()
     MM.uncommit_physical_pages({}, 1);
 }
 
+Optional<PhysicalAddress> CommittedPhysicalPageSet::take_large_page()
+{
+    if (m_page_count < pages_per_large_page)
+        return {};
+    auto paddr = MM.allocate_committed_large_page({});
+    if (paddr.has_value())
+        m_page_count -= pages_per_large_page;
+    return paddr;
+}
+
+void CommittedPhysicalPageSet::return_large_page(PhysicalAddress paddr)
+{
+    MM.deallocate_committed_large_page({}, paddr);
+    m_page_count += pages_per_large_page;
+}
+
 void MemoryManager::copy_physical_page(PhysicalPage& physical_page, u8 page_buffer[PAGE_SIZE])
 {
     auto* quickmapped_page = quickmap_page(physical_page);
@@ -1227,10 +1559,10 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_unbacked_region_anywhere(
 
 MemoryManager::SystemMemoryInfo MemoryManager::get_system_memory_info()
 {
-    return m_global_data.with([&](auto& global_data) {
-        auto physical_pages_unused = global_data.system_memory_info.physical_pages_committed + global_data.system_memory_info.physical_pages_uncommitted;
-        VERIFY(global_data.system_memory_info.physical_pages == (global_data.system_memory_info.physical_pages_used + physical_pages_unused));
-        return global_data.system_memory_info;
+    return m_system_memory_info.with([&](auto& system_memory_info) {
+        auto physical_pages_unused = system_memory_info.physical_pages_committed + system_memory_info.physical_pages_uncommitted;
+        VERIFY(system_memory_info.physical_pages == (system_memory_info.physical_pages_used + physical_pages_unused));
+        return system_memory_info;
     });
 }
 }
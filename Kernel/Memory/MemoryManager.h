@@ -6,12 +6,14 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Badge.h>
 #include <AK/Concepts.h>
 #include <AK/HashTable.h>
 #include <AK/IntrusiveRedBlackTree.h>
 #include <Kernel/Forward.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Memory/AllocationStrategy.h>
 #include <Kernel/Memory/PhysicalPage.h>
 #include <Kernel/Memory/PhysicalRegion.h>
@@ -33,6 +35,10 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// Anonymous userspace memory is mapped with large pages where the architecture allows for it.
+static constexpr size_t large_page_size = 2 * MiB;
+static constexpr size_t pages_per_large_page = large_page_size / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -87,6 +93,22 @@ struct MemoryManagerData {
 
     Spinlock<LockRank::None> m_quickmap_in_use {};
     InterruptsState m_quickmap_previous_interrupts_state;
+
+    // A stash of free physical pages for this processor, so that most page allocations and
+    // deallocations don't have to go through the global lock. These pages still count as free.
+    struct PhysicalPageMagazine {
+        static constexpr size_t capacity = 64;
+        static constexpr size_t batch_size = capacity / 2;
+        static constexpr size_t zeroed_capacity = 128;
+
+        Array<PhysicalAddress, capacity> pages;
+        size_t page_count { 0 };
+
+        // Pages that the page zeroing task has already cleared while the processor was idle.
+        Array<PhysicalAddress, zeroed_capacity> zeroed_pages;
+        size_t zeroed_page_count { 0 };
+    };
+    SpinlockProtected<PhysicalPageMagazine, LockRank::None> m_physical_page_magazine {};
 };
 
 // This class represents a set of committed physical pages.
@@ -115,6 +137,10 @@ public:
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
     void uncommit_one();
 
+    // Takes pages_per_large_page committed pages at once, as a zeroed, naturally aligned and physically contiguous block.
+    Optional<PhysicalAddress> take_large_page();
+    void return_large_page(PhysicalAddress);
+
     void operator=(CommittedPhysicalPageSet&&) = delete;
 
 private:
@@ -124,6 +150,7 @@ private:
 class MemoryManager {
     friend class PageDirectory;
     friend class AnonymousVMObject;
+    friend class SharedInodeVMObject;
     friend class Region;
     friend class RegionTree;
     friend class VMObject;
@@ -153,6 +180,7 @@ public:
     static void enter_address_space(AddressSpace&);
 
     bool validate_user_stack(AddressSpace&, VirtualAddress) const;
+    bool validate_user_stack_of_current_address_space(VirtualAddress) const;
 
     enum class ShouldZeroFill {
         No,
@@ -163,6 +191,8 @@ public:
     void uncommit_physical_pages(Badge<CommittedPhysicalPageSet>, size_t page_count);
 
     NonnullRefPtr<PhysicalPage> allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
+    Optional<PhysicalAddress> allocate_committed_large_page(Badge<CommittedPhysicalPageSet>);
+    void deallocate_committed_large_page(Badge<CommittedPhysicalPageSet>, PhysicalAddress);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> allocate_contiguous_physical_pages(size_t size);
     void deallocate_physical_page(PhysicalAddress);
@@ -183,10 +213,18 @@ public:
         PhysicalSize physical_pages_used { 0 };
         PhysicalSize physical_pages_committed { 0 };
         PhysicalSize physical_pages_uncommitted { 0 };
+        size_t large_pages_mapped { 0 };
+        size_t large_page_allocations { 0 };
+        size_t large_page_allocation_failures { 0 };
+        size_t large_page_splits { 0 };
     };
 
     SystemMemoryInfo get_system_memory_info();
 
+    // Clears a free page ahead of time, so a later zero-filled allocation on this processor doesn't have to.
+    // Returns false if there's nothing left to do.
+    bool zero_free_physical_page();
+
     template<IteratorFunction<VMObject&> Callback>
     static void for_each_vmobject(Callback callback)
     {
@@ -253,7 +291,11 @@ private:
 
     static Region* find_region_from_vaddr(VirtualAddress);
 
-    RefPtr<PhysicalPage> find_free_physical_page(bool);
+    RefPtr<PhysicalPage> find_free_physical_page(bool committed, ShouldZeroFill);
+    Optional<PhysicalAddress> take_free_physical_page(ShouldZeroFill, bool& is_zeroed, bool committed);
+    size_t take_free_pages_from_regions(Span<PhysicalAddress>);
+    void return_free_pages_to_regions(ReadonlySpan<PhysicalAddress>);
+    void drain_physical_page_magazines();
 
     ALWAYS_INLINE u8* quickmap_page(PhysicalPage& page)
     {
@@ -273,6 +315,13 @@ private:
     };
     void release_pte(PageDirectory&, VirtualAddress, IsLastPTERelease);
 
+    // Replaces the page table behind the given large page boundary with a single large page, if it maps
+    // a naturally aligned and physically contiguous range with the same attributes everywhere.
+    bool try_map_large_page(PageDirectory&, VirtualAddress);
+#if ARCH(X86_64)
+    void split_large_page(PageDirectory&, PageDirectoryEntry&, VirtualAddress);
+#endif
+
     // NOTE: These are outside of GlobalData as they are only assigned on startup,
     //       and then never change. Atomic ref-counting covers that case without
     //       the need for additional synchronization.
@@ -285,11 +334,13 @@ private:
     PhysicalPageEntry* m_physical_page_entries { nullptr };
     size_t m_physical_page_entries_count { 0 };
 
+    // NOTE: This is kept apart from GlobalData, so that allocating a page from this processor's
+    //       magazine only needs to hold a lock for as long as it takes to update the counters.
+    SpinlockProtected<SystemMemoryInfo, LockRank::None> m_system_memory_info {};
+
     struct GlobalData {
         GlobalData();
 
-        SystemMemoryInfo system_memory_info;
-
         Vector<NonnullOwnPtr<PhysicalRegion>> physical_regions;
         OwnPtr<PhysicalRegion> physical_pages_region;
 
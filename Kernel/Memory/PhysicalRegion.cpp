@@ -55,8 +55,20 @@ void PhysicalRegion::initialize_zones()
         return zone_count;
     };
 
+    // Large pages are carved out of the 16 MiB zones, so make them start at a large page boundary
+    // by covering whatever comes before it with smaller zones.
+    while (remaining_pages > 0 && base_address.get() % large_page_size != 0) {
+        auto pages_to_boundary = (align_up_to(base_address.get(), large_page_size) - base_address.get()) / PAGE_SIZE;
+        auto pages_in_zone = min(pages_to_boundary, remaining_pages);
+        pages_in_zone = static_cast<size_t>(1) << (8 * sizeof(size_t) - 1 - count_leading_zeroes(pages_in_zone));
+        m_zones.append(adopt_nonnull_own_or_enomem(new (nothrow) PhysicalZone(base_address, pages_in_zone)).release_value_but_fixme_should_propagate_errors());
+        m_usable_zones.append(*m_zones.last());
+        base_address = base_address.offset(pages_in_zone * PAGE_SIZE);
+        remaining_pages -= pages_in_zone;
+    }
+
     // First make 16 MiB zones (with 4096 pages each)
-    m_large_zones = make_zones(large_zone_size);
+    make_zones(large_zone_size);
 
     // Then divide any remaining space into 1 MiB zones (with 256 pages each)
     make_zones(small_zone_size);
@@ -102,10 +114,30 @@ Vector<NonnullRefPtr<PhysicalPage>> PhysicalRegion::take_contiguous_free_pages(s
     return physical_pages;
 }
 
-RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
+Optional<PhysicalAddress> PhysicalRegion::take_free_large_page()
+{
+    static constexpr size_t large_page_order = count_trailing_zeroes(pages_per_large_page);
+
+    for (auto& zone : m_usable_zones) {
+        // Only zones that start at a large page boundary hand out naturally aligned blocks of this size.
+        if (zone.base().get() % large_page_size != 0)
+            continue;
+        auto page_base = zone.allocate_block(large_page_order);
+        if (!page_base.has_value())
+            continue;
+        if (zone.is_empty()) {
+            // We've exhausted this zone, move it to the full zones list.
+            m_full_zones.append(zone);
+        }
+        return page_base;
+    }
+    return {};
+}
+
+Optional<PhysicalAddress> PhysicalRegion::take_free_page()
 {
     if (m_usable_zones.is_empty())
-        return nullptr;
+        return {};
 
     auto& zone = *m_usable_zones.first();
     auto page = zone.allocate_block(0);
@@ -116,21 +148,23 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
         m_full_zones.append(zone);
     }
 
-    return PhysicalPage::create(page.value());
+    return page.value();
 }
 
 void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto large_zone_base = lower().get();
-    auto small_zone_base = lower().get() + (m_large_zones * large_zone_size);
-
-    size_t zone_index;
-    if (paddr.get() < small_zone_base)
-        zone_index = (paddr.get() - large_zone_base) / large_zone_size;
-    else
-        zone_index = m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
+    // The zones are sorted by address, so look for the last one that starts at or below the page.
+    size_t lower_index = 0;
+    size_t upper_index = m_zones.size();
+    while (upper_index - lower_index > 1) {
+        auto middle_index = lower_index + (upper_index - lower_index) / 2;
+        if (m_zones[middle_index]->base() <= paddr)
+            lower_index = middle_index;
+        else
+            upper_index = middle_index;
+    }
 
-    auto& zone = m_zones[zone_index];
+    auto& zone = m_zones[lower_index];
     VERIFY(zone->contains(paddr));
     zone->deallocate_block(paddr, 0);
     if (m_full_zones.contains(*zone))
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ByteBuffer.h>
 #include <AK/StringView.h>
 #include <Kernel/Arch/PageDirectory.h>
 #include <Kernel/Arch/PageFault.h>
@@ -21,6 +22,9 @@
 
 namespace Kernel::Memory {
 
+// The number of pages around a faulting page of a file that we read and map in one go.
+static constexpr size_t fault_around_page_count = 16;
+
 Region::Region()
     : m_range(VirtualRange({}, 0))
 {
@@ -304,6 +308,12 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
             break;
         ++page_index;
     }
+    // Anonymous memory that was faulted in as a large page can be mapped as one again, e.g. after an mprotect().
+    if (page_index == page_count() && is_user() && vmobject().is_anonymous()) {
+        auto large_page_vaddr = VirtualAddress { align_up_to(vaddr().get(), large_page_size) };
+        for (; large_page_vaddr.offset(large_page_size) <= range().end(); large_page_vaddr = large_page_vaddr.offset(large_page_size))
+            (void)MM.try_map_large_page(page_directory, large_page_vaddr);
+    }
     if (page_index > 0) {
         if (should_flush_tlb == ShouldFlushTLB::Yes)
             MemoryManager::flush_tlb(m_page_directory, vaddr(), page_index);
@@ -410,6 +420,8 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
 
     if (page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
+        if (auto response = try_handle_zero_fault_with_large_page(page_index_in_region); response.has_value())
+            return response.value();
         new_physical_page = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
         dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED {}", new_physical_page->paddr());
     } else {
@@ -444,6 +456,34 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     return PageFaultResponse::Continue;
 }
 
+Optional<PageFaultResponse> Region::try_handle_zero_fault_with_large_page(size_t page_index_in_region)
+{
+    // Only memory that gets mapped the same way all over can end up in a single large page.
+    if (!is_user() || !is_readable() || !is_writable() || !is_cacheable() || is_write_combine())
+        return {};
+
+    auto large_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index_in_region).get() & ~(large_page_size - 1) };
+    if (large_page_vaddr < vaddr() || large_page_vaddr.offset(large_page_size) > range().end())
+        return {};
+    auto first_page_index_in_region = (large_page_vaddr.get() - vaddr().get()) / PAGE_SIZE;
+
+    auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject());
+    if (!anonymous_vmobject.try_allocate_committed_large_page({}, translate_to_vmobject_page(first_page_index_in_region)))
+        return {};
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED LARGE PAGE {}", physical_page(first_page_index_in_region)->paddr());
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        if (!map_individual_page_impl(first_page_index_in_region + i)) {
+            dmesgln("MM: handle_zero_fault was unable to allocate a page table to map {}", large_page_vaddr);
+            return PageFaultResponse::OutOfMemory;
+        }
+    }
+    if (!MM.try_map_large_page(*m_page_directory, large_page_vaddr))
+        MemoryManager::flush_tlb(m_page_directory, large_page_vaddr, pages_per_large_page);
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     auto current_thread = Thread::current();
@@ -460,22 +500,50 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return response;
 }
 
+bool Region::map_inode_pages(size_t first_page_index_in_vmobject, size_t end_page_index_in_vmobject)
+{
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    for (auto page_index_in_vmobject = first_page_index_in_vmobject; page_index_in_vmobject < end_page_index_in_vmobject; ++page_index_in_vmobject) {
+        RefPtr<PhysicalPage> page;
+        {
+            SpinlockLocker vmobject_locker(vmobject().m_lock);
+            page = vmobject().physical_pages()[page_index_in_vmobject];
+        }
+        // Pages that haven't been read yet stay unmapped, so touching them faults them in.
+        if (!page)
+            continue;
+        if (!map_individual_page_impl(page_index_in_vmobject - first_page_index(), move(page)))
+            return false;
+    }
+    MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_page_index_in_vmobject - first_page_index()), end_page_index_in_vmobject - first_page_index_in_vmobject);
+    return true;
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     VERIFY(vmobject().is_inode());
     VERIFY(!g_scheduler_lock.is_locked_by_current_processor());
 
     auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto& inode = inode_vmobject.inode();
 
     auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
     auto& vmobject_physical_page_slot = inode_vmobject.physical_pages()[page_index_in_vmobject];
 
+    // We don't only map the faulting page, but every page around it that we already have, so that
+    // touching a mapped file from start to end doesn't take a trap for every single page.
+    auto file_page_count = static_cast<size_t>(ceil_div(inode.size(), static_cast<u64>(PAGE_SIZE)));
+    auto cluster_first = max(page_index_in_vmobject & ~(fault_around_page_count - 1), first_page_index());
+    auto cluster_end = min((page_index_in_vmobject | (fault_around_page_count - 1)) + 1, first_page_index() + page_count());
+    cluster_end = max(min(cluster_end, file_page_count), page_index_in_vmobject + 1);
+
     {
         // NOTE: The VMObject lock is required when manipulating the VMObject's physical page slot.
         SpinlockLocker locker(inode_vmobject.m_lock);
         if (!vmobject_physical_page_slot.is_null()) {
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else before reading, remapping.");
-            if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
+            locker.unlock();
+            if (!map_inode_pages(cluster_first, cluster_end))
                 return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
@@ -487,61 +555,93 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
-
-    if (result.is_error()) {
-        dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
-        return PageFaultResponse::ShouldCrash;
-    }
-
-    auto nread = result.value();
-    // Note: If we received 0, it means we are at the end of file or after it,
-    // which means we should return bus error.
-    if (nread == 0)
+    // Note: If we're at the end of file or after it, we should return bus error.
+    if (page_index_in_vmobject >= file_page_count)
         return PageFaultResponse::BusError;
 
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
-    }
+    if (inode_vmobject.is_shared_inode()) {
+        // Shared mappings map the inode's page cache directly, the same pages that read() and write() use.
+        auto page_or_error = static_cast<SharedInodeVMObject&>(inode_vmobject).ensure_page(page_index_in_vmobject);
+        if (page_or_error.is_error()) {
+            if (page_or_error.error().code() == ENOMEM) {
+                dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
+                return PageFaultResponse::OutOfMemory;
+            }
+            dmesgln("handle_inode_fault: Error ({}) while reading from inode", page_or_error.error());
+            return PageFaultResponse::ShouldCrash;
+        }
+    } else {
+        // Read in all the pages of the cluster that nobody has faulted in yet, as long as they
+        // form a single run with the faulting page, so the file system sees one larger read.
+        auto read_first = page_index_in_vmobject;
+        auto read_end = page_index_in_vmobject + 1;
+        {
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            while (read_first > cluster_first && inode_vmobject.physical_pages()[read_first - 1].is_null())
+                --read_first;
+            while (read_end < cluster_end && inode_vmobject.physical_pages()[read_end].is_null())
+                ++read_end;
+        }
 
-    // Allocate a new physical page, and copy the read inode contents into it.
-    auto new_physical_page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (new_physical_page_or_error.is_error()) {
-        dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
-        return PageFaultResponse::OutOfMemory;
-    }
-    auto new_physical_page = new_physical_page_or_error.release_value();
-    {
-        InterruptDisabler disabler;
-        u8* dest_ptr = MM.quickmap_page(*new_physical_page);
-        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
-        MM.unquickmap_page();
-    }
+        auto read_buffer_or_error = ByteBuffer::create_uninitialized((read_end - read_first) * PAGE_SIZE);
+        if (read_buffer_or_error.is_error()) {
+            dmesgln("MM: handle_inode_fault was unable to allocate a read buffer");
+            return PageFaultResponse::OutOfMemory;
+        }
+        auto read_buffer = read_buffer_or_error.release_value();
 
-    {
-        // NOTE: The VMObject lock is required when manipulating the VMObject's physical page slot.
-        SpinlockLocker locker(inode_vmobject.m_lock);
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(read_buffer.data());
+        auto result = inode.read_bytes(read_first * PAGE_SIZE, read_buffer.size(), buffer, nullptr);
+        if (result.is_error()) {
+            dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
+            return PageFaultResponse::ShouldCrash;
+        }
 
-        if (!vmobject_physical_page_slot.is_null()) {
-            // Someone else faulted in this page while we were reading from the inode.
-            // No harm done (other than some duplicate work), remap the page here and return.
-            dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else, remapping.");
-            if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
+        auto nread = result.value();
+        // Note: If we didn't get as far as the faulting page, it means that it's at the end of file
+        // or after it (the file may have shrunk since we looked), which means we should return bus error.
+        if (nread <= (page_index_in_vmobject - read_first) * PAGE_SIZE)
+            return PageFaultResponse::BusError;
+
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        read_end = read_first + ceil_div(nread, static_cast<size_t>(PAGE_SIZE));
+        memset(read_buffer.data() + nread, 0, (read_end - read_first) * PAGE_SIZE - nread);
+
+        for (auto index = read_first; index < read_end; ++index) {
+            // Allocate a new physical page, and copy the read inode contents into it.
+            auto new_physical_page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
+            if (new_physical_page_or_error.is_error()) {
+                // The other pages are only nice to have, so we only give up if we can't get the faulting one.
+                if (index != page_index_in_vmobject)
+                    continue;
+                dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
                 return PageFaultResponse::OutOfMemory;
-            return PageFaultResponse::Continue;
+            }
+            auto new_physical_page = new_physical_page_or_error.release_value();
+            {
+                InterruptDisabler disabler;
+                u8* dest_ptr = MM.quickmap_page(*new_physical_page);
+                memcpy(dest_ptr, read_buffer.data() + (index - read_first) * PAGE_SIZE, PAGE_SIZE);
+                MM.unquickmap_page();
+            }
+
+            // NOTE: The VMObject lock is required when manipulating the VMObject's physical page slot.
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            auto& physical_page_slot = inode_vmobject.physical_pages()[index];
+            // If someone else faulted in this page while we were reading from the inode, we keep theirs.
+            if (physical_page_slot.is_null())
+                physical_page_slot = move(new_physical_page);
         }
-
-        vmobject_physical_page_slot = new_physical_page;
     }
 
-    if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
+    if (!map_inode_pages(cluster_first, cluster_end))
         return PageFaultResponse::OutOfMemory;
 
+    // Start reading the next cluster in the background, so it's likely to be cached once we fault on it.
+    auto readahead_end = min(cluster_end + fault_around_page_count, min(first_page_index() + page_count(), file_page_count));
+    if (cluster_end < readahead_end)
+        inode.readahead(static_cast<u64>(cluster_end) * PAGE_SIZE, (readahead_end - cluster_end) * PAGE_SIZE);
+
     return PageFaultResponse::Continue;
 }
 
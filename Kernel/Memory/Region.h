@@ -225,8 +225,10 @@ private:
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
+    [[nodiscard]] Optional<PageFaultResponse> try_handle_zero_fault_with_large_page(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
+    [[nodiscard]] bool map_inode_pages(size_t first_page_index_in_vmobject, size_t end_page_index_in_vmobject);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
 
     LockRefPtr<PageDirectory> m_page_directory;
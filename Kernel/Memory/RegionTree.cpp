@@ -20,10 +20,17 @@ RegionTree::~RegionTree()
 void RegionTree::delete_all_regions_assuming_they_are_unmapped()
 {
     // FIXME: This could definitely be done in a more efficient manner.
-    while (!m_regions.is_empty()) {
-        auto& region = *m_regions.begin();
-        m_regions.remove(region.vaddr().get());
-        delete &region;
+    for (;;) {
+        Region* region = nullptr;
+        {
+            RWSpinlockLocker locker(m_lock, LockMode::Exclusive);
+            if (m_regions.is_empty())
+                break;
+            region = &*m_regions.begin();
+            m_regions.remove(region->vaddr().get());
+        }
+        // NOTE: Deleting a kernel region removes it from the kernel's region tree, so we can't hold the lock here.
+        delete region;
     }
 }
 
@@ -133,6 +140,7 @@ ErrorOr<void> RegionTree::place_anywhere(Region& region, RandomizeVirtualAddress
 {
     auto range = TRY(randomize_virtual_address == RandomizeVirtualAddress::Yes ? allocate_range_randomized(size, alignment) : allocate_range_anywhere(size, alignment));
     region.m_range = range;
+    RWSpinlockLocker locker(m_lock, LockMode::Exclusive);
     m_regions.insert(region.vaddr().get(), region);
     return {};
 }
@@ -141,17 +149,20 @@ ErrorOr<void> RegionTree::place_specifically(Region& region, VirtualRange const&
 {
     auto allocated_range = TRY(allocate_range_specific(range.base(), range.size()));
     region.m_range = allocated_range;
+    RWSpinlockLocker locker(m_lock, LockMode::Exclusive);
     m_regions.insert(region.vaddr().get(), region);
     return {};
 }
 
 bool RegionTree::remove(Region& region)
 {
+    RWSpinlockLocker locker(m_lock, LockMode::Exclusive);
     return m_regions.remove(region.range().base().get());
 }
 
 Region* RegionTree::find_region_containing(VirtualAddress address)
 {
+    RWSpinlockLocker locker(m_lock, LockMode::Shared);
     auto* region = m_regions.find_largest_not_above(address.get());
     if (!region || !region->contains(address))
         return nullptr;
@@ -160,6 +171,7 @@ Region* RegionTree::find_region_containing(VirtualAddress address)
 
 Region* RegionTree::find_region_containing(VirtualRange range)
 {
+    RWSpinlockLocker locker(m_lock, LockMode::Shared);
     auto* region = m_regions.find_largest_not_above(range.base().get());
     if (!region || !region->contains(range))
         return nullptr;
@@ -23,6 +23,9 @@ enum class RandomizeVirtualAddress {
 // RegionTree represents a virtual address space.
 // It is used by MemoryManager for kernel VM and by AddressSpace for user VM.
 // Regions are stored in an intrusive data structure and there are no allocations when interacting with it.
+// NOTE: Changes to the tree are expected to be serialized by its owner. The tree has a lock of its own, which
+//       lets lookups (like the ones from the page fault handler) run concurrently with each other, without
+//       having to take the owner's lock.
 class RegionTree {
     AK_MAKE_NONCOPYABLE(RegionTree);
     AK_MAKE_NONMOVABLE(RegionTree);
@@ -50,6 +53,18 @@ public:
     Region* find_region_containing(VirtualAddress);
     Region* find_region_containing(VirtualRange);
 
+    // Calls back with the region containing the address (or nullptr) while the tree is locked, so that the region
+    // can't be removed and freed while it's being looked at, even if the owner's lock isn't held.
+    template<typename Callback>
+    decltype(auto) with_region_containing(VirtualAddress address, Callback callback)
+    {
+        RWSpinlockLocker locker(m_lock, LockMode::Shared);
+        auto* region = m_regions.find_largest_not_above(address.get());
+        if (region && !region->contains(address))
+            region = nullptr;
+        return callback(region);
+    }
+
 private:
     ErrorOr<VirtualRange> allocate_range_anywhere(size_t size, size_t alignment = PAGE_SIZE);
     ErrorOr<VirtualRange> allocate_range_specific(VirtualAddress base, size_t size);
@@ -57,6 +72,7 @@ private:
 
     IntrusiveRedBlackTree<&Region::m_tree_node> m_regions;
     VirtualRange const m_total_range;
+    mutable RWSpinlock<LockRank::None> m_lock {};
 };
 
 }
@@ -5,8 +5,13 @@
  */
 
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/InterruptDisabler.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel::Memory {
 
@@ -51,22 +56,400 @@ SharedInodeVMObject::SharedInodeVMObject(SharedInodeVMObject const& other, Fixed
 
 ErrorOr<void> SharedInodeVMObject::sync(off_t offset_in_pages, size_t pages)
 {
-    SpinlockLocker locker(m_lock);
+    return write_back_pages(offset_in_pages, pages, OnlyDirtyPages::No);
+}
 
-    size_t highest_page_to_flush = min(page_count(), offset_in_pages + pages);
+// Contiguous dirty pages are written back to the inode in runs of up to this many pages.
+static constexpr size_t max_pages_per_write_back = 16;
 
-    for (size_t page_index = offset_in_pages; page_index < highest_page_to_flush; ++page_index) {
-        auto& physical_page = m_physical_pages[page_index];
-        if (!physical_page)
+// Reads and writes map up to this many cached pages into the kernel at once.
+static constexpr size_t max_window_page_count = 64;
+
+// Maps the pages into a temporary kernel window, so that data can be copied straight into or out of them,
+// even across operations that might block.
+static ErrorOr<NonnullOwnPtr<Region>> map_pages_into_kernel(Span<NonnullRefPtr<PhysicalPage>> physical_pages, Region::Access access)
+{
+    auto window_vmobject = TRY(AnonymousVMObject::try_create_with_physical_pages(physical_pages));
+    return MM.allocate_kernel_region_with_vmobject(*window_vmobject, physical_pages.size() * PAGE_SIZE, "SharedInodeVMObject Window"sv, access);
+}
+
+ErrorOr<void> SharedInodeVMObject::write_back_dirty_pages(size_t first_page, size_t pages)
+{
+    return write_back_pages(first_page, pages, OnlyDirtyPages::Yes);
+}
+
+ErrorOr<void> SharedInodeVMObject::write_back_pages(size_t first_page, size_t pages, OnlyDirtyPages only_dirty_pages)
+{
+    size_t end_page = min(page_count(), first_page + min(pages, page_count()));
+    if (first_page >= end_page)
+        return {};
+
+    // NOTE: Pages are only dirtied by write_bytes(), which holds the inode lock, and a page is only marked clean
+    //       once its write has succeeded. So while we hold the lock, nobody can dirty a page we're writing back,
+    //       and a dirty page can't be purged and read back from the file system before its data got there.
+    //       Holding the lock also keeps the file from being truncated while we write.
+    MutexLocker inode_locker(m_inode->m_inode_lock);
+
+    // Don't write anything past the end of the file, as that would extend it.
+    auto file_size = m_inode->size();
+
+    OwnPtr<KBuffer> buffer;
+    size_t page_index = first_page;
+    while (page_index < end_page) {
+        Array<RefPtr<PhysicalPage>, max_pages_per_write_back> run_pages;
+        size_t run_start = page_index;
+        size_t run_length = 0;
+        {
+            SpinlockLocker locker(m_lock);
+            for (; page_index < end_page; ++page_index) {
+                auto& physical_page = m_physical_pages[page_index];
+                bool wanted = physical_page && (only_dirty_pages == OnlyDirtyPages::No || m_dirty_pages.get(page_index));
+                if (!wanted) {
+                    if (run_length > 0)
+                        break;
+                    continue;
+                }
+                if (run_length == 0)
+                    run_start = page_index;
+                run_pages[run_length++] = physical_page;
+                if (run_length == max_pages_per_write_back) {
+                    ++page_index;
+                    break;
+                }
+            }
+        }
+        if (run_length == 0)
+            break;
+
+        u64 run_offset = static_cast<u64>(run_start) * PAGE_SIZE;
+        if (run_offset >= file_size)
+            break;
+        size_t bytes_to_write = min(static_cast<u64>(run_length) * PAGE_SIZE, file_size - run_offset);
+
+        // NOTE: Writing can block, so the pages are copied out first rather than quickmapped.
+        if (!buffer)
+            buffer = TRY(KBuffer::try_create_with_size("SharedInodeVMObject: Write back"sv, max_pages_per_write_back * PAGE_SIZE, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+        for (size_t i = 0; i < run_length; ++i)
+            MM.copy_physical_page(*run_pages[i], buffer->data() + i * PAGE_SIZE);
+
+        // If this fails, the pages are still dirty and will be written back again later.
+        // NOTE: The data goes into the file system's cache, which gathers it into larger writes to the disk.
+        auto data = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+        TRY(m_inode->write_bytes_locked(run_offset, bytes_to_write, data, nullptr));
+
+        SpinlockLocker locker(m_lock);
+        for (size_t i = 0; i < run_length; ++i)
+            m_dirty_pages.set(run_start + i, false);
+    }
+
+    return {};
+}
+
+ErrorOr<void> SharedInodeVMObject::read_pages_from_inode(size_t first_page, Span<NonnullRefPtr<PhysicalPage>> physical_pages, OpenFileDescription* description)
+{
+    // The pages are read straight into a kernel mapping of them. Whatever lies past the end of the file reads as zeroes.
+    auto window = TRY(map_pages_into_kernel(physical_pages, Region::Access::ReadWrite));
+    size_t size = physical_pages.size() * PAGE_SIZE;
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(window->vaddr().as_ptr());
+    size_t nread = 0;
+    {
+        MutexLocker locker(m_inode->m_inode_lock, Mutex::Mode::Shared);
+        nread = TRY(m_inode->read_bytes_locked(static_cast<u64>(first_page) * PAGE_SIZE, size, buffer, description));
+    }
+    if (nread < size)
+        memset(window->vaddr().offset(nread).as_ptr(), 0, size - nread);
+    return {};
+}
+
+ErrorOr<void> SharedInodeVMObject::ensure_pages(size_t first_page, size_t count, OpenFileDescription* description)
+{
+    size_t end_page = min(page_count(), first_page + count);
+    size_t page_index = first_page;
+    while (page_index < end_page) {
+        // Find the next run of pages that aren't cached yet, and fill them with a single read.
+        size_t run_start = end_page;
+        size_t run_length = 0;
+        {
+            SpinlockLocker locker(m_lock);
+            for (; page_index < end_page && run_length < max_window_page_count; ++page_index) {
+                if (m_physical_pages[page_index]) {
+                    if (run_length > 0)
+                        break;
+                    continue;
+                }
+                if (run_length++ == 0)
+                    run_start = page_index;
+            }
+        }
+        if (run_length == 0)
+            break;
+
+        Vector<NonnullRefPtr<PhysicalPage>, max_window_page_count> new_physical_pages;
+        for (size_t i = 0; i < run_length; ++i)
+            new_physical_pages.unchecked_append(TRY(MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No)));
+        TRY(read_pages_from_inode(run_start, new_physical_pages.span(), description));
+
+        SpinlockLocker locker(m_lock);
+        for (size_t i = 0; i < run_length; ++i) {
+            // If someone else filled this page while we were reading from the inode, we use theirs instead.
+            auto& physical_page_slot = m_physical_pages[run_start + i];
+            if (!physical_page_slot)
+                physical_page_slot = move(new_physical_pages[i]);
+        }
+    }
+    return {};
+}
+
+ErrorOr<NonnullRefPtr<PhysicalPage>> SharedInodeVMObject::ensure_page(size_t page_index)
+{
+    VERIFY(page_index < page_count());
+    for (;;) {
+        {
+            SpinlockLocker locker(m_lock);
+            if (auto& physical_page = m_physical_pages[page_index])
+                return *physical_page;
+        }
+        // NOTE: The page may get purged again before we get to it, in which case we simply read it once more.
+        TRY(ensure_pages(page_index, 1));
+    }
+}
+
+ErrorOr<NonnullRefPtr<PhysicalPage>> SharedInodeVMObject::ensure_page_for_writing(size_t page_index, bool will_overwrite_whole_page)
+{
+    VERIFY(page_index < page_count());
+    for (;;) {
+        {
+            // The page is marked dirty before it is written to, so that it can't be purged as a clean page
+            // in the meantime, taking the new data with it.
+            SpinlockLocker locker(m_lock);
+            if (auto& physical_page = m_physical_pages[page_index]) {
+                m_dirty_pages.set(page_index, true);
+                return *physical_page;
+            }
+        }
+        if (!will_overwrite_whole_page) {
+            TRY(ensure_pages(page_index, 1));
             continue;
+        }
+        // There's no need to read in a page that is about to be overwritten, but it must not show anything
+        // else to a shared mapping of it in the meantime.
+        auto new_physical_page = TRY(MM.allocate_physical_page(MemoryManager::ShouldZeroFill::Yes));
+        SpinlockLocker locker(m_lock);
+        if (!m_physical_pages[page_index])
+            m_physical_pages[page_index] = move(new_physical_page);
+    }
+}
+
+template<typename Callback>
+ErrorOr<size_t> SharedInodeVMObject::for_each_window(u64 offset, size_t count, Region::Access access, OpenFileDescription* description, Callback callback)
+{
+    bool is_writing = has_flag(access, Region::Access::Write);
+    size_t ndone = 0;
+    while (ndone < count) {
+        u64 position = offset + ndone;
+        size_t first_page_index = position / PAGE_SIZE;
+        size_t offset_in_first_page = position % PAGE_SIZE;
+        size_t chunk_size = min(count - ndone, max_window_page_count * PAGE_SIZE - offset_in_first_page);
+        size_t window_page_count = ceil_div(offset_in_first_page + chunk_size, static_cast<size_t>(PAGE_SIZE));
+
+        auto window_or_error = [&]() -> ErrorOr<NonnullOwnPtr<Region>> {
+            Vector<NonnullRefPtr<PhysicalPage>, max_window_page_count> physical_pages;
+            if (is_writing) {
+                for (size_t i = 0; i < window_page_count; ++i) {
+                    u64 page_start = static_cast<u64>(first_page_index + i) * PAGE_SIZE;
+                    bool will_overwrite_whole_page = page_start >= offset && page_start + PAGE_SIZE <= offset + count;
+                    physical_pages.unchecked_append(TRY(ensure_page_for_writing(first_page_index + i, will_overwrite_whole_page)));
+                }
+            } else {
+                TRY(ensure_pages(first_page_index, window_page_count, description));
+                for (size_t i = 0; i < window_page_count; ++i)
+                    physical_pages.unchecked_append(TRY(ensure_page(first_page_index + i)));
+            }
+            return map_pages_into_kernel(physical_pages.span(), access);
+        }();
+        if (window_or_error.is_error()) {
+            if (ndone > 0)
+                break;
+            return window_or_error.release_error();
+        }
+
+        auto window = window_or_error.release_value();
+        auto ndone_in_window_or_error = callback(window->vaddr().offset(offset_in_first_page).as_ptr(), ndone, chunk_size);
+        if (ndone_in_window_or_error.is_error()) {
+            if (ndone > 0)
+                break;
+            return ndone_in_window_or_error.release_error();
+        }
+        ndone += ndone_in_window_or_error.value();
+        if (ndone_in_window_or_error.value() < chunk_size)
+            break;
+    }
+    return ndone;
+}
+
+ErrorOr<size_t> SharedInodeVMObject::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description)
+{
+    VERIFY(offset >= 0);
 
-        u8 page_buffer[PAGE_SIZE];
-        MM.copy_physical_page(*physical_page, page_buffer);
+    auto file_size = m_inode->size();
+    if (static_cast<u64>(offset) >= file_size)
+        return 0;
+    count = min(count, file_size - offset);
 
-        TRY(m_inode->write_bytes(page_index * PAGE_SIZE, PAGE_SIZE, UserOrKernelBuffer::for_kernel_buffer(page_buffer), nullptr));
+    // The file may have grown past the end of this VMObject, the rest comes straight from the file system then.
+    size_t cached_count = static_cast<u64>(offset) < size() ? min(count, size() - offset) : 0;
+
+    size_t nread = 0;
+    if (buffer.is_kernel_buffer()) {
+        // Kernel buffers can't fault, so we can copy straight out of a quickmapped page.
+        TRY(ensure_pages(offset / PAGE_SIZE, ceil_div(static_cast<size_t>(offset % PAGE_SIZE) + cached_count, static_cast<size_t>(PAGE_SIZE)), description));
+        while (nread < cached_count) {
+            u64 position = offset + nread;
+            size_t offset_in_page = position % PAGE_SIZE;
+            size_t bytes_to_copy = min(PAGE_SIZE - offset_in_page, cached_count - nread);
+            auto physical_page = TRY(ensure_page(position / PAGE_SIZE));
+            InterruptDisabler disabler;
+            u8* page = MM.quickmap_page(*physical_page);
+            auto result = buffer.write(page + offset_in_page, nread, bytes_to_copy);
+            MM.unquickmap_page();
+            TRY(result);
+            nread += bytes_to_copy;
+        }
+    } else {
+        // A user buffer could fault, which we can't handle while a page is quickmapped. So we map a window of
+        // pages into the kernel instead, and copy straight out of that.
+        nread = TRY(for_each_window(offset, cached_count, Region::Access::Read, description, [&](u8* data, size_t buffer_offset, size_t size) -> ErrorOr<size_t> {
+            TRY(buffer.write(data, buffer_offset, size));
+            return size;
+        }));
+        if (nread < cached_count)
+            return nread;
+    }
+
+    if (nread < count) {
+        auto remaining_buffer = buffer.offset(nread);
+        nread += TRY(m_inode->read_bytes_without_page_cache(offset + nread, count - nread, remaining_buffer, description));
     }
+    return nread;
+}
+
+ErrorOr<size_t> SharedInodeVMObject::splice_bytes(off_t offset, size_t count, File::SpliceSink const& sink, OpenFileDescription* description)
+{
+    VERIFY(offset >= 0);
+
+    // NOTE: Whatever lies past the end of this VMObject is left to the caller.
+    auto end = min(m_inode->size(), static_cast<u64>(size()));
+    if (static_cast<u64>(offset) >= end)
+        return 0;
+    count = min(count, end - offset);
 
+    // The cached pages themselves are mapped into the window, so the sink copies straight out of the page cache.
+    return for_each_window(offset, count, Region::Access::Read, description, [&](u8* data, size_t, size_t size) {
+        return sink(UserOrKernelBuffer::for_kernel_buffer(data), size);
+    });
+}
+
+ErrorOr<size_t> SharedInodeVMObject::write_bytes(off_t offset, size_t count, UserOrKernelBuffer const& data)
+{
+    VERIFY(offset >= 0);
+    VERIFY(static_cast<u64>(offset) + count <= size());
+
+    size_t nwritten = 0;
+    if (data.is_kernel_buffer()) {
+        // Kernel buffers can't fault, so we can copy straight into a quickmapped page.
+        while (nwritten < count) {
+            u64 position = offset + nwritten;
+            size_t offset_in_page = position % PAGE_SIZE;
+            size_t bytes_to_copy = min(PAGE_SIZE - offset_in_page, count - nwritten);
+            auto physical_page = TRY(ensure_page_for_writing(position / PAGE_SIZE, bytes_to_copy == PAGE_SIZE));
+            InterruptDisabler disabler;
+            u8* page = MM.quickmap_page(*physical_page);
+            auto result = data.read(page + offset_in_page, nwritten, bytes_to_copy);
+            MM.unquickmap_page();
+            TRY(result);
+            nwritten += bytes_to_copy;
+        }
+    } else {
+        nwritten = TRY(for_each_window(offset, count, Region::Access::ReadWrite, nullptr, [&](u8* window, size_t data_offset, size_t size) -> ErrorOr<size_t> {
+            TRY(data.read(window, data_offset, size));
+            return size;
+        }));
+    }
+
+    schedule_write_back();
+    return nwritten;
+}
+
+void SharedInodeVMObject::schedule_write_back()
+{
+    if (m_write_back_scheduled.exchange(true))
+        return;
+
+    auto result = g_io_work->try_queue([vmobject = NonnullLockRefPtr<SharedInodeVMObject>(*this)]() mutable {
+        vmobject->m_write_back_scheduled.store(false);
+        if (auto result = vmobject->write_back_dirty_pages(); result.is_error())
+            dbgln("SharedInodeVMObject: Failed to write back dirty pages of {}: {}", vmobject->inode().identifier(), result.error());
+    });
+    if (result.is_error()) {
+        // We couldn't defer it, so write the pages back right now instead.
+        m_write_back_scheduled.store(false);
+        if (auto write_back_result = write_back_dirty_pages(); write_back_result.is_error())
+            dbgln("SharedInodeVMObject: Failed to write back dirty pages of {}: {}", inode().identifier(), write_back_result.error());
+    }
+}
+
+ErrorOr<void> SharedInodeVMObject::reload_resident_pages(size_t first_page, size_t pages)
+{
+    // NOTE: The pages are updated in place, so any regions mapping them see the new contents right away.
+    size_t end_page = min(page_count(), first_page + min(pages, page_count()));
+    size_t page_index = first_page;
+    while (page_index < end_page) {
+        Vector<NonnullRefPtr<PhysicalPage>, max_window_page_count> run_pages;
+        size_t run_start = page_index;
+        {
+            SpinlockLocker locker(m_lock);
+            for (; page_index < end_page && run_pages.size() < max_window_page_count; ++page_index) {
+                auto& physical_page = m_physical_pages[page_index];
+                if (!physical_page) {
+                    if (!run_pages.is_empty())
+                        break;
+                    continue;
+                }
+                if (run_pages.is_empty())
+                    run_start = page_index;
+                run_pages.unchecked_append(*physical_page);
+            }
+        }
+        if (run_pages.is_empty())
+            break;
+        TRY(read_pages_from_inode(run_start, run_pages.span()));
+    }
     return {};
 }
 
+void SharedInodeVMObject::did_truncate(u64 new_size)
+{
+    // Whatever lies past the new end of the file must read back as zeroes if the file grows again,
+    // and must never be written back to it.
+    size_t first_page = new_size / PAGE_SIZE;
+    size_t offset_in_first_page = new_size % PAGE_SIZE;
+    for (size_t page_index = first_page; page_index < page_count(); ++page_index) {
+        RefPtr<PhysicalPage> physical_page;
+        {
+            SpinlockLocker locker(m_lock);
+            physical_page = m_physical_pages[page_index];
+            if (page_index != first_page || offset_in_first_page == 0)
+                m_dirty_pages.set(page_index, false);
+        }
+        if (!physical_page)
+            continue;
+
+        size_t offset_in_page = page_index == first_page ? offset_in_first_page : 0;
+        InterruptDisabler disabler;
+        u8* dest_ptr = MM.quickmap_page(*physical_page);
+        memset(dest_ptr + offset_in_page, 0, PAGE_SIZE - offset_in_page);
+        MM.unquickmap_page();
+    }
+}
+
 }
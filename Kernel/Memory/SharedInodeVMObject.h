@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <Kernel/FileSystem/File.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/UnixTypes.h>
 
@@ -21,15 +23,48 @@ public:
 
     ErrorOr<void> sync(off_t offset_in_pages = 0, size_t pages = -1);
 
+    // The shared VMObject of an inode doubles as its page cache: read() and write() on the inode
+    // go through these pages, so they stay coherent with shared mappings of the same file.
+    ErrorOr<size_t> read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription*);
+    ErrorOr<size_t> write_bytes(off_t offset, size_t count, UserOrKernelBuffer const& data);
+    // Hands the cached pages to the sink in place, see File::splice_read().
+    ErrorOr<size_t> splice_bytes(off_t offset, size_t count, File::SpliceSink const&, OpenFileDescription*);
+
+    ErrorOr<NonnullRefPtr<PhysicalPage>> ensure_page(size_t page_index);
+
+    ErrorOr<void> write_back_dirty_pages(size_t first_page = 0, size_t page_count = -1);
+    ErrorOr<void> reload_resident_pages(size_t first_page = 0, size_t page_count = -1);
+    void did_truncate(u64 new_size);
+
 private:
     virtual bool is_shared_inode() const override { return true; }
 
+    enum class OnlyDirtyPages {
+        No,
+        Yes,
+    };
+    ErrorOr<void> write_back_pages(size_t first_page, size_t page_count, OnlyDirtyPages);
+
+    // Pages that aren't cached yet are read through the file system's own cache. Reads on behalf of a description
+    // tell the file system about it, so that it can read ahead of sequential readers.
+    ErrorOr<void> read_pages_from_inode(size_t first_page, Span<NonnullRefPtr<PhysicalPage>>, OpenFileDescription* = nullptr);
+    ErrorOr<void> ensure_pages(size_t first_page, size_t page_count, OpenFileDescription* = nullptr);
+    ErrorOr<NonnullRefPtr<PhysicalPage>> ensure_page_for_writing(size_t page_index, bool will_overwrite_whole_page);
+
+    // Maps the cached pages covering the given range into the kernel a few at a time, and calls
+    // callback(data, offset_into_range, size) for each part.
+    template<typename Callback>
+    ErrorOr<size_t> for_each_window(u64 offset, size_t count, Region::Access, OpenFileDescription*, Callback);
+    void schedule_write_back();
+
     explicit SharedInodeVMObject(Inode&, FixedArray<RefPtr<PhysicalPage>>&&, Bitmap dirty_pages);
     explicit SharedInodeVMObject(SharedInodeVMObject const&, FixedArray<RefPtr<PhysicalPage>>&&, Bitmap dirty_pages);
 
     virtual StringView class_name() const override { return "SharedInodeVMObject"sv; }
 
     SharedInodeVMObject& operator=(SharedInodeVMObject const&) = delete;
+
+    Atomic<bool> m_write_back_scheduled { false };
 };
 
 }
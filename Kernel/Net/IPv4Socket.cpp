@@ -278,8 +278,10 @@ ErrorOr<size_t> IPv4Socket::receive_byte_buffered(OpenFileDescription& descripti
     else
         nreceived_or_error = m_receive_buffer->read(buffer, buffer_length);
 
-    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK))
+    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK)) {
         Thread::current()->did_ipv4_socket_read(nreceived_or_error.value());
+        protocol_did_consume_receive_buffer();
+    }
 
     set_can_read(!m_receive_buffer->is_empty());
     return nreceived_or_error;
@@ -425,8 +427,12 @@ bool IPv4Socket::did_receive(IPv4Address const& source_address, u16 source_port,
     if (buffer_mode() == BufferMode::Bytes) {
         VERIFY(m_receive_buffer);
 
+        // NOTE: Only the payload ends up in the receive buffer, and that's also what TCP advertises its receive window for.
+        auto payload_size_or_error = protocol_size(packet);
+        if (payload_size_or_error.is_error())
+            return false;
         size_t space_in_receive_buffer = m_receive_buffer->space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        if (payload_size_or_error.value() > space_in_receive_buffer) {
             dbgln("IPv4Socket({}): did_receive refusing packet since buffer is full.", this);
             VERIFY(m_can_read);
             return false;
@@ -86,6 +86,8 @@ protected:
     virtual ErrorOr<u16> protocol_allocate_local_port() { return ENOPROTOOPT; }
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes /* raw_ipv4_packet */) { return ENOTIMPL; }
     virtual bool protocol_is_disconnected() const { return false; }
+    // Called after data was read out of the byte stream receive buffer, which made room for more.
+    virtual void protocol_did_consume_receive_buffer() { }
 
     virtual void shut_down_for_reading() override;
 
@@ -94,6 +96,8 @@ protected:
 
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
+    size_t receive_buffer_capacity() const { return m_receive_buffer ? m_receive_buffer->capacity() : 0; }
+    size_t receive_buffer_space() const { return m_receive_buffer ? m_receive_buffer->space_for_writing() : 0; }
 
 private:
     virtual bool is_ipv4() const override { return true; }
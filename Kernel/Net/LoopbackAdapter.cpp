@@ -4,12 +4,27 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/Singleton.h>
+#include <Kernel/Debug.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Random.h>
 
 namespace Kernel {
 
 static bool s_loopback_initialized = false;
+static Atomic<u32> s_packet_loss_permille { 0 };
+
+u32 LoopbackAdapter::packet_loss_permille()
+{
+    return s_packet_loss_permille.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+void LoopbackAdapter::set_packet_loss_permille(u32 permille)
+{
+    VERIFY(permille <= 1000);
+    s_packet_loss_permille.store(permille, AK::MemoryOrder::memory_order_relaxed);
+}
 
 LockRefPtr<LoopbackAdapter> LoopbackAdapter::try_create()
 {
@@ -32,7 +47,11 @@ LoopbackAdapter::~LoopbackAdapter() = default;
 
 void LoopbackAdapter::send_raw(ReadonlyBytes payload)
 {
-    dbgln("LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
+    if (auto loss = packet_loss_permille(); loss > 0 && get_fast_random<u32>() % 1000 < loss) {
+        dbgln_if(ETHERNET_VERY_DEBUG, "LoopbackAdapter: Dropping {} byte(s) on purpose.", payload.size());
+        return;
+    }
+    dbgln_if(ETHERNET_VERY_DEBUG, "LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
     did_receive(payload);
 }
 
@@ -26,6 +26,10 @@ public:
     virtual bool link_up() override { return true; }
     virtual bool link_full_duplex() override { return true; }
     virtual int link_speed() override { return 1000; }
+
+    // NOTE: This lets us see how the network stack copes with packet loss.
+    static u32 packet_loss_permille();
+    static void set_packet_loss_permille(u32);
 };
 
 }
@@ -75,9 +75,12 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
     m_packets_in++;
     m_bytes_in += payload.size();
 
-    if (m_packet_queue_size == max_packet_buffers) {
-        // FIXME: Keep track of the number of dropped packets
-        return;
+    {
+        SpinlockLocker lock(m_packet_queue_lock);
+        if (m_packet_queue_size == max_packet_buffers) {
+            // FIXME: Keep track of the number of dropped packets
+            return;
+        }
     }
 
     auto packet = acquire_packet_buffer(payload.size());
@@ -88,27 +91,32 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    {
+        SpinlockLocker lock(m_packet_queue_lock);
+        m_packet_queue.append(*packet);
+        m_packet_queue_size++;
+    }
 
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+bool NetworkAdapter::has_queued_packets() const
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
-    packet_timestamp = packet_with_timestamp->timestamp;
-    auto& packet_buffer = packet_with_timestamp->buffer;
-    size_t packet_size = packet_buffer->size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
-    return packet_size;
+    SpinlockLocker lock(m_packet_queue_lock);
+    return !m_packet_queue.is_empty();
+}
+
+size_t NetworkAdapter::dequeue_packets(PacketList& packets, size_t max_count)
+{
+    SpinlockLocker lock(m_packet_queue_lock);
+    size_t count = 0;
+    while (count < max_count && !m_packet_queue.is_empty()) {
+        packets.append(*m_packet_queue.take_first());
+        m_packet_queue_size--;
+        count++;
+    }
+    return count;
 }
 
 LockRefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
@@ -16,6 +16,7 @@
 #include <Kernel/KBuffer.h>
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Library/LockWeakable.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
@@ -79,9 +80,13 @@ public:
     void send(MACAddress const&, ARPPacket const&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
+
+    // Moves up to max_count received packets over to the given list. Once the caller is done
+    // with them, they have to be handed back with release_packet_buffer().
+    size_t dequeue_packets(PacketList&, size_t max_count);
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    bool has_queued_packets() const;
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
@@ -115,16 +120,17 @@ private:
     // FIXME: Make this configurable
     static constexpr size_t max_packet_buffers = 1024;
 
-    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
-
+    // NOTE: Packets are queued from interrupt handlers (or, for the loopback adapter, from any thread
+    //       that sends something), while the adapter's receive thread drains them on another CPU.
+    mutable Spinlock<LockRank::None> m_packet_queue_lock {};
     PacketList m_packet_queue;
     size_t m_packet_queue_size { 0 };
     SpinlockProtected<PacketList, LockRank::None> m_unused_packets {};
     NonnullOwnPtr<KString> m_name;
-    u32 m_packets_in { 0 };
-    u32 m_bytes_in { 0 };
-    u32 m_packets_out { 0 };
-    u32 m_bytes_out { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_packets_in { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_bytes_in { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_packets_out { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_bytes_out { 0 };
     u32 m_mtu { 1500 };
 };
 
@@ -25,6 +25,7 @@
 
 namespace Kernel {
 
+static void handle_frame(ReadonlyBytes frame, Time const& packet_timestamp);
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
 static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, Time const& packet_timestamp);
@@ -35,10 +36,22 @@ static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_pac
 static void flush_delayed_tcp_acks();
 static void retransmit_tcp_packets();
 
-static Thread* network_task = nullptr;
-static HashTable<NonnullRefPtr<TCPSocket>>* delayed_ack_sockets;
+// NOTE: The main thread of the network task only takes care of timers, while every adapter
+//       gets a thread of its own that processes the packets it receives. Packets of a single
+//       connection come in through the same adapter, so they're still handled in order.
+static Process* network_task = nullptr;
+static MutexProtected<HashTable<NonnullRefPtr<TCPSocket>>>* delayed_ack_sockets;
+
+// How many packets a receive thread takes off its adapter's queue at once.
+static constexpr size_t receive_batch_size = 64;
+
+struct ReceiveThreadContext {
+    NonnullLockRefPtr<NetworkAdapter> adapter;
+    WaitQueue packet_wait_queue;
+};
 
 [[noreturn]] static void NetworkTask_main(void*);
+[[noreturn]] static void NetworkTask_receive_main(void*);
 
 void NetworkTask::spawn()
 {
@@ -46,21 +59,20 @@ void NetworkTask::spawn()
     auto name = KString::try_create("Network Task"sv);
     if (name.is_error())
         TODO();
-    (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
-    network_task = thread;
+    auto process = Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
+    network_task = process.ptr();
 }
 
 bool NetworkTask::is_current()
 {
-    return Thread::current() == network_task;
+    auto* current_thread = Thread::current();
+    return current_thread && &current_thread->process() == network_task;
 }
 
 void NetworkTask_main(void*)
 {
-    delayed_ack_sockets = new HashTable<NonnullRefPtr<TCPSocket>>;
+    delayed_ack_sockets = new MutexProtected<HashTable<NonnullRefPtr<TCPSocket>>>;
 
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -69,64 +81,72 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_netmask({ 255, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        auto* context = new ReceiveThreadContext { adapter, {} };
+        adapter.on_receive = [context]() {
+            context->packet_wait_queue.wake_one();
         };
-    });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
-    };
-
-    size_t buffer_size = 64 * KiB;
-    auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer"sv, Memory::Region::Access::ReadWrite);
-    if (region_or_error.is_error())
-        TODO();
-    auto buffer_region = region_or_error.release_value();
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
+        auto name = KString::formatted("Network Task ({})", adapter.name());
+        if (name.is_error())
+            TODO();
+        auto thread = Process::current().create_kernel_thread(NetworkTask_receive_main, context, THREAD_PRIORITY_NORMAL, name.release_value(), THREAD_AFFINITY_DEFAULT, false);
+        if (!thread)
+            TODO();
+    });
 
     for (;;) {
         flush_delayed_tcp_acks();
         retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
-            auto timeout_time = Time::from_milliseconds(500);
-            auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
-            continue;
-        }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
+        // NOTE: This needs to be short enough for the retransmission timers of TCP sockets to go off on time.
+        (void)Thread::current()->sleep(Time::from_milliseconds(100));
+    }
+}
+
+void NetworkTask_receive_main(void* context_ptr)
+{
+    auto& context = *static_cast<ReceiveThreadContext*>(context_ptr);
+    auto& adapter = *context.adapter;
+
+    for (;;) {
+        NetworkAdapter::PacketList packets;
+        if (adapter.dequeue_packets(packets, receive_batch_size) == 0) {
+            // NOTE: The adapter wakes us with wake_one(), which isn't lost if it happens right before we get here.
+            context.packet_wait_queue.wait_forever("NetworkTask"sv);
             continue;
         }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+
+        while (auto packet = packets.take_first()) {
+            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet->buffer->size());
+            handle_frame(packet->bytes(), packet->timestamp);
+            adapter.release_packet_buffer(*packet);
         }
+
+        // Acknowledge everything we received in this batch at once, rather than after every packet.
+        flush_delayed_tcp_acks();
+    }
+}
+
+void handle_frame(ReadonlyBytes frame, Time const& packet_timestamp)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame.size());
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame.size());
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, frame.size(), packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
     }
 }
 
@@ -310,13 +330,23 @@ void send_delayed_tcp_ack(TCPSocket& socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    delayed_ack_sockets->with_exclusive([&](auto& sockets) {
+        sockets.set(socket);
+    });
 }
 
 void flush_delayed_tcp_acks()
 {
+    // NOTE: Take the sockets out of the table before locking any of them, as send_delayed_tcp_ack()
+    //       locks the table while holding a socket's lock.
+    auto sockets = delayed_ack_sockets->with_exclusive([](auto& sockets) {
+        return move(sockets);
+    });
+    if (sockets.is_empty())
+        return;
+
     Vector<NonnullRefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(*socket));
@@ -325,13 +355,13 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
-        if (remaining_sockets.size() > 0)
-            dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    if (remaining_sockets.is_empty())
+        return;
+    dbgln_if(TCP_DEBUG, "flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    delayed_ack_sockets->with_exclusive([&](auto& sockets) {
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
-    }
+            sockets.set(move(socket));
+    });
 }
 
 void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, LockRefPtr<NetworkAdapter> adapter)
@@ -381,6 +411,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         dbgln("handle_tcp: TCP packet header has invalid size {}", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -459,6 +490,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -620,17 +652,24 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
-                dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
-                [[maybe_unused]] auto result = socket->send_ack(true);
+            // NOTE: A pure acknowledgement doesn't need one in return, even if it's ahead of the data we have.
+            if (payload_size == 0 && !tcp_packet.has_fin())
+                return;
+
+            // Hold on to segments that arrive ahead of a missing one, so the peer only needs to send that one again.
+            if (payload_size != 0 && !tcp_packet.has_fin() && tcp_sequence_number_is_before(socket->ack_number(), tcp_packet.sequence_number())) {
+                dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+                socket->queue_out_of_order_segment(ipv4_packet, tcp_packet, payload_size, packet_timestamp);
+            } else {
+                dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
             }
+
+            // RFC 5681, 4.2: An out-of-order segment has to be acknowledged right away, so that the peer
+            // notices the gap (and, with SACK, what's beyond it).
+            [[maybe_unused]] auto result = socket->send_ack(true);
             return;
         }
 
-        socket->set_duplicate_acks(0);
-
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -645,9 +684,18 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         if (payload_size) {
             if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp)) {
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+                bool did_fill_gap = socket->has_out_of_order_segments();
+                socket->deliver_out_of_order_segments();
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(*socket);
+                if (did_fill_gap) {
+                    [[maybe_unused]] auto result = socket->send_ack(true);
+                } else {
+                    send_delayed_tcp_ack(*socket);
+                }
+            } else {
+                // Let the peer know how much room we actually have.
+                [[maybe_unused]] auto result = socket->send_ack(true);
             }
         }
     }
@@ -21,6 +21,15 @@ struct TCPFlags {
     };
 };
 
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NoOperation = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -38,6 +47,45 @@ private:
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// RFC 7323, 2.2. Window Scale Option
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+    u8 shift_count() const { return m_shift_count; }
+
+private:
+    u8 m_option_kind { 0x03 };
+    u8 m_option_length { sizeof(TCPOptionWindowScale) };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 3>());
+
+// RFC 2018, 2. Sack-Permitted Option
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_option_kind { 0x04 };
+    u8 m_option_length { sizeof(TCPOptionSACKPermitted) };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 2>());
+
+// RFC 2018, 3. Sack Option Format
+struct [[gnu::packed]] TCPSACKBlock {
+    NetworkOrdered<u32> left_edge;
+    NetworkOrdered<u32> right_edge;
+};
+
+static_assert(AssertSize<TCPSACKBlock, 8>());
+
+// NOTE: Sequence numbers wrap around, so they can only be compared relative to each other (RFC 793, 3.3).
+constexpr bool tcp_sequence_number_is_before(u32 a, u32 b) { return static_cast<i32>(a - b) < 0; }
+constexpr bool tcp_sequence_number_is_at_or_before(u32 a, u32 b) { return static_cast<i32>(a - b) <= 0; }
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -77,6 +125,13 @@ public:
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
 
+    ReadonlyBytes options() const
+    {
+        if (header_size() <= sizeof(TCPPacket))
+            return {};
+        return { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) };
+    }
+
     void const* payload() const { return ((u8 const*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
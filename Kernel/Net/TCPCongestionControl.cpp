@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+static Atomic<TCPCongestionControl::Algorithm> s_default_algorithm { TCPCongestionControl::Algorithm::Cubic };
+
+// RFC 6928, 2. Proposal
+static u32 initial_window_for(u32 mss)
+{
+    return min(10 * mss, max(2 * mss, 14600u));
+}
+
+TCPCongestionControl::TCPCongestionControl(u32 mss)
+{
+    set_mss(mss);
+}
+
+void TCPCongestionControl::set_mss(u32 mss)
+{
+    m_mss = max(mss, 1u);
+    m_congestion_window = initial_window_for(m_mss);
+}
+
+void TCPCongestionControl::grow_in_slow_start(u32 acked_bytes)
+{
+    // RFC 3465, 2.2. Slow Start: Grow by the number of acknowledged bytes, but by at most 2 * MSS per ACK.
+    m_congestion_window += min(acked_bytes, 2 * m_mss);
+}
+
+void TCPCongestionControl::on_retransmit_timeout(u32 bytes_in_flight)
+{
+    // RFC 5681, 3.1. Slow Start and Congestion Avoidance, equation (4)
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+    m_congestion_window = m_mss;
+}
+
+// RFC 5681 congestion avoidance, with the loss recovery of RFC 6582 done by TCPSocket.
+class NewRenoCongestionControl final : public TCPCongestionControl {
+public:
+    explicit NewRenoCongestionControl(u32 mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::NewReno; }
+
+    virtual void on_ack(u32 acked_bytes, Time const&, Time const&) override
+    {
+        if (is_in_slow_start()) {
+            grow_in_slow_start(acked_bytes);
+            return;
+        }
+
+        // Grow by one MSS for every congestion window worth of acknowledged data.
+        m_bytes_acked += acked_bytes;
+        if (m_bytes_acked >= m_congestion_window) {
+            m_bytes_acked -= m_congestion_window;
+            m_congestion_window += m_mss;
+        }
+    }
+
+    virtual void on_loss(u32 bytes_in_flight, Time const&) override
+    {
+        m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+        m_congestion_window = m_slow_start_threshold;
+        m_bytes_acked = 0;
+    }
+
+    virtual void on_retransmit_timeout(u32 bytes_in_flight) override
+    {
+        TCPCongestionControl::on_retransmit_timeout(bytes_in_flight);
+        m_bytes_acked = 0;
+    }
+
+private:
+    u32 m_bytes_acked { 0 };
+};
+
+static u64 integer_cube_root(u64 value)
+{
+    // NOTE: 2642245 is the largest number whose cube fits in 64 bits.
+    u64 low = 0;
+    u64 high = 2642245;
+    while (low < high) {
+        u64 middle = (low + high + 1) / 2;
+        if (middle * middle * middle <= value)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+// RFC 9438, with β = 0.7 and C = 0.4. The kernel can't use floating point, so this works with windows in bytes
+// and times in milliseconds instead.
+class CubicCongestionControl final : public TCPCongestionControl {
+public:
+    explicit CubicCongestionControl(u32 mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::Cubic; }
+
+    virtual void on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt) override
+    {
+        if (is_in_slow_start()) {
+            grow_in_slow_start(acked_bytes);
+            return;
+        }
+
+        if (!m_epoch_start.has_value())
+            start_epoch(now);
+
+        // RFC 9438, 4.2. Window Increase Function: W_cubic(t) = C * (t - K)^3 + W_max, looking one RTT ahead.
+        i64 t = (now - m_epoch_start.value() + smoothed_rtt).to_milliseconds();
+        i64 time_from_origin = clamp(t - m_time_to_origin_in_ms, -max_cubic_time_in_ms, max_cubic_time_in_ms);
+        // NOTE: C * t^3 with t in milliseconds, in thousandths of a segment.
+        i64 offset_in_millisegments = 4 * time_from_origin * time_from_origin * time_from_origin / 10'000'000;
+        i64 cubic_window = static_cast<i64>(m_origin_window) + offset_in_millisegments * m_mss / 1000;
+
+        // RFC 9438, 4.4. Reno-Friendly Region: W_est grows by α = 3 * (1 - β) / (1 + β) ≈ 0.53 segments per window.
+        m_reno_window_credit += static_cast<u64>(acked_bytes) * m_mss * 53 / 100;
+        m_reno_window += m_reno_window_credit / m_congestion_window;
+        m_reno_window_credit %= m_congestion_window;
+
+        u64 target = max(cubic_window, static_cast<i64>(m_reno_window));
+        // RFC 9438, 4.2: The target must lie between the current congestion window and 1.5 times that.
+        target = clamp(target, static_cast<u64>(m_congestion_window), static_cast<u64>(m_congestion_window) * 3 / 2);
+
+        m_growth_credit += (target - m_congestion_window) * acked_bytes;
+        u64 growth = m_growth_credit / m_congestion_window;
+        m_growth_credit %= m_congestion_window;
+        m_congestion_window = static_cast<u32>(min(static_cast<u64>(m_congestion_window) + growth, static_cast<u64>(NumericLimits<u32>::max())));
+    }
+
+    virtual void on_loss(u32, Time const&) override
+    {
+        // RFC 9438, 4.7. Fast Convergence
+        if (m_congestion_window < m_max_window)
+            m_max_window = static_cast<u64>(m_congestion_window) * 17 / 20;
+        else
+            m_max_window = m_congestion_window;
+
+        // RFC 9438, 4.6. Multiplicative Decrease
+        m_slow_start_threshold = max(static_cast<u32>(static_cast<u64>(m_congestion_window) * 7 / 10), 2 * m_mss);
+        m_congestion_window = m_slow_start_threshold;
+        m_epoch_start.clear();
+    }
+
+    virtual void on_retransmit_timeout(u32) override
+    {
+        // RFC 9438, 4.8. Timeout
+        m_max_window = m_congestion_window;
+        m_slow_start_threshold = max(static_cast<u32>(static_cast<u64>(m_congestion_window) * 7 / 10), 2 * m_mss);
+        m_congestion_window = m_mss;
+        m_epoch_start.clear();
+    }
+
+private:
+    static constexpr i64 max_cubic_time_in_ms = 100'000;
+
+    void start_epoch(Time const& now)
+    {
+        m_epoch_start = now;
+        m_growth_credit = 0;
+        m_reno_window = m_congestion_window;
+        m_reno_window_credit = 0;
+
+        if (m_congestion_window >= m_max_window) {
+            m_time_to_origin_in_ms = 0;
+            m_origin_window = m_congestion_window;
+            return;
+        }
+
+        // K = cbrt((W_max - cwnd) / C), in milliseconds.
+        u64 missing_millisegments = min((m_max_window - m_congestion_window) * 1000 / m_mss, 1'000'000'000'000ull);
+        m_time_to_origin_in_ms = static_cast<i64>(integer_cube_root(missing_millisegments * 2'500'000));
+        m_origin_window = m_max_window;
+    }
+
+    Optional<Time> m_epoch_start;
+    i64 m_time_to_origin_in_ms { 0 };
+    u64 m_origin_window { 0 };
+    u64 m_max_window { 0 };
+    u64 m_growth_credit { 0 };
+    u64 m_reno_window { 0 };
+    u64 m_reno_window_credit { 0 };
+};
+
+ErrorOr<NonnullOwnPtr<TCPCongestionControl>> TCPCongestionControl::try_create(Algorithm algorithm, u32 mss)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return adopt_nonnull_own_or_enomem(new (nothrow) NewRenoCongestionControl(mss));
+    case Algorithm::Cubic:
+        return adopt_nonnull_own_or_enomem(new (nothrow) CubicCongestionControl(mss));
+    }
+    VERIFY_NOT_REACHED();
+}
+
+Optional<TCPCongestionControl::Algorithm> TCPCongestionControl::algorithm_from_name(StringView name)
+{
+    if (name == "newreno"sv || name == "reno"sv)
+        return Algorithm::NewReno;
+    if (name == "cubic"sv)
+        return Algorithm::Cubic;
+    return {};
+}
+
+StringView TCPCongestionControl::name_of(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return "newreno"sv;
+    case Algorithm::Cubic:
+        return "cubic"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+TCPCongestionControl::Algorithm TCPCongestionControl::default_algorithm()
+{
+    return s_default_algorithm.load();
+}
+
+void TCPCongestionControl::set_default_algorithm(Algorithm algorithm)
+{
+    s_default_algorithm.store(algorithm);
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Time.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// A TCPCongestionControl decides how much data a TCPSocket may have in flight. The socket detects losses and
+// takes care of recovering from them, and tells its congestion control about acknowledged data, losses and
+// retransmission timeouts.
+class TCPCongestionControl {
+public:
+    enum class Algorithm {
+        NewReno,
+        Cubic,
+    };
+
+    static ErrorOr<NonnullOwnPtr<TCPCongestionControl>> try_create(Algorithm, u32 mss);
+    static Optional<Algorithm> algorithm_from_name(StringView);
+    static StringView name_of(Algorithm);
+
+    static Algorithm default_algorithm();
+    static void set_default_algorithm(Algorithm);
+
+    virtual ~TCPCongestionControl() = default;
+
+    virtual Algorithm algorithm() const = 0;
+    StringView name() const { return name_of(algorithm()); }
+
+    u32 mss() const { return m_mss; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    // NOTE: This also resets the congestion window to the initial window, so it should only be used before sending any data.
+    void set_mss(u32);
+
+    // New data has been acknowledged outside of loss recovery.
+    virtual void on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt) = 0;
+    // A loss was detected through duplicate acknowledgements or SACK, and loss recovery starts now.
+    virtual void on_loss(u32 bytes_in_flight, Time const& now) = 0;
+    // All the data that was in flight when loss recovery started has been acknowledged.
+    virtual void on_recovery_complete() { m_congestion_window = m_slow_start_threshold; }
+    // The retransmission timer expired.
+    virtual void on_retransmit_timeout(u32 bytes_in_flight);
+
+protected:
+    explicit TCPCongestionControl(u32 mss);
+
+    void grow_in_slow_start(u32 acked_bytes);
+
+    u32 m_mss { 0 };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+};
+
+}
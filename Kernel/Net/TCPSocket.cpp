@@ -4,8 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <AK/HashFunctions.h>
 #include <AK/Singleton.h>
 #include <AK/Time.h>
+#include <Kernel/API/POSIX/netinet/tcp.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -22,25 +25,32 @@
 
 namespace Kernel {
 
+static Singleton<Array<TCPSocket::SocketTable, TCPSocket::socket_table_shard_count>> s_socket_tuples;
+
 void TCPSocket::for_each(Function<void(TCPSocket const&)> callback)
 {
-    sockets_by_tuple().for_each_shared([&](auto const& it) {
-        callback(*it.value);
-    });
+    for (auto& shard : *s_socket_tuples) {
+        shard.for_each_shared([&](auto const& it) {
+            callback(*it.value);
+        });
+    }
 }
 
 ErrorOr<void> TCPSocket::try_for_each(Function<ErrorOr<void>(TCPSocket const&)> callback)
 {
-    return sockets_by_tuple().with_shared([&](auto const& sockets) -> ErrorOr<void> {
-        for (auto& it : sockets)
-            TRY(callback(*it.value));
-        return {};
-    });
+    for (auto& shard : *s_socket_tuples) {
+        TRY(shard.with_shared([&](auto const& sockets) -> ErrorOr<void> {
+            for (auto& it : sockets)
+                TRY(callback(*it.value));
+            return {};
+        }));
+    }
+    return {};
 }
 
 bool TCPSocket::unref() const
 {
-    bool did_hit_zero = sockets_by_tuple().with_exclusive([&](auto& table) {
+    bool did_hit_zero = sockets_by_tuple(tuple()).with_exclusive([&](auto& table) {
         if (deref_base())
             return false;
         table.remove(tuple());
@@ -95,42 +105,44 @@ MutexProtected<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_
     return *s_socket_closing;
 }
 
-static Singleton<MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>> s_socket_tuples;
-
-MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+TCPSocket::SocketTable& TCPSocket::sockets_by_tuple(IPv4SocketTuple const& tuple)
 {
-    return *s_socket_tuples;
+    // NOTE: The shard's HashMap buckets by the same hash, so mix it up a bit to keep the two from correlating.
+    auto shard_index = int_hash(Traits<IPv4SocketTuple>::hash(tuple)) % socket_table_shard_count;
+    return (*s_socket_tuples)[shard_index];
 }
 
 RefPtr<TCPSocket> TCPSocket::from_tuple(IPv4SocketTuple const& tuple)
 {
-    return sockets_by_tuple().with_shared([&](auto const& table) -> RefPtr<TCPSocket> {
-        auto exact_match = table.get(tuple);
-        if (exact_match.has_value())
-            return { *exact_match.value() };
+    auto lookup = [](IPv4SocketTuple const& tuple) {
+        return sockets_by_tuple(tuple).with_shared([&](auto const& table) -> RefPtr<TCPSocket> {
+            auto match = table.get(tuple);
+            if (match.has_value())
+                return { *match.value() };
+            return {};
+        });
+    };
 
-        auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-        auto address_match = table.get(address_tuple);
-        if (address_match.has_value())
-            return { *address_match.value() };
+    if (auto exact_match = lookup(tuple))
+        return exact_match;
 
-        auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-        auto wildcard_match = table.get(wildcard_tuple);
-        if (wildcard_match.has_value())
-            return { *wildcard_match.value() };
+    if (auto address_match = lookup(IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0)))
+        return address_match;
 
-        return {};
-    });
+    return lookup(IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0));
 }
 ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create_client(IPv4Address const& new_local_address, u16 new_local_port, IPv4Address const& new_peer_address, u16 new_peer_port)
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
-    return sockets_by_tuple().with_exclusive([&](auto& table) -> ErrorOr<NonnullRefPtr<TCPSocket>> {
+    return sockets_by_tuple(tuple).with_exclusive([&](auto& table) -> ErrorOr<NonnullRefPtr<TCPSocket>> {
         if (table.contains(tuple))
             return EEXIST;
 
         auto receive_buffer = TRY(try_create_receive_buffer());
         auto client = TRY(TCPSocket::try_create(protocol(), move(receive_buffer)));
+        // Accepted connections use the same congestion control as the socket they came in on.
+        if (client->m_congestion_control->algorithm() != m_congestion_control->algorithm())
+            client->m_congestion_control = TRY(TCPCongestionControl::try_create(m_congestion_control->algorithm(), default_mss));
 
         client->set_setup_state(SetupState::InProgress);
         client->set_local_address(new_local_address);
@@ -162,10 +174,11 @@ void TCPSocket::release_for_accept(NonnullRefPtr<TCPSocket> socket)
     [[maybe_unused]] auto rc = queue_connection_from(move(socket));
 }
 
-TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
+TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl> congestion_control)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
+    , m_congestion_control(move(congestion_control))
 {
-    m_last_retransmit_time = kgettimeofday();
+    m_retransmit_timer_start = kgettimeofday();
 }
 
 TCPSocket::~TCPSocket()
@@ -179,7 +192,8 @@ ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create(int protocol, NonnullOwn
 {
     // Note: Scratch buffer is only used for SOCK_STREAM sockets.
     auto scratch_buffer = TRY(KBuffer::try_create_with_size("TCPSocket: Scratch buffer"sv, 65536));
-    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer)));
+    auto congestion_control = TRY(TCPCongestionControl::try_create(TCPCongestionControl::default_algorithm(), default_mss));
+    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer), move(congestion_control)));
 }
 
 ErrorOr<size_t> TCPSocket::protocol_size(ReadonlyBytes raw_ipv4_packet)
@@ -200,13 +214,26 @@ ErrorOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserO
     return payload_size;
 }
 
+static u16 maximum_segment_size_for(NetworkAdapter const& adapter)
+{
+    // NOTE: Besides fitting into the MTU, a whole frame has to fit into a 64 KiB packet buffer, which also keeps
+    //       the IPv4 packet within its maximum size (this matters for the loopback adapter's large MTU).
+    size_t maximum_ipv4_payload_size = min<size_t>(adapter.mtu() - sizeof(IPv4Packet), 64 * KiB - adapter.ipv4_payload_offset());
+    return maximum_ipv4_payload_size - sizeof(TCPPacket);
+}
+
 ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t data_length)
 {
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-    data_length = min(data_length, mss);
+    size_t mss = min<size_t>(m_send_mss, maximum_segment_size_for(*routing_decision.adapter));
+    size_t sendable = m_unacked_packets.with_shared([&](auto const& unacked_packets) {
+        return sendable_bytes(unacked_packets);
+    });
+    if (sendable == 0)
+        return set_so_error(EAGAIN);
+    data_length = min(data_length, min(mss, sendable));
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
@@ -218,6 +245,100 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
     return send_tcp_packet(TCPFlags::ACK);
 }
 
+u8 TCPSocket::receive_window_scale_to_offer() const
+{
+    u8 shift = 0;
+    while (shift < maximum_window_scale && (receive_buffer_capacity() >> shift) > NumericLimits<u16>::max())
+        ++shift;
+    return shift;
+}
+
+u32 TCPSocket::receive_window() const
+{
+    // NOTE: Segments waiting in the out-of-order queue have already claimed part of the receive buffer.
+    auto space = receive_buffer_space();
+    if (space <= m_out_of_order_bytes)
+        return 0;
+    return min<size_t>(space - m_out_of_order_bytes, NumericLimits<u32>::max());
+}
+
+size_t TCPSocket::write_options(u16 flags, size_t payload_size, Bytes options) const
+{
+    size_t offset = 0;
+    auto append = [&](auto const& option) {
+        VERIFY(offset + sizeof(option) <= options.size());
+        memcpy(options.offset_pointer(offset), &option, sizeof(option));
+        offset += sizeof(option);
+    };
+    auto append_padding = [&](size_t count) {
+        VERIFY(offset + count <= options.size());
+        memset(options.offset_pointer(offset), to_underlying(TCPOptionKind::NoOperation), count);
+        offset += count;
+    };
+
+    if (flags & TCPFlags::SYN) {
+        // NOTE: We always offer window scaling and SACK, but a SYN-ACK may only contain them if the peer offered them as well.
+        bool is_syn_ack = flags & TCPFlags::ACK;
+        append(TCPOptionMSS { m_receive_mss });
+        if (!is_syn_ack || m_is_window_scaling_enabled) {
+            append_padding(1);
+            append(TCPOptionWindowScale { is_syn_ack ? m_receive_window_scale : receive_window_scale_to_offer() });
+        }
+        if (!is_syn_ack || m_is_sack_enabled) {
+            append_padding(2);
+            append(TCPOptionSACKPermitted {});
+        }
+        return offset;
+    }
+
+    // RFC 2018, 4: Report the out-of-order data we're holding on to whenever we send an acknowledgement.
+    // NOTE: We only do this for pure acknowledgements, so the options never take away room from the payload.
+    if (!m_is_sack_enabled || m_out_of_order_segments.is_empty() || payload_size != 0)
+        return 0;
+
+    struct Range {
+        u32 left_edge { 0 };
+        u32 right_edge { 0 };
+    };
+    Vector<Range, 16> ranges;
+    for (auto const& segment : m_out_of_order_segments) {
+        u32 segment_end = segment.sequence_number + segment.payload_size;
+        if (!ranges.is_empty() && tcp_sequence_number_is_at_or_before(segment.sequence_number, ranges.last().right_edge)) {
+            if (tcp_sequence_number_is_before(ranges.last().right_edge, segment_end))
+                ranges.last().right_edge = segment_end;
+            continue;
+        }
+        if (ranges.try_append({ segment.sequence_number, segment_end }).is_error())
+            break;
+    }
+
+    // The first block has to be the one containing the most recently received segment, and the others should
+    // be the ones closest to it (RFC 2018, 4).
+    Optional<size_t> most_recent_index;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (tcp_sequence_number_is_at_or_before(ranges[i].left_edge, m_most_recent_out_of_order_sequence_number)
+            && tcp_sequence_number_is_before(m_most_recent_out_of_order_sequence_number, ranges[i].right_edge)) {
+            most_recent_index = i;
+            break;
+        }
+    }
+
+    size_t block_count = min(ranges.size(), maximum_sack_blocks);
+    append_padding(2);
+    append(to_underlying(TCPOptionKind::SACK));
+    append(static_cast<u8>(2 + block_count * sizeof(TCPSACKBlock)));
+    auto append_block = [&](Range const& range) {
+        append(TCPSACKBlock { range.left_edge, range.right_edge });
+    };
+    if (most_recent_index.has_value())
+        append_block(ranges[most_recent_index.value()]);
+    for (size_t i = ranges.size(); i > 0 && offset < 4 + block_count * sizeof(TCPSACKBlock); --i) {
+        if (!most_recent_index.has_value() || i - 1 != most_recent_index.value())
+            append_block(ranges[i - 1]);
+    }
+    return offset;
+}
+
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* payload, size_t payload_size, RoutingDecision* user_routing_decision)
 {
     RoutingDecision routing_decision = user_routing_decision ? *user_routing_decision : route_to(peer_address(), local_address(), bound_interface());
@@ -226,8 +347,12 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    if (flags & TCPFlags::SYN)
+        m_receive_mss = maximum_segment_size_for(*routing_decision.adapter);
+
+    Array<u8, maximum_options_size> options;
+    const size_t options_size = write_options(flags, payload_size, options);
+    VERIFY(options_size % sizeof(u32) == 0);
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -241,7 +366,10 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    // RFC 7323, 2.2: The window field in a SYN segment is never scaled.
+    u8 window_scale = (flags & TCPFlags::SYN) ? 0 : m_receive_window_scale;
+    u16 window_size = min<u32>(receive_window() >> window_scale, NumericLimits<u16>::max());
+    tcp_packet.set_window_size(window_size);
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
@@ -253,23 +381,27 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         }
     }
 
+    auto now = kgettimeofday();
+
     if (flags & TCPFlags::ACK) {
         m_last_ack_number_sent = m_ack_number;
-        m_last_ack_sent_time = kgettimeofday();
+        m_last_ack_sent_time = now;
+        m_last_advertised_window_edge = m_ack_number + (static_cast<u32>(window_size) << window_scale);
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    u32 sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
+        m_send_unacknowledged = m_sequence_number;
+        m_recovery_point = m_sequence_number;
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+    if (options_size > 0) {
+        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + options_size);
+        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), options.data(), options_size);
     }
 
     tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
@@ -278,13 +410,17 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     if (expect_ack) {
         bool append_failed { false };
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter });
+            // RFC 6298, 5.1: Start the retransmission timer if it isn't running yet.
+            if (unacked_packets.packets.is_empty())
+                m_retransmit_timer_start = now;
+            auto result = unacked_packets.packets.try_append({ sequence_number, m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter, 0, now });
             if (result.is_error()) {
                 dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
                 append_failed = true;
                 return;
             }
             unacked_packets.size += payload_size;
+            unacked_packets.pipe_size += m_sequence_number - sequence_number;
             enqueue_for_retransmit();
         });
         if (append_failed)
@@ -300,55 +436,354 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     return {};
 }
 
+TCPSocket::ReceivedOptions TCPSocket::parse_options(TCPPacket const& packet)
+{
+    ReceivedOptions options;
+    auto bytes = packet.options();
+    for (size_t offset = 0; offset < bytes.size();) {
+        auto kind = static_cast<TCPOptionKind>(bytes[offset]);
+        if (kind == TCPOptionKind::End)
+            break;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++offset;
+            continue;
+        }
+        if (offset + 1 >= bytes.size())
+            break;
+        size_t length = bytes[offset + 1];
+        if (length < 2 || offset + length > bytes.size()) {
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: Ignoring malformed option of kind {} with length {}", to_underlying(kind), length);
+            break;
+        }
+        auto data = bytes.slice(offset + 2, length - 2);
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (data.size() == sizeof(u16))
+                options.mss = (data[0] << 8) | data[1];
+            break;
+        case TCPOptionKind::WindowScale:
+            // RFC 7323, 2.3: Larger shift counts have to be treated as the maximum.
+            if (data.size() == sizeof(u8))
+                options.window_scale = min(data[0], maximum_window_scale);
+            break;
+        case TCPOptionKind::SACKPermitted:
+            options.sack_permitted = true;
+            break;
+        case TCPOptionKind::SACK:
+            for (size_t i = 0; i + sizeof(TCPSACKBlock) <= data.size() && options.sack_blocks.size() < maximum_sack_blocks; i += sizeof(TCPSACKBlock)) {
+                TCPSACKBlock block;
+                memcpy(&block, data.offset_pointer(i), sizeof(block));
+                options.sack_blocks.unchecked_append(block);
+            }
+            break;
+        default:
+            break;
+        }
+        offset += length;
+    }
+    return options;
+}
+
+void TCPSocket::process_syn_options(TCPPacket const& packet)
+{
+    process_syn_options(parse_options(packet));
+}
+
+void TCPSocket::process_syn_options(ReceivedOptions const& options)
+{
+    // RFC 7323, 1.3 and RFC 2018, 2: These are only used if both sides asked for them in their SYN.
+    m_is_window_scaling_enabled = options.window_scale.has_value();
+    m_send_window_scale = options.window_scale.value_or(0);
+    m_receive_window_scale = m_is_window_scaling_enabled ? receive_window_scale_to_offer() : 0;
+    m_is_sack_enabled = options.sack_permitted;
+
+    u16 mss = options.mss.value_or(default_mss);
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (!routing_decision.is_zero())
+        mss = min(mss, maximum_segment_size_for(*routing_decision.adapter));
+    m_send_mss = mss;
+    m_congestion_control->set_mss(mss);
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): mss={}, window scaling={} (send {}, receive {}), SACK={}",
+        this, m_send_mss, m_is_window_scaling_enabled, m_send_window_scale, m_receive_window_scale, m_is_sack_enabled);
+}
+
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    auto options = parse_options(packet);
+
+    if (packet.has_syn() && m_state == State::SynSent)
+        process_syn_options(options);
+
+    if (packet.has_ack())
+        process_ack(packet, options, size - packet.header_size());
+
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+u32 TCPSocket::bytes_in_flight(UnackedPackets const& unacked_packets) const
+{
+    // RFC 6675, 4 (SetPipe): Packets the peer already has or that we're about to send again don't count.
+    u32 in_flight = unacked_packets.pipe_size;
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    // RFC 5681, 3.2: Without SACK, every duplicate acknowledgement tells us that a segment has left the network.
+    if (m_is_in_loss_recovery && !m_is_sack_enabled)
+        in_flight -= min(in_flight, m_duplicate_acks * m_send_mss);
+    return in_flight;
+}
 
+u32 TCPSocket::sendable_bytes(UnackedPackets const& unacked_packets) const
+{
+    u32 outstanding = m_sequence_number - m_send_unacknowledged;
+    u32 in_flight = bytes_in_flight(unacked_packets);
+    u32 congestion_window = m_congestion_control->congestion_window();
+    u32 congestion_room = congestion_window > in_flight ? congestion_window - in_flight : 0;
+    u32 receive_room = m_send_window_size > outstanding ? m_send_window_size - outstanding : 0;
+    u32 room = min(congestion_room, receive_room);
+
+    // RFC 1122, 4.2.2.17: Keep probing a closed window with a single segment.
+    if (outstanding == 0)
+        return max(room, 1u);
+
+    // RFC 1122, 4.2.3.4: Don't send tiny segments while we're waiting for the window to open up.
+    if (room < m_send_mss)
+        return 0;
+    return room;
+}
+
+void TCPSocket::update_retransmission_timeout(Time const& rtt)
+{
+    if (!m_has_rtt_sample) {
+        // RFC 6298, 2.2
+        m_smoothed_rtt = rtt;
+        m_rtt_variance = Time::from_microseconds(rtt.to_microseconds() / 2);
+        m_has_rtt_sample = true;
+    } else {
+        // RFC 6298, 2.3, with alpha = 1/8 and beta = 1/4
+        auto smoothed_rtt = m_smoothed_rtt.to_microseconds();
+        auto sample = rtt.to_microseconds();
+        auto deviation = smoothed_rtt > sample ? smoothed_rtt - sample : sample - smoothed_rtt;
+        m_rtt_variance = Time::from_microseconds((3 * m_rtt_variance.to_microseconds() + deviation) / 4);
+        m_smoothed_rtt = Time::from_microseconds((7 * smoothed_rtt + sample) / 8);
+    }
+
+    auto variance_term = max(clock_granularity, Time::from_microseconds(4 * m_rtt_variance.to_microseconds()));
+    m_retransmission_timeout = clamp(m_smoothed_rtt + variance_term, minimum_retransmission_timeout, maximum_retransmission_timeout);
+}
+
+void TCPSocket::process_ack(TCPPacket const& tcp_packet, ReceivedOptions const& options, size_t payload_size)
+{
+    u32 ack_number = tcp_packet.ack_number();
+    auto now = kgettimeofday();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+
+    u32 previous_send_window_size = m_send_window_size;
+    // RFC 7323, 2.2: The window field in a SYN segment is never scaled.
+    m_send_window_size = tcp_packet.has_syn() ? tcp_packet.window_size() : static_cast<u32>(tcp_packet.window_size()) << m_send_window_scale;
+
+    u32 acked_bytes = 0;
+    if (tcp_sequence_number_is_before(m_send_unacknowledged, ack_number) && tcp_sequence_number_is_at_or_before(ack_number, m_sequence_number)) {
+        acked_bytes = ack_number - m_send_unacknowledged;
+        m_send_unacknowledged = ack_number;
+    }
+
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        bool had_outstanding_packets = !unacked_packets.packets.is_empty();
+
+        Optional<Time> rtt_sample;
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
-                    break;
+        while (!unacked_packets.packets.is_empty()) {
+            auto& packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
+
+            if (!tcp_sequence_number_is_at_or_before(packet.ack_number, ack_number))
+                break;
+
+            // RFC 6298, 3 (Karn's algorithm): A retransmitted packet can't tell us anything about the round-trip time.
+            if (packet.tx_counter == 0)
+                rtt_sample = now - packet.sent_time;
+
+            auto old_adapter = packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*packet.buffer);
+            auto& sent_tcp_packet = *(TCPPacket const*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+            auto sent_payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8 const*)sent_tcp_packet.payload();
+            unacked_packets.size -= sent_payload_size;
+            unacked_packets.pipe_size -= UnackedPackets::pipe_size_of(packet);
+            unacked_packets.packets.take_first();
+            removed++;
+        }
+
+        if (rtt_sample.has_value())
+            update_retransmission_timeout(rtt_sample.value());
+
+        if (m_is_sack_enabled) {
+            for (auto const& block : options.sack_blocks) {
+                u32 left_edge = block.left_edge;
+                u32 right_edge = block.right_edge;
+                for (auto& packet : unacked_packets.packets) {
+                    if (tcp_sequence_number_is_at_or_before(left_edge, packet.sequence_number) && tcp_sequence_number_is_at_or_before(packet.ack_number, right_edge))
+                        unacked_packets.set_packet_state(packet, true, false);
                 }
             }
+        }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+        auto mark_lost = [&](OutgoingPacket& packet) {
+            if (packet.is_lost || packet.is_sacked)
+                return;
+            packet.is_lost = true;
+            unacked_packets.set_packet_state(packet, false, true);
+        };
+
+        if (acked_bytes > 0) {
+            m_duplicate_acks = 0;
+            m_retransmit_attempts = 0;
+            // RFC 6298, 5.3: Restart the timer whenever new data is acknowledged.
+            m_retransmit_timer_start = now;
+            if (m_is_in_loss_recovery) {
+                if (tcp_sequence_number_is_at_or_before(m_recovery_point, ack_number)) {
+                    m_is_in_loss_recovery = false;
+                    m_congestion_control->on_recovery_complete();
+                } else if (!unacked_packets.packets.is_empty() && !unacked_packets.packets.first().is_sacked) {
+                    // RFC 6582, 3.2 (step 5): A partial acknowledgement means that the next segment was lost as well.
+                    unacked_packets.packets.first().is_lost = true;
+                    unacked_packets.set_packet_state(unacked_packets.packets.first(), false, true);
+                }
+            } else if (!tcp_packet.has_syn()) {
+                m_congestion_control->on_ack(acked_bytes, now, m_smoothed_rtt);
             }
+        } else if (had_outstanding_packets && payload_size == 0 && !tcp_packet.has_syn() && !tcp_packet.has_fin()
+            && ack_number == m_send_unacknowledged && m_send_window_size == previous_send_window_size) {
+            // RFC 5681, 2: This is a duplicate acknowledgement.
+            ++m_duplicate_acks;
+        }
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+        if (!unacked_packets.packets.is_empty()) {
+            u32 sacked_bytes = 0;
+            for (auto const& packet : unacked_packets.packets) {
+                if (packet.is_sacked)
+                    sacked_bytes += packet.ack_number - packet.sequence_number;
+            }
+            // RFC 6675, 4 (IsLost): A segment is lost once enough data above it has been SACKed.
+            u32 const lost_threshold = (duplicate_ack_threshold - 1) * m_send_mss;
+
+            if (!m_is_in_loss_recovery && tcp_sequence_number_is_at_or_before(m_recovery_point, m_send_unacknowledged)
+                && (m_duplicate_acks >= duplicate_ack_threshold || (m_is_sack_enabled && sacked_bytes > lost_threshold))) {
+                // RFC 5681, 3.2 and RFC 6675, 5: Enter loss recovery, and send the first missing segment again right away.
+                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): Entering loss recovery at {} ({} duplicate ACKs, {} bytes SACKed)", this, m_send_unacknowledged, m_duplicate_acks, sacked_bytes);
+                m_is_in_loss_recovery = true;
+                m_recovery_point = m_sequence_number;
+                m_congestion_control->on_loss(bytes_in_flight(unacked_packets), now);
+                mark_lost(unacked_packets.packets.first());
+            }
+
+            if (m_is_in_loss_recovery && m_is_sack_enabled) {
+                u32 sacked_bytes_above = sacked_bytes;
+                for (auto& packet : unacked_packets.packets) {
+                    if (packet.is_sacked) {
+                        sacked_bytes_above -= packet.ack_number - packet.sequence_number;
+                        continue;
+                    }
+                    if (sacked_bytes_above <= lost_threshold)
+                        break;
+                    mark_lost(packet);
+                }
+            }
+        }
+
+        if (unacked_packets.packets.is_empty()) {
+            m_retransmit_attempts = 0;
+            dequeue_for_retransmit();
+        }
+
+        transmit_lost_packets(unacked_packets);
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+    });
+
+    if (acked_bytes > 0 || m_send_window_size != previous_send_window_size)
+        evaluate_block_conditions();
+}
+
+void TCPSocket::queue_out_of_order_segment(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, size_t payload_size, Time const& packet_timestamp)
+{
+    u32 sequence_number = tcp_packet.sequence_number();
+    VERIFY(tcp_sequence_number_is_before(m_ack_number, sequence_number));
+
+    // NOTE: The data in between will need room in the receive buffer as well.
+    if ((sequence_number + payload_size) - m_ack_number > receive_buffer_space() || m_out_of_order_segments.size() >= maximum_out_of_order_segments) {
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}): Dropping out-of-order segment at {} since there is no room for it", this, sequence_number);
+        return;
     }
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+    size_t index = 0;
+    for (; index < m_out_of_order_segments.size(); ++index) {
+        auto const& segment = m_out_of_order_segments[index];
+        if (segment.sequence_number == sequence_number) {
+            m_most_recent_out_of_order_sequence_number = sequence_number;
+            return;
+        }
+        if (tcp_sequence_number_is_before(sequence_number, segment.sequence_number))
+            break;
+    }
+
+    auto buffer_or_error = KBuffer::try_create_with_bytes("TCPSocket: Out-of-order segment"sv, { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() });
+    if (buffer_or_error.is_error()) {
+        dbgln("TCPSocket: Dropped out-of-order segment because allocating storage for it failed");
+        return;
+    }
+    if (m_out_of_order_segments.try_insert(index, { sequence_number, static_cast<u32>(payload_size), packet_timestamp, buffer_or_error.release_value() }).is_error()) {
+        dbgln("TCPSocket: Dropped out-of-order segment because try_insert() failed");
+        return;
+    }
+    m_out_of_order_bytes += payload_size;
+    m_most_recent_out_of_order_sequence_number = sequence_number;
+}
+
+size_t TCPSocket::deliver_out_of_order_segments()
+{
+    size_t delivered = 0;
+    while (!m_out_of_order_segments.is_empty()) {
+        if (tcp_sequence_number_is_before(m_ack_number, m_out_of_order_segments.first().sequence_number))
+            break;
+
+        auto segment = m_out_of_order_segments.take_first();
+        m_out_of_order_bytes -= segment.payload_size;
+
+        // NOTE: We can't trim segments that overlap the data we have already, so we let the peer send those again.
+        if (segment.sequence_number != m_ack_number)
+            continue;
+        if (!did_receive(peer_address(), peer_port(), segment.ipv4_packet->bytes(), segment.timestamp))
+            continue;
+        m_ack_number += segment.payload_size;
+        ++delivered;
+    }
+    return delivered;
+}
+
+void TCPSocket::protocol_did_consume_receive_buffer()
+{
+    if (m_state != State::Established && m_state != State::FinWait1 && m_state != State::FinWait2)
+        return;
+
+    // RFC 1122, 4.2.3.3: Let the peer know that the window opened up, once that's worth a full segment or half the buffer.
+    u32 window_edge = m_ack_number + receive_window();
+    u32 threshold = min<size_t>(m_receive_mss, receive_buffer_capacity() / 2);
+    if (tcp_sequence_number_is_before(m_last_advertised_window_edge, window_edge) && window_edge - m_last_advertised_window_edge >= threshold)
+        (void)send_ack(true);
 }
 
 bool TCPSocket::should_delay_next_ack() const
 {
-    // FIXME: We don't know the MSS here so make a reasonable guess.
-    const size_t mss = 1500;
+    // RFC 5681, 4.2: Segments that arrive out of order, or that fill in a gap, have to be acknowledged right away.
+    if (!m_out_of_order_segments.is_empty())
+        return false;
 
     // RFC 1122 says we should send an ACK for every two full-sized segments.
-    if (m_ack_number >= m_last_ack_number_sent + 2 * mss)
+    if (m_ack_number - m_last_ack_number_sent >= 2u * m_receive_mss)
         return false;
 
     // RFC 1122 says we should not delay ACKs for more than 500 milliseconds.
@@ -421,7 +856,7 @@ ErrorOr<void> TCPSocket::protocol_bind()
 ErrorOr<void> TCPSocket::protocol_listen(bool did_allocate_port)
 {
     if (!did_allocate_port) {
-        bool ok = sockets_by_tuple().with_exclusive([&](auto& table) -> bool {
+        bool ok = sockets_by_tuple(tuple()).with_exclusive([&](auto& table) -> bool {
             if (table.contains(tuple()))
                 return false;
             table.set(tuple(), this);
@@ -488,24 +923,26 @@ ErrorOr<u16> TCPSocket::protocol_allocate_local_port()
     constexpr u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    return sockets_by_tuple().with_exclusive([&](auto& table) -> ErrorOr<u16> {
-        for (u16 port = first_scan_port;;) {
-            IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
+    for (u16 port = first_scan_port;;) {
+        IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
 
-            auto it = table.find(proposed_tuple);
-            if (it == table.end()) {
-                set_local_port(port);
-                table.set(proposed_tuple, this);
-                return port;
-            }
-            ++port;
-            if (port > last_ephemeral_port)
-                port = first_ephemeral_port;
-            if (port == first_scan_port)
-                break;
-        }
-        return set_so_error(EADDRINUSE);
-    });
+        bool did_claim_port = sockets_by_tuple(proposed_tuple).with_exclusive([&](auto& table) {
+            if (table.contains(proposed_tuple))
+                return false;
+            set_local_port(port);
+            table.set(proposed_tuple, this);
+            return true;
+        });
+        if (did_claim_port)
+            return port;
+
+        ++port;
+        if (port > last_ephemeral_port)
+            port = first_ephemeral_port;
+        if (port == first_scan_port)
+            break;
+    }
+    return set_so_error(EADDRINUSE);
 }
 
 bool TCPSocket::protocol_is_disconnected() const
@@ -573,70 +1010,109 @@ void TCPSocket::dequeue_for_retransmit()
     });
 }
 
+void TCPSocket::retransmit_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_counter++;
+    packet.sent_time = kgettimeofday();
+    m_retransmitted_packets++;
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
+
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
+
+    auto packet_buffer = packet.buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+}
+
+void TCPSocket::transmit_lost_packets(UnackedPackets& unacked_packets)
+{
+    Optional<RoutingDecision> routing_decision;
+    u32 in_flight = bytes_in_flight(unacked_packets);
+    for (auto& packet : unacked_packets.packets) {
+        if (!packet.needs_retransmit)
+            continue;
+        if (in_flight >= m_congestion_control->congestion_window())
+            break;
+        if (!routing_decision.has_value()) {
+            routing_decision = route_to(peer_address(), local_address(), bound_interface());
+            if (routing_decision->is_zero())
+                return;
+        }
+        unacked_packets.set_packet_state(packet, packet.is_sacked, false);
+        retransmit_packet(packet, routing_decision.value());
+        in_flight += packet.ack_number - packet.sequence_number;
+    }
+}
+
 void TCPSocket::retransmit_packets()
 {
     auto now = kgettimeofday();
 
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
+    // RFC 6298, 5.5: Back off the timer exponentially with every retransmission. According to
+    // RFC 1122, we must do that even for SYN packets.
+    auto timeout = m_retransmission_timeout;
+    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts && timeout < maximum_retransmission_timeout; i++)
+        timeout = timeout + timeout;
+    timeout = min(timeout, maximum_retransmission_timeout);
 
-    if (m_last_retransmit_time > now - Time::from_seconds(retransmit_interval))
+    if (now < m_retransmit_timer_start + timeout)
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
 
-    m_last_retransmit_time = now;
+    m_retransmit_timer_start = now;
     ++m_retransmit_attempts;
 
-    if (m_retransmit_attempts > maximum_retransmits) {
+    // RFC 1122, 4.2.2.17: A peer that keeps its receive window closed is still there, so keep probing it.
+    bool is_probing_closed_window = m_state == State::Established && m_send_window_size == 0;
+    if (m_retransmit_attempts > maximum_retransmits && !is_probing_closed_window) {
         set_state(TCPSocket::State::Closed);
         set_error(TCPSocket::Error::RetransmitTimeout);
         set_setup_state(Socket::SetupState::Completed);
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    if (routing_decision.is_zero())
-        return;
-
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-        for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
-
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+        if (unacked_packets.packets.is_empty())
+            return;
 
-            auto packet_buffer = packet.buffer->bytes();
+        m_congestion_control->on_retransmit_timeout(bytes_in_flight(unacked_packets));
+        m_is_in_loss_recovery = false;
+        m_recovery_point = m_sequence_number;
+        m_duplicate_acks = 0;
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
+        // RFC 2018, 8 and RFC 6675, 5.1: The peer may have dropped data it told us about, so forget about
+        // the SACKs and consider everything lost.
+        for (auto& packet : unacked_packets.packets) {
+            packet.is_lost = true;
+            unacked_packets.set_packet_state(packet, false, true);
         }
+
+        transmit_lost_packets(unacked_packets);
     });
 }
 
@@ -648,11 +1124,67 @@ bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
-    return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+    // NOTE: This has to agree with protocol_send(), which refuses to send anything if there's no room.
+    return m_unacked_packets.with_shared([&](auto const& unacked_packets) {
+        return sendable_bytes(unacked_packets) > 0;
     });
 }
+
+ErrorOr<void> TCPSocket::setsockopt(int level, int option, Userspace<void const*> user_value, socklen_t user_value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::setsockopt(level, option, user_value, user_value_size);
+
+    MutexLocker locker(mutex());
+
+    switch (option) {
+    case TCP_CONGESTION: {
+        if (user_value_size == 0 || user_value_size > TCP_CA_NAME_MAX)
+            return EINVAL;
+        auto name = TRY(try_copy_kstring_from_user(static_ptr_cast<char const*>(user_value), user_value_size));
+        auto name_view = name->view();
+        if (auto terminator = name_view.find('\0'); terminator.has_value())
+            name_view = name_view.substring_view(0, terminator.value());
+        auto algorithm = TCPCongestionControl::algorithm_from_name(name_view);
+        if (!algorithm.has_value())
+            return ENOENT;
+        if (algorithm.value() == m_congestion_control->algorithm())
+            return {};
+        // NOTE: can_write() looks at the congestion control without holding our lock, so it can't change once we're sending.
+        if (m_state != State::Closed && m_state != State::Listen)
+            return EISCONN;
+        m_congestion_control = TRY(TCPCongestionControl::try_create(algorithm.value(), m_send_mss));
+        return {};
+    }
+    default:
+        return ENOPROTOOPT;
+    }
+}
+
+ErrorOr<void> TCPSocket::getsockopt(OpenFileDescription& description, int level, int option, Userspace<void*> value, Userspace<socklen_t*> value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::getsockopt(description, level, option, value, value_size);
+
+    MutexLocker locker(mutex());
+
+    socklen_t size;
+    TRY(copy_from_user(&size, value_size.unsafe_userspace_ptr()));
+
+    switch (option) {
+    case TCP_CONGESTION: {
+        auto name = m_congestion_control->name();
+        if (size < name.length() + 1)
+            return EINVAL;
+        char buffer[TCP_CA_NAME_MAX] {};
+        VERIFY(name.length() < sizeof(buffer));
+        memcpy(buffer, name.characters_without_null_termination(), name.length());
+        size = name.length() + 1;
+        TRY(copy_to_user(static_ptr_cast<char*>(value), buffer, size));
+        return copy_to_user(value_size, &size);
+    }
+    default:
+        return ENOPROTOOPT;
+    }
+}
 }
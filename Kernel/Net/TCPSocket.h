@@ -13,6 +13,8 @@
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -134,18 +136,36 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    u32 retransmitted_packets() const { return m_retransmitted_packets; }
+
+    TCPCongestionControl const& congestion_control() const { return *m_congestion_control; }
+    u32 send_window_size() const { return m_send_window_size; }
+    Time smoothed_rtt() const { return m_smoothed_rtt; }
+    Time retransmission_timeout() const { return m_retransmission_timeout; }
+    bool is_window_scaling_enabled() const { return m_is_window_scaling_enabled; }
+    bool is_sack_enabled() const { return m_is_sack_enabled; }
+
+    virtual ErrorOr<void> setsockopt(int level, int option, Userspace<void const*>, socklen_t) override;
+    virtual ErrorOr<void> getsockopt(OpenFileDescription&, int level, int option, Userspace<void*>, Userspace<socklen_t*>) override;
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
+    void process_syn_options(TCPPacket const&);
+
+    // Segments that arrive ahead of a gap in the sequence space are held on to until the gap is filled,
+    // and reported to the peer with SACK blocks in the meantime.
+    void queue_out_of_order_segment(IPv4Packet const&, TCPPacket const&, size_t payload_size, Time const& packet_timestamp);
+    size_t deliver_out_of_order_segments();
+    bool has_out_of_order_segments() const { return !m_out_of_order_segments.is_empty(); }
 
     bool should_delay_next_ack() const;
 
-    static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    // NOTE: The tuple table is split into independently locked shards, so that looking up sockets
+    //       for packets coming in on different adapters (and binding new ones) doesn't contend on a single lock.
+    using SocketTable = MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>;
+    static constexpr size_t socket_table_shard_count = 16;
+    static SocketTable& sockets_by_tuple(IPv4SocketTuple const&);
     static RefPtr<TCPSocket> from_tuple(IPv4SocketTuple const& tuple);
 
     static MutexProtected<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& closing_sockets();
@@ -168,10 +188,11 @@ protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
 private:
-    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer);
+    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl>);
     virtual StringView class_name() const override { return "TCPSocket"sv; }
 
     virtual void shut_down_for_writing() override;
+    virtual void protocol_did_consume_receive_buffer() override;
 
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) override;
@@ -182,6 +203,34 @@ private:
     virtual ErrorOr<void> protocol_bind() override;
     virtual ErrorOr<void> protocol_listen(bool did_allocate_port) override;
 
+    struct OutgoingPacket;
+    struct UnackedPackets;
+
+    // RFC 793, 3.1: The data offset field limits the options to 40 bytes, which leaves room for 4 SACK blocks.
+    static constexpr size_t maximum_options_size = 40;
+    static constexpr size_t maximum_sack_blocks = 4;
+    // RFC 7323, 2.3
+    static constexpr u8 maximum_window_scale = 14;
+
+    struct ReceivedOptions {
+        Optional<u16> mss;
+        Optional<u8> window_scale;
+        bool sack_permitted { false };
+        Vector<TCPSACKBlock, maximum_sack_blocks> sack_blocks;
+    };
+    static ReceivedOptions parse_options(TCPPacket const&);
+    void process_syn_options(ReceivedOptions const&);
+    size_t write_options(u16 flags, size_t payload_size, Bytes) const;
+    u8 receive_window_scale_to_offer() const;
+    u32 receive_window() const;
+
+    void process_ack(TCPPacket const&, ReceivedOptions const&, size_t payload_size);
+    void update_retransmission_timeout(Time const& rtt);
+    u32 bytes_in_flight(UnackedPackets const&) const;
+    u32 sendable_bytes(UnackedPackets const&) const;
+    void transmit_lost_packets(UnackedPackets&);
+    void retransmit_packet(OutgoingPacket&, RoutingDecision&);
+
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
@@ -193,39 +242,112 @@ private:
     u32 m_sequence_number { 0 };
     u32 m_ack_number { 0 };
     State m_state { State::Closed };
-    u32 m_packets_in { 0 };
-    u32 m_bytes_in { 0 };
-    u32 m_packets_out { 0 };
-    u32 m_bytes_out { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_packets_in { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_bytes_in { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_packets_out { 0 };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_bytes_out { 0 };
 
     struct OutgoingPacket {
+        // The packet covers the sequence numbers [sequence_number, ack_number).
+        u32 sequence_number { 0 };
         u32 ack_number { 0 };
         LockRefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         LockWeakPtr<NetworkAdapter> adapter;
         int tx_counter { 0 };
+        Time sent_time;
+        // The peer told us it has this packet (RFC 2018).
+        bool is_sacked { false };
+        // We decided this packet was lost, which only happens once per loss recovery (RFC 6675, 4).
+        bool is_lost { false };
+        // We'll send this packet again as soon as the congestion window allows.
+        bool needs_retransmit { false };
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
         size_t size { 0 };
+        // RFC 6675, 4 (SetPipe): The sequence space of the packets that are neither SACKed nor about to be sent again.
+        // This is kept up to date as packets change, so that sending doesn't have to walk the whole list.
+        u32 pipe_size { 0 };
+
+        static u32 pipe_size_of(OutgoingPacket const& packet)
+        {
+            if (packet.is_sacked || packet.needs_retransmit)
+                return 0;
+            return packet.ack_number - packet.sequence_number;
+        }
+
+        void set_packet_state(OutgoingPacket& packet, bool is_sacked, bool needs_retransmit)
+        {
+            pipe_size -= pipe_size_of(packet);
+            packet.is_sacked = is_sacked;
+            packet.needs_retransmit = needs_retransmit;
+            pipe_size += pipe_size_of(packet);
+        }
     };
 
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    // The oldest sequence number that hasn't been acknowledged yet (SND.UNA in RFC 793).
+    u32 m_send_unacknowledged { 0 };
+
+    // RFC 5681, 3.2: This many duplicate acknowledgements are taken as a sign that a segment was lost.
+    static constexpr u32 duplicate_ack_threshold = 3;
     u32 m_duplicate_acks { 0 };
 
+    NonnullOwnPtr<TCPCongestionControl> m_congestion_control;
+    bool m_is_in_loss_recovery { false };
+    // Loss recovery ends once everything up to this sequence number has been acknowledged (RFC 6582).
+    u32 m_recovery_point { 0 };
+
     u32 m_last_ack_number_sent { 0 };
     Time m_last_ack_sent_time;
+    // The right edge of the receive window that we last advertised to the peer.
+    u32 m_last_advertised_window_edge { 0 };
 
     // FIXME: Make this configurable (sysctl)
-    static constexpr u32 maximum_retransmits = 5;
-    Time m_last_retransmit_time;
+    static constexpr u32 maximum_retransmits = 8;
+    Time m_retransmit_timer_start;
     u32 m_retransmit_attempts { 0 };
-
-    // FIXME: Parse window size TCP option from the peer
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_retransmitted_packets { 0 };
+
+    // RFC 6298, Computing TCP's Retransmission Timer
+    // NOTE: Like other common implementations, we use a lower bound of 200ms rather than the suggested 1 second.
+    static constexpr Time minimum_retransmission_timeout = Time::from_milliseconds(200);
+    static constexpr Time maximum_retransmission_timeout = Time::from_seconds(60);
+    static constexpr Time clock_granularity = Time::from_milliseconds(10);
+    bool m_has_rtt_sample { false };
+    Time m_smoothed_rtt;
+    Time m_rtt_variance;
+    Time m_retransmission_timeout { Time::from_seconds(1) };
+
+    // RFC 1122, 4.2.2.6: Without an MSS option, we must assume the peer can only receive 536 bytes per segment.
+    static constexpr u16 default_mss = 536;
+    u16 m_send_mss { default_mss };
+    u16 m_receive_mss { default_mss };
+
+    // RFC 7323, 2. TCP Window Scale Option
+    bool m_is_window_scaling_enabled { false };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
     u32 m_send_window_size { 64 * KiB };
 
+    bool m_is_sack_enabled { false };
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        u32 payload_size { 0 };
+        Time timestamp;
+        NonnullOwnPtr<KBuffer> ipv4_packet;
+    };
+    static constexpr size_t maximum_out_of_order_segments = 256;
+    // NOTE: This is sorted by sequence number.
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    // RFC 2018, 4: The first SACK block must describe the segment we received most recently.
+    u32 m_most_recent_out_of_order_sequence_number { 0 };
+
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
 public:
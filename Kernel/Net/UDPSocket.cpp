@@ -15,32 +15,39 @@
 
 namespace Kernel {
 
+static Singleton<Array<UDPSocket::SocketTable, UDPSocket::socket_table_shard_count>> s_sockets_by_port;
+
 void UDPSocket::for_each(Function<void(UDPSocket const&)> callback)
 {
-    sockets_by_port().for_each_shared([&](auto const& socket) {
-        callback(*socket.value);
-    });
+    for (auto& shard : *s_sockets_by_port) {
+        shard.for_each_shared([&](auto const& socket) {
+            callback(*socket.value);
+        });
+    }
 }
 
 ErrorOr<void> UDPSocket::try_for_each(Function<ErrorOr<void>(UDPSocket const&)> callback)
 {
-    return sockets_by_port().with_shared([&](auto const& sockets) -> ErrorOr<void> {
-        for (auto& socket : sockets)
-            TRY(callback(*socket.value));
-        return {};
-    });
+    for (auto& shard : *s_sockets_by_port) {
+        TRY(shard.with_shared([&](auto const& sockets) -> ErrorOr<void> {
+            for (auto& socket : sockets)
+                TRY(callback(*socket.value));
+            return {};
+        }));
+    }
+    return {};
 }
 
-static Singleton<MutexProtected<HashMap<u16, UDPSocket*>>> s_map;
-
-MutexProtected<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+UDPSocket::SocketTable& UDPSocket::sockets_by_port(u16 port)
 {
-    return *s_map;
+    // NOTE: The shard's HashMap buckets by the same hash, so mix it up a bit to keep the two from correlating.
+    auto shard_index = int_hash(port) % socket_table_shard_count;
+    return (*s_sockets_by_port)[shard_index];
 }
 
 RefPtr<UDPSocket> UDPSocket::from_port(u16 port)
 {
-    return sockets_by_port().with_shared([&](auto const& table) -> RefPtr<UDPSocket> {
+    return sockets_by_port(port).with_shared([&](auto const& table) -> RefPtr<UDPSocket> {
         auto it = table.find(port);
         if (it == table.end())
             return {};
@@ -55,8 +62,10 @@ UDPSocket::UDPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer)
 
 UDPSocket::~UDPSocket()
 {
-    sockets_by_port().with_exclusive([&](auto& table) {
-        table.remove(local_port());
+    sockets_by_port(local_port()).with_exclusive([&](auto& table) {
+        // NOTE: We may have failed to bind to a port that's taken by another socket.
+        if (auto it = table.find(local_port()); it != table.end() && it->value == this)
+            table.remove(it);
     });
 }
 
@@ -119,27 +128,28 @@ ErrorOr<u16> UDPSocket::protocol_allocate_local_port()
     constexpr u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    return sockets_by_port().with_exclusive([&](auto& table) -> ErrorOr<u16> {
-        for (u16 port = first_scan_port;;) {
-            auto it = table.find(port);
-            if (it == table.end()) {
-                set_local_port(port);
-                table.set(port, this);
-                return port;
-            }
-            ++port;
-            if (port > last_ephemeral_port)
-                port = first_ephemeral_port;
-            if (port == first_scan_port)
-                break;
-        }
-        return set_so_error(EADDRINUSE);
-    });
+    for (u16 port = first_scan_port;;) {
+        bool did_claim_port = sockets_by_port(port).with_exclusive([&](auto& table) {
+            if (table.contains(port))
+                return false;
+            set_local_port(port);
+            table.set(port, this);
+            return true;
+        });
+        if (did_claim_port)
+            return port;
+        ++port;
+        if (port > last_ephemeral_port)
+            port = first_ephemeral_port;
+        if (port == first_scan_port)
+            break;
+    }
+    return set_so_error(EADDRINUSE);
 }
 
 ErrorOr<void> UDPSocket::protocol_bind()
 {
-    return sockets_by_port().with_exclusive([&](auto& table) -> ErrorOr<void> {
+    return sockets_by_port(local_port()).with_exclusive([&](auto& table) -> ErrorOr<void> {
         if (table.contains(local_port()))
             return set_so_error(EADDRINUSE);
         table.set(local_port(), this);
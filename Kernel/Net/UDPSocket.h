@@ -21,10 +21,15 @@ public:
     static void for_each(Function<void(UDPSocket const&)>);
     static ErrorOr<void> try_for_each(Function<ErrorOr<void>(UDPSocket const&)>);
 
+    // NOTE: Like TCPSocket's tuple table, the port table is split into independently locked shards,
+    //       so that datagrams coming in on different adapters don't contend on a single lock.
+    using SocketTable = MutexProtected<HashMap<u16, UDPSocket*>>;
+    static constexpr size_t socket_table_shard_count = 16;
+    static SocketTable& sockets_by_port(u16);
+
 private:
     explicit UDPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer);
     virtual StringView class_name() const override { return "UDPSocket"sv; }
-    static MutexProtected<HashMap<u16, UDPSocket*>>& sockets_by_port();
 
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) override;
@@ -166,6 +166,16 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
         event.data.read.start_timestamp = arg5;
         event.data.read.success = !arg6.is_error();
         break;
+    case PERF_EVENT_LOCK_WAIT:
+    case PERF_EVENT_LOCK_HOLD: {
+        auto& lock = type == PERF_EVENT_LOCK_WAIT ? event.data.lock_wait : event.data.lock_hold;
+        lock.lock = arg1;
+        lock.duration_ns = arg2;
+        memset(lock.name, 0, sizeof(lock.name));
+        if (!arg3.is_empty())
+            memcpy(lock.name, arg3.characters_without_null_termination(), min(arg3.length(), sizeof(lock.name) - 1));
+        break;
+    }
     default:
         return EINVAL;
     }
@@ -217,6 +227,8 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
         if (!show_kernel_addresses) {
             if (event.type == PERF_EVENT_KMALLOC || event.type == PERF_EVENT_KFREE)
                 continue;
+            if (event.type == PERF_EVENT_LOCK_WAIT || event.type == PERF_EVENT_LOCK_HOLD)
+                continue;
         }
 
         auto event_object = TRY(array.add_object());
@@ -297,6 +309,18 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
             TRY(event_object.add("start_timestamp"sv, event.data.read.start_timestamp));
             TRY(event_object.add("success"sv, event.data.read.success));
             break;
+        case PERF_EVENT_LOCK_WAIT:
+            TRY(event_object.add("type"sv, "lock_wait"));
+            TRY(event_object.add("lock"sv, static_cast<u64>(event.data.lock_wait.lock)));
+            TRY(event_object.add("name"sv, event.data.lock_wait.name));
+            TRY(event_object.add("duration_ns"sv, event.data.lock_wait.duration_ns));
+            break;
+        case PERF_EVENT_LOCK_HOLD:
+            TRY(event_object.add("type"sv, "lock_hold"));
+            TRY(event_object.add("lock"sv, static_cast<u64>(event.data.lock_hold.lock)));
+            TRY(event_object.add("name"sv, event.data.lock_hold.name));
+            TRY(event_object.add("duration_ns"sv, event.data.lock_hold.duration_ns));
+            break;
         }
         TRY(event_object.add("pid"sv, event.pid));
         TRY(event_object.add("tid"sv, event.tid));
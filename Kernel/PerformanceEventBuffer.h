@@ -76,6 +76,12 @@ struct [[gnu::packed]] ReadPerformanceEvent {
     bool success;
 };
 
+struct [[gnu::packed]] LockPerformanceEvent {
+    FlatPtr lock;
+    u64 duration_ns;
+    char name[32];
+};
+
 struct [[gnu::packed]] PerformanceEvent {
     u32 type { 0 };
     u8 stack_size { 0 };
@@ -96,6 +102,8 @@ struct [[gnu::packed]] PerformanceEvent {
         KFreePerformanceEvent kfree;
         SignpostPerformanceEvent signpost;
         ReadPerformanceEvent read;
+        LockPerformanceEvent lock_wait;
+        LockPerformanceEvent lock_hold;
     } data;
     static constexpr size_t max_stack_frame_count = 64;
     FlatPtr stack[max_stack_frame_count];
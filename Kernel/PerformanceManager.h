@@ -162,6 +162,25 @@ public:
         [[maybe_unused]] auto rc = event_buffer->append(PERF_EVENT_READ, fd, size, {}, &thread, filepath_string_index, start_timestamp, result); // wrong arguments
     }
 
+    // Lock contention is only timed while someone is profiling it, so the locks can check this cheaply
+    // before doing any bookkeeping. A timestamp of 0 means that the event type is disabled.
+    static u64 lock_event_timestamp(u64 event_type)
+    {
+        if ((g_profiling_event_mask & event_type) == 0 || !TimeManagement::is_initialized())
+            return 0;
+        return static_cast<u64>(max<i64>(TimeManagement::the().monotonic_time(TimePrecision::Precise).to_nanoseconds(), 1));
+    }
+
+    static void add_lock_wait_event(Thread& thread, void const* lock, StringView name, u64 wait_start_timestamp)
+    {
+        add_lock_event(thread, PERF_EVENT_LOCK_WAIT, lock, name, wait_start_timestamp);
+    }
+
+    static void add_lock_hold_event(Thread& thread, void const* lock, StringView name, u64 hold_start_timestamp)
+    {
+        add_lock_event(thread, PERF_EVENT_LOCK_HOLD, lock, name, hold_start_timestamp);
+    }
+
     static void timer_tick(RegisterState const& regs)
     {
         static Time last_wakeup;
@@ -179,6 +198,20 @@ public:
         auto lost_samples = delay.to_microseconds() / ideal_interval.to_microseconds();
         PerformanceManager::add_cpu_sample_event(*current_thread, regs, lost_samples);
     }
+
+private:
+    static void add_lock_event(Thread& thread, int type, void const* lock, StringView name, u64 start_timestamp)
+    {
+        if (start_timestamp == 0 || thread.is_profiling_suppressed())
+            return;
+        auto* event_buffer = thread.process().current_perf_events_buffer();
+        if (event_buffer == nullptr)
+            return;
+        auto end_timestamp = lock_event_timestamp(type);
+        if (end_timestamp < start_timestamp)
+            return;
+        [[maybe_unused]] auto rc = event_buffer->append(type, reinterpret_cast<FlatPtr>(lock), end_timestamp - start_timestamp, name, &thread);
+    }
 };
 
 }
@@ -293,6 +293,9 @@ public:
     ErrorOr<FlatPtr> sys$yield();
     ErrorOr<FlatPtr> sys$sync();
     ErrorOr<FlatPtr> sys$beep(int tone);
+    ErrorOr<FlatPtr> sys$epoll_create(int flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<epoll_event const*>);
+    ErrorOr<FlatPtr> sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*>);
     ErrorOr<FlatPtr> sys$create_inode_watcher(u32 flags);
     ErrorOr<FlatPtr> sys$inode_watcher_add_watch(Userspace<Syscall::SC_inode_watcher_add_watch_params const*> user_params);
     ErrorOr<FlatPtr> sys$inode_watcher_remove_watch(int fd, int wd);
@@ -321,6 +324,7 @@ public:
     ErrorOr<FlatPtr> sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count);
     ErrorOr<FlatPtr> sys$write(int fd, Userspace<u8 const*>, size_t);
     ErrorOr<FlatPtr> sys$pwritev(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*>);
+    ErrorOr<FlatPtr> sys$sendfile(int out_fd, int in_fd, Userspace<off_t*>, size_t);
     ErrorOr<FlatPtr> sys$fstat(int fd, Userspace<stat*>);
     ErrorOr<FlatPtr> sys$stat(Userspace<Syscall::SC_stat_params const*>);
     ErrorOr<FlatPtr> sys$annotate_mapping(Userspace<void*>, int flags);
@@ -46,7 +46,14 @@ struct ThreadReadyQueues {
     Array<ThreadReadyQueue, count> queues;
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues, LockRank::None>> g_ready_queues;
+// Every processor owns a set of ready queues so that picking the next thread
+// on one core doesn't contend with the others. Runnable threads are queued on
+// the processor they last ran on, and processors that run out of work steal
+// threads from their peers. Threads only ever move between the sets with the
+// scheduler lock held, and peers are only ever try-locked, so a busy processor
+// is skipped rather than waited for.
+using ProcessorReadyQueues = SpinlockProtected<ThreadReadyQueues, LockRank::None>;
+static Singleton<Array<ProcessorReadyQueues, MAX_CPU_COUNT>> g_ready_queues;
 
 static SpinlockProtected<TotalTimeScheduled, LockRank::None> g_total_time_scheduled {};
 
@@ -64,11 +71,34 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
+static u32 ready_queue_processor_for(Thread const& thread)
+{
+    auto affinity = thread.affinity();
+    auto processor_count = Processor::count();
+
+    // Prefer the processor this thread last ran on, its caches are likely still warm.
+    // Threads that have never run start out on the processor that made them runnable.
+    auto preferred_id = thread.times_scheduled() > 0 ? thread.cpu() : Processor::current_id();
+    if (preferred_id < processor_count && (affinity & (1u << preferred_id)))
+        return preferred_id;
+
+    auto current_id = Processor::current_id();
+    if (affinity & (1u << current_id))
+        return current_id;
+
+    if (processor_count < sizeof(affinity) * 8)
+        affinity &= (1u << processor_count) - 1;
+    VERIFY(affinity != 0);
+    return bit_scan_forward(affinity) - 1;
+}
+
 Thread& Scheduler::pull_next_runnable_thread()
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    auto current_id = Processor::current_id();
+    auto affinity_mask = 1u << current_id;
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
+    auto take_next_runnable_thread = [&](ThreadReadyQueues& ready_queues) -> Thread* {
         auto priority_mask = ready_queues.mask;
         while (priority_mask != 0) {
             auto priority = bit_scan_forward(priority_mask);
@@ -95,19 +125,38 @@ Thread& Scheduler::pull_next_runnable_thread()
                 // switching to it.
                 // FIXME: Figure out a better way maybe?
                 thread.set_active(true);
-                return thread;
+                return &thread;
             }
             priority_mask &= ~(1u << priority);
         }
-        return *Processor::idle_thread();
-    });
+        return nullptr;
+    };
+
+    if (auto* thread = g_ready_queues->at(current_id).with(take_next_runnable_thread))
+        return *thread;
+
+    // We ran out of local work, so try to steal a thread from another processor.
+    // Start with our neighbor so that the processors don't all gang up on the same victim.
+    auto processor_count = Processor::count();
+    for (u32 i = 1; i < processor_count; ++i) {
+        auto victim_id = (current_id + i) % processor_count;
+        Thread* thread = nullptr;
+        g_ready_queues->at(victim_id).try_with([&](auto& ready_queues) { thread = take_next_runnable_thread(ready_queues); });
+        if (thread) {
+            dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole {} from processor {}", current_id, *thread, victim_id);
+            return *thread;
+        }
+    }
+
+    return *Processor::idle_thread();
 }
 
 Thread* Scheduler::peek_next_runnable_thread()
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    auto current_id = Processor::current_id();
+    auto affinity_mask = 1u << current_id;
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
+    auto find_next_runnable_thread = [&](ThreadReadyQueues& ready_queues) -> Thread* {
         auto priority_mask = ready_queues.mask;
         while (priority_mask != 0) {
             auto priority = bit_scan_forward(priority_mask);
@@ -123,12 +172,28 @@ Thread* Scheduler::peek_next_runnable_thread()
             }
             priority_mask &= ~(1u << priority);
         }
-
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
         return nullptr;
-    });
+    };
+
+    if (auto* thread = g_ready_queues->at(current_id).with(find_next_runnable_thread))
+        return thread;
+
+    // Other processors may have queued up more work than they can handle,
+    // in which case we would be stealing it in pull_next_runnable_thread().
+    // This runs on every timer tick, so don't wait for peers that are busy.
+    auto processor_count = Processor::count();
+    for (u32 i = 1; i < processor_count; ++i) {
+        auto victim_id = (current_id + i) % processor_count;
+        Thread* thread = nullptr;
+        g_ready_queues->at(victim_id).try_with([&](auto& ready_queues) { thread = find_next_runnable_thread(ready_queues); });
+        if (thread)
+            return thread;
+    }
+
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread. We just want to see if we have any other thread ready
+    // to be scheduled.
+    return nullptr;
 }
 
 bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
@@ -136,7 +201,10 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
+    // NOTE: The thread can't migrate between ready queues behind our back,
+    //       as that only ever happens with the scheduler lock held.
+    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    return g_ready_queues->at(thread.m_ready_queue_processor).with([&](auto& ready_queues) {
         auto priority = thread.m_runnable_priority;
         if (priority < 0) {
             VERIFY(!thread.m_ready_queue_node.is_in_list());
@@ -162,10 +230,12 @@ void Scheduler::enqueue_runnable_thread(Thread& thread)
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto processor_id = ready_queue_processor_for(thread);
 
-    g_ready_queues->with([&](auto& ready_queues) {
+    g_ready_queues->at(processor_id).with([&](auto& ready_queues) {
         VERIFY(thread.m_runnable_priority < 0);
         thread.m_runnable_priority = (int)priority;
+        thread.m_ready_queue_processor = processor_id;
         VERIFY(!thread.m_ready_queue_node.is_in_list());
         auto& ready_queue = ready_queues.queues[priority];
         bool was_empty = ready_queue.thread_list.is_empty();
@@ -220,6 +290,8 @@ void Scheduler::pick_next()
         dump_thread_list();
     }
 
+    // NOTE: The thread is taken off the ready queues with the scheduler lock held, so nobody can
+    //       stop it, change its affinity or queue it up again before we have switched to it.
     auto& thread_to_schedule = pull_next_runnable_thread();
     if constexpr (SCHEDULER_DEBUG) {
         dbgln("Scheduler[{}]: Switch to {} @ {:p}",
@@ -159,6 +159,25 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
         prp_dma_region = move(buffer);
     }
 
+    // Get the controller attributes
+    {
+        NVMeSubmission sub {};
+        u16 status = 0;
+        sub.op = OP_ADMIN_IDENTIFY;
+        sub.identify.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(prp_dma_buffer->paddr().as_ptr()));
+        sub.identify.cns = NVMe_CNS_ID_CTRL & 0xff;
+        status = submit_admin_command(sub, true);
+        if (status) {
+            dmesgln_pci(*this, "Failed to identify controller command");
+            return EFAULT;
+        }
+        if (void* fault_at; !safe_memcpy(namespace_data_struct.data(), prp_dma_region->vaddr().as_ptr(), NVMe_IDENTIFY_SIZE, fault_at)) {
+            return EFAULT;
+        }
+        m_max_transfer_size = max_transfer_size_from_mdts(namespace_data_struct[MDTS_INDEX]);
+        dbgln_if(NVME_DEBUG, "NVMe: Max transfer size is {}", m_max_transfer_size);
+    }
+
     // Get the active namespace
     {
         NVMeSubmission sub {};
@@ -204,7 +223,13 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
 
             dbgln_if(NVME_DEBUG, "NVMe: Block count is {} and Block size is {}", block_counts, block_size);
 
-            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size)));
+            // Every request has to transfer at least one block, which this controller couldn't do with a single command.
+            if (static_cast<size_t>(block_size) > m_max_transfer_size) {
+                dmesgln_pci(*this, "Ignoring namespace {}, its block size of {} is larger than the max transfer size of {}", nsid, block_size, m_max_transfer_size);
+                continue;
+            }
+
+            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size, m_max_transfer_size)));
             m_device_count++;
             dbgln_if(NVME_DEBUG, "NVMe: Initialized namespace with NSID: {}", nsid);
         }
@@ -212,6 +237,19 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
     return {};
 }
 
+UNMAP_AFTER_INIT size_t NVMeController::max_transfer_size_from_mdts(u8 mdts) const
+{
+    // An MDTS of 0 means there is no limit.
+    if (mdts == 0)
+        return NVMeQueue::max_transfer_size;
+
+    // Otherwise, the limit is 2 ^ MDTS times the controller's minimum memory page size.
+    auto shift = 12u + CAP_MPSMIN(m_controller_regs->cap) + mdts;
+    if (shift >= sizeof(size_t) * 8)
+        return NVMeQueue::max_transfer_size;
+    return min(NVMeQueue::max_transfer_size, static_cast<size_t>(1) << shift);
+}
+
 UNMAP_AFTER_INIT Tuple<u64, u8> NVMeController::get_ns_features(IdentifyNamespace& identify_data_struct)
 {
     auto flbas = identify_data_struct.flbas & FLBA_SIZE_MASK;
@@ -58,6 +58,7 @@ private:
     NVMeController(PCI::DeviceIdentifier const&, u32 hardware_relative_controller_id);
 
     ErrorOr<void> identify_and_init_namespaces();
+    size_t max_transfer_size_from_mdts(u8 mdts) const;
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
     ErrorOr<void> create_admin_queue(Optional<u8> irq);
     ErrorOr<void> create_io_queue(u8 qid, Optional<u8> irq);
@@ -77,6 +78,7 @@ private:
     AK::Time m_ready_timeout;
     u32 m_bar { 0 };
     u8 m_dbl_stride { 0 };
+    size_t m_max_transfer_size { NVMeQueue::max_transfer_size };
     static Atomic<u8> s_controller_id;
 };
 }
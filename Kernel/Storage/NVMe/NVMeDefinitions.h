@@ -55,6 +55,14 @@ static constexpr u32 CAP_TO(u64 cap)
     return (cap & CAP_TO_MASK) >> CAP_TO_SHIFT;
 }
 
+static constexpr u8 CAP_MPSMIN_SHIFT = 48;
+static constexpr u64 CAP_MPSMIN_MASK = 0xfull << CAP_MPSMIN_SHIFT;
+static constexpr u8 CAP_MPSMIN(u64 cap)
+{
+    // The controller's minimum memory page size is 2 ^ (12 + MPSMIN).
+    return (cap & CAP_MPSMIN_MASK) >> CAP_MPSMIN_SHIFT;
+}
+
 // CC – Controller Configuration
 static constexpr u8 CC_EN_BIT = 0x0;
 static constexpr u8 CSTS_RDY_BIT = 0x0;
@@ -98,11 +106,18 @@ static constexpr u16 CQ_STATUS_FIELD(u16 x)
 }
 
 static constexpr u16 IO_QUEUE_SIZE = 64; // TODO:Need to be configurable
+// One entry of the submission queue is always left empty, which leaves this many commands in flight per IO queue.
+static constexpr u16 IO_QUEUE_MAX_COMMANDS = IO_QUEUE_SIZE - 1;
+// The most a single IO command transfers, unless the controller's MDTS (maximum data transfer size) is smaller.
+static constexpr u32 IO_QUEUE_MAX_TRANSFER_PAGES = 4;
+static constexpr u32 NVMe_PRP_LIST_ENTRY_SIZE = sizeof(u64);
 
 // IDENTIFY
 static constexpr u16 NVMe_IDENTIFY_SIZE = 4096;
 static constexpr u8 NVMe_CNS_ID_ACTIVE_NS = 0x2;
 static constexpr u8 NVMe_CNS_ID_NS = 0x0;
+static constexpr u8 NVMe_CNS_ID_CTRL = 0x1;
+static constexpr u8 MDTS_INDEX = 77;
 static constexpr u8 FLBA_SIZE_INDEX = 26;
 static constexpr u8 FLBA_SIZE_MASK = 0xf;
 static constexpr u8 LBA_FORMAT_SUPPORT_INDEX = 128;
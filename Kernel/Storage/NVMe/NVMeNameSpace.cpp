@@ -12,31 +12,33 @@
 
 namespace Kernel {
 
-UNMAP_AFTER_INIT ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> NVMeNameSpace::try_create(NVMeController const& controller, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size)
+UNMAP_AFTER_INIT ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> NVMeNameSpace::try_create(NVMeController const& controller, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size, size_t max_transfer_size)
 {
-    auto device = TRY(DeviceManagement::try_create_device<NVMeNameSpace>(StorageDevice::LUNAddress { controller.controller_id(), nsid, 0 }, controller.hardware_relative_controller_id(), move(queues), storage_size, lba_size, nsid));
+    auto device = TRY(DeviceManagement::try_create_device<NVMeNameSpace>(StorageDevice::LUNAddress { controller.controller_id(), nsid, 0 }, controller.hardware_relative_controller_id(), move(queues), storage_size, lba_size, nsid, max_transfer_size));
     return device;
 }
 
-UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(LUNAddress logical_unit_number_address, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t max_addresable_block, size_t lba_size, u16 nsid)
+UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(LUNAddress logical_unit_number_address, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t max_addresable_block, size_t lba_size, u16 nsid, size_t max_transfer_size)
     : StorageDevice(logical_unit_number_address, hardware_relative_controller_id, lba_size, max_addresable_block)
     , m_nsid(nsid)
+    , m_max_transfer_size(max_transfer_size)
     , m_queues(move(queues))
 {
+    VERIFY(m_max_transfer_size >= lba_size);
 }
 
 void NVMeNameSpace::start_request(AsyncBlockDeviceRequest& request)
 {
-    auto index = Processor::current_id();
-    auto& queue = m_queues.at(index);
-    // TODO: For now we support only IO transfers of size PAGE_SIZE (Going along with the current constraint in the block layer)
-    // Eventually remove this constraint by using the PRP2 field in the submission struct and remove block layer constraint for NVMe driver.
-    VERIFY(request.block_count() <= (PAGE_SIZE / block_size()));
+    VERIFY(request.merged_buffer_size() <= m_max_transfer_size);
 
-    if (request.request_type() == AsyncBlockDeviceRequest::Read) {
-        queue->read(request, m_nsid, request.block_index(), request.block_count());
-    } else {
-        queue->write(request, m_nsid, request.block_index(), request.block_count());
+    // Every processor has its own IO queue, which we prefer to use. If all of its command slots are
+    // in use, any other queue with a free slot will do, and only if there is none we have to wait.
+    auto queue_count = m_queues.size();
+    auto preferred_queue_index = Processor::current_id() % queue_count;
+    for (size_t i = 0; i < queue_count; ++i) {
+        if (m_queues[(preferred_queue_index + i) % queue_count]->try_submit_request(request, m_nsid))
+            return;
     }
+    m_queues[preferred_queue_index]->submit_request_when_possible(request, m_nsid);
 }
 }
@@ -23,15 +23,25 @@ class NVMeNameSpace : public StorageDevice {
     friend class DeviceManagement;
 
 public:
-    static ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> try_create(NVMeController const&, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size);
+    static ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> try_create(NVMeController const&, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size, size_t max_transfer_size);
 
     CommandSet command_set() const override { return CommandSet::NVMe; };
     void start_request(AsyncBlockDeviceRequest& request) override;
 
+protected:
+    // ^Device
+    virtual size_t max_requests_in_flight() const override { return m_queues.size() * IO_QUEUE_MAX_COMMANDS; }
+
+    // ^StorageDevice
+    virtual size_t max_blocks_per_request() const override { return m_max_transfer_size / block_size(); }
+    virtual bool supports_request_merging() const override { return true; }
+
 private:
-    NVMeNameSpace(LUNAddress, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t storage_size, size_t lba_size, u16 nsid);
+    NVMeNameSpace(LUNAddress, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t storage_size, size_t lba_size, u16 nsid, size_t max_transfer_size);
 
     u16 m_nsid;
+    // The controller may not be able to transfer as much as our IO queues can with a single command.
+    size_t m_max_transfer_size;
     Vector<NonnullLockRefPtr<NVMeQueue>> m_queues;
 };
 
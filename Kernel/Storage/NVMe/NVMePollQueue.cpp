@@ -5,40 +5,37 @@
  */
 
 #include <Kernel/Arch/Delay.h>
-#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Storage/NVMe/NVMeDefinitions.h>
 #include <Kernel/Storage/NVMe/NVMePollQueue.h>
 
 namespace Kernel {
-UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
+UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(OwnPtr<Memory::Region> rw_dma_region, OwnPtr<Memory::Region> prp_list_dma_region, RefPtr<Memory::PhysicalPage> prp_list_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
+    : NVMeQueue(move(rw_dma_region), move(prp_list_dma_region), move(prp_list_dma_page), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
 {
 }
 
 void NVMePollQueue::submit_sqe(NVMeSubmission& sub)
 {
     NVMeQueue::submit_sqe(sub);
-    SpinlockLocker lock_cq(m_cq_lock);
-    while (!process_cq()) {
-        microseconds_delay(1);
-    }
-}
-
-void NVMePollQueue::complete_current_request(u16 status)
-{
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    if (status) {
-        current_request->complete(AsyncBlockDeviceRequest::Failure);
+    if (is_admin_queue()) {
+        SpinlockLocker lock_cq(m_cq_lock);
+        while (!process_cq()) {
+            microseconds_delay(1);
+        }
         return;
     }
-    if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-        if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-            current_request->complete(AsyncDeviceRequest::MemoryFault);
-            return;
+
+    // NOTE: Other processors may have submitted to this queue as well, so we keep polling until our own command is done.
+    //       The request itself is completed from the IO work queue, just like it would be with interrupts.
+    auto cid = sub.cmdid;
+    for (;;) {
+        {
+            SpinlockLocker lock_cq(m_cq_lock);
+            process_cq();
+            if (has_seen_completion_of(cid))
+                return;
         }
+        microseconds_delay(1);
     }
-    current_request->complete(AsyncDeviceRequest::Success);
-    return;
 }
 }
@@ -5,30 +5,41 @@
  */
 
 #include <Kernel/Arch/Delay.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/Storage/NVMe/NVMeController.h>
 #include <Kernel/Storage/NVMe/NVMeInterruptQueue.h>
 #include <Kernel/Storage/NVMe/NVMePollQueue.h>
 #include <Kernel/Storage/NVMe/NVMeQueue.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
+
+static constexpr size_t prp_list_entries_per_command = IO_QUEUE_MAX_TRANSFER_PAGES - 1;
+static_assert(IO_QUEUE_MAX_COMMANDS * prp_list_entries_per_command * NVMe_PRP_LIST_ENTRY_SIZE <= PAGE_SIZE);
+
 ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
+    // Note: Every command slot of an IO queue gets its own DMA buffer for reads and writes, and its own PRP list
+    // to describe that buffer to the controller. The buffers don't need to be physically contiguous.
+    OwnPtr<Memory::Region> rw_dma_region;
+    OwnPtr<Memory::Region> prp_list_dma_region;
+    RefPtr<Memory::PhysicalPage> prp_list_dma_page;
+    if (qid != 0) {
+        VERIFY(q_depth == IO_QUEUE_SIZE);
+        rw_dma_region = TRY(MM.allocate_kernel_region(IO_QUEUE_MAX_COMMANDS * max_transfer_size, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow, Memory::Region::Cacheable::No));
+        prp_list_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue PRP lists"sv, Memory::Region::Access::ReadWrite, prp_list_dma_page));
+    }
     if (!irq.has_value()) {
-        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), *rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(prp_list_dma_region), move(prp_list_dma_page), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
         return queue;
     }
-    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), *rw_dma_page, qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), move(prp_list_dma_region), move(prp_list_dma_page), qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
-    : m_current_request(nullptr)
-    , m_rw_dma_region(move(rw_dma_region))
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, OwnPtr<Memory::Region> prp_list_dma_region, RefPtr<Memory::PhysicalPage> prp_list_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
@@ -36,11 +47,35 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
-
+    , m_rw_dma_region(move(rw_dma_region))
+    , m_prp_list_dma_region(move(prp_list_dma_region))
+    , m_prp_list_dma_page(move(prp_list_dma_page))
 {
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
+
+    if (!m_admin_queue) {
+        VERIFY(m_rw_dma_region);
+        VERIFY(m_prp_list_dma_region);
+        // Hand out the lowest command ids first.
+        for (u16 cid = IO_QUEUE_MAX_COMMANDS; cid > 0; --cid)
+            m_free_command_ids.unchecked_append(cid - 1);
+        fill_prp_lists();
+    }
+}
+
+UNMAP_AFTER_INIT void NVMeQueue::fill_prp_lists()
+{
+    // The pages backing each command's DMA buffer never change, so neither do the PRP lists describing them.
+    auto* prp_lists = reinterpret_cast<LittleEndian<u64>*>(m_prp_list_dma_region->vaddr().as_ptr());
+    size_t pages_per_command = max_transfer_size / PAGE_SIZE;
+    for (size_t cid = 0; cid < IO_QUEUE_MAX_COMMANDS; ++cid) {
+        for (size_t i = 1; i < pages_per_command; ++i) {
+            auto page = m_rw_dma_region->physical_page(cid * pages_per_command + i);
+            VERIFY(page);
+            prp_lists[cid * prp_list_entries_per_command + (i - 1)] = page->paddr().get();
+        }
+    }
 }
 
 bool NVMeQueue::cqe_available()
@@ -73,13 +108,8 @@ u32 NVMeQueue::process_cq()
         // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
         //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
         if (m_admin_queue == false) {
-            // As the block layer calls are now sync (as we wait on each requests),
-            // everything is operated on a single request similar to BMIDE driver.
-            // TODO: Remove this constraint eventually.
-            VERIFY(cmdid == m_prev_sq_tail);
-            if (m_current_request) {
-                complete_current_request(status);
-            }
+            VERIFY(cmdid < IO_QUEUE_MAX_COMMANDS);
+            complete_request(cmdid, status);
         }
         update_cqe_head();
     }
@@ -92,9 +122,10 @@ u32 NVMeQueue::process_cq()
 void NVMeQueue::submit_sqe(NVMeSubmission& sub)
 {
     SpinlockLocker lock(m_sq_lock);
-    // For now let's use sq tail as a unique command id.
-    sub.cmdid = m_sq_tail;
-    m_prev_sq_tail = m_sq_tail;
+    // The admin queue only ever has one command in flight, so it simply uses the sq tail as a unique command id.
+    // IO commands already carry the id of the command slot they were submitted with.
+    if (m_admin_queue)
+        sub.cmdid = m_sq_tail;
 
     memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
     {
@@ -133,42 +164,155 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
     return status;
 }
 
-void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+bool NVMeQueue::try_submit_request(AsyncBlockDeviceRequest& request, u16 nsid)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    VERIFY(!m_admin_queue);
+    u16 cid;
+    {
+        SpinlockLocker lock(m_request_lock);
+        if (m_free_command_ids.is_empty())
+            return false;
+        cid = m_free_command_ids.take_last();
+        m_commands[cid].request = request;
+        m_commands[cid].has_seen_completion = false;
+    }
+    submit_request_with_command_id(cid, request, nsid);
+    return true;
+}
 
-    sub.op = OP_NVME_READ;
+void NVMeQueue::submit_request_when_possible(AsyncBlockDeviceRequest& request, u16 nsid)
+{
+    {
+        SpinlockLocker lock(m_request_lock);
+        if (m_free_command_ids.is_empty()) {
+            if (m_backlog.try_append({ request, nsid }).is_error()) {
+                lock.unlock();
+                request.complete_merged(AsyncDeviceRequest::Failure);
+            }
+            return;
+        }
+    }
+    if (!try_submit_request(request, nsid))
+        submit_request_when_possible(request, nsid);
+}
+
+void NVMeQueue::submit_request_with_command_id(u16 cid, AsyncBlockDeviceRequest& request, u16 nsid)
+{
+    VERIFY(request.merged_buffer_size() <= max_transfer_size);
+    auto* dma_buffer = dma_buffer_for(cid);
+
+    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
+        if (auto result = request.read_from_merged_buffers(dma_buffer); result.is_error()) {
+            {
+                SpinlockLocker lock(m_request_lock);
+                m_commands[cid].request.clear();
+            }
+            request.complete_merged(AsyncDeviceRequest::MemoryFault);
+            release_command_id(cid);
+            return;
+        }
+    }
+
+    size_t pages_per_command = max_transfer_size / PAGE_SIZE;
+    size_t page_count = ceil_div(request.merged_buffer_size(), static_cast<size_t>(PAGE_SIZE));
+    auto first_page = m_rw_dma_region->physical_page(cid * pages_per_command);
+
+    NVMeSubmission sub {};
+    sub.op = request.request_type() == AsyncBlockDeviceRequest::Read ? OP_NVME_READ : OP_NVME_WRITE;
+    sub.cmdid = cid;
     sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
+    sub.rw.slba = AK::convert_between_host_and_little_endian(request.block_index());
     // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    sub.rw.length = AK::convert_between_host_and_little_endian((request.merged_block_count() - 1) & 0xFFFF);
+    sub.rw.data_ptr.prp1 = first_page->paddr().get();
+    if (page_count == 2) {
+        sub.rw.data_ptr.prp2 = m_rw_dma_region->physical_page(cid * pages_per_command + 1)->paddr().get();
+    } else if (page_count > 2) {
+        auto prp_list_offset = cid * prp_list_entries_per_command * NVMe_PRP_LIST_ENTRY_SIZE;
+        sub.rw.data_ptr.prp2 = m_prp_list_dma_page->paddr().offset(prp_list_offset).get();
+    }
 
     full_memory_barrier();
     submit_sqe(sub);
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::complete_request(u16 cid, u16 status)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    // NOTE: This is called while processing the completion queue, which may happen in IRQ context.
+    //       Copying the data to the request's buffer might require switching address spaces (or faulting),
+    //       so that's deferred to the IO work queue.
+    m_commands[cid].has_seen_completion = true;
+    auto work_item_creation_result = g_io_work->try_queue([this, cid, status]() {
+        finish_request(cid, status);
+    });
+    if (work_item_creation_result.is_error()) {
+        LockRefPtr<AsyncBlockDeviceRequest> request;
+        {
+            SpinlockLocker lock(m_request_lock);
+            request = move(m_commands[cid].request);
+        }
+        VERIFY(request);
+        release_command_id(cid);
+        request->complete_merged(AsyncDeviceRequest::Failure);
+    }
+}
+
+void NVMeQueue::finish_request(u16 cid, u16 status)
+{
+    LockRefPtr<AsyncBlockDeviceRequest> request;
+    {
+        SpinlockLocker lock(m_request_lock);
+        request = move(m_commands[cid].request);
+    }
+    VERIFY(request);
+
+    if (status) {
+        request->complete_merged(AsyncDeviceRequest::Failure);
+    } else if (request->request_type() == AsyncBlockDeviceRequest::Read) {
+        request->complete_merged(AsyncDeviceRequest::Success, dma_buffer_for(cid));
+    } else {
+        request->complete_merged(AsyncDeviceRequest::Success);
+    }
+    release_command_id(cid);
+}
 
-    if (auto result = m_current_request->read_from_buffer(m_current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), m_current_request->buffer_size()); result.is_error()) {
-        complete_current_request(AsyncDeviceRequest::MemoryFault);
+void NVMeQueue::release_command_id(u16 cid)
+{
+    SpinlockLocker lock(m_request_lock);
+    VERIFY(!m_commands[cid].request);
+    m_free_command_ids.unchecked_append(cid);
+    if (m_backlog.is_empty() || m_backlog_submission_scheduled)
         return;
+
+    m_backlog_submission_scheduled = true;
+    lock.unlock();
+    auto work_item_creation_result = g_io_work->try_queue([queue = NonnullLockRefPtr<NVMeQueue>(*this)]() mutable {
+        queue->submit_requests_from_backlog();
+    });
+    if (work_item_creation_result.is_error()) {
+        // We'll try again with the next completed command.
+        SpinlockLocker lock(m_request_lock);
+        m_backlog_submission_scheduled = false;
     }
-    sub.op = OP_NVME_WRITE;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+}
 
-    full_memory_barrier();
-    submit_sqe(sub);
+void NVMeQueue::submit_requests_from_backlog()
+{
+    for (;;) {
+        Optional<BacklogEntry> entry;
+        {
+            SpinlockLocker lock(m_request_lock);
+            if (m_backlog.is_empty() || m_free_command_ids.is_empty()) {
+                m_backlog_submission_scheduled = false;
+                return;
+            }
+            entry = m_backlog.take_first();
+        }
+        if (!try_submit_request(*entry->request, entry->nsid)) {
+            // Someone else grabbed the slot, so this request has to wait for the next one.
+            submit_request_when_possible(*entry->request, entry->nsid);
+        }
+    }
 }
 
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
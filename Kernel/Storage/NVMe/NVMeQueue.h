@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
@@ -31,39 +32,61 @@ public:
     static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
     bool is_admin_queue() { return m_admin_queue; };
     u16 submit_sync_sqe(NVMeSubmission&);
-    void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
+
+    // Returns false if all command slots of this queue are in use.
+    bool try_submit_request(AsyncBlockDeviceRequest&, u16 nsid);
+    // Submits the request as soon as a command slot of this queue becomes available.
+    void submit_request_when_possible(AsyncBlockDeviceRequest&, u16 nsid);
+
     virtual void submit_sqe(NVMeSubmission&);
     virtual ~NVMeQueue();
 
+    static constexpr size_t max_transfer_size = IO_QUEUE_MAX_TRANSFER_PAGES * PAGE_SIZE;
+
 protected:
     u32 process_cq();
     void update_sq_doorbell()
     {
         m_db_regs->sq_tail = m_sq_tail;
     }
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+    NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, OwnPtr<Memory::Region> prp_list_dma_region, RefPtr<Memory::PhysicalPage> prp_list_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+
+    bool has_seen_completion_of(u16 cid) const { return m_commands[cid].has_seen_completion; }
 
 private:
     bool cqe_available();
     void update_cqe_head();
-    virtual void complete_current_request(u16 status) = 0;
     void update_cq_doorbell()
     {
         m_db_regs->cq_head = m_cq_head;
     }
 
+    void fill_prp_lists();
+    void submit_request_with_command_id(u16 cid, AsyncBlockDeviceRequest&, u16 nsid);
+    void complete_request(u16 cid, u16 status);
+    void finish_request(u16 cid, u16 status);
+    void release_command_id(u16 cid);
+    void submit_requests_from_backlog();
+    u8* dma_buffer_for(u16 cid) { return m_rw_dma_region->vaddr().offset(cid * max_transfer_size).as_ptr(); }
+
+    struct Command {
+        LockRefPtr<AsyncBlockDeviceRequest> request;
+        bool has_seen_completion { false };
+    };
+
+    struct BacklogEntry {
+        NonnullLockRefPtr<AsyncBlockDeviceRequest> request;
+        u16 nsid;
+    };
+
 protected:
     Spinlock<LockRank::Interrupts> m_cq_lock {};
-    LockRefPtr<AsyncBlockDeviceRequest> m_current_request;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
     Spinlock<LockRank::None> m_request_lock {};
 
 private:
     u16 m_qid {};
     u8 m_cq_valid_phase { 1 };
     u16 m_sq_tail {};
-    u16 m_prev_sq_tail {};
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
@@ -75,6 +98,14 @@ private:
     Vector<NonnullRefPtr<Memory::PhysicalPage>> m_sq_dma_page;
     Span<NVMeCompletion> m_cqe_array;
     Memory::TypedMapping<DoorbellRegister volatile> m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage const> m_rw_dma_page;
+
+    // NOTE: The following are only used by IO queues. Every command slot has its own DMA buffer and PRP list.
+    OwnPtr<Memory::Region> m_rw_dma_region;
+    OwnPtr<Memory::Region> m_prp_list_dma_region;
+    RefPtr<Memory::PhysicalPage> m_prp_list_dma_page;
+    Array<Command, IO_QUEUE_MAX_COMMANDS> m_commands;
+    Vector<u16, IO_QUEUE_MAX_COMMANDS> m_free_command_ids;
+    Vector<BacklogEntry> m_backlog;
+    bool m_backlog_submission_scheduled { false };
 };
 }
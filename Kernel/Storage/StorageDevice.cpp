@@ -83,6 +83,94 @@ StringView StorageDevice::command_set_to_string_view() const
     VERIFY_NOT_REACHED();
 }
 
+// A single read() or write() call is split into at most this many requests, which are all queued at once.
+static constexpr size_t max_requests_per_transfer = 16;
+
+size_t StorageDevice::max_blocks_per_request() const
+{
+    // NOTE: Most drivers only use a single page for their DMA buffer, so that's our limit by default.
+    return m_blocks_per_page;
+}
+
+void StorageDevice::will_start_request(AsyncDeviceRequest& request)
+{
+    if (!supports_request_merging())
+        return;
+
+    // Fold queued requests for the blocks that directly follow this one into it, as long as the driver can handle it in one go.
+    // This turns concurrent small reads and writes of adjacent blocks (e.g. from several threads, or readahead) into one command.
+    auto& block_request = static_cast<AsyncBlockDeviceRequest&>(request);
+    auto max_blocks = max_blocks_per_request();
+    bool did_merge = false;
+    do {
+        did_merge = false;
+        for_each_queued_request([&](AsyncDeviceRequest& queued_request) {
+            auto& other_request = static_cast<AsyncBlockDeviceRequest&>(queued_request);
+            if (&other_request == &block_request)
+                return IterationDecision::Continue;
+            if (other_request.request_type() != block_request.request_type() || other_request.block_index() != block_request.merged_end_block_index())
+                return IterationDecision::Continue;
+            if (block_request.merged_block_count() + other_request.block_count() > max_blocks)
+                return IterationDecision::Continue;
+            did_merge = block_request.try_merge(other_request);
+            return IterationDecision::Break;
+        });
+    } while (did_merge);
+}
+
+// Waits for the request to finish, even if we get interrupted in the meantime, as the device may otherwise still
+// be transferring into or out of the buffer once our caller is gone. There's no way to cancel a request yet.
+static AsyncDeviceRequest::RequestResult wait_for_request_to_finish(AsyncDeviceRequest& request, bool& was_interrupted)
+{
+    for (;;) {
+        auto result = request.wait();
+        if (!result.wait_result().was_interrupted())
+            return result.request_result();
+        was_interrupted = true;
+    }
+}
+
+ErrorOr<void> StorageDevice::transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer)
+{
+    auto blocks_per_request = max_blocks_per_request();
+    VERIFY(blocks_per_request > 0);
+    Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>, max_requests_per_transfer> requests;
+    ErrorOr<void> result {};
+
+    // Queue all requests up front, so drivers that can keep multiple commands in flight get to do so.
+    for (size_t block_offset = 0; block_offset < block_count; block_offset += blocks_per_request) {
+        auto blocks_in_request = min(blocks_per_request, block_count - block_offset);
+        auto request_or_error = try_make_request<AsyncBlockDeviceRequest>(request_type, index + block_offset, blocks_in_request, buffer.offset(block_offset * block_size()), blocks_in_request * block_size());
+        if (request_or_error.is_error()) {
+            result = request_or_error.release_error();
+            break;
+        }
+        requests.append(request_or_error.release_value());
+    }
+
+    // NOTE: We always wait for every request we queued, as they refer to the caller's buffer.
+    bool was_interrupted = false;
+    for (auto& request : requests) {
+        auto request_result = wait_for_request_to_finish(*request, was_interrupted);
+        if (result.is_error())
+            continue;
+        switch (request_result) {
+        case AsyncDeviceRequest::Failure:
+        case AsyncDeviceRequest::Cancelled:
+            result = EIO;
+            break;
+        case AsyncDeviceRequest::MemoryFault:
+            result = EFAULT;
+            break;
+        default:
+            break;
+        }
+    }
+    if (was_interrupted && !result.is_error())
+        return EINTR;
+    return result;
+}
+
 ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
 {
     u64 index = offset >> block_size_log();
@@ -90,10 +178,9 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
     size_t whole_blocks = len >> block_size_log();
     size_t remaining = len - (whole_blocks << block_size_log());
 
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
+    auto max_blocks = max_blocks_per_request() * max_requests_per_transfer;
+    if (whole_blocks >= max_blocks) {
+        whole_blocks = max_blocks;
         remaining = 0;
     }
 
@@ -102,21 +189,8 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
 
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
-    if (whole_blocks > 0) {
-        auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size()));
-        auto result = read_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
-    }
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -124,10 +198,11 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
         auto data = TRY(ByteBuffer::create_uninitialized(block_size()));
         auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data.data());
         auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size()));
-        auto result = read_request->wait();
-        if (result.wait_result().was_interrupted())
+        bool was_interrupted = false;
+        auto request_result = wait_for_request_to_finish(*read_request, was_interrupted);
+        if (was_interrupted)
             return EINTR;
-        switch (result.request_result()) {
+        switch (request_result) {
         case AsyncDeviceRequest::Failure:
             return pos;
         case AsyncDeviceRequest::Cancelled:
@@ -156,10 +231,9 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
     size_t whole_blocks = len >> block_size_log();
     size_t remaining = len - (whole_blocks << block_size_log());
 
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
+    auto max_blocks = max_blocks_per_request() * max_requests_per_transfer;
+    if (whole_blocks >= max_blocks) {
+        whole_blocks = max_blocks;
         remaining = 0;
     }
 
@@ -174,21 +248,8 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
 
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::write() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
-    if (whole_blocks > 0) {
-        auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size()));
-        auto result = write_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
-    }
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -199,10 +260,11 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
         auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(partial_write_block->data());
         {
             auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size()));
-            auto result = read_request->wait();
-            if (result.wait_result().was_interrupted())
+            bool was_interrupted = false;
+            auto request_result = wait_for_request_to_finish(*read_request, was_interrupted);
+            if (was_interrupted)
                 return EINTR;
-            switch (result.request_result()) {
+            switch (request_result) {
             case AsyncDeviceRequest::Failure:
                 return pos;
             case AsyncDeviceRequest::Cancelled:
@@ -219,10 +281,11 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
 
         {
             auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index + whole_blocks, 1, data_buffer, block_size()));
-            auto result = write_request->wait();
-            if (result.wait_result().was_interrupted())
+            bool was_interrupted = false;
+            auto request_result = wait_for_request_to_finish(*write_request, was_interrupted);
+            if (was_interrupted)
                 return EINTR;
-            switch (result.request_result()) {
+            switch (request_result) {
             case AsyncDeviceRequest::Failure:
                 return pos;
             case AsyncDeviceRequest::Cancelled:
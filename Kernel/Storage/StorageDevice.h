@@ -88,7 +88,19 @@ protected:
     // ^DiskDevice
     virtual StringView class_name() const override;
 
+    // ^Device
+    virtual void will_start_request(AsyncDeviceRequest&) override;
+
+    // The most blocks a single request to this device may span.
+    virtual size_t max_blocks_per_request() const;
+
+    // Drivers that return true here have to carry out (and complete) the requests that were merged into
+    // the ones they are asked to start, see AsyncBlockDeviceRequest::try_merge().
+    virtual bool supports_request_merging() const { return false; }
+
 private:
+    ErrorOr<void> transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+
     virtual ErrorOr<void> after_inserting() override;
     virtual void will_be_destroyed() override;
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$epoll_create(int flags)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~EPOLL_CLOEXEC)
+        return EINVAL;
+
+    auto event_poll = TRY(EventPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(event_poll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & EPOLL_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<epoll_event const*> user_event)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto epoll_description = TRY(open_file_description(epoll_fd));
+    auto* event_poll = epoll_description->event_poll();
+    if (!event_poll)
+        return EINVAL;
+    auto description = TRY(open_file_description(fd));
+
+    epoll_event event {};
+    if (op != EPOLL_CTL_DEL)
+        TRY(copy_from_user(&event, user_event));
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        TRY(event_poll->add_watch(fd, description, event));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(event_poll->modify_watch(fd, description, event));
+        return 0;
+    case EPOLL_CTL_DEL:
+        TRY(event_poll->remove_watch(fd, description));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.max_events <= 0)
+        return EINVAL;
+
+    auto epoll_description = TRY(open_file_description(params.epoll_fd));
+    auto* event_poll = epoll_description->event_poll();
+    if (!event_poll)
+        return EINVAL;
+
+    Optional<Thread::BlockTimeout> timeout = Thread::BlockTimeout {};
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        if (timeout_time.is_zero())
+            timeout = {};
+        else
+            timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    auto* current_thread = Thread::current();
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    Vector<epoll_event> events;
+    TRY(events.try_resize(min(static_cast<size_t>(params.max_events), OpenFileDescriptions::max_open())));
+
+    auto event_count = TRY(event_poll->wait(events.span(), timeout));
+    if (event_count > 0)
+        TRY(copy_n_to_user(params.events, events.data(), event_count));
+    return event_count;
+}
+
+}
@@ -49,13 +49,7 @@ ErrorOr<FlatPtr> Process::sys$posix_fallocate(int fd, Userspace<off_t const*> us
     VERIFY(description->file().is_inode());
 
     auto& file = static_cast<InodeFile&>(description->file());
-    if (file.inode().size() >= checked_size.value())
-        return 0;
-
-    // Note: truncate essentially calls resize in the inodes implementation
-    //       while resize is not a standard member of an inode, so we just call
-    //       truncate instead
-    TRY(file.inode().truncate(checked_size.value()));
+    TRY(file.inode().fallocate(offset, length));
 
     // FIXME: EINTR: A signal was caught during execution.
     return 0;
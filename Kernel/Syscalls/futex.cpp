@@ -105,9 +105,8 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
 
     switch (cmd) {
     case FUTEX_WAIT:
-    case FUTEX_WAIT_BITSET:
-    case FUTEX_REQUEUE:
-    case FUTEX_CMP_REQUEUE: {
+    case FUTEX_WAIT_BITSET: {
+        // NOTE: The requeue and wake-op commands share this slot with val2, so only the wait commands have a timeout.
         if (params.timeout) {
             auto timeout_time = TRY(copy_time_from_user(params.timeout));
             bool is_absolute = cmd != FUTEX_WAIT;
@@ -224,8 +223,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         auto futex_key2 = TRY(get_futex_key(user_address2, shared));
         auto woken_or_requeued = TRY(futex_queue->wake_n_requeue(
             params.val, [&]() -> ErrorOr<FutexQueue*> {
-                // NOTE: futex_queue's lock is being held while this callback is called
-                // The reason we're doing this in a callback is that we don't want to always
+                // NOTE: The reason we're doing this in a callback is that we don't want to always
                 // create a target queue, only if we actually have anything to move to it!
                 target_futex_queue = TRY(find_futex_queue(futex_key2, true));
                 return target_futex_queue.ptr();
@@ -250,8 +248,10 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         u32 op_arg = _FUTEX_OP_ARG(params.val3);
         auto op = _FUTEX_OP(params.val3);
         if (op & FUTEX_OP_ARG_SHIFT) {
-            op_arg = 1 << op_arg;
-            op &= FUTEX_OP_ARG_SHIFT;
+            if (op_arg >= 32)
+                return EINVAL;
+            op_arg = 1u << op_arg;
+            op &= ~FUTEX_OP_ARG_SHIFT;
         }
         atomic_thread_fence(AK::MemoryOrder::memory_order_release);
         switch (op) {
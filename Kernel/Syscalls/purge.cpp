@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -65,6 +66,8 @@ ErrorOr<FlatPtr> Process::sys$purge(int mode)
             purged_page_count += vmobject->release_all_clean_pages();
         }
     }
+    if (mode & PURGE_ALL_CLEAN_BLOCK_CACHE)
+        purged_page_count += BlockBasedFileSystem::release_all_clean_cache_pages();
     return purged_page_count;
 }
 
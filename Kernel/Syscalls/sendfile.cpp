@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+// NOTE: The offset is passed by pointer because off_t is 64bit,
+// hence it can't be passed by register on 32bit platforms.
+ErrorOr<FlatPtr> Process::sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> user_offset, size_t count)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+    if (count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in_description = TRY(open_file_description(in_fd));
+    if (!in_description->is_readable())
+        return EBADF;
+    if (in_description->is_directory())
+        return EISDIR;
+    auto out_description = TRY(open_file_description(out_fd));
+    if (!out_description->is_writable())
+        return EBADF;
+
+    auto& in_file = in_description->file();
+    off_t base_offset = 0;
+    if (user_offset) {
+        if (!in_file.is_seekable())
+            return ESPIPE;
+        base_offset = TRY(copy_typed_from_user(user_offset));
+        if (base_offset < 0)
+            return EINVAL;
+    } else if (in_file.is_seekable()) {
+        base_offset = in_description->offset();
+    }
+
+    if (out_description->should_append() && out_description->file().is_seekable())
+        TRY(out_description->seek(0, SEEK_END));
+
+    // The sink writes whatever it can without blocking, waiting for the destination happens below.
+    bool sink_was_full = false;
+    File::SpliceSink sink = [&](UserOrKernelBuffer const& data, size_t size) -> ErrorOr<size_t> {
+        auto nwritten_or_error = out_description->write(data, size);
+        if (nwritten_or_error.is_error()) {
+            if (nwritten_or_error.error().code() != EAGAIN)
+                return nwritten_or_error.release_error();
+            sink_was_full = true;
+            return 0;
+        }
+        if (nwritten_or_error.value() < size)
+            sink_was_full = true;
+        return nwritten_or_error.value();
+    };
+
+    size_t total_nsent = 0;
+    auto result = [&]() -> ErrorOr<void> {
+        while (total_nsent < count) {
+            if (!out_description->can_write()) {
+                if (!out_description->is_blocking())
+                    return total_nsent > 0 ? ErrorOr<void> {} : Error::from_errno(EAGAIN);
+                auto unblock_flags = BlockFlags::None;
+                if (Thread::current()->block<Thread::WriteBlocker>({}, *out_description, unblock_flags).was_interrupted())
+                    return total_nsent > 0 ? ErrorOr<void> {} : Error::from_errno(EINTR);
+                continue;
+            }
+
+            if (!in_description->can_read()) {
+                // Like read(), only wait for more data if we haven't moved any yet.
+                if (total_nsent > 0 || !in_description->is_blocking())
+                    return total_nsent > 0 ? ErrorOr<void> {} : Error::from_errno(EAGAIN);
+                auto unblock_flags = BlockFlags::None;
+                if (Thread::current()->block<Thread::ReadBlocker>({}, *in_description, unblock_flags).was_interrupted())
+                    return Error::from_errno(EINTR);
+                if (!has_flag(unblock_flags, BlockFlags::Read))
+                    return Error::from_errno(EAGAIN);
+            }
+
+            sink_was_full = false;
+            auto nsent_or_error = in_file.splice_read(*in_description, base_offset + total_nsent, count - total_nsent, sink);
+            if (nsent_or_error.is_error()) {
+                if (total_nsent > 0)
+                    return {};
+                if (nsent_or_error.error().code() == EPIPE)
+                    Thread::current()->send_signal(SIGPIPE, &Process::current());
+                return nsent_or_error.release_error();
+            }
+            total_nsent += nsent_or_error.value();
+            if (nsent_or_error.value() == 0 && !sink_was_full)
+                return {};
+        }
+        return {};
+    }();
+
+    if (total_nsent > 0) {
+        off_t new_offset = base_offset + total_nsent;
+        if (user_offset)
+            TRY(copy_to_user(user_offset, &new_offset));
+        else if (in_file.is_seekable())
+            TRY(in_description->seek(new_offset, SEEK_SET));
+    }
+
+    if (result.is_error())
+        return result.release_error();
+    return total_nsent;
+}
+
+}
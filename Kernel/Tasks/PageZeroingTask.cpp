@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/PageZeroingTask.h>
+
+namespace Kernel {
+
+static void page_zeroing_task_main(void*)
+{
+    // NOTE: The first thread is created with the default priority, so make sure we all end up at the same one.
+    Thread::current()->set_priority(THREAD_PRIORITY_MIN);
+
+    for (;;) {
+        // NOTE: We run at the lowest priority, so we only get to clear pages while this processor has nothing better to do.
+        if (!MM.zero_free_physical_page())
+            (void)Thread::current()->sleep(Time::from_milliseconds(50));
+    }
+}
+
+// Keeps a pool of pre-zeroed pages around for every processor, so that faulting in anonymous
+// memory doesn't have to clear the new page while the faulting thread waits for it.
+UNMAP_AFTER_INIT void PageZeroingTask::spawn()
+{
+    LockRefPtr<Thread> first_thread;
+    auto process = Process::create_kernel_process(first_thread, KString::must_create("Page Zeroing Task"sv), page_zeroing_task_main, nullptr, 1u << 0);
+    if (!process)
+        return;
+
+    // The pools are per processor, so each one gets a thread of its own that stays on it.
+    for (u32 cpu = 1; cpu < Processor::count(); ++cpu) {
+        auto name = KString::must_create("Page Zeroing Task"sv);
+        (void)process->create_kernel_thread(page_zeroing_task_main, nullptr, THREAD_PRIORITY_MIN, move(name), 1u << cpu, false);
+    }
+}
+
+}
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+namespace Kernel {
+class PageZeroingTask {
+public:
+    static void spawn();
+};
+}
@@ -389,7 +389,7 @@ public:
             Vector<BlockerInfo, 4> taken_blockers;
             taken_blockers.ensure_capacity(move_count);
             for (size_t i = 0; i < move_count; i++)
-                taken_blockers.append(m_blockers.take(i));
+                taken_blockers.unchecked_append(m_blockers[i]);
             m_blockers.remove(0, move_count);
             return taken_blockers;
         }
@@ -403,8 +403,8 @@ public:
                 return;
             }
             m_blockers.ensure_capacity(m_blockers.size() + blockers_to_append.size());
-            for (size_t i = 0; i < blockers_to_append.size(); i++)
-                m_blockers.append(blockers_to_append.take(i));
+            for (auto& info : blockers_to_append)
+                m_blockers.unchecked_append(info);
             blockers_to_append.clear();
         }
 
@@ -1089,6 +1089,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    u32 m_ready_queue_processor { 0 };
 
     friend class WaitQueue;
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/HashMap.h>
+#include <AK/SwissHashTable.h>
+
+// Benchmarks on smaller tables repeat their work until they have performed about as many
+// operations as the bigger ones, so that the results can be compared across sizes.
+static constexpr size_t operations_per_benchmark = 1'000'000;
+
+static size_t repetitions_for(size_t size)
+{
+    return max<size_t>(operations_per_benchmark / size, 1);
+}
+
+// Scatter the keys over the whole 32-bit range, as sequential keys are unrealistically kind to probing.
+static u32 key_for(size_t index)
+{
+    return static_cast<u32>(index) * 2654435761u;
+}
+
+template<typename MapType>
+static void fill(MapType& map, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        map.set(key_for(i), i);
+}
+
+template<typename MapType>
+static void benchmark_insert(size_t size)
+{
+    for (size_t repetition = 0; repetition < repetitions_for(size); ++repetition) {
+        MapType map;
+        fill(map, size);
+        EXPECT_EQ(map.size(), size);
+    }
+}
+
+template<typename MapType>
+static void benchmark_lookup(size_t size)
+{
+    MapType map;
+    fill(map, size);
+
+    // Half of the lookups hit, half of them miss.
+    size_t found = 0;
+    for (size_t repetition = 0; repetition < repetitions_for(size); ++repetition) {
+        for (size_t i = 0; i < size; ++i) {
+            if (map.contains(key_for(i / 2 + (i % 2) * size)))
+                ++found;
+        }
+    }
+    EXPECT_EQ(found, repetitions_for(size) * ((size + 1) / 2));
+}
+
+// This includes filling the table, subtract the matching insert benchmark to get the cost of erasing.
+template<typename MapType>
+static void benchmark_erase(size_t size)
+{
+    for (size_t repetition = 0; repetition < repetitions_for(size); ++repetition) {
+        MapType map;
+        fill(map, size);
+        for (size_t i = 0; i < size; ++i)
+            map.remove(key_for(i));
+        EXPECT(map.is_empty());
+    }
+}
+
+#define HASH_TABLE_BENCHMARKS(name, size)                                         \
+    BENCHMARK_CASE(hash_map_insert_##name)                                        \
+    {                                                                             \
+        benchmark_insert<HashMap<u32, size_t>>(size);                             \
+    }                                                                             \
+    BENCHMARK_CASE(swiss_hash_map_insert_##name)                                  \
+    {                                                                             \
+        benchmark_insert<SwissHashMap<u32, size_t>>(size);                        \
+    }                                                                             \
+    BENCHMARK_CASE(hash_map_lookup_##name)                                        \
+    {                                                                             \
+        benchmark_lookup<HashMap<u32, size_t>>(size);                             \
+    }                                                                             \
+    BENCHMARK_CASE(swiss_hash_map_lookup_##name)                                  \
+    {                                                                             \
+        benchmark_lookup<SwissHashMap<u32, size_t>>(size);                        \
+    }                                                                             \
+    BENCHMARK_CASE(hash_map_erase_##name)                                         \
+    {                                                                             \
+        benchmark_erase<HashMap<u32, size_t>>(size);                              \
+    }                                                                             \
+    BENCHMARK_CASE(swiss_hash_map_erase_##name)                                   \
+    {                                                                             \
+        benchmark_erase<SwissHashMap<u32, size_t>>(size);                         \
+    }
+
+HASH_TABLE_BENCHMARKS(1k, 1'000)
+HASH_TABLE_BENCHMARKS(10k, 10'000)
+HASH_TABLE_BENCHMARKS(100k, 100'000)
+HASH_TABLE_BENCHMARKS(1m, 1'000'000)
+HASH_TABLE_BENCHMARKS(10m, 10'000'000)
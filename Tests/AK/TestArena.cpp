@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/Arena.h>
+#include <AK/DeprecatedString.h>
+#include <AK/HashMap.h>
+#include <AK/SwissHashTable.h>
+#include <AK/Vector.h>
+
+TEST_CASE(allocations_are_aligned_and_distinct)
+{
+    Arena arena;
+    auto* a = arena.allocate(1, 1);
+    auto* b = arena.allocate(8, 8);
+    auto* c = arena.allocate(64, 64);
+    EXPECT(a && b && c);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(b) % 8, 0u);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(c) % 64, 0u);
+    EXPECT(static_cast<u8*>(a) < static_cast<u8*>(b));
+    EXPECT(static_cast<u8*>(b) + 8 <= static_cast<u8*>(c));
+    EXPECT_EQ(arena.bytes_allocated(), 73u);
+}
+
+TEST_CASE(large_allocations_get_their_own_chunk)
+{
+    Arena arena;
+    auto* small = static_cast<u8*>(arena.allocate(16, 16));
+    auto* large = arena.allocate(1 * MiB, 16);
+    EXPECT(large);
+    __builtin_memset(large, 0xaa, 1 * MiB);
+
+    // The current chunk keeps being used after the large allocation.
+    auto* next = static_cast<u8*>(arena.allocate(16, 16));
+    EXPECT_EQ(next, small + 16);
+}
+
+TEST_CASE(last_allocation_is_given_back)
+{
+    Arena arena;
+    auto* a = arena.allocate(32, 8);
+    arena.deallocate(a, 32);
+    EXPECT_EQ(arena.allocate(32, 8), a);
+
+    auto* b = arena.allocate(32, 8);
+    arena.deallocate(a, 32);
+    EXPECT(arena.allocate(32, 8) != a);
+    EXPECT(b != a);
+}
+
+TEST_CASE(clear)
+{
+    Arena arena;
+    for (size_t i = 0; i < 10'000; ++i)
+        EXPECT(arena.allocate(100, 8));
+    EXPECT(arena.bytes_reserved() >= 1'000'000u);
+
+    arena.clear();
+    EXPECT_EQ(arena.bytes_allocated(), 0u);
+    EXPECT_EQ(arena.bytes_reserved(), 0u);
+    EXPECT(arena.allocate(100, 8));
+}
+
+TEST_CASE(make)
+{
+    struct Node {
+        int value;
+        Node* next;
+    };
+
+    Arena arena;
+    Node* head = nullptr;
+    for (int i = 0; i < 1000; ++i)
+        head = arena.make<Node>(i, head);
+
+    int sum = 0;
+    for (auto* node = head; node; node = node->next)
+        sum += node->value;
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+}
+
+TEST_CASE(arena_vector)
+{
+    Arena arena;
+    ArenaVector<int> vector { arena };
+    for (int i = 0; i < 10'000; ++i)
+        vector.append(i);
+    EXPECT_EQ(vector.size(), 10'000u);
+    EXPECT_EQ(vector[1234], 1234);
+    EXPECT(arena.bytes_allocated() >= 10'000 * sizeof(int));
+
+    // Copies and moves keep using the same arena.
+    auto copy = vector;
+    EXPECT_EQ(copy.size(), 10'000u);
+    auto moved = move(copy);
+    moved.shrink_to_fit();
+    moved.append(10'000);
+    EXPECT_EQ(moved.last(), 10'000);
+
+    // Converting to a regular Vector moves the contents onto the heap.
+    Vector<int> heap_vector = vector;
+    EXPECT_EQ(heap_vector.size(), 10'000u);
+    EXPECT_EQ(heap_vector, vector);
+
+    // Going the other way needs the arena to be spelled out.
+    auto bytes_allocated_before_copy = arena.bytes_allocated();
+    ArenaVector<int> arena_copy { heap_vector, arena };
+    EXPECT_EQ(arena_copy, heap_vector);
+    EXPECT(arena.bytes_allocated() >= bytes_allocated_before_copy + 10'000 * sizeof(int));
+}
+
+TEST_CASE(arena_vector_with_inline_capacity)
+{
+    Arena arena;
+    ArenaVector<DeprecatedString, 4> vector { arena };
+    vector.append("one");
+    vector.append("two");
+    EXPECT_EQ(arena.bytes_allocated(), 0u);
+
+    for (int i = 0; i < 100; ++i)
+        vector.append(DeprecatedString::number(i));
+    EXPECT_EQ(vector.size(), 102u);
+    EXPECT_EQ(vector[0], "one");
+    EXPECT_EQ(vector[101], "99");
+    EXPECT(arena.bytes_allocated() > 0u);
+}
+
+TEST_CASE(arena_vector_of_vectors)
+{
+    // A small parse-tree-like structure, where every container lives in the arena.
+    Arena arena;
+    ArenaVector<ArenaVector<int>> rows { arena };
+    for (int i = 0; i < 100; ++i) {
+        ArenaVector<int> row { arena };
+        for (int j = 0; j < i; ++j)
+            row.append(j);
+        rows.append(move(row));
+    }
+
+    size_t total = 0;
+    for (auto& row : rows)
+        total += row.size();
+    EXPECT_EQ(total, 99u * 100 / 2);
+}
+
+TEST_CASE(arena_hash_map)
+{
+    Arena arena;
+    ArenaHashMap<DeprecatedString, int> map { arena };
+    for (int i = 0; i < 1000; ++i)
+        map.set(DeprecatedString::number(i), i);
+    EXPECT_EQ(map.size(), 1000u);
+    EXPECT_EQ(map.get("123"sv), 123);
+
+    for (int i = 0; i < 500; ++i)
+        EXPECT(map.remove(DeprecatedString::number(i)));
+    EXPECT_EQ(map.size(), 500u);
+
+    map.clear();
+    map.set("again", 1);
+    EXPECT_EQ(map.get("again"sv), 1);
+
+    ArenaHashMap<int, int, Traits<int>, Traits<int>, true> ordered_map { arena };
+    for (int i = 0; i < 100; ++i)
+        ordered_map.set(100 - i, i);
+    int expected = 0;
+    for (auto& it : ordered_map)
+        EXPECT_EQ(it.value, expected++);
+}
+
+TEST_CASE(arena_hash_table)
+{
+    Arena arena;
+    ArenaHashTable<int> table { arena };
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT(table.contains(i));
+
+    auto copy = table;
+    EXPECT_EQ(copy.size(), 1000u);
+    table.clear();
+    EXPECT(table.is_empty());
+    table.set(1);
+    EXPECT(table.contains(1));
+}
+
+TEST_CASE(arena_swiss_hash_map)
+{
+    Arena arena;
+    HashMap<int, int, Traits<int>, Traits<int>, false, SwissHashTable, ArenaAllocator> map { arena };
+    for (int i = 0; i < 1000; ++i)
+        map.set(i, i * 2);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(map.get(i), i * 2);
+}
+
+TEST_CASE(pre_sized_arena_hash_tables)
+{
+    Arena arena;
+    ArenaHashTable<int> table { 1000, arena };
+    auto capacity = table.capacity();
+    EXPECT(capacity >= 1000u);
+    for (int i = 0; i < 100; ++i)
+        table.set(i);
+    EXPECT_EQ(table.capacity(), capacity);
+
+    SwissHashTable<int, Traits<int>, false, ArenaAllocator> swiss_table { 1000, arena };
+    capacity = swiss_table.capacity();
+    for (int i = 0; i < 1000; ++i)
+        swiss_table.set(i);
+    EXPECT_EQ(swiss_table.capacity(), capacity);
+    EXPECT(arena.bytes_allocated() > 0u);
+}
+
+TEST_CASE(vector_capacity_overflow_is_an_error)
+{
+    Vector<u64> vector;
+    EXPECT(vector.try_ensure_capacity(NumericLimits<size_t>::max() / 4).is_error());
+    EXPECT(vector.is_empty());
+}
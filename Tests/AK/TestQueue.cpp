@@ -57,3 +57,32 @@ TEST_CASE(order)
 
     EXPECT(strings.is_empty());
 }
+
+TEST_CASE(dequeue_end)
+{
+    Queue<int, 4> ints;
+    for (int i = 0; i < 10; ++i)
+        ints.enqueue(i);
+
+    EXPECT_EQ(ints.dequeue(), 0);
+    EXPECT_EQ(ints.dequeue_end(), 9);
+    EXPECT_EQ(ints.dequeue_end(), 8);
+    EXPECT_EQ(ints.dequeue_end(), 7);
+    EXPECT_EQ(ints.size(), 6u);
+
+    ints.enqueue(10);
+    EXPECT_EQ(ints.tail(), 10);
+    EXPECT_EQ(ints.dequeue(), 1);
+    EXPECT_EQ(ints.dequeue(), 2);
+    EXPECT_EQ(ints.dequeue(), 3);
+    EXPECT_EQ(ints.dequeue_end(), 10);
+    EXPECT_EQ(ints.dequeue_end(), 6);
+    EXPECT_EQ(ints.dequeue(), 4);
+    EXPECT_EQ(ints.dequeue_end(), 5);
+    EXPECT(ints.is_empty());
+
+    ints.enqueue(11);
+    EXPECT_EQ(ints.head(), 11);
+    EXPECT_EQ(ints.dequeue_end(), 11);
+    EXPECT(ints.is_empty());
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/DeprecatedString.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/SwissHashTable.h>
+
+TEST_CASE(construct)
+{
+    using IntTable = SwissHashTable<int>;
+    EXPECT(IntTable().is_empty());
+    EXPECT_EQ(IntTable().size(), 0u);
+    EXPECT(IntTable().begin() == IntTable().end());
+}
+
+TEST_CASE(basic_move)
+{
+    SwissHashTable<int> foo;
+    foo.set(1);
+    EXPECT_EQ(foo.size(), 1u);
+    auto bar = move(foo);
+    EXPECT_EQ(bar.size(), 1u);
+    EXPECT_EQ(foo.size(), 0u);
+    EXPECT(!foo.contains(1));
+    foo = move(bar);
+    EXPECT_EQ(bar.size(), 0u);
+    EXPECT_EQ(foo.size(), 1u);
+    EXPECT(foo.contains(1));
+}
+
+TEST_CASE(copy)
+{
+    SwissHashTable<DeprecatedString> strings;
+    for (int i = 0; i < 100; ++i)
+        strings.set(DeprecatedString::number(i));
+
+    auto copy = strings;
+    EXPECT_EQ(copy.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+        EXPECT(copy.contains(DeprecatedString::number(i)));
+}
+
+TEST_CASE(set_results)
+{
+    SwissHashTable<DeprecatedString, CaseInsensitiveStringTraits> table;
+    EXPECT_EQ(table.set("nickserv"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(table.set("NickServ"), AK::HashSetResult::ReplacedExistingEntry);
+    EXPECT_EQ(table.set("NICKSERV", AK::HashSetExistingEntryBehavior::Keep), AK::HashSetResult::KeptExistingEntry);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(*table.begin(), "NickServ");
+}
+
+TEST_CASE(range_loop)
+{
+    SwissHashTable<int> table;
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+
+    int sum = 0;
+    size_t loop_counter = 0;
+    for (auto value : table) {
+        sum += value;
+        ++loop_counter;
+    }
+    EXPECT_EQ(loop_counter, 1000u);
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+}
+
+TEST_CASE(many_strings)
+{
+    SwissHashTable<DeprecatedString> strings;
+    for (int i = 0; i < 999; ++i)
+        EXPECT_EQ(strings.set(DeprecatedString::number(i)), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.size(), 999u);
+    for (int i = 0; i < 999; ++i)
+        EXPECT_EQ(strings.remove(DeprecatedString::number(i)), true);
+    EXPECT_EQ(strings.is_empty(), true);
+}
+
+TEST_CASE(many_collisions)
+{
+    struct StringCollisionTraits : public GenericTraits<DeprecatedString> {
+        static unsigned hash(DeprecatedString const&) { return 0; }
+    };
+
+    SwissHashTable<DeprecatedString, StringCollisionTraits> strings;
+    for (int i = 0; i < 999; ++i)
+        EXPECT_EQ(strings.set(DeprecatedString::number(i)), AK::HashSetResult::InsertedNewEntry);
+
+    EXPECT_EQ(strings.set("foo"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.size(), 1000u);
+
+    for (int i = 0; i < 999; ++i)
+        EXPECT_EQ(strings.remove(DeprecatedString::number(i)), true);
+
+    EXPECT(strings.find("foo") != strings.end());
+}
+
+TEST_CASE(tombstones_are_reused)
+{
+    SwissHashTable<int> table;
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+    auto capacity = table.capacity();
+
+    // Keep the table at the same size while churning through keys, so every removal leaves a
+    // tombstone that either gets reused or cleaned up without growing the table.
+    for (int i = 1000; i < 100'000; ++i) {
+        EXPECT_EQ(table.set(i), AK::HashSetResult::InsertedNewEntry);
+        EXPECT_EQ(table.remove(i - 1000), true);
+    }
+
+    EXPECT_EQ(table.size(), 1000u);
+    EXPECT_EQ(table.capacity(), capacity);
+    for (int i = 99'000; i < 100'000; ++i)
+        EXPECT(table.contains(i));
+    EXPECT(!table.contains(98'999));
+}
+
+TEST_CASE(capacity_leak)
+{
+    SwissHashTable<int> table;
+    for (size_t i = 0; i < 10000; ++i) {
+        table.set(i);
+        table.remove(i);
+    }
+    EXPECT(table.capacity() < 100u);
+}
+
+TEST_CASE(ensure_capacity)
+{
+    SwissHashTable<int> table;
+    table.ensure_capacity(1000);
+    auto capacity = table.capacity();
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+    EXPECT_EQ(table.capacity(), capacity);
+}
+
+TEST_CASE(non_trivial_type_table)
+{
+    SwissHashTable<NonnullOwnPtr<int>> table;
+
+    table.set(make<int>(3));
+    table.set(make<int>(11));
+
+    for (int i = 0; i < 1'000; ++i)
+        table.set(make<int>(-i));
+    for (int i = 0; i < 10'000; ++i) {
+        table.set(make<int>(i));
+        table.remove(make<int>(i));
+    }
+
+    EXPECT_EQ(table.remove_all_matching([&](auto&) { return true; }), true);
+    EXPECT(table.is_empty());
+    EXPECT_EQ(table.remove_all_matching([&](auto&) { return true; }), false);
+}
+
+TEST_CASE(remove_all_matching)
+{
+    SwissHashTable<int> table;
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+
+    EXPECT_EQ(table.remove_all_matching([](int value) { return value % 2 == 0; }), true);
+    EXPECT_EQ(table.size(), 500u);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(table.contains(i), i % 2 == 1);
+}
+
+TEST_CASE(clear_with_capacity)
+{
+    SwissHashTable<DeprecatedString> table;
+    table.clear_with_capacity();
+    for (int i = 0; i < 100; ++i)
+        table.set(DeprecatedString::number(i));
+    auto capacity = table.capacity();
+
+    table.clear_with_capacity();
+    EXPECT(table.is_empty());
+    EXPECT_EQ(table.capacity(), capacity);
+    EXPECT(!table.contains("1"));
+    table.set("1");
+    EXPECT(table.contains("1"));
+}
+
+TEST_CASE(iterator_removal)
+{
+    SwissHashTable<int> table;
+    table.set(0);
+    table.set(1);
+
+    auto it = table.begin();
+    table.remove(it);
+    EXPECT_EQ(it, table.end());
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST_CASE(matches_hash_table)
+{
+    // Drive both tables through the same mix of insertions and removals, with keys that only
+    // differ in their upper bits, which the table has to mix into its probing.
+    HashTable<u32> reference;
+    SwissHashTable<u32> table;
+    u32 state = 1;
+    for (size_t i = 0; i < 100'000; ++i) {
+        state = state * 1103515245 + 12345;
+        auto key = (state >> 16) << 20;
+        if (state & 0x100) {
+            EXPECT_EQ(table.set(key), reference.set(key));
+        } else {
+            EXPECT_EQ(table.remove(key), reference.remove(key));
+        }
+    }
+
+    EXPECT_EQ(table.size(), reference.size());
+    for (auto key : reference)
+        EXPECT(table.contains(key));
+    for (auto key : table)
+        EXPECT(reference.contains(key));
+}
+
+TEST_CASE(swiss_hash_map)
+{
+    SwissHashMap<DeprecatedString, int> map;
+    for (int i = 0; i < 1000; ++i)
+        map.set(DeprecatedString::number(i), i);
+
+    EXPECT_EQ(map.size(), 1000u);
+    EXPECT_EQ(map.get("123"sv), 123);
+    EXPECT(!map.get("1000"sv).has_value());
+    EXPECT_EQ(map.ensure("1000", [] { return 1000; }), 1000);
+    EXPECT_EQ(map.take("1000"), 1000);
+    EXPECT_EQ(map.remove("0"), true);
+    EXPECT_EQ(map.remove("0"), false);
+    EXPECT_EQ(map.size(), 999u);
+
+    EXPECT_EQ(map.remove_all_matching([](auto&, int value) { return value >= 500; }), true);
+    EXPECT_EQ(map.size(), 499u);
+
+    int sum = 0;
+    for (auto& it : map)
+        sum += it.value;
+    EXPECT_EQ(sum, 499 * 500 / 2);
+}
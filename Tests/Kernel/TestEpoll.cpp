@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct EpollWithPipe {
+    EpollWithPipe()
+    {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        VERIFY(epoll_fd >= 0);
+        VERIFY(pipe(pipe_fds) == 0);
+    }
+
+    ~EpollWithPipe()
+    {
+        close(epoll_fd);
+        if (pipe_fds[0] >= 0)
+            close(pipe_fds[0]);
+        if (pipe_fds[1] >= 0)
+            close(pipe_fds[1]);
+    }
+
+    int add(int fd, u32 events, u64 data)
+    {
+        epoll_event event {};
+        event.events = events;
+        event.data.u64 = data;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    int modify(int fd, u32 events, u64 data)
+    {
+        epoll_event event {};
+        event.events = events;
+        event.data.u64 = data;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    int poll_once()
+    {
+        last_event = {};
+        return epoll_wait(epoll_fd, &last_event, 1, 0);
+    }
+
+    void write_byte()
+    {
+        char c = 'x';
+        VERIFY(write(pipe_fds[1], &c, 1) == 1);
+    }
+
+    void read_byte()
+    {
+        char c;
+        VERIFY(read(pipe_fds[0], &c, 1) == 1);
+    }
+
+    int read_fd() const { return pipe_fds[0]; }
+    int write_fd() const { return pipe_fds[1]; }
+
+    int epoll_fd { -1 };
+    int pipe_fds[2] { -1, -1 };
+    epoll_event last_event {};
+};
+
+TEST_CASE(level_triggered_readiness)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 1), 0);
+    EXPECT_EQ(test.poll_once(), 0);
+
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.events, EPOLLIN);
+    EXPECT_EQ(test.last_event.data.u64, 1u);
+
+    // The pipe is still readable, so we keep hearing about it.
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.events, EPOLLIN);
+
+    test.read_byte();
+    EXPECT_EQ(test.poll_once(), 0);
+}
+
+TEST_CASE(edge_triggered_readiness)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN | EPOLLET, 2), 0);
+    EXPECT_EQ(test.poll_once(), 0);
+
+    test.write_byte();
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.events, EPOLLIN);
+    EXPECT_EQ(test.last_event.data.u64, 2u);
+
+    // Nothing changed since, so there is nothing to report, even though there is still data to read.
+    EXPECT_EQ(test.poll_once(), 0);
+    test.read_byte();
+    EXPECT_EQ(test.poll_once(), 0);
+
+    // New data is a new edge.
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.events, EPOLLIN);
+}
+
+TEST_CASE(one_shot_until_modified)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN | EPOLLONESHOT, 3), 0);
+
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 0);
+
+    // Modifying the watch arms it again.
+    EXPECT_EQ(test.modify(test.read_fd(), EPOLLIN | EPOLLONESHOT, 4), 0);
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.data.u64, 4u);
+}
+
+TEST_CASE(modify_and_delete)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 5), 0);
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 5), -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.data.u64, 5u);
+
+    // The read end of a pipe never becomes writable, so this watch no longer has anything to report.
+    EXPECT_EQ(test.modify(test.read_fd(), EPOLLOUT, 6), 0);
+    EXPECT_EQ(test.poll_once(), 0);
+
+    EXPECT_EQ(test.modify(test.read_fd(), EPOLLIN, 7), 0);
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.data.u64, 7u);
+
+    EXPECT_EQ(epoll_ctl(test.epoll_fd, EPOLL_CTL_DEL, test.read_fd(), nullptr), 0);
+    EXPECT_EQ(test.poll_once(), 0);
+
+    EXPECT_EQ(epoll_ctl(test.epoll_fd, EPOLL_CTL_DEL, test.read_fd(), nullptr), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(test.modify(test.read_fd(), EPOLLIN, 8), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    // A deleted watch can be added again.
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 9), 0);
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.data.u64, 9u);
+}
+
+TEST_CASE(closing_a_registered_fd)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 10), 0);
+    test.write_byte();
+
+    // Closing the last reference to the description drops the watch.
+    close(test.pipe_fds[0]);
+    test.pipe_fds[0] = -1;
+    EXPECT_EQ(test.poll_once(), 0);
+    EXPECT_EQ(test.poll_once(), 0);
+}
+
+TEST_CASE(closing_a_registered_fd_with_the_description_still_open)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 11), 0);
+
+    // The watch belongs to the description, so it outlives the fd as long as a duplicate keeps the description open.
+    int duplicate_fd = dup(test.read_fd());
+    EXPECT(duplicate_fd >= 0);
+    close(test.pipe_fds[0]);
+    test.pipe_fds[0] = duplicate_fd;
+
+    test.write_byte();
+    EXPECT_EQ(test.poll_once(), 1);
+    EXPECT_EQ(test.last_event.data.u64, 11u);
+}
+
+TEST_CASE(wait_is_woken_by_a_writer)
+{
+    EpollWithPipe test;
+    EXPECT_EQ(test.add(test.read_fd(), EPOLLIN, 12), 0);
+
+    int child_pid = fork();
+    EXPECT(child_pid >= 0);
+    if (child_pid == 0) {
+        usleep(100'000);
+        test.write_byte();
+        _exit(EXIT_SUCCESS);
+    }
+
+    epoll_event event {};
+    EXPECT_EQ(epoll_wait(test.epoll_fd, &event, 1, 5000), 1);
+    EXPECT_EQ(event.events, EPOLLIN);
+    EXPECT_EQ(event.data.u64, 12u);
+    EXPECT_EQ(waitpid(child_pid, nullptr, 0), child_pid);
+}
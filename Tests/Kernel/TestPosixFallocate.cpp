@@ -4,8 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ByteBuffer.h>
 #include <LibCore/System.h>
 #include <LibTest/TestCase.h>
+#include <string.h>
+#include <unistd.h>
 
 TEST_CASE(posix_fallocate_basics)
 {
@@ -53,6 +56,42 @@ TEST_CASE(posix_fallocate_basics)
     MUST(Core::System::close(fd));
 }
 
+TEST_CASE(posix_fallocate_allocated_space)
+{
+    char pattern[] = "/tmp/posix_fallocate.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    VERIFY(fd >= 0);
+    MUST(Core::System::unlink({ pattern, strlen(pattern) }));
+
+    constexpr size_t file_size = 256 * KiB;
+    MUST(Core::System::posix_fallocate(fd, 0, file_size));
+
+    auto stat = MUST(Core::System::fstat(fd));
+    EXPECT_EQ(static_cast<size_t>(stat.st_size), file_size);
+    EXPECT(static_cast<size_t>(stat.st_blocks) * 512 >= file_size);
+
+    // Allocated but never written space reads back as zeroes, also around a partial write.
+    EXPECT_EQ(pwrite(fd, "well hello friends", 18, 5000), 18);
+    auto buffer = MUST(ByteBuffer::create_uninitialized(file_size));
+    EXPECT_EQ(pread(fd, buffer.data(), file_size, 0), static_cast<ssize_t>(file_size));
+    size_t non_zero_bytes = 0;
+    for (size_t i = 0; i < file_size; ++i) {
+        if ((i < 5000 || i >= 5018) && buffer[i] != 0)
+            ++non_zero_bytes;
+    }
+    EXPECT_EQ(non_zero_bytes, 0u);
+    EXPECT_EQ(StringView(buffer.bytes().slice(5000, 18)), "well hello friends"sv);
+
+    // Allocating a range inside the file neither shrinks it nor touches its contents.
+    MUST(Core::System::posix_fallocate(fd, 4096, 4096));
+    stat = MUST(Core::System::fstat(fd));
+    EXPECT_EQ(static_cast<size_t>(stat.st_size), file_size);
+    EXPECT_EQ(pread(fd, buffer.data(), 18, 5000), 18);
+    EXPECT_EQ(StringView(buffer.bytes().slice(0, 18)), "well hello friends"sv);
+
+    MUST(Core::System::close(fd));
+}
+
 TEST_CASE(posix_fallocate_on_device_file)
 {
     auto fd = MUST(Core::System::open("/dev/zero"sv, O_RDWR));
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Spawns increasing numbers of threads that alternate between a short burst
+// of work and sched_yield(), and reports how many of those rounds per second
+// the whole system managed to run. On a scheduler that scales, the rate should
+// keep growing with the thread count until every processor is busy.
+
+struct WorkerContext {
+    int rounds { 0 };
+    int work_per_round { 0 };
+    Atomic<bool>* start_flag { nullptr };
+    u64 checksum { 0 };
+};
+
+static void* worker(void* arg)
+{
+    auto& context = *static_cast<WorkerContext*>(arg);
+    while (!context.start_flag->load())
+        sched_yield();
+
+    u64 value = 0x9e3779b97f4a7c15;
+    for (int round = 0; round < context.rounds; ++round) {
+        for (int i = 0; i < context.work_per_round; ++i) {
+            value ^= value << 13;
+            value ^= value >> 7;
+            value ^= value << 17;
+        }
+        sched_yield();
+    }
+    context.checksum = value;
+    return nullptr;
+}
+
+static double elapsed_seconds(timespec const& start, timespec const& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1'000'000'000.0;
+}
+
+static bool run_pass(int thread_count, int rounds, int work_per_round)
+{
+    Atomic<bool> start_flag { false };
+    Vector<WorkerContext> contexts;
+    contexts.resize(thread_count);
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+
+    for (int i = 0; i < thread_count; ++i) {
+        contexts[i].rounds = rounds;
+        contexts[i].work_per_round = work_per_round;
+        contexts[i].start_flag = &start_flag;
+        if (auto rc = pthread_create(&threads[i], nullptr, worker, &contexts[i]); rc != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+            return false;
+        }
+    }
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    start_flag.store(true);
+
+    for (int i = 0; i < thread_count; ++i)
+        pthread_join(threads[i], nullptr);
+
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto seconds = elapsed_seconds(start, end);
+    auto total_rounds = static_cast<double>(thread_count) * rounds;
+    printf("%4d threads: %8.3f s, %12.0f rounds/s\n", thread_count, seconds, seconds > 0 ? total_rounds / seconds : 0.0);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    int max_threads = 64;
+    int rounds = 2000;
+    int work_per_round = 10000;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(max_threads, "Maximum number of threads to run (doubled each pass, starting at 1)", "threads", 't', "count");
+    args_parser.add_option(rounds, "Number of work/yield rounds per thread", "rounds", 'r', "count");
+    args_parser.add_option(work_per_round, "Amount of work done between yields", "work", 'w', "count");
+    args_parser.parse(arguments);
+
+    if (max_threads < 1 || rounds < 1 || work_per_round < 0) {
+        warnln("Invalid arguments");
+        return EXIT_FAILURE;
+    }
+
+    for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        if (!run_pass(thread_count, rounds, work_per_round))
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Pushes a stream of data through a TCP connection over the loopback adapter, once for every
+// congestion control algorithm and packet loss rate, and reports the throughput each of them
+// achieved. The loopback adapter drops packets on purpose according to
+// /sys/kernel/variables/loopback_packet_loss_permille, so anything but 0 loss needs root.
+
+static constexpr char const* packet_loss_variable = "/sys/kernel/variables/loopback_packet_loss_permille";
+
+static bool set_packet_loss(size_t permille)
+{
+    FILE* file = fopen(packet_loss_variable, "w");
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+    fprintf(file, "%zu", permille);
+    if (fclose(file) != 0) {
+        perror("fclose");
+        return false;
+    }
+    return true;
+}
+
+struct ReceiverContext {
+    int listen_fd { -1 };
+    size_t bytes_received { 0 };
+};
+
+static void* receiver(void* arg)
+{
+    auto& context = *static_cast<ReceiverContext*>(arg);
+    int fd = accept(context.listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+        perror("accept");
+        return nullptr;
+    }
+
+    Vector<u8> buffer;
+    buffer.resize(64 * KiB);
+    for (;;) {
+        auto nread = read(fd, buffer.data(), buffer.size());
+        if (nread < 0) {
+            perror("read");
+            break;
+        }
+        if (nread == 0)
+            break;
+        context.bytes_received += nread;
+    }
+    close(fd);
+    return nullptr;
+}
+
+static double elapsed_seconds(timespec const& start, timespec const& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1'000'000'000.0;
+}
+
+static bool set_congestion_control(int fd, char const* algorithm)
+{
+    if (setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, algorithm, strlen(algorithm)) < 0) {
+        perror("setsockopt(TCP_CONGESTION)");
+        return false;
+    }
+    return true;
+}
+
+static bool run_pass(char const* algorithm, size_t loss_permille, size_t total_bytes)
+{
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return false;
+    }
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_size = sizeof(address);
+    if (!set_congestion_control(listen_fd, algorithm)
+        || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listen_fd, 1) < 0
+        || getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &address_size) < 0) {
+        perror("listen");
+        close(listen_fd);
+        return false;
+    }
+
+    ReceiverContext context { listen_fd, 0 };
+    pthread_t receiver_thread;
+    if (auto rc = pthread_create(&receiver_thread, nullptr, receiver, &context); rc != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+        close(listen_fd);
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || !set_congestion_control(fd, algorithm) || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        perror("connect");
+        close(listen_fd);
+        return false;
+    }
+
+    Vector<u8> buffer;
+    buffer.resize(64 * KiB);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = i & 0xff;
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    size_t bytes_sent = 0;
+    while (bytes_sent < total_bytes) {
+        auto nwritten = write(fd, buffer.data(), min(buffer.size(), total_bytes - bytes_sent));
+        if (nwritten < 0) {
+            perror("write");
+            break;
+        }
+        bytes_sent += nwritten;
+    }
+    close(fd);
+    pthread_join(receiver_thread, nullptr);
+
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    close(listen_fd);
+
+    auto seconds = elapsed_seconds(start, end);
+    auto mebibytes = static_cast<double>(context.bytes_received) / MiB;
+    printf("%-8s %5.1f%% loss: %8.3f s, %10.2f MiB/s%s\n", algorithm, loss_permille / 10.0, seconds,
+        seconds > 0 ? mebibytes / seconds : 0.0, context.bytes_received == total_bytes ? "" : " (incomplete!)");
+    return context.bytes_received == total_bytes;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    size_t size_in_mebibytes = 64;
+    Vector<size_t> loss_rates;
+    StringView algorithm;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(size_in_mebibytes, "Amount of data to send per pass", "size", 's', "MiB");
+    args_parser.add_option(loss_rates, "Comma-separated packet loss rates to test, in packets per thousand (default: 0,5,20)", "loss", 'l', "permille");
+    args_parser.add_option(algorithm, "Only test this congestion control algorithm", "algorithm", 'a', "name");
+    args_parser.parse(arguments);
+
+    if (size_in_mebibytes == 0) {
+        warnln("Invalid arguments");
+        return EXIT_FAILURE;
+    }
+    if (loss_rates.is_empty())
+        loss_rates = { 0, 5, 20 };
+
+    Vector<char const*> algorithms;
+    if (algorithm.is_empty())
+        algorithms = { "newreno", "cubic" };
+    else
+        algorithms.append(algorithm.characters_without_null_termination());
+
+    bool success = true;
+    bool did_change_packet_loss = false;
+    for (auto loss_permille : loss_rates) {
+        // NOTE: Running without any loss doesn't need root, as long as nobody else changed it.
+        if (loss_permille > 1000 || (!set_packet_loss(loss_permille) && loss_permille != 0)) {
+            success = false;
+            break;
+        }
+        did_change_packet_loss |= loss_permille != 0;
+        for (auto* name : algorithms) {
+            if (!run_pass(name, loss_permille, size_in_mebibytes * MiB))
+                success = false;
+        }
+    }
+
+    if (did_change_packet_loss)
+        (void)set_packet_loss(0);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
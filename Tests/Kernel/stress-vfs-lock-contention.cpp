@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Hammers a few filesystem and VFS paths that only hold their locks for a short while from several
+// threads at once, and reports how many operations per second all of them together got through.
+// With --compare, every workload runs once with and once without adaptive spinning in Kernel::Mutex,
+// which is toggled through /sys/kernel/variables/mutex_adaptive_spinning and needs root.
+
+static constexpr char const* adaptive_spinning_variable = "/sys/kernel/variables/mutex_adaptive_spinning";
+
+static bool set_adaptive_spinning(bool enabled)
+{
+    FILE* file = fopen(adaptive_spinning_variable, "w");
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+    fprintf(file, "%d", enabled ? 1 : 0);
+    if (fclose(file) != 0) {
+        perror("fclose");
+        return false;
+    }
+    return true;
+}
+
+struct Workload {
+    char const* name;
+    bool (*run_once)(int fd, char const* path);
+};
+
+static bool stat_path(int, char const* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static bool fstat_fd(int fd, char const*)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0;
+}
+
+static bool pread_byte(int fd, char const*)
+{
+    char byte;
+    return pread(fd, &byte, 1, 0) == 1;
+}
+
+static bool lseek_fd(int fd, char const*)
+{
+    return lseek(fd, 0, SEEK_SET) == 0;
+}
+
+static bool open_and_close_path(int, char const* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    return close(fd) == 0;
+}
+
+static Workload const s_workloads[] = {
+    { "stat", stat_path },
+    { "fstat", fstat_fd },
+    { "pread", pread_byte },
+    { "lseek", lseek_fd },
+    { "open-close", open_and_close_path },
+};
+
+struct WorkerContext {
+    Workload const* workload { nullptr };
+    int fd { -1 };
+    char const* path { nullptr };
+    size_t iterations { 0 };
+    Atomic<bool>* start { nullptr };
+    bool failed { false };
+};
+
+static void* worker(void* arg)
+{
+    auto& context = *static_cast<WorkerContext*>(arg);
+    while (!context.start->load(AK::memory_order_acquire))
+        sched_yield();
+    for (size_t i = 0; i < context.iterations; ++i) {
+        if (!context.workload->run_once(context.fd, context.path)) {
+            perror(context.workload->name);
+            context.failed = true;
+            break;
+        }
+    }
+    return nullptr;
+}
+
+static double elapsed_seconds(timespec const& start, timespec const& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1'000'000'000.0;
+}
+
+static bool run_pass(Workload const& workload, int fd, char const* path, size_t thread_count, size_t iterations, char const* label)
+{
+    Atomic<bool> start { false };
+    Vector<WorkerContext> contexts;
+    contexts.resize(thread_count);
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        contexts[i] = { &workload, fd, path, iterations, &start, false };
+        if (auto rc = pthread_create(&threads[i], nullptr, worker, &contexts[i]); rc != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+            start.store(true, AK::memory_order_release);
+            for (size_t j = 0; j < i; ++j)
+                pthread_join(threads[j], nullptr);
+            return false;
+        }
+    }
+
+    timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    start.store(true, AK::memory_order_release);
+    for (auto thread : threads)
+        pthread_join(thread, nullptr);
+    timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    bool success = true;
+    for (auto& context : contexts)
+        success &= !context.failed;
+
+    auto seconds = elapsed_seconds(start_time, end_time);
+    auto operations = static_cast<double>(thread_count * iterations);
+    printf("%-10s %3zu threads%s: %8.3f s, %12.0f ops/s\n", workload.name, thread_count, label, seconds,
+        seconds > 0 ? operations / seconds : 0.0);
+    return success;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    size_t iterations = 20000;
+    Vector<size_t> thread_counts;
+    StringView workload_name;
+    bool compare = false;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(iterations, "Operations per thread and pass", "iterations", 'n', "count");
+    args_parser.add_option(thread_counts, "Comma-separated thread counts to test (default: 1,2,4,8)", "threads", 't', "counts");
+    args_parser.add_option(workload_name, "Only run this workload (stat, fstat, pread, lseek or open-close)", "workload", 'w', "name");
+    args_parser.add_option(compare, "Run every pass with and without adaptive mutex spinning (needs root)", "compare", 'c');
+    args_parser.parse(arguments);
+
+    if (iterations == 0) {
+        warnln("Invalid arguments");
+        return EXIT_FAILURE;
+    }
+    if (thread_counts.is_empty())
+        thread_counts = { 1, 2, 4, 8 };
+
+    char path[] = "/tmp/stress-vfs-lock-contention.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    if (write(fd, "x", 1) != 1) {
+        perror("write");
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+
+    bool success = true;
+    bool did_run_workload = false;
+    for (auto const& workload : s_workloads) {
+        if (!workload_name.is_empty() && workload_name != workload.name)
+            continue;
+        did_run_workload = true;
+        for (auto thread_count : thread_counts) {
+            if (thread_count == 0)
+                continue;
+            if (!compare) {
+                success &= run_pass(workload, fd, path, thread_count, iterations, "");
+                continue;
+            }
+            if (!set_adaptive_spinning(true) || !run_pass(workload, fd, path, thread_count, iterations, " (spinning)")
+                || !set_adaptive_spinning(false) || !run_pass(workload, fd, path, thread_count, iterations, " (blocking)")) {
+                success = false;
+            }
+        }
+    }
+
+    if (compare)
+        (void)set_adaptive_spinning(true);
+
+    close(fd);
+    unlink(path);
+
+    if (!did_run_workload) {
+        warnln("Unknown workload '{}'", workload_name);
+        return EXIT_FAILURE;
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
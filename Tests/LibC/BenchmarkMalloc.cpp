@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/Array.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+static constexpr size_t iterations_per_thread = 200000;
+static constexpr size_t live_allocations_per_thread = 64;
+static constexpr Array<size_t, 6> allocation_sizes { 8, 24, 48, 100, 250, 600 };
+
+static void* allocate_and_free(void*)
+{
+    Array<void*, live_allocations_per_thread> allocations {};
+    for (size_t i = 0; i < iterations_per_thread; ++i) {
+        auto& slot = allocations[i % live_allocations_per_thread];
+        free(slot);
+        slot = malloc(allocation_sizes[i % allocation_sizes.size()]);
+        VERIFY(slot);
+    }
+    for (auto* allocation : allocations)
+        free(allocation);
+    return nullptr;
+}
+
+static void run_on_threads(size_t thread_count)
+{
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, allocate_and_free, nullptr), 0);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+}
+
+BENCHMARK_CASE(malloc_free_1_thread)
+{
+    run_on_threads(1);
+}
+
+BENCHMARK_CASE(malloc_free_2_threads)
+{
+    run_on_threads(2);
+}
+
+BENCHMARK_CASE(malloc_free_4_threads)
+{
+    run_on_threads(4);
+}
+
+BENCHMARK_CASE(malloc_free_8_threads)
+{
+    run_on_threads(8);
+}
+
+struct ProducerConsumerState {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    Vector<void*> queue;
+    bool done { false };
+};
+
+static void* consume(void* argument)
+{
+    auto& state = *static_cast<ProducerConsumerState*>(argument);
+    pthread_mutex_lock(&state.mutex);
+    while (true) {
+        while (state.queue.is_empty() && !state.done)
+            pthread_cond_wait(&state.cond, &state.mutex);
+        if (state.queue.is_empty())
+            break;
+        auto batch = move(state.queue);
+        pthread_mutex_unlock(&state.mutex);
+        for (auto* allocation : batch)
+            free(allocation);
+        pthread_mutex_lock(&state.mutex);
+    }
+    pthread_mutex_unlock(&state.mutex);
+    return nullptr;
+}
+
+// Memory allocated on one thread and freed on another has to find its way back to the shared pool.
+BENCHMARK_CASE(malloc_on_one_thread_free_on_another)
+{
+    ProducerConsumerState state;
+    pthread_t consumer;
+    EXPECT_EQ(pthread_create(&consumer, nullptr, consume, &state), 0);
+
+    for (size_t i = 0; i < iterations_per_thread; ++i) {
+        auto* allocation = malloc(allocation_sizes[i % allocation_sizes.size()]);
+        VERIFY(allocation);
+        pthread_mutex_lock(&state.mutex);
+        state.queue.append(allocation);
+        if (state.queue.size() >= live_allocations_per_thread)
+            pthread_cond_signal(&state.cond);
+        pthread_mutex_unlock(&state.mutex);
+    }
+
+    pthread_mutex_lock(&state.mutex);
+    state.done = true;
+    pthread_cond_signal(&state.cond);
+    pthread_mutex_unlock(&state.mutex);
+    EXPECT_EQ(pthread_join(consumer, nullptr), 0);
+}
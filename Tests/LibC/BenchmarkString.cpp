@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/Vector.h>
+#include <string.h>
+
+// Each benchmark runs once with LibC's implementation, and once with a plain byte-at-a-time loop for comparison.
+
+static constexpr size_t run_count = 2000;
+static constexpr size_t short_string_length = 23;
+static constexpr size_t long_string_length = 64 * KiB;
+
+static Vector<char> make_string(size_t length)
+{
+    Vector<char> string;
+    string.resize(length + 1);
+    for (size_t i = 0; i < length; ++i)
+        string[i] = 'a' + (i % 26);
+    string[length] = '\0';
+    return string;
+}
+
+static size_t scalar_strlen(char const* str)
+{
+    size_t length = 0;
+    while (str[length])
+        ++length;
+    return length;
+}
+
+static char const* scalar_strchr(char const* str, char ch)
+{
+    for (;; ++str) {
+        if (*str == ch)
+            return str;
+        if (!*str)
+            return nullptr;
+    }
+}
+
+static void const* scalar_memchr(void const* ptr, char ch, size_t size)
+{
+    auto const* bytes = static_cast<char const*>(ptr);
+    for (size_t i = 0; i < size; ++i) {
+        if (bytes[i] == ch)
+            return bytes + i;
+    }
+    return nullptr;
+}
+
+static int scalar_memcmp(void const* v1, void const* v2, size_t n)
+{
+    auto const* s1 = static_cast<u8 const*>(v1);
+    auto const* s2 = static_cast<u8 const*>(v2);
+    for (size_t i = 0; i < n; ++i) {
+        if (s1[i] != s2[i])
+            return s1[i] < s2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BENCHMARK_CASE(strlen_short)
+{
+    auto string = make_string(short_string_length);
+    for (size_t i = 0; i < run_count * 100; ++i)
+        EXPECT_EQ(strlen(string.data()), short_string_length);
+}
+
+BENCHMARK_CASE(strlen_short_scalar)
+{
+    auto string = make_string(short_string_length);
+    for (size_t i = 0; i < run_count * 100; ++i)
+        EXPECT_EQ(scalar_strlen(string.data()), short_string_length);
+}
+
+BENCHMARK_CASE(strlen_long)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(strlen(string.data()), long_string_length);
+}
+
+BENCHMARK_CASE(strlen_long_scalar)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(scalar_strlen(string.data()), long_string_length);
+}
+
+BENCHMARK_CASE(strnlen_long)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(strnlen(string.data(), long_string_length / 2), long_string_length / 2);
+}
+
+BENCHMARK_CASE(strchr_long)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(strchr(string.data(), '!'), nullptr);
+}
+
+BENCHMARK_CASE(strchr_long_scalar)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(scalar_strchr(string.data(), '!'), nullptr);
+}
+
+BENCHMARK_CASE(memchr_long)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(memchr(string.data(), '\0', long_string_length + 1), string.data() + long_string_length);
+}
+
+BENCHMARK_CASE(memchr_long_scalar)
+{
+    auto string = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(scalar_memchr(string.data(), '\0', long_string_length + 1), string.data() + long_string_length);
+}
+
+BENCHMARK_CASE(memcmp_long)
+{
+    auto first = make_string(long_string_length);
+    auto second = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(memcmp(first.data(), second.data(), long_string_length), 0);
+}
+
+BENCHMARK_CASE(memcmp_long_scalar)
+{
+    auto first = make_string(long_string_length);
+    auto second = make_string(long_string_length);
+    for (size_t i = 0; i < run_count; ++i)
+        EXPECT_EQ(scalar_memcmp(first.data(), second.data(), long_string_length), 0);
+}
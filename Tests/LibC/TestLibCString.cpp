@@ -8,6 +8,8 @@
 #include <LibTest/TestCase.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 TEST_CASE(strerror_r_basic)
 {
@@ -29,3 +31,49 @@ TEST_CASE(strtok_r_delimiters_only)
     // The string to which `saved_str` initially points to shouldn't be modified.
     EXPECT_EQ(strcmp(dummy, "a;"), 0);
 }
+
+TEST_CASE(string_functions_at_end_of_mapping)
+{
+    // The vectorized implementations read whole aligned chunks, so make sure that they neither
+    // fault on, nor get confused by, strings and buffers that end right in front of an unmapped page.
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    auto* mapping = static_cast<char*>(mmap(nullptr, page_size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    EXPECT_NE(mapping, MAP_FAILED);
+    EXPECT_EQ(mprotect(mapping + page_size, page_size, PROT_NONE), 0);
+    char* page_end = mapping + page_size;
+
+    for (size_t length = 0; length < 100; ++length) {
+        char* string = page_end - length - 1;
+        memset(string, 'x', length);
+        string[length] = '\0';
+        EXPECT_EQ(strlen(string), length);
+        EXPECT_EQ(strnlen(string, length + 10), length);
+        EXPECT_EQ(strnlen(string, length / 2), length / 2);
+        EXPECT_EQ(strchr(string, 'y'), nullptr);
+        EXPECT_EQ(strchr(string, '\0'), string + length);
+        if (length > 0) {
+            string[length - 1] = 'y';
+            EXPECT_EQ(strchr(string, 'y'), string + length - 1);
+        }
+
+        char* buffer = page_end - length;
+        memset(buffer, 'x', length);
+        EXPECT_EQ(memchr(buffer, 'y', length), nullptr);
+        if (length > 0) {
+            buffer[length / 2] = 'y';
+            EXPECT_EQ(memchr(buffer, 'y', length), buffer + length / 2);
+            EXPECT_EQ(memchr(buffer, 'y', length / 2), nullptr);
+        }
+
+        char* other = mapping + (length % 32);
+        memcpy(other, buffer, length);
+        EXPECT_EQ(memcmp(buffer, other, length), 0);
+        if (length > 0) {
+            other[length - 1] = 'z';
+            EXPECT(memcmp(buffer, other, length) < 0);
+            EXPECT(memcmp(other, buffer, length) > 0);
+        }
+    }
+
+    EXPECT_EQ(munmap(mapping, page_size * 2), 0);
+}
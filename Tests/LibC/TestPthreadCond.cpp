@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <serenity.h>
+
+static constexpr size_t waiter_count = 8;
+
+struct SharedState {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    size_t waiting { 0 };
+    size_t woken { 0 };
+    bool go { false };
+};
+
+static void* waiter(void* argument)
+{
+    auto& state = *static_cast<SharedState*>(argument);
+    pthread_mutex_lock(&state.mutex);
+    state.waiting++;
+    while (!state.go)
+        pthread_cond_wait(&state.cond, &state.mutex);
+    state.woken++;
+    pthread_mutex_unlock(&state.mutex);
+    return nullptr;
+}
+
+TEST_CASE(cond_broadcast_wakes_all_waiters)
+{
+    SharedState state;
+    Array<pthread_t, waiter_count> threads;
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, waiter, &state), 0);
+
+    // Wait until everybody is either asleep on the condition variable or about to be.
+    while (true) {
+        pthread_mutex_lock(&state.mutex);
+        bool all_waiting = state.waiting == waiter_count;
+        if (all_waiting) {
+            state.go = true;
+            pthread_cond_broadcast(&state.cond);
+        }
+        pthread_mutex_unlock(&state.mutex);
+        if (all_waiting)
+            break;
+        sched_yield();
+    }
+
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(state.woken, waiter_count);
+}
+
+struct RoundsState {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    size_t round { 0 };
+    size_t arrived { 0 };
+};
+
+static constexpr size_t round_count = 2000;
+
+static void* round_waiter(void* argument)
+{
+    auto& state = *static_cast<RoundsState*>(argument);
+    for (size_t round = 1; round <= round_count; ++round) {
+        pthread_mutex_lock(&state.mutex);
+        state.arrived++;
+        while (state.round < round)
+            pthread_cond_wait(&state.cond, &state.mutex);
+        pthread_mutex_unlock(&state.mutex);
+    }
+    return nullptr;
+}
+
+TEST_CASE(cond_broadcast_outside_mutex_under_contention)
+{
+    // Broadcasting without holding the mutex races the broadcast's requeue against waiters
+    // coming and going. A waiter that got lost on the way would hang this test.
+    RoundsState state;
+    Array<pthread_t, waiter_count> threads;
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, round_waiter, &state), 0);
+
+    for (size_t round = 1; round <= round_count; ++round) {
+        while (true) {
+            pthread_mutex_lock(&state.mutex);
+            bool all_arrived = state.arrived == round * waiter_count;
+            if (all_arrived)
+                state.round = round;
+            pthread_mutex_unlock(&state.mutex);
+            if (all_arrived)
+                break;
+            sched_yield();
+        }
+        pthread_cond_broadcast(&state.cond);
+    }
+
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(state.arrived, round_count * waiter_count);
+}
+
+TEST_CASE(futex_requeue)
+{
+    u32 source = 0;
+    u32 target = 0;
+
+    // With nobody waiting, there is nothing to wake or requeue.
+    EXPECT_EQ(futex_requeue(&source, 1, &target, INT_MAX, false), 0);
+
+    // FUTEX_CMP_REQUEUE refuses to do anything if the value has changed.
+    int rc = futex(&source, FUTEX_CMP_REQUEUE | FUTEX_PRIVATE_FLAG, 1, reinterpret_cast<timespec const*>(INT_MAX), &target, 1);
+    EXPECT_EQ(rc, -1);
+    EXPECT_EQ(errno, EAGAIN);
+}
+
+TEST_CASE(futex_wake_op)
+{
+    u32 first = 0;
+    u32 second = 5;
+
+    // Shift the argument, and only wake waiters on the second futex if it was 5 before.
+    int rc = futex(&first, FUTEX_WAKE_OP | FUTEX_PRIVATE_FLAG, 1, reinterpret_cast<timespec const*>(1), &second, FUTEX_OP(FUTEX_OP_OR | FUTEX_OP_ARG_SHIFT, 4, FUTEX_OP_CMP_EQ, 5));
+    EXPECT_EQ(rc, 0);
+    EXPECT_EQ(second, 5u | (1u << 4));
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <LibThreading/Parallel.h>
+#include <LibThreading/ThreadPool.h>
+
+TEST_CASE(futures_resolve)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    auto answer = Threading::spawn(*pool, [] { return 42; });
+    Atomic<bool> did_run { false };
+    auto nothing = Threading::spawn(*pool, [&] { did_run = true; });
+
+    EXPECT_EQ(answer->await(), 42);
+    nothing->await();
+    EXPECT(did_run.load());
+}
+
+TEST_CASE(task_group_waits_for_all_tasks)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    Atomic<size_t> counter { 0 };
+    {
+        Threading::TaskGroup group(*pool);
+        for (size_t i = 0; i < 1000; ++i)
+            group.spawn([&] { counter.fetch_add(1); });
+        group.wait();
+        EXPECT_EQ(counter.load(), 1000u);
+    }
+}
+
+// Tasks waiting on tasks they spawned themselves must not be able to starve the pool.
+static size_t fibonacci(Threading::ThreadPool& pool, size_t n)
+{
+    if (n < 2)
+        return n;
+    auto first = Threading::spawn(pool, [&pool, n] { return fibonacci(pool, n - 1); });
+    auto second = fibonacci(pool, n - 2);
+    return first->await() + second;
+}
+
+TEST_CASE(nested_tasks)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(2));
+    EXPECT_EQ(fibonacci(*pool, 18), 2584u);
+}
+
+TEST_CASE(parallel_for_each_and_transform)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    Vector<u32> numbers;
+    for (u32 i = 0; i < 100000; ++i)
+        numbers.append(i);
+
+    Threading::parallel_for_each(*pool, numbers.span(), [](u32& number) { number *= 2; });
+    for (u32 i = 0; i < numbers.size(); ++i)
+        EXPECT_EQ(numbers[i], i * 2);
+
+    Vector<u64> squares;
+    squares.resize(numbers.size());
+    Threading::parallel_transform(*pool, numbers.span(), squares.span(), [](u32 number) { return static_cast<u64>(number) * number; });
+    for (u32 i = 0; i < numbers.size(); ++i)
+        EXPECT_EQ(squares[i], static_cast<u64>(i * 2) * (i * 2));
+}
+
+TEST_CASE(parallel_sort)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    Vector<u32> numbers;
+    u32 state = 1;
+    for (size_t i = 0; i < 200000; ++i) {
+        state = state * 1103515245 + 12345;
+        // Plenty of duplicates, to exercise the equal range of the partitioning.
+        numbers.append((state >> 8) % 5000);
+    }
+
+    Threading::parallel_sort(*pool, numbers.span(), [](u32 a, u32 b) { return a < b; });
+    for (size_t i = 1; i < numbers.size(); ++i)
+        EXPECT(numbers[i - 1] <= numbers[i]);
+}
+
+TEST_CASE(parallel_sort_sorted_and_reversed_input)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    Vector<u32> numbers;
+    for (u32 i = 0; i < 100000; ++i)
+        numbers.append(i % 2 ? i : 100000 - i);
+
+    Threading::parallel_sort(*pool, numbers.span(), [](u32 a, u32 b) { return a < b; });
+    for (size_t i = 1; i < numbers.size(); ++i)
+        EXPECT(numbers[i - 1] <= numbers[i]);
+
+    Threading::parallel_sort(*pool, numbers.span(), [](u32 a, u32 b) { return a > b; });
+    for (size_t i = 1; i < numbers.size(); ++i)
+        EXPECT(numbers[i - 1] >= numbers[i]);
+}
+
+TEST_CASE(many_tasks_from_outside_the_pool)
+{
+    auto pool = MUST(Threading::ThreadPool::try_create(4));
+    Atomic<size_t> count { 0 };
+    {
+        Threading::TaskGroup group(*pool);
+        for (size_t i = 0; i < 10000; ++i)
+            group.spawn([&count] { count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed); });
+    }
+    EXPECT_EQ(count.load(), 10000u);
+}
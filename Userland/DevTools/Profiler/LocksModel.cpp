@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "LocksModel.h"
+#include "Profile.h"
+
+namespace Profiler {
+
+LocksModel::LocksModel(Profile& profile)
+    : m_profile(profile)
+{
+}
+
+int LocksModel::row_count(GUI::ModelIndex const&) const
+{
+    return m_profile.lock_statistics().size();
+}
+
+int LocksModel::column_count(GUI::ModelIndex const&) const
+{
+    return Column::__Count;
+}
+
+DeprecatedString LocksModel::column_name(int column) const
+{
+    switch (column) {
+    case Column::Name:
+        return "Lock";
+    case Column::Address:
+        return "Address";
+    case Column::Site:
+        return "Site";
+    case Column::WaitCount:
+        return "Contended waits";
+    case Column::TotalWaitTime:
+        return "Total wait (µs)";
+    case Column::MaxWaitTime:
+        return "Max wait (µs)";
+    case Column::HoldCount:
+        return "Contended holds";
+    case Column::TotalHoldTime:
+        return "Total hold (µs)";
+    case Column::MaxHoldTime:
+        return "Max hold (µs)";
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+GUI::Variant LocksModel::data(GUI::ModelIndex const& index, GUI::ModelRole role) const
+{
+    auto const& statistics = m_profile.lock_statistics()[index.row()];
+
+    if (role == GUI::ModelRole::TextAlignment) {
+        if (index.column() == Column::Name || index.column() == Column::Site)
+            return Gfx::TextAlignment::CenterLeft;
+        return Gfx::TextAlignment::CenterRight;
+    }
+
+    if (role == GUI::ModelRole::Display) {
+        switch (index.column()) {
+        case Column::Name:
+            return statistics.name;
+        case Column::Address:
+            return DeprecatedString::formatted("{:p}", statistics.lock);
+        case Column::Site:
+            return statistics.site;
+        case Column::WaitCount:
+            return statistics.wait_count;
+        case Column::TotalWaitTime:
+            return statistics.total_wait_ns / 1000;
+        case Column::MaxWaitTime:
+            return statistics.max_wait_ns / 1000;
+        case Column::HoldCount:
+            return statistics.hold_count;
+        case Column::TotalHoldTime:
+            return statistics.total_hold_ns / 1000;
+        case Column::MaxHoldTime:
+            return statistics.max_hold_ns / 1000;
+        default:
+            return {};
+        }
+    }
+    return {};
+}
+
+}
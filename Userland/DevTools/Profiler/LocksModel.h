@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <LibGUI/Model.h>
+
+namespace Profiler {
+
+class Profile;
+
+class LocksModel final : public GUI::Model {
+public:
+    static NonnullRefPtr<LocksModel> create(Profile& profile)
+    {
+        return adopt_ref(*new LocksModel(profile));
+    }
+
+    enum Column {
+        Name,
+        Address,
+        Site,
+        WaitCount,
+        TotalWaitTime,
+        MaxWaitTime,
+        HoldCount,
+        TotalHoldTime,
+        MaxHoldTime,
+        __Count
+    };
+
+    virtual ~LocksModel() override = default;
+
+    virtual int row_count(GUI::ModelIndex const& = GUI::ModelIndex()) const override;
+    virtual int column_count(GUI::ModelIndex const& = GUI::ModelIndex()) const override;
+    virtual DeprecatedString column_name(int) const override;
+    virtual GUI::Variant data(GUI::ModelIndex const&, GUI::ModelRole) const override;
+    virtual bool is_column_sortable(int) const override { return false; }
+
+private:
+    explicit LocksModel(Profile&);
+
+    Profile& m_profile;
+};
+
+}
@@ -9,6 +9,8 @@
 #include "ProfileModel.h"
 #include "SamplesModel.h"
 #include "SourceModel.h"
+#include <AK/Array.h>
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
 #include <AK/LexicalPath.h>
 #include <AK/QuickSort.h>
@@ -48,6 +50,7 @@ Profile::Profile(Vector<Process> processes, Vector<Event> events)
     m_samples_model = SamplesModel::create(*this);
     m_signposts_model = SignpostsModel::create(*this);
     m_file_event_model = FileEventModel::create(*this);
+    m_locks_model = LocksModel::create(*this);
 
     rebuild_tree();
 }
@@ -67,6 +70,34 @@ GUI::Model& Profile::signposts_model()
     return *m_signposts_model;
 }
 
+GUI::Model& Profile::locks_model()
+{
+    return *m_locks_model;
+}
+
+// The innermost frame that isn't part of the locking machinery itself, i.e. the code that wanted the lock.
+static DeprecatedString lock_site_for(Profile::Event const& event)
+{
+    static constexpr Array locking_symbol_prefixes {
+        "Kernel::Mutex"sv,
+        "Kernel::Spinlock"sv,
+        "Kernel::RecursiveSpinlock"sv,
+        "Kernel::RWSpinlock"sv,
+        "Kernel::spinlock_wait_"sv,
+        "Kernel::PerformanceManager"sv,
+        "Kernel::PerformanceEventBuffer"sv,
+    };
+
+    for (ssize_t i = event.frames.size() - 1; i >= 0; --i) {
+        auto const& symbol = event.frames[i].symbol;
+        if (symbol.is_empty())
+            continue;
+        if (!any_of(locking_symbol_prefixes, [&](auto prefix) { return symbol.starts_with(prefix); }))
+            return symbol;
+    }
+    return "??";
+}
+
 void Profile::rebuild_tree()
 {
     Vector<NonnullRefPtr<ProfileNode>> roots;
@@ -102,6 +133,17 @@ void Profile::rebuild_tree()
     m_filtered_event_indices.clear();
     m_filtered_signpost_indices.clear();
     m_file_event_nodes->children().clear();
+    m_lock_statistics.clear();
+
+    HashMap<FlatPtr, HashMap<DeprecatedString, size_t>> lock_statistics_indices;
+    auto lock_statistics_for = [&](FlatPtr lock, DeprecatedString const& name, Event const& event) -> LockStatistics& {
+        auto site = lock_site_for(event);
+        auto index = lock_statistics_indices.ensure(lock).ensure(site, [&] {
+            m_lock_statistics.append({ .lock = lock, .name = name, .site = site });
+            return m_lock_statistics.size() - 1;
+        });
+        return m_lock_statistics[index];
+    };
 
     for (size_t event_index = 0; event_index < m_events.size(); ++event_index) {
         auto& event = m_events.at(event_index);
@@ -120,6 +162,22 @@ void Profile::rebuild_tree()
             continue;
         }
 
+        if (auto* wait_data = event.data.get_pointer<Event::LockWaitData>()) {
+            auto& statistics = lock_statistics_for(wait_data->lock, wait_data->name, event);
+            ++statistics.wait_count;
+            statistics.total_wait_ns += wait_data->duration_ns;
+            statistics.max_wait_ns = max(statistics.max_wait_ns, wait_data->duration_ns);
+            continue;
+        }
+
+        if (auto* hold_data = event.data.get_pointer<Event::LockHoldData>()) {
+            auto& statistics = lock_statistics_for(hold_data->lock, hold_data->name, event);
+            ++statistics.hold_count;
+            statistics.total_hold_ns += hold_data->duration_ns;
+            statistics.max_hold_ns = max(statistics.max_hold_ns, hold_data->duration_ns);
+            continue;
+        }
+
         m_filtered_event_indices.append(event_index);
 
         if (auto* malloc_data = event.data.get_pointer<Event::MallocData>(); malloc_data && !live_allocations.contains(malloc_data->ptr))
@@ -225,8 +283,14 @@ void Profile::rebuild_tree()
 
     sort_profile_nodes(roots);
 
+    // The locks that kept everybody waiting the longest go first.
+    quick_sort(m_lock_statistics, [](auto& a, auto& b) {
+        return a.total_wait_ns + a.total_hold_ns > b.total_wait_ns + b.total_hold_ns;
+    });
+
     m_roots = move(roots);
     m_model->invalidate();
+    m_locks_model->invalidate();
 }
 
 Optional<MappedObject> g_kernel_debuginfo_object;
@@ -394,6 +458,18 @@ ErrorOr<NonnullOwnPtr<Profile>> Profile::load_from_perfcore_file(StringView path
                 .start_timestamp = perf_event.get_integer<size_t>("start_timestamp"sv).value_or(0),
                 .success = perf_event.get_bool("success"sv).value_or(false)
             };
+        } else if (type_string == "lock_wait"sv) {
+            event.data = Event::LockWaitData {
+                .lock = perf_event.get_addr("lock"sv).value_or(0),
+                .name = perf_event.get_deprecated_string("name"sv).value_or({}),
+                .duration_ns = perf_event.get_u64("duration_ns"sv).value_or(0),
+            };
+        } else if (type_string == "lock_hold"sv) {
+            event.data = Event::LockHoldData {
+                .lock = perf_event.get_addr("lock"sv).value_or(0),
+                .name = perf_event.get_deprecated_string("name"sv).value_or({}),
+                .duration_ns = perf_event.get_u64("duration_ns"sv).value_or(0),
+            };
         } else {
             dbgln("Unknown event type '{}'", type_string);
             VERIFY_NOT_REACHED();
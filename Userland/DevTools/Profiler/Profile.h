@@ -8,6 +8,7 @@
 
 #include "DisassemblyModel.h"
 #include "FilesystemEventModel.h"
+#include "LocksModel.h"
 #include "Process.h"
 #include "Profile.h"
 #include "ProfileModel.h"
@@ -150,6 +151,7 @@ public:
     GUI::Model* disassembly_model();
     GUI::Model* source_model();
     GUI::Model* file_event_model();
+    GUI::Model& locks_model();
 
     Process const* find_process(pid_t pid, EventSerialNumber serial) const
     {
@@ -230,13 +232,41 @@ public:
             bool success;
         };
 
-        Variant<nullptr_t, SampleData, MallocData, FreeData, SignpostData, MmapData, MunmapData, ProcessCreateData, ProcessExecData, ThreadCreateData, ReadData> data { nullptr };
+        struct LockWaitData {
+            FlatPtr lock {};
+            DeprecatedString name;
+            u64 duration_ns {};
+        };
+
+        struct LockHoldData {
+            FlatPtr lock {};
+            DeprecatedString name;
+            u64 duration_ns {};
+        };
+
+        Variant<nullptr_t, SampleData, MallocData, FreeData, SignpostData, MmapData, MunmapData, ProcessCreateData, ProcessExecData, ThreadCreateData, ReadData, LockWaitData, LockHoldData> data { nullptr };
+
+        bool is_lock_event() const { return data.has<LockWaitData>() || data.has<LockHoldData>(); }
+    };
+
+    // Contended waits for and holds of one lock, from the same place in the code.
+    struct LockStatistics {
+        FlatPtr lock { 0 };
+        DeprecatedString name;
+        DeprecatedString site;
+        u32 wait_count { 0 };
+        u64 total_wait_ns { 0 };
+        u64 max_wait_ns { 0 };
+        u32 hold_count { 0 };
+        u64 total_hold_ns { 0 };
+        u64 max_hold_ns { 0 };
     };
 
     Vector<Event> const& events() const { return m_events; }
     Vector<size_t> const& filtered_event_indices() const { return m_filtered_event_indices; }
     Vector<size_t> const& filtered_signpost_indices() const { return m_filtered_signpost_indices; }
     NonnullRefPtr<FileEventNode> const& file_event_nodes() { return m_file_event_nodes; }
+    Vector<LockStatistics> const& lock_statistics() const { return m_lock_statistics; }
 
     u64 length_in_ms() const { return m_last_timestamp - m_first_timestamp; }
     u64 first_timestamp() const { return m_first_timestamp; }
@@ -296,6 +326,7 @@ private:
     RefPtr<DisassemblyModel> m_disassembly_model;
     RefPtr<SourceModel> m_source_model;
     RefPtr<FileEventModel> m_file_event_model;
+    RefPtr<LocksModel> m_locks_model;
 
     GUI::ModelIndex m_disassembly_index;
     GUI::ModelIndex m_source_index;
@@ -317,6 +348,7 @@ private:
     Vector<ProcessFilter> m_process_filters;
 
     NonnullRefPtr<FileEventNode> m_file_event_nodes;
+    Vector<LockStatistics> m_lock_statistics;
 
     bool m_inverted { false };
     bool m_show_top_functions { false };
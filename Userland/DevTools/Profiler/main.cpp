@@ -265,6 +265,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     filesystem_events_tree_view->set_selection_behavior(GUI::TreeView::SelectionBehavior::SelectRows);
     filesystem_events_tree_view->set_model(profile->file_event_model());
 
+    auto locks_tab = TRY(tab_widget->try_add_tab<GUI::Widget>(TRY("Locks"_string)));
+    TRY(locks_tab->try_set_layout<GUI::VerticalBoxLayout>(4));
+
+    auto locks_table_view = TRY(locks_tab->try_add<GUI::TableView>());
+    locks_table_view->set_model(profile->locks_model());
+
     auto file_menu = TRY(window->try_add_menu("&File"));
     TRY(file_menu->try_add_action(GUI::CommonActions::make_quit_action([&](auto&) { app->quit(); })));
 
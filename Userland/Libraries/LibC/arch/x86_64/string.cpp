@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/BuiltinWrappers.h>
+#include <AK/SIMD.h>
+#include <AK/Types.h>
+#include <cpuid.h>
+#include <string.h>
+
+// These all work on naturally aligned vectors wherever they can, as an aligned load can never cross
+// into the next page, and thus never fault even if it reads a few bytes past the end of the string.
+// Any bytes in front of the start of the string are shifted out of the resulting masks.
+
+using namespace AK::SIMD;
+
+namespace {
+
+template<typename T>
+requires(sizeof(T) == 16) ALWAYS_INLINE T load(void const* address)
+{
+    T value;
+    __builtin_memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+template<typename T>
+requires(sizeof(T) == 32) [[gnu::target("avx2")]] ALWAYS_INLINE T load(void const* address)
+{
+    T value;
+    __builtin_memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+template<size_t alignment>
+ALWAYS_INLINE char const* align_down(char const* address)
+{
+    return reinterpret_cast<char const*>(reinterpret_cast<FlatPtr>(address) & ~(alignment - 1));
+}
+
+ALWAYS_INLINE u32 byte_mask(i8x16 comparison)
+{
+    return static_cast<u32>(__builtin_ia32_pmovmskb128((c8x16)comparison));
+}
+
+[[gnu::target("avx2")]] ALWAYS_INLINE u32 byte_mask(i8x32 comparison)
+{
+    return static_cast<u32>(__builtin_ia32_pmovmskb256((c8x32)comparison));
+}
+
+template<typename T>
+requires(sizeof(T) == 16) ALWAYS_INLINE T splat(char c)
+{
+    return T {} + c;
+}
+
+template<typename T>
+requires(sizeof(T) == 32) [[gnu::target("avx2")]] ALWAYS_INLINE T splat(char c)
+{
+    return T {} + c;
+}
+
+ALWAYS_INLINE int compare_bytes(u8 a, u8 b)
+{
+    return a < b ? -1 : 1;
+}
+
+// SSE2 is part of the x86_64 baseline, so these are always available.
+
+size_t strlen_sse2(char const* str)
+{
+    auto const* chunk = align_down<16>(str);
+    u32 mask = byte_mask(load<c8x16>(chunk) == 0) >> (str - chunk);
+    if (mask)
+        return count_trailing_zeroes(mask);
+    for (;;) {
+        chunk += 16;
+        mask = byte_mask(load<c8x16>(chunk) == 0);
+        if (mask)
+            return chunk - str + count_trailing_zeroes(mask);
+    }
+}
+
+size_t strnlen_sse2(char const* str, size_t maxlen)
+{
+    if (maxlen == 0)
+        return 0;
+    auto const* chunk = align_down<16>(str);
+    size_t offset = str - chunk;
+    u32 mask = byte_mask(load<c8x16>(chunk) == 0) >> offset;
+    if (mask)
+        return min<size_t>(count_trailing_zeroes(mask), maxlen);
+    for (size_t length = 16 - offset; length < maxlen; length += 16) {
+        mask = byte_mask(load<c8x16>(str + length) == 0);
+        if (mask)
+            return min<size_t>(length + count_trailing_zeroes(mask), maxlen);
+    }
+    return maxlen;
+}
+
+char* strchr_sse2(char const* str, int c)
+{
+    char ch = c;
+    auto needle = splat<c8x16>(ch);
+    auto const* chunk = align_down<16>(str);
+    auto bytes = load<c8x16>(chunk);
+    u32 mask = byte_mask((bytes == needle) | (bytes == 0)) >> (str - chunk);
+    auto const* match = str;
+    if (!mask) {
+        for (;;) {
+            chunk += 16;
+            bytes = load<c8x16>(chunk);
+            mask = byte_mask((bytes == needle) | (bytes == 0));
+            if (mask)
+                break;
+        }
+        match = chunk;
+    }
+    match += count_trailing_zeroes(mask);
+    return *match == ch ? const_cast<char*>(match) : nullptr;
+}
+
+void* memchr_sse2(void const* ptr, int c, size_t size)
+{
+    if (size == 0)
+        return nullptr;
+    auto const* bytes = static_cast<char const*>(ptr);
+    auto needle = splat<c8x16>(c);
+    auto const* chunk = align_down<16>(bytes);
+    size_t offset = bytes - chunk;
+    u32 mask = byte_mask(load<c8x16>(chunk) == needle) >> offset;
+    size_t length = 0;
+    if (!mask) {
+        for (length = 16 - offset; length < size; length += 16) {
+            mask = byte_mask(load<c8x16>(bytes + length) == needle);
+            if (mask)
+                break;
+        }
+        if (!mask)
+            return nullptr;
+    }
+    length += count_trailing_zeroes(mask);
+    return length < size ? const_cast<char*>(bytes + length) : nullptr;
+}
+
+// memcmp() must not touch anything past the end of either buffer, and can't align both of them
+// at once, so it uses unaligned loads, and a final overlapping load for the tail.
+int memcmp_sse2(void const* v1, void const* v2, size_t n)
+{
+    auto const* s1 = static_cast<u8 const*>(v1);
+    auto const* s2 = static_cast<u8 const*>(v2);
+    if (n < 16) {
+        for (size_t i = 0; i < n; ++i) {
+            if (s1[i] != s2[i])
+                return compare_bytes(s1[i], s2[i]);
+        }
+        return 0;
+    }
+    for (size_t offset = 0; offset < n; offset += 16) {
+        // Compare the last 16 bytes, overlapping with the previous chunk, instead of a partial chunk.
+        if (offset + 16 > n)
+            offset = n - 16;
+        u32 mask = byte_mask(load<u8x16>(s1 + offset) != load<u8x16>(s2 + offset));
+        if (mask) {
+            size_t index = offset + count_trailing_zeroes(mask);
+            return compare_bytes(s1[index], s2[index]);
+        }
+    }
+    return 0;
+}
+
+[[gnu::target("avx2")]] size_t strlen_avx2(char const* str)
+{
+    auto const* chunk = align_down<32>(str);
+    u32 mask = byte_mask(load<c8x32>(chunk) == 0) >> (str - chunk);
+    if (mask)
+        return count_trailing_zeroes(mask);
+    for (;;) {
+        chunk += 32;
+        mask = byte_mask(load<c8x32>(chunk) == 0);
+        if (mask)
+            return chunk - str + count_trailing_zeroes(mask);
+    }
+}
+
+[[gnu::target("avx2")]] size_t strnlen_avx2(char const* str, size_t maxlen)
+{
+    if (maxlen == 0)
+        return 0;
+    auto const* chunk = align_down<32>(str);
+    size_t offset = str - chunk;
+    u32 mask = byte_mask(load<c8x32>(chunk) == 0) >> offset;
+    if (mask)
+        return min<size_t>(count_trailing_zeroes(mask), maxlen);
+    for (size_t length = 32 - offset; length < maxlen; length += 32) {
+        mask = byte_mask(load<c8x32>(str + length) == 0);
+        if (mask)
+            return min<size_t>(length + count_trailing_zeroes(mask), maxlen);
+    }
+    return maxlen;
+}
+
+[[gnu::target("avx2")]] char* strchr_avx2(char const* str, int c)
+{
+    char ch = c;
+    auto needle = splat<c8x32>(ch);
+    auto const* chunk = align_down<32>(str);
+    auto bytes = load<c8x32>(chunk);
+    u32 mask = byte_mask((bytes == needle) | (bytes == 0)) >> (str - chunk);
+    auto const* match = str;
+    if (!mask) {
+        for (;;) {
+            chunk += 32;
+            bytes = load<c8x32>(chunk);
+            mask = byte_mask((bytes == needle) | (bytes == 0));
+            if (mask)
+                break;
+        }
+        match = chunk;
+    }
+    match += count_trailing_zeroes(mask);
+    return *match == ch ? const_cast<char*>(match) : nullptr;
+}
+
+[[gnu::target("avx2")]] void* memchr_avx2(void const* ptr, int c, size_t size)
+{
+    if (size == 0)
+        return nullptr;
+    auto const* bytes = static_cast<char const*>(ptr);
+    auto needle = splat<c8x32>(c);
+    auto const* chunk = align_down<32>(bytes);
+    size_t offset = bytes - chunk;
+    u32 mask = byte_mask(load<c8x32>(chunk) == needle) >> offset;
+    size_t length = 0;
+    if (!mask) {
+        for (length = 32 - offset; length < size; length += 32) {
+            mask = byte_mask(load<c8x32>(bytes + length) == needle);
+            if (mask)
+                break;
+        }
+        if (!mask)
+            return nullptr;
+    }
+    length += count_trailing_zeroes(mask);
+    return length < size ? const_cast<char*>(bytes + length) : nullptr;
+}
+
+[[gnu::target("avx2")]] int memcmp_avx2(void const* v1, void const* v2, size_t n)
+{
+    if (n < 32)
+        return memcmp_sse2(v1, v2, n);
+    auto const* s1 = static_cast<u8 const*>(v1);
+    auto const* s2 = static_cast<u8 const*>(v2);
+    for (size_t offset = 0; offset < n; offset += 32) {
+        if (offset + 32 > n)
+            offset = n - 32;
+        u32 mask = byte_mask(load<u8x32>(s1 + offset) != load<u8x32>(s2 + offset));
+        if (mask) {
+            size_t index = offset + count_trailing_zeroes(mask);
+            return compare_bytes(s1[index], s2[index]);
+        }
+    }
+    return 0;
+}
+
+// Bit 27 of ecx in cpuid[eax = 1] indicates that the OS has enabled XSAVE, and thus XGETBV
+constexpr u32 cpuid_1_ecx_bit_osxsave = 1 << 27;
+constexpr u32 cpuid_1_ecx_bit_avx = 1 << 28;
+// Bit 5 of ebx in cpuid[eax = 7] indicates support for AVX2
+constexpr u32 cpuid_7_ebx_bit_avx2 = 1 << 5;
+// Bits 1 and 2 of XCR0 indicate that the OS saves the SSE and AVX register state on context switches
+constexpr u32 xcr0_sse_and_avx_state = (1 << 1) | (1 << 2);
+
+bool has_usable_avx2()
+{
+    u32 eax, ebx, ecx, edx;
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & cpuid_1_ecx_bit_osxsave) || !(ecx & cpuid_1_ecx_bit_avx))
+        return false;
+
+    u32 xcr0_low, xcr0_high;
+    asm volatile("xgetbv"
+                 : "=a"(xcr0_low), "=d"(xcr0_high)
+                 : "c"(0));
+    if ((xcr0_low & xcr0_sse_and_avx_state) != xcr0_sse_and_avx_state)
+        return false;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & cpuid_7_ebx_bit_avx2;
+}
+
+}
+
+extern "C" {
+
+namespace {
+[[gnu::used]] decltype(&strlen) resolve_strlen()
+{
+    return has_usable_avx2() ? strlen_avx2 : strlen_sse2;
+}
+
+[[gnu::used]] decltype(&strnlen) resolve_strnlen()
+{
+    return has_usable_avx2() ? strnlen_avx2 : strnlen_sse2;
+}
+
+[[gnu::used]] decltype(&strchr) resolve_strchr()
+{
+    return has_usable_avx2() ? strchr_avx2 : strchr_sse2;
+}
+
+[[gnu::used]] decltype(&memchr) resolve_memchr()
+{
+    return has_usable_avx2() ? memchr_avx2 : memchr_sse2;
+}
+
+[[gnu::used]] decltype(&memcmp) resolve_memcmp()
+{
+    return has_usable_avx2() ? memcmp_avx2 : memcmp_sse2;
+}
+}
+
+#if !defined(AK_COMPILER_CLANG) && !defined(_DYNAMIC_LOADER)
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/strlen.html
+[[gnu::ifunc("resolve_strlen")]] size_t strlen(char const*);
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/strnlen.html
+[[gnu::ifunc("resolve_strnlen")]] size_t strnlen(char const*, size_t);
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/strchr.html
+[[gnu::ifunc("resolve_strchr")]] char* strchr(char const*, int);
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/memchr.html
+[[gnu::ifunc("resolve_memchr")]] void* memchr(void const*, int, size_t);
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/memcmp.html
+[[gnu::ifunc("resolve_memcmp")]] int memcmp(void const*, void const*, size_t);
+#else
+// DynamicLoader can't self-relocate IFUNCs. See memset.cpp for why Clang builds can't use them either.
+size_t strlen(char const* str)
+{
+    static decltype(&strlen) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_strlen();
+
+    return s_impl(str);
+}
+
+size_t strnlen(char const* str, size_t maxlen)
+{
+    static decltype(&strnlen) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_strnlen();
+
+    return s_impl(str, maxlen);
+}
+
+char* strchr(char const* str, int c)
+{
+    static decltype(&strchr) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_strchr();
+
+    return s_impl(str, c);
+}
+
+void* memchr(void const* ptr, int c, size_t size)
+{
+    static decltype(&memchr) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memchr();
+
+    return s_impl(ptr, c, size);
+}
+
+int memcmp(void const* v1, void const* v2, size_t n)
+{
+    static decltype(&memcmp) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memcmp();
+
+    return s_impl(v1, v2, n);
+}
+#endif
+}
@@ -115,6 +115,9 @@ struct MallocStats {
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_flushes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -284,6 +287,125 @@ static void* try_allocate_chunk_aligned(size_t align, ChunkedBlock& block)
     return nullptr;
 }
 
+static ErrorOr<void*> allocate_chunk_locked(Allocator& allocator, size_t good_size, size_t align)
+{
+    ChunkedBlock* block = nullptr;
+    void* ptr = nullptr;
+    for (auto& current : allocator.usable_blocks) {
+        if (current.free_chunks()) {
+            ptr = try_allocate_chunk_aligned(align, current);
+            if (ptr) {
+                block = &current;
+                break;
+            }
+        }
+    }
+
+    if (!block && s_hot_empty_block_count) {
+        g_malloc_stats.number_of_hot_empty_block_hits++;
+        block = s_hot_empty_blocks[--s_hot_empty_block_count];
+        if (block->m_size != good_size) {
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+            set_mmap_name(block, ChunkedBlock::block_size, buffer);
+        }
+        allocator.usable_blocks.append(*block);
+    }
+
+    if (!block && s_cold_empty_block_count) {
+        g_malloc_stats.number_of_cold_empty_block_hits++;
+        block = s_cold_empty_blocks[--s_cold_empty_block_count];
+        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
+        bool this_block_was_purged = rc == 1;
+        if (rc < 0) {
+            perror("madvise");
+            VERIFY_NOT_REACHED();
+        }
+        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
+        if (rc < 0) {
+            perror("mprotect");
+            VERIFY_NOT_REACHED();
+        }
+        if (this_block_was_purged || block->m_size != good_size) {
+            if (this_block_was_purged)
+                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+        }
+        allocator.usable_blocks.append(*block);
+    }
+
+    if (!block) {
+        g_malloc_stats.number_of_block_allocs++;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
+        new (block) ChunkedBlock(good_size);
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
+    }
+
+    if (!ptr) {
+        ptr = try_allocate_chunk_aligned(align, *block);
+    }
+
+    VERIFY(ptr);
+    if (block->is_full()) {
+        g_malloc_stats.number_of_blocks_full++;
+        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
+    }
+    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+static void free_chunk_locked(ChunkedBlock& block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block.m_freelist;
+    block.m_freelist = entry;
+
+    if (block.is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block.m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", &block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(block);
+        allocator->usable_blocks.prepend(block);
+    }
+
+    ++block.m_free_chunks;
+
+    if (!block.used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block.m_size, good_size);
+        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", &block);
+            g_malloc_stats.number_of_hot_keeps++;
+            allocator->usable_blocks.remove(block);
+            s_hot_empty_blocks[s_hot_empty_block_count++] = &block;
+            return;
+        }
+        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", &block);
+            g_malloc_stats.number_of_cold_keeps++;
+            allocator->usable_blocks.remove(block);
+            s_cold_empty_blocks[s_cold_empty_block_count++] = &block;
+            mprotect(&block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(&block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", &block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(block);
+        --allocator->block_count;
+        os_free(&block, ChunkedBlock::block_size);
+    }
+}
+
 enum class CallerWillInitializeMemory {
     No,
     Yes,
@@ -291,6 +413,74 @@ enum class CallerWillInitializeMemory {
 
 #ifndef NO_TLS
 __thread bool s_allocation_enabled = true;
+
+// Each thread keeps a small stash of free chunks for the smaller size classes, so that most
+// allocations and frees don't have to take s_malloc_mutex at all. Chunks in a thread cache
+// still count as used in their ChunkedBlock, and only move between the cache and the shared
+// blocks in batches.
+static constexpr size_t thread_cache_maximum_chunk_size = 1008;
+static constexpr size_t thread_cache_chunks_per_size_class = 32;
+static constexpr size_t thread_cache_batch_size = thread_cache_chunks_per_size_class / 2;
+
+struct ThreadCacheBin {
+    FreelistEntry* chunks { nullptr };
+    size_t chunk_count { 0 };
+};
+
+static bool s_use_thread_cache = true;
+static __thread ThreadCacheBin s_thread_cache[num_size_classes];
+
+static ThreadCacheBin* thread_cache_bin_for_chunk_size(size_t chunk_size)
+{
+    if (!s_use_thread_cache || chunk_size > thread_cache_maximum_chunk_size)
+        return nullptr;
+    for (size_t i = 0; size_classes[i]; ++i) {
+        if (size_classes[i] == chunk_size)
+            return &s_thread_cache[i];
+    }
+    VERIFY_NOT_REACHED();
+}
+
+static ErrorOr<void> refill_thread_cache_bin(ThreadCacheBin& bin, Allocator& allocator, size_t good_size)
+{
+    PthreadMutexLocker locker(s_malloc_mutex);
+    g_malloc_stats.number_of_thread_cache_refills++;
+    while (bin.chunk_count < thread_cache_batch_size) {
+        auto ptr_or_error = allocate_chunk_locked(allocator, good_size, 16);
+        if (ptr_or_error.is_error()) {
+            // Make do with what we have, if anything.
+            if (bin.chunk_count > 0)
+                break;
+            return ptr_or_error.release_error();
+        }
+        auto* entry = (FreelistEntry*)ptr_or_error.value();
+        entry->next = bin.chunks;
+        bin.chunks = entry;
+        ++bin.chunk_count;
+    }
+    return {};
+}
+
+static void flush_thread_cache_bin(ThreadCacheBin& bin, size_t chunks_to_keep)
+{
+    PthreadMutexLocker locker(s_malloc_mutex);
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    while (bin.chunk_count > chunks_to_keep) {
+        auto* entry = bin.chunks;
+        bin.chunks = entry->next;
+        --bin.chunk_count;
+        auto* block = (ChunkedBlock*)((FlatPtr)entry & ChunkedBlock::block_mask);
+        free_chunk_locked(*block, entry);
+    }
+}
+
+void __malloc_release_thread_cache()
+{
+    for (auto& bin : s_thread_cache) {
+        if (bin.chunk_count > 0)
+            flush_thread_cache_bin(bin, 0);
+    }
+}
 #endif
 
 static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializeMemory caller_will_initialize_memory)
@@ -321,6 +511,24 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
     size_t good_size;
     auto* allocator = allocator_for_size(size, good_size, align);
 
+#ifndef NO_TLS
+    if (allocator && align <= 16) {
+        if (auto* bin = thread_cache_bin_for_chunk_size(good_size)) {
+            if (bin->chunk_count == 0)
+                TRY(refill_thread_cache_bin(*bin, *allocator, good_size));
+            void* ptr = bin->chunks;
+            bin->chunks = bin->chunks->next;
+            --bin->chunk_count;
+
+            if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+
+            ue_notify_malloc(ptr, size);
+            return ptr;
+        }
+    }
+#endif
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (!allocator) {
@@ -365,79 +573,10 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         return ptr;
     }
 
-    ChunkedBlock* block = nullptr;
-    void* ptr = nullptr;
-    for (auto& current : allocator->usable_blocks) {
-        if (current.free_chunks()) {
-            ptr = try_allocate_chunk_aligned(align, current);
-            if (ptr) {
-                block = &current;
-                break;
-            }
-        }
-    }
-
-    if (!block && s_hot_empty_block_count) {
-        g_malloc_stats.number_of_hot_empty_block_hits++;
-        block = s_hot_empty_blocks[--s_hot_empty_block_count];
-        if (block->m_size != good_size) {
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-            char buffer[64];
-            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-            set_mmap_name(block, ChunkedBlock::block_size, buffer);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block && s_cold_empty_block_count) {
-        g_malloc_stats.number_of_cold_empty_block_hits++;
-        block = s_cold_empty_blocks[--s_cold_empty_block_count];
-        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
-        bool this_block_was_purged = rc == 1;
-        if (rc < 0) {
-            perror("madvise");
-            VERIFY_NOT_REACHED();
-        }
-        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
-        if (rc < 0) {
-            perror("mprotect");
-            VERIFY_NOT_REACHED();
-        }
-        if (this_block_was_purged || block->m_size != good_size) {
-            if (this_block_was_purged)
-                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block) {
-        g_malloc_stats.number_of_block_allocs++;
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
-        new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
-    }
-
-    if (!ptr) {
-        ptr = try_allocate_chunk_aligned(align, *block);
-    }
-
-    VERIFY(ptr);
-    if (block->is_full()) {
-        g_malloc_stats.number_of_blocks_full++;
-        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
-    }
-    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    auto* ptr = TRY(allocate_chunk_locked(*allocator, good_size, align));
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -459,6 +598,23 @@ static void free_impl(void* ptr)
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
+#ifndef NO_TLS
+    if (magic == MAGIC_PAGE_HEADER) {
+        auto* block = (ChunkedBlock*)block_base;
+        if (auto* bin = thread_cache_bin_for_chunk_size(block->bytes_per_chunk())) {
+            if (s_scrub_free)
+                memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+
+            auto* entry = (FreelistEntry*)ptr;
+            entry->next = bin->chunks;
+            bin->chunks = entry;
+            if (++bin->chunk_count > thread_cache_chunks_per_size_class)
+                flush_thread_cache_bin(*bin, thread_cache_batch_size);
+            return;
+        }
+    }
+#endif
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
@@ -494,46 +650,7 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
-    }
-
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    free_chunk_locked(*block, ptr);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
@@ -663,6 +780,9 @@ void __malloc_init()
         // keeps track of heap memory anyway.
         s_scrub_malloc = false;
         s_scrub_free = false;
+#ifndef NO_TLS
+        s_use_thread_cache = false;
+#endif
     }
 
     if (secure_getenv("LIBC_NOSCRUB_MALLOC"))
@@ -705,5 +825,8 @@ void serenity_dump_malloc_stats()
     dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
     dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln();
+    dbgln("thread cache refills: {}", g_malloc_stats.number_of_thread_cache_refills);
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes);
 }
 }
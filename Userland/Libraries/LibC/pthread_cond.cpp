@@ -155,7 +155,11 @@ int pthread_cond_broadcast(pthread_cond_t* cond)
     pthread_mutex_t* mutex = AK::atomic_load(&cond->mutex, AK::memory_order_relaxed);
     VERIFY(mutex);
 
-    int rc = futex(&cond->value, FUTEX_REQUEUE | FUTEX_PRIVATE_FLAG, 1, nullptr, &mutex->lock, INT_MAX);
+    // Waking everyone up would only have them all immediately fight over the
+    // mutex, so wake up a single waiter, and move the rest over to the mutex.
+    // They then get woken up one by one as the mutex is passed along, since
+    // each of them takes it with __pthread_mutex_lock_pessimistic_np().
+    int rc = futex_requeue(&cond->value, 1, &mutex->lock, INT_MAX, false);
     VERIFY(rc >= 0);
     return 0;
 }
@@ -97,6 +97,9 @@ static constexpr u32 MUTEX_UNLOCKED = 0;
 static constexpr u32 MUTEX_LOCKED_NO_NEED_TO_WAKE = 1;
 static constexpr u32 MUTEX_LOCKED_NEED_TO_WAKE = 2;
 
+// How many times pthread_mutex_lock() checks on a contended mutex before going to sleep.
+static constexpr size_t MUTEX_SPIN_COUNT = 100;
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_mutex_init.html
 int pthread_mutex_init(pthread_mutex_t* mutex, pthread_mutexattr_t const* attributes)
 {
@@ -149,6 +152,26 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
         }
     }
 
+    // Before going to sleep, spin for a little while in case the owner is about
+    // to release the mutex, which saves a futex wait here as well as a futex
+    // wake on the other side. Once someone is already asleep on the mutex there
+    // is no point in doing so, as the owner is going to hand it to them anyway.
+    for (size_t i = 0; i < MUTEX_SPIN_COUNT && value != MUTEX_LOCKED_NEED_TO_WAKE; ++i) {
+        if (value == MUTEX_UNLOCKED) {
+            if (AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire)) {
+                if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
+                    AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+                mutex->level = 0;
+                return 0;
+            }
+            continue;
+        }
+#if ARCH(X86_64)
+        __builtin_ia32_pause();
+#endif
+        value = AK::atomic_load(&mutex->lock, AK::memory_order_relaxed);
+    }
+
     // Slow path: wait, record the fact that we're going to wait, and always
     // remember to wake the next thread up once we release the mutex.
     if (value != MUTEX_LOCKED_NEED_TO_WAKE)
@@ -48,6 +48,13 @@ static ALWAYS_INLINE int futex_wake(uint32_t* userspace_address, uint32_t count,
     return futex(userspace_address, FUTEX_WAKE | (process_shared ? 0 : FUTEX_PRIVATE_FLAG), count, NULL, NULL, 0);
 }
 
+// Wakes up to wake_count waiters on userspace_address, and moves up to requeue_count of the remaining
+// ones over to wait on userspace_address2 instead.
+static ALWAYS_INLINE int futex_requeue(uint32_t* userspace_address, uint32_t wake_count, uint32_t* userspace_address2, uint32_t requeue_count, int process_shared)
+{
+    return futex(userspace_address, FUTEX_REQUEUE | (process_shared ? 0 : FUTEX_PRIVATE_FLAG), wake_count, (const struct timespec*)(uintptr_t)requeue_count, userspace_address2, 0);
+}
+
 #ifdef ALWAYS_INLINE_SERENITY_H
 #    undef ALWAYS_INLINE
 #endif
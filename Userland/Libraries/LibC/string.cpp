@@ -50,6 +50,9 @@ size_t strcspn(char const* s, char const* reject)
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strlen.html
+// For x86-64, vectorized implementations are found in ./arch/x86_64/string.cpp
+#if ARCH(X86_64)
+#else
 size_t strlen(char const* str)
 {
     size_t len = 0;
@@ -57,8 +60,12 @@ size_t strlen(char const* str)
         ++len;
     return len;
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strnlen.html
+// For x86-64, vectorized implementations are found in ./arch/x86_64/string.cpp
+#if ARCH(X86_64)
+#else
 size_t strnlen(char const* str, size_t maxlen)
 {
     size_t len = 0;
@@ -66,6 +73,7 @@ size_t strnlen(char const* str, size_t maxlen)
         len++;
     return len;
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strdup.html
 char* strdup(char const* str)
@@ -111,6 +119,9 @@ int strncmp(char const* s1, char const* s2, size_t n)
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/memcmp.html
+// For x86-64, vectorized implementations are found in ./arch/x86_64/string.cpp
+#if ARCH(X86_64)
+#else
 int memcmp(void const* v1, void const* v2, size_t n)
 {
     auto* s1 = (uint8_t const*)v1;
@@ -121,6 +132,7 @@ int memcmp(void const* v1, void const* v2, size_t n)
     }
     return 0;
 }
+#endif
 
 int timingsafe_memcmp(void const* b1, void const* b2, size_t len)
 {
@@ -210,6 +222,9 @@ size_t strlcpy(char* dest, char const* src, size_t n)
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strchr.html
+// For x86-64, vectorized implementations are found in ./arch/x86_64/string.cpp
+#if ARCH(X86_64)
+#else
 char* strchr(char const* str, int c)
 {
     char ch = c;
@@ -220,6 +235,7 @@ char* strchr(char const* str, int c)
             return nullptr;
     }
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699959399/functions/index.html
 char* index(char const* str, int c)
@@ -237,6 +253,9 @@ char* strchrnul(char const* str, int c)
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/memchr.html
+// For x86-64, vectorized implementations are found in ./arch/x86_64/string.cpp
+#if ARCH(X86_64)
+#else
 void* memchr(void const* ptr, int c, size_t size)
 {
     char ch = c;
@@ -247,6 +266,7 @@ void* memchr(void const* ptr, int c, size_t size)
     }
     return nullptr;
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strrchr.html
 char* strrchr(char const* str, int ch)
@@ -6,6 +6,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/AnyOf.h>
+#include <AK/Array.h>
 #include <AK/Assertions.h>
 #include <AK/Badge.h>
 #include <AK/Debug.h>
@@ -41,6 +43,7 @@
 
 #ifdef AK_OS_SERENITY
 #    include <LibCore/Account.h>
+#    include <sys/epoll.h>
 
 extern bool s_global_initializers_ran;
 #endif
@@ -80,6 +83,43 @@ thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 thread_local bool s_warned_promise_count { false };
 
+#ifdef AK_OS_SERENITY
+// On Serenity, the fds we're interested in are kept in an epoll interest list, so waiting for events doesn't
+// have to hand the kernel every single fd again. Several notifiers may share an fd, so we track them per fd.
+static thread_local int s_epoll_fd { -1 };
+static thread_local HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
+
+static void update_epoll_interest(int fd)
+{
+    u32 events = 0;
+    bool has_notifiers = false;
+    if (auto it = s_notifiers_by_fd->find(fd); it != s_notifiers_by_fd->end()) {
+        for (auto* notifier : it->value) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+        has_notifiers = !it->value.is_empty();
+    }
+
+    if (!has_notifiers) {
+        // NOTE: This fails if the fd has been closed already, which removed it from the interest list anyway.
+        (void)epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    epoll_event event { events, { .fd = fd } };
+    if (epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0)
+        return;
+    if (errno == ENOENT && epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0)
+        return;
+    dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -93,6 +133,17 @@ void EventLoop::initialize_wake_pipes()
 #endif
         VERIFY(rc == 0);
         s_wake_pipe_initialized = true;
+
+#ifdef AK_OS_SERENITY
+        // NOTE: After a fork, the interest list is still shared with the parent, so we need one of our own.
+        if (s_epoll_fd >= 0)
+            close(s_epoll_fd);
+        s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        VERIFY(s_epoll_fd >= 0);
+        epoll_event event { EPOLLIN, { .fd = s_wake_pipe_fds[0] } };
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_pipe_fds[0], &event);
+        VERIFY(rc == 0);
+#endif
     }
 }
 
@@ -333,6 +384,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef AK_OS_SERENITY
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
+#endif
     }
 
     if (s_event_loop_stack->is_empty()) {
@@ -685,6 +739,9 @@ void EventLoop::notify_forked(ForkEvent event)
         s_event_loop_stack->clear();
         s_timers->clear();
         s_notifiers->clear();
+#ifdef AK_OS_SERENITY
+        s_notifiers_by_fd->clear();
+#endif
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
         if (auto* info = signals_info<false>()) {
@@ -700,6 +757,10 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef AK_OS_SERENITY
+    Array<epoll_event, 64> epoll_events;
+retry:
+#else
     fd_set rfds;
     fd_set wfds;
 retry:
@@ -729,6 +790,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             VERIFY_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -755,8 +817,15 @@ retry:
     }
 
 try_select_again:
+#ifdef AK_OS_SERENITY
+    // Wait for file system events, calls to wake(), POSIX signals, or timer expirations.
+    // NOTE: Round the timeout up, so we don't wake up just before a timer expires and spin until it does.
+    int timeout_ms = should_wait_forever ? -1 : static_cast<int>(timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000);
+    int marked_fd_count = epoll_wait(s_epoll_fd, epoll_events.data(), epoll_events.size(), timeout_ms);
+#else
     // select() and wait for file system events, calls to wake(), POSIX signals, or timer expirations.
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#endif
     // Because POSIX, we might spuriously return from select() with EINTR; just select again.
     if (marked_fd_count < 0) {
         int saved_errno = errno;
@@ -769,9 +838,17 @@ try_select_again:
         VERIFY_NOT_REACHED();
     }
 
+#ifdef AK_OS_SERENITY
+    bool wake_pipe_is_readable = any_of(epoll_events.span().trim(max(marked_fd_count, 0)), [](auto& event) {
+        return event.data.fd == s_wake_pipe_fds[0];
+    });
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+
     // We woke up due to a call to wake() or a POSIX signal.
     // Handle signals and see whether we need to handle events as well.
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -831,6 +908,20 @@ try_select_again:
         return;
 
     // Handle file system notifiers by making them normal events.
+#ifdef AK_OS_SERENITY
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto const& event = epoll_events[i];
+        auto it = s_notifiers_by_fd->find(event.data.fd);
+        if (it == s_notifiers_by_fd->end())
+            continue;
+        for (auto* notifier : it->value) {
+            if ((event.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+            if ((event.events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->event_mask() & Notifier::Event::Read)
@@ -841,6 +932,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(Time const& now) const
@@ -904,13 +996,35 @@ bool EventLoop::unregister_timer(int timer_id)
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
-    s_notifiers->set(&notifier);
+    if (s_notifiers->set(&notifier) != HashSetResult::InsertedNewEntry)
+        return;
+#ifdef AK_OS_SERENITY
+    s_notifiers_by_fd->ensure(notifier.fd()).append(&notifier);
+    update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
-    s_notifiers->remove(&notifier);
+    if (!s_notifiers->remove(&notifier))
+        return;
+#ifdef AK_OS_SERENITY
+    if (auto it = s_notifiers_by_fd->find(notifier.fd()); it != s_notifiers_by_fd->end()) {
+        it->value.remove_first_matching([&](auto* other) { return other == &notifier; });
+        if (it->value.is_empty())
+            s_notifiers_by_fd->remove(it);
+    }
+    update_epoll_interest(notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, [[maybe_unused]] Notifier& notifier)
+{
+#ifdef AK_OS_SERENITY
+    if (s_notifiers && s_notifiers->contains(&notifier))
+        update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoop::wake_current()
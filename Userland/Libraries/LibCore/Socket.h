@@ -191,6 +191,8 @@ public:
     ErrorOr<void> set_blocking(bool enabled) override { return m_helper.set_blocking(enabled); }
     ErrorOr<void> set_close_on_exec(bool enabled) override { return m_helper.set_close_on_exec(enabled); }
 
+    Optional<int> fd() const;
+
     virtual ~TCPSocket() override { close(); }
 
 private:
@@ -420,6 +422,12 @@ public:
 
     virtual size_t buffer_size() const override { return m_helper.buffer_size(); }
 
+    Optional<int> fd() const
+    requires(requires(T const& stream) { stream.fd(); })
+    {
+        return m_helper.stream().fd();
+    }
+
     virtual ~BufferedSocket() override = default;
 
 private:
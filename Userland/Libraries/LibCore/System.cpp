@@ -31,6 +31,7 @@
 #    include <LibSystem/syscall.h>
 #    include <serenity.h>
 #    include <sys/ptrace.h>
+#    include <sys/sendfile.h>
 #endif
 
 #if defined(AK_OS_LINUX) && !defined(MFD_CLOEXEC)
@@ -217,6 +218,14 @@ ErrorOr<int> recvfd(int sockfd, int options)
     return fd;
 }
 
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    auto rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return rc;
+}
+
 ErrorOr<void> ptrace_peekbuf(pid_t tid, void const* tracee_addr, Bytes destination_buf)
 {
     Syscall::SC_ptrace_buf_params buf_params {
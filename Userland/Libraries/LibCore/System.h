@@ -49,6 +49,7 @@ ErrorOr<void> unveil(StringView path, StringView permissions);
 ErrorOr<void> unveil_after_exec(StringView path, StringView permissions);
 ErrorOr<void> sendfd(int sockfd, int fd);
 ErrorOr<int> recvfd(int sockfd, int options);
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
 ErrorOr<void> ptrace_peekbuf(pid_t tid, void const* tracee_addr, Bytes destination_buf);
 ErrorOr<void> mount(int source_fd, StringView target, StringView fs_type, int flags);
 ErrorOr<void> umount(StringView mount_point);
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/BuiltinWrappers.h>
+#include <AK/QuickSort.h>
+#include <AK/Span.h>
+#include <LibThreading/ThreadPool.h>
+
+namespace Threading {
+
+namespace Detail {
+
+// Splits the work into a few chunks per worker, so that stealing can even out uneven chunks,
+// but never into chunks so small that handing them around costs more than running them.
+inline size_t parallel_chunk_size(ThreadPool& pool, size_t size, size_t minimum_chunk_size)
+{
+    size_t chunk_count = pool.thread_count() * 4;
+    return max((size + chunk_count - 1) / chunk_count, minimum_chunk_size);
+}
+
+template<typename Callback>
+void parallel_for_each_chunk(ThreadPool& pool, size_t size, size_t minimum_chunk_size, Callback callback)
+{
+    size_t chunk_size = parallel_chunk_size(pool, size, minimum_chunk_size);
+    if (size <= chunk_size) {
+        callback(0, size);
+        return;
+    }
+
+    TaskGroup group(pool);
+    size_t start = 0;
+    for (; start + chunk_size < size; start += chunk_size)
+        group.spawn([&callback, start, chunk_size] { callback(start, start + chunk_size); });
+    // Make ourselves useful with the last chunk, instead of only waiting for the others.
+    callback(start, size);
+    group.wait();
+}
+
+template<typename T, typename LessThan>
+void parallel_sort(ThreadPool& pool, Span<T> span, LessThan& less_than, size_t sequential_threshold, size_t depth_limit)
+{
+    // Running out of depth means the pivots keep being bad, so stop spawning tasks for ever
+    // smaller partitions and leave the rest to a sequential sort.
+    if (span.size() <= sequential_threshold || depth_limit == 0) {
+        quick_sort(span, less_than);
+        return;
+    }
+
+    // Median of three, as sorted or reversed input is common.
+    auto& first = span.first();
+    auto& middle = span[span.size() / 2];
+    auto& last = span.last();
+    auto* pivot_element = &middle;
+    if (less_than(first, middle)) {
+        if (less_than(last, first))
+            pivot_element = &first;
+        else if (less_than(last, middle))
+            pivot_element = &last;
+    } else {
+        if (less_than(first, last))
+            pivot_element = &first;
+        else if (less_than(middle, last))
+            pivot_element = &last;
+    }
+    T pivot = *pivot_element;
+
+    // Three-way partition into [less than pivot | equal to pivot | greater than pivot], so that
+    // runs of equal elements don't degrade into quadratic behavior.
+    size_t less_end = 0;
+    size_t index = 0;
+    size_t greater_start = span.size();
+    while (index < greater_start) {
+        if (less_than(span[index], pivot))
+            swap(span[less_end++], span[index++]);
+        else if (less_than(pivot, span[index]))
+            swap(span[index], span[--greater_start]);
+        else
+            ++index;
+    }
+
+    TaskGroup group(pool);
+    auto less = span.slice(0, less_end);
+    group.spawn([&pool, less, &less_than, sequential_threshold, depth_limit] { parallel_sort(pool, less, less_than, sequential_threshold, depth_limit - 1); });
+    parallel_sort(pool, span.slice(greater_start), less_than, sequential_threshold, depth_limit - 1);
+    group.wait();
+}
+
+}
+
+// Calls callback(element) for every element of the span, spread over the pool's workers.
+template<typename T, typename Callback>
+void parallel_for_each(ThreadPool& pool, Span<T> span, Callback callback, size_t minimum_chunk_size = 1)
+{
+    Detail::parallel_for_each_chunk(pool, span.size(), minimum_chunk_size, [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i)
+            callback(span[i]);
+    });
+}
+
+template<typename T, typename Callback>
+void parallel_for_each(Span<T> span, Callback callback, size_t minimum_chunk_size = 1)
+{
+    parallel_for_each(ThreadPool::the(), span, move(callback), minimum_chunk_size);
+}
+
+// Stores callback(input[i]) into output[i] for every element of the input.
+template<typename T, typename U, typename Callback>
+void parallel_transform(ThreadPool& pool, Span<T> input, Span<U> output, Callback callback, size_t minimum_chunk_size = 1)
+{
+    VERIFY(output.size() >= input.size());
+    Detail::parallel_for_each_chunk(pool, input.size(), minimum_chunk_size, [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i)
+            output[i] = callback(input[i]);
+    });
+}
+
+template<typename T, typename U, typename Callback>
+void parallel_transform(Span<T> input, Span<U> output, Callback callback, size_t minimum_chunk_size = 1)
+{
+    parallel_transform(ThreadPool::the(), input, output, move(callback), minimum_chunk_size);
+}
+
+// Sorts the span in place. This is not a stable sort.
+template<typename T, typename LessThan>
+void parallel_sort(ThreadPool& pool, Span<T> span, LessThan less_than)
+{
+    // Below this, the overhead of spawning tasks outweighs sorting sequentially.
+    static constexpr size_t sequential_threshold = 4096;
+    // Twice the depth that perfect pivots would need, like an introsort.
+    size_t depth_limit = 2 * (sizeof(size_t) * 8 - count_leading_zeroes_safe(span.size()));
+    Detail::parallel_sort(pool, span, less_than, max(sequential_threshold, span.size() / (pool.thread_count() * 8)), depth_limit);
+}
+
+template<typename T, typename LessThan>
+void parallel_sort(Span<T> span, LessThan less_than)
+{
+    parallel_sort(ThreadPool::the(), span, move(less_than));
+}
+
+template<typename T>
+void parallel_sort(Span<T> span)
+{
+    parallel_sort(span, [](auto& a, auto& b) { return a < b; });
+}
+
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibThreading/ThreadPool.h>
+#include <unistd.h>
+
+namespace Threading {
+
+// The worker that is running on the current thread, if any, so that tasks submitted from inside
+// a task end up in the submitting worker's own queue.
+static thread_local ThreadPool* s_current_worker_pool = nullptr;
+static thread_local size_t s_current_worker_index = 0;
+
+ErrorOr<NonnullOwnPtr<ThreadPool>> ThreadPool::try_create(size_t thread_count)
+{
+    if (thread_count == 0) {
+        auto processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = processor_count > 0 ? static_cast<size_t>(processor_count) : 1;
+    }
+    auto pool = TRY(adopt_nonnull_own_or_enomem(new (nothrow) ThreadPool));
+    TRY(pool->start_workers(thread_count));
+    return pool;
+}
+
+ThreadPool& ThreadPool::the()
+{
+    static ThreadPool* s_the = ThreadPool::try_create().release_value_but_fixme_should_propagate_errors().leak_ptr();
+    return *s_the;
+}
+
+ErrorOr<void> ThreadPool::start_workers(size_t thread_count)
+{
+    TRY(m_workers.try_ensure_capacity(thread_count));
+    for (size_t i = 0; i < thread_count; ++i)
+        m_workers.unchecked_append(TRY(adopt_nonnull_own_or_enomem(new (nothrow) Worker)));
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_workers[i]->thread = TRY(Thread::try_create([this, i] {
+            s_current_worker_pool = this;
+            s_current_worker_index = i;
+            run_worker();
+            return 0;
+        },
+            "ThreadPool worker"sv));
+    }
+    for (auto& worker : m_workers)
+        worker->thread->start();
+    return {};
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        MutexLocker locker(m_sleep_mutex);
+        m_should_exit = true;
+    }
+    m_work_available.broadcast();
+    for (auto& worker : m_workers) {
+        if (worker->thread && worker->thread->needs_to_be_joined())
+            (void)worker->thread->join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    bool is_worker = s_current_worker_pool == this;
+    auto& mutex = is_worker ? m_workers[s_current_worker_index]->mutex : m_shared_tasks_mutex;
+    auto& tasks = is_worker ? m_workers[s_current_worker_index]->tasks : m_shared_tasks;
+    {
+        MutexLocker locker(mutex);
+        tasks.enqueue(move(task));
+        m_queued_task_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    // Nothing to do in here, but a worker that saw no queued tasks is now either asleep, or
+    // about to see the new one.
+    {
+        MutexLocker locker(m_sleep_mutex);
+    }
+    m_work_available.signal();
+}
+
+Optional<ThreadPool::Task> ThreadPool::take_from(Mutex& mutex, TaskQueue& tasks, bool newest)
+{
+    MutexLocker locker(mutex);
+    if (tasks.is_empty())
+        return {};
+    m_queued_task_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+    return newest ? tasks.dequeue_end() : tasks.dequeue();
+}
+
+Optional<ThreadPool::Task> ThreadPool::take_task()
+{
+    // Our own tasks first, newest first, as their data is most likely to still be in the cache.
+    bool is_worker = s_current_worker_pool == this;
+    if (is_worker) {
+        auto& worker = *m_workers[s_current_worker_index];
+        if (auto task = take_from(worker.mutex, worker.tasks, true); task.has_value())
+            return task;
+    }
+
+    if (auto task = take_from(m_shared_tasks_mutex, m_shared_tasks, false); task.has_value())
+        return task;
+
+    // Steal the oldest task of another worker, which is usually the biggest chunk of work.
+    size_t start_index = is_worker ? s_current_worker_index + 1 : 0;
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        auto& victim = *m_workers[(start_index + i) % m_workers.size()];
+        if (auto task = take_from(victim.mutex, victim.tasks, false); task.has_value())
+            return task;
+    }
+
+    return {};
+}
+
+void ThreadPool::run_worker()
+{
+    for (;;) {
+        if (auto task = take_task(); task.has_value()) {
+            (*task)();
+            continue;
+        }
+
+        MutexLocker locker(m_sleep_mutex);
+        while (m_queued_task_count.load(AK::MemoryOrder::memory_order_relaxed) == 0 && !m_should_exit)
+            m_work_available.wait();
+        if (m_should_exit && m_queued_task_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            return;
+    }
+}
+
+void TaskGroup::spawn(ThreadPool::Task task)
+{
+    m_pending_task_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    m_pool.submit([this, task = move(task)] {
+        task();
+        MutexLocker locker(m_mutex);
+        if (m_pending_task_count.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel) == 1)
+            m_completed.broadcast();
+    });
+}
+
+void TaskGroup::wait()
+{
+    m_pool.run_tasks_until([this] { return m_pending_task_count.load(AK::MemoryOrder::memory_order_acquire) == 0; }, m_mutex, m_completed);
+    // The last task might still be on its way out of m_mutex after letting us go.
+    MutexLocker locker(m_mutex);
+}
+
+}
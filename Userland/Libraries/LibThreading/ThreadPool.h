@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/AtomicRefCounted.h>
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <AK/Queue.h>
+#include <AK/RefPtr.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Variant.h>
+#include <AK/Vector.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+
+namespace Threading {
+
+// A fixed set of worker threads that run submitted tasks.
+//
+// Every worker has its own queue of tasks. Tasks submitted from a worker go into that worker's
+// queue, which it works through from the back, so related work tends to stay on the same thread.
+// Idle workers steal from the front of the other queues, and tasks submitted from outside the
+// pool are shared among all workers.
+//
+// Waiting on a Future or a TaskGroup runs other queued tasks in the meantime, so tasks may freely
+// spawn and wait on more tasks without starving the pool.
+class ThreadPool {
+    AK_MAKE_NONCOPYABLE(ThreadPool);
+    AK_MAKE_NONMOVABLE(ThreadPool);
+
+public:
+    using Task = Function<void()>;
+
+    // A thread count of 0 creates one worker per online processor.
+    static ErrorOr<NonnullOwnPtr<ThreadPool>> try_create(size_t thread_count = 0);
+    // The process-wide pool, which is created on first use and is never destroyed.
+    static ThreadPool& the();
+
+    // Runs all remaining tasks, then stops and joins the workers.
+    ~ThreadPool();
+
+    size_t thread_count() const { return m_workers.size(); }
+
+    void submit(Task);
+
+    // Runs queued tasks on the calling thread until is_done() returns true. When there is nothing
+    // left to run, sleeps on the given condition variable until its owner signals completion.
+    template<typename IsDone>
+    void run_tasks_until(IsDone is_done, Mutex& mutex, ConditionVariable& completed)
+    {
+        while (!is_done()) {
+            if (auto task = take_task(); task.has_value()) {
+                (*task)();
+                continue;
+            }
+            MutexLocker locker(mutex);
+            if (!is_done())
+                completed.wait();
+        }
+    }
+
+private:
+    // Tasks are queued in small segments, as most queues only ever hold a handful of them.
+    using TaskQueue = Queue<Task, 64>;
+
+    struct Worker {
+        Mutex mutex;
+        TaskQueue tasks;
+        RefPtr<Thread> thread;
+    };
+
+    ThreadPool() = default;
+
+    ErrorOr<void> start_workers(size_t thread_count);
+    void run_worker();
+    Optional<Task> take_task();
+    Optional<Task> take_from(Mutex&, TaskQueue&, bool newest);
+
+    Vector<NonnullOwnPtr<Worker>> m_workers;
+
+    Mutex m_shared_tasks_mutex;
+    TaskQueue m_shared_tasks;
+
+    // Workers sleep on this when there is nothing to do. The count of queued tasks is updated with
+    // the lock of the queue that holds the task, so it can never be behind the queues. Submitters
+    // take the sleep mutex after incrementing it, so a worker can't miss a wakeup between checking
+    // the count and waiting.
+    Mutex m_sleep_mutex;
+    ConditionVariable m_work_available { m_sleep_mutex };
+    Atomic<size_t> m_queued_task_count { 0 };
+    bool m_should_exit { false };
+};
+
+// The eventual result of a task running on a ThreadPool.
+template<typename T>
+class Future final : public AtomicRefCounted<Future<T>> {
+public:
+    using ValueType = Conditional<IsVoid<T>, Empty, T>;
+
+    explicit Future(ThreadPool& pool)
+        : m_pool(pool)
+    {
+    }
+
+    bool is_ready() const { return m_ready.load(AK::MemoryOrder::memory_order_acquire); }
+
+    // Blocks until the task has finished, running other tasks in the meantime.
+    decltype(auto) await()
+    {
+        m_pool.run_tasks_until([this] { return is_ready(); }, m_mutex, m_completed);
+        if constexpr (!IsVoid<T>)
+            return m_value.value();
+    }
+
+    void resolve(ValueType value)
+    {
+        MutexLocker locker(m_mutex);
+        m_value = move(value);
+        m_ready.store(true, AK::MemoryOrder::memory_order_release);
+        m_completed.broadcast();
+    }
+
+private:
+    ThreadPool& m_pool;
+    Optional<ValueType> m_value;
+    Atomic<bool> m_ready { false };
+    Mutex m_mutex;
+    ConditionVariable m_completed { m_mutex };
+};
+
+template<typename Callable, typename Result = decltype(declval<Callable>()())>
+NonnullRefPtr<Future<Result>> spawn(ThreadPool& pool, Callable callable)
+{
+    auto future = adopt_ref(*new Future<Result>(pool));
+    pool.submit([future, callable = move(callable)]() mutable {
+        if constexpr (IsVoid<Result>) {
+            callable();
+            future->resolve({});
+        } else {
+            future->resolve(callable());
+        }
+    });
+    return future;
+}
+
+template<typename Callable>
+auto spawn(Callable callable)
+{
+    return spawn(ThreadPool::the(), move(callable));
+}
+
+// A set of tasks that can be waited on together. The destructor waits for all of them.
+class TaskGroup {
+    AK_MAKE_NONCOPYABLE(TaskGroup);
+    AK_MAKE_NONMOVABLE(TaskGroup);
+
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::the())
+        : m_pool(pool)
+    {
+    }
+
+    ~TaskGroup() { wait(); }
+
+    void spawn(ThreadPool::Task);
+
+    // Blocks until every task spawned so far has finished, running other tasks in the meantime.
+    void wait();
+
+private:
+    ThreadPool& m_pool;
+    Atomic<size_t> m_pending_task_count { 0 };
+    Mutex m_mutex;
+    ConditionVariable m_completed { m_mutex };
+};
+
+}
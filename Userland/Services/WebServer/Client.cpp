@@ -19,6 +19,7 @@
 #include <LibCore/File.h>
 #include <LibCore/MappedFile.h>
 #include <LibCore/MimeData.h>
+#include <LibCore/System.h>
 #include <LibFileSystem/FileSystem.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
@@ -173,11 +174,11 @@ ErrorOr<bool> Client::handle_request(ReadonlyBytes raw_request)
         .type = TRY(String::from_utf8(Core::guess_mime_type_based_on_filename(real_path.bytes_as_string_view()))),
         .length = TRY(FileSystem::size(real_path.bytes_as_string_view()))
     };
-    TRY(send_response(*stream, request, move(info)));
+    TRY(send_file_response(*stream, request, move(info)));
     return true;
 }
 
-ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+ErrorOr<void> Client::send_response_header(HTTP::HttpRequest const& request, ContentInfo const& content_info)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n"sv);
@@ -195,6 +196,23 @@ ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& r
     auto builder_contents = TRY(builder.to_byte_buffer());
     TRY(m_socket->write_until_depleted(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+void Client::close_unless_keep_alive(HTTP::HttpRequest const& request)
+{
+    auto keep_alive = false;
+    if (auto it = request.headers().find_if([](auto& header) { return header.name.equals_ignoring_ascii_case("Connection"sv); }); !it.is_end()) {
+        if (it->value.trim_whitespace().equals_ignoring_ascii_case("keep-alive"sv))
+            keep_alive = true;
+    }
+    if (!keep_alive)
+        m_socket->close();
+}
+
+ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_header(request, content_info));
 
     char buffer[PAGE_SIZE];
     do {
@@ -214,14 +232,33 @@ ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& r
         }
     } while (true);
 
-    auto keep_alive = false;
-    if (auto it = request.headers().find_if([](auto& header) { return header.name.equals_ignoring_ascii_case("Connection"sv); }); !it.is_end()) {
-        if (it->value.trim_whitespace().equals_ignoring_ascii_case("keep-alive"sv))
-            keep_alive = true;
+    close_unless_keep_alive(request);
+    return {};
+}
+
+ErrorOr<void> Client::send_file_response(Core::File& file, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    auto socket_fd = m_socket->fd();
+    if (!socket_fd.has_value())
+        return Error::from_errno(ENOTCONN);
+
+    TRY(send_response_header(request, content_info));
+
+    // Let the kernel move the file contents into the socket, instead of copying them through our own buffer.
+    size_t remaining = content_info.length;
+    while (remaining > 0) {
+        ErrorOr<size_t> result = 0;
+        do {
+            result = Core::System::sendfile(socket_fd.value(), file.fd(), nullptr, remaining);
+        } while (result.is_error() && result.error().code() == EINTR);
+        auto nsent = TRY(result);
+        // We already promised the client the whole file, so the connection has to be dropped rather than reused.
+        if (nsent == 0)
+            return Error::from_string_literal("File got shorter while it was being sent");
+        remaining -= nsent;
     }
-    if (!keep_alive)
-        m_socket->close();
 
+    close_unless_keep_alive(request);
     return {};
 }
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <AK/String.h>
+#include <LibCore/Forward.h>
 #include <LibCore/Object.h>
 #include <LibCore/Socket.h>
 #include <LibHTTP/Forward.h>
@@ -31,6 +32,9 @@ private:
 
     ErrorOr<bool> handle_request(ReadonlyBytes);
     ErrorOr<void> send_response(Stream&, HTTP::HttpRequest const&, ContentInfo);
+    ErrorOr<void> send_file_response(Core::File&, HTTP::HttpRequest const&, ContentInfo);
+    ErrorOr<void> send_response_header(HTTP::HttpRequest const&, ContentInfo const&);
+    void close_unless_keep_alive(HTTP::HttpRequest const&);
     ErrorOr<void> send_redirect(StringView redirect, HTTP::HttpRequest const&);
     ErrorOr<void> send_error_response(unsigned code, HTTP::HttpRequest const&, Vector<String> const& headers = {});
     void die();
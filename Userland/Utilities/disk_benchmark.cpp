@@ -5,8 +5,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
 #include <AK/DeprecatedString.h>
+#include <AK/Random.h>
 #include <AK/ScopeGuard.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
@@ -15,6 +17,7 @@
 #include <LibCore/System.h>
 #include <LibMain/Main.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -40,6 +43,7 @@ static Result average_result(Vector<Result> const& results)
 }
 
 static ErrorOr<Result> benchmark(DeprecatedString const& filename, int file_size, ByteBuffer& buffer, bool allow_cache);
+static ErrorOr<void> iops_benchmark(DeprecatedString const& filename, size_t file_size, size_t block_size, Vector<size_t> const& queue_depths, Time time_per_benchmark, bool allow_cache);
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
@@ -49,6 +53,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     i64 time_per_benchmark_sec = 10;
     Vector<size_t> file_sizes;
     Vector<size_t> block_sizes;
+    Vector<size_t> queue_depths;
     bool allow_cache = false;
 
     Core::ArgsParser args_parser;
@@ -57,6 +62,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(time_per_benchmark_sec, "Time elapsed per benchmark (seconds)", "time-per-benchmark", 't', "time-per-benchmark");
     args_parser.add_option(file_sizes, "A comma-separated list of file sizes", "file-size", 'f', "file-size");
     args_parser.add_option(block_sizes, "A comma-separated list of block sizes", "block-size", 'b', "block-size");
+    args_parser.add_option(queue_depths, "Measure random read IOPS at each of these comma-separated queue depths instead", "queue-depth", 'q', "queue-depth");
     args_parser.parse(arguments);
 
     Time const time_per_benchmark = Time::from_seconds(time_per_benchmark_sec);
@@ -72,6 +78,17 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     auto filename = DeprecatedString::formatted("{}/disk_benchmark.tmp", directory);
 
+    if (!queue_depths.is_empty()) {
+        for (auto file_size : file_sizes) {
+            for (auto block_size : block_sizes) {
+                if (block_size > file_size)
+                    continue;
+                TRY(iops_benchmark(filename, file_size, block_size, queue_depths, time_per_benchmark, allow_cache));
+            }
+        }
+        return 0;
+    }
+
     for (auto file_size : file_sizes) {
         for (auto block_size : block_sizes) {
             if (block_size > file_size)
@@ -145,3 +162,122 @@ ErrorOr<Result> benchmark(DeprecatedString const& filename, int file_size, ByteB
     result.read_bps = (u64)(timer.elapsed() ? (file_size / timer.elapsed()) : file_size) * 1000;
     return result;
 }
+
+struct IOPSWorker {
+    DeprecatedString const* filename { nullptr };
+    size_t block_count { 0 };
+    size_t block_size { 0 };
+    bool allow_cache { false };
+    Atomic<bool>* should_stop { nullptr };
+    u64 completed_reads { 0 };
+    int error { 0 };
+};
+
+static void* iops_worker(void* argument)
+{
+    auto& worker = *static_cast<IOPSWorker*>(argument);
+
+    int flags = O_RDONLY;
+    if (!worker.allow_cache)
+        flags |= O_DIRECT;
+    int fd = open(worker.filename->characters(), flags);
+    if (fd < 0) {
+        worker.error = errno;
+        return nullptr;
+    }
+
+    auto buffer_or_error = ByteBuffer::create_uninitialized(worker.block_size);
+    if (buffer_or_error.is_error()) {
+        worker.error = ENOMEM;
+        close(fd);
+        return nullptr;
+    }
+    auto buffer = buffer_or_error.release_value();
+
+    while (!worker.should_stop->load(AK::MemoryOrder::memory_order_relaxed)) {
+        auto offset = static_cast<off_t>(get_random_uniform(worker.block_count)) * worker.block_size;
+        if (pread(fd, buffer.data(), worker.block_size, offset) < 0) {
+            worker.error = errno;
+            break;
+        }
+        ++worker.completed_reads;
+    }
+
+    close(fd);
+    return nullptr;
+}
+
+// Keeps `queue_depth` random reads in flight by issuing them from that many threads,
+// which is how a device that can service several requests at once gets to show it.
+ErrorOr<void> iops_benchmark(DeprecatedString const& filename, size_t file_size, size_t block_size, Vector<size_t> const& queue_depths, Time time_per_benchmark, bool allow_cache)
+{
+    int flags = O_CREAT | O_TRUNC | O_WRONLY;
+    if (!allow_cache)
+        flags |= O_DIRECT;
+
+    int fd = TRY(Core::System::open(filename, flags, 0644));
+    auto file_cleanup = ScopeGuard([fd, filename] {
+        auto void_or_error = Core::System::close(fd);
+        if (void_or_error.is_error())
+            warnln("{}", void_or_error.release_error());
+
+        void_or_error = Core::System::unlink(filename);
+        if (void_or_error.is_error())
+            warnln("{}", void_or_error.release_error());
+    });
+
+    auto buffer = TRY(ByteBuffer::create_zeroed(block_size));
+    for (size_t total_written = 0; total_written < file_size;)
+        total_written += TRY(Core::System::write(fd, buffer));
+
+    for (auto queue_depth : queue_depths) {
+        if (queue_depth == 0)
+            continue;
+
+        outln("Running: file_size={} block_size={} queue_depth={}", file_size, block_size, queue_depth);
+
+        Atomic<bool> should_stop { false };
+        Vector<IOPSWorker> workers;
+        TRY(workers.try_resize(queue_depth));
+        Vector<pthread_t> threads;
+        TRY(threads.try_ensure_capacity(queue_depth));
+
+        auto timer = Core::ElapsedTimer::start_new();
+        for (auto& worker : workers) {
+            worker.filename = &filename;
+            worker.block_count = file_size / block_size;
+            worker.block_size = block_size;
+            worker.allow_cache = allow_cache;
+            worker.should_stop = &should_stop;
+
+            pthread_t thread;
+            if (auto rc = pthread_create(&thread, nullptr, iops_worker, &worker); rc != 0) {
+                should_stop.store(true);
+                for (auto started_thread : threads)
+                    pthread_join(started_thread, nullptr);
+                return Error::from_errno(rc);
+            }
+            threads.unchecked_append(thread);
+        }
+
+        usleep(time_per_benchmark.to_microseconds());
+        should_stop.store(true);
+        for (auto thread : threads)
+            pthread_join(thread, nullptr);
+        auto elapsed_ms = timer.elapsed();
+
+        u64 total_reads = 0;
+        for (auto& worker : workers) {
+            if (worker.error != 0)
+                return Error::from_errno(worker.error);
+            total_reads += worker.completed_reads;
+        }
+
+        auto iops = elapsed_ms ? total_reads * 1000 / elapsed_ms : total_reads;
+        outln("Finished: reads={} time={}ms iops={} read_bps={}", total_reads, elapsed_ms, iops, iops * block_size);
+
+        sleep(1);
+    }
+
+    return {};
+}
@@ -52,6 +52,10 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
                 event_mask |= PERF_EVENT_SYSCALL;
             else if (event_type == "read")
                 event_mask |= PERF_EVENT_READ;
+            else if (event_type == "lock_wait")
+                event_mask |= PERF_EVENT_LOCK_WAIT;
+            else if (event_type == "lock_hold")
+                event_mask |= PERF_EVENT_LOCK_HOLD;
             else {
                 warnln("Unknown event type '{}' specified.", event_type);
                 exit(1);
@@ -63,7 +67,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     auto print_types = [] {
         outln();
-        outln("Event type can be one of: sample, context_switch, page_fault, syscall, read, kmalloc and kfree.");
+        outln("Event type can be one of: sample, context_switch, page_fault, syscall, read, lock_wait, lock_hold, kmalloc and kfree.");
     };
 
     if (!args_parser.parse(arguments, Core::ArgsParser::FailureBehavior::PrintUsage)) {
@@ -15,19 +15,23 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     bool purge_all_volatile = false;
     bool purge_all_clean_inode = false;
+    bool purge_all_clean_block_cache = false;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(purge_all_volatile, "Mode PURGE_ALL_VOLATILE", nullptr, 'v');
     args_parser.add_option(purge_all_clean_inode, "Mode PURGE_ALL_CLEAN_INODE", nullptr, 'c');
+    args_parser.add_option(purge_all_clean_block_cache, "Mode PURGE_ALL_CLEAN_BLOCK_CACHE", nullptr, 'b');
     args_parser.parse(arguments);
 
-    if (!purge_all_volatile && !purge_all_clean_inode)
-        purge_all_volatile = purge_all_clean_inode = true;
+    if (!purge_all_volatile && !purge_all_clean_inode && !purge_all_clean_block_cache)
+        purge_all_volatile = purge_all_clean_inode = purge_all_clean_block_cache = true;
 
     if (purge_all_volatile)
         mode |= PURGE_ALL_VOLATILE;
     if (purge_all_clean_inode)
         mode |= PURGE_ALL_CLEAN_INODE;
+    if (purge_all_clean_block_cache)
+        mode |= PURGE_ALL_CLEAN_BLOCK_CACHE;
 
     int purged_page_count = purge(mode);
     if (purged_page_count < 0) {